@@ -0,0 +1,284 @@
+#include "AsyncCompute.h"
+
+#include <algorithm>
+
+AsyncCompute::AsyncCompute()
+{
+}
+
+void AsyncCompute::create(VkPhysicalDevice physicalDevice, VkDevice newDevice, VkQueue newQueue, uint32_t queueFamily, uint32_t graphicsQueueFamily,
+	FrameScheduler * newGraphicsScheduler, int framesInFlight){
+
+	device = newDevice;
+	queue = newQueue;
+	graphicsScheduler = newGraphicsScheduler;
+
+	// a queue running alongside the graphics queue signals its own timeline, values have to be signalled in order
+	dedicated = queueFamily != graphicsQueueFamily;
+	if (dedicated) {
+		computeScheduler.create(device, framesInFlight);
+		scheduler = &computeScheduler;
+	}
+	else
+	{
+		scheduler = graphicsScheduler;
+	}
+
+	// -- COMMAND BUFFERS --
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;	// re-recorded every frame
+	poolInfo.queueFamilyIndex = queueFamily;
+
+	if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create async compute command pool");
+	}
+
+	std::vector<VkCommandBuffer> commandBuffers(framesInFlight);
+
+	VkCommandBufferAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = commandPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+	if (vkAllocateCommandBuffers(device, &allocateInfo, commandBuffers.data()) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate async compute command buffers");
+	}
+
+	frames.resize(framesInFlight);
+	for (int i = 0; i < framesInFlight; i++) {
+		frames[i].commandBuffer = commandBuffers[i];
+	}
+
+	// -- TIMESTAMPS --
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+	timestampPeriod = deviceProperties.limits.timestampPeriod;
+
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilyList(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilyList.data());
+
+	uint32_t validBits = 0;
+	if (queueFamily < queueFamilyCount && graphicsQueueFamily < queueFamilyCount) {
+		validBits = std::min(queueFamilyList[queueFamily].timestampValidBits, queueFamilyList[graphicsQueueFamily].timestampValidBits);
+	}
+	timestampsSupported = validBits > 0;
+	timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+	if (!timestampsSupported) {
+		return;
+	}
+
+	VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+	queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolCreateInfo.queryCount = 2;
+
+	for (auto &frame : frames) {
+		VkQueryPool queryPools[2];
+		for (VkQueryPool &queryPool : queryPools) {
+			if (vkCreateQueryPool(device, &queryPoolCreateInfo, nullptr, &queryPool) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create a timestamp query pool");
+			}
+		}
+		frame.computeQueries = UniqueQueryPool(device, queryPools[0]);
+		frame.graphicsQueries = UniqueQueryPool(device, queryPools[1]);
+	}
+}
+
+void AsyncCompute::destroy(){
+
+	// command buffers go with their pool
+	frames.clear();
+	if (commandPool != VK_NULL_HANDLE) {
+		vkDestroyCommandPool(device, commandPool, nullptr);
+		commandPool = VK_NULL_HANDLE;
+	}
+	computeScheduler.destroy();
+	scheduler = nullptr;
+	timestampsSupported = false;
+}
+
+bool AsyncCompute::isDedicated(){
+	return dedicated;
+}
+
+void AsyncCompute::collect(int frame){
+
+	Frame &queries = frames[frame];
+	if (!timestampsSupported || !queries.computeRecorded || !queries.graphicsRecorded) {
+		return;
+	}
+	queries.computeRecorded = false;
+	queries.graphicsRecorded = false;
+
+	uint64_t computeBegin, computeEnd, graphicsBegin, graphicsEnd;
+	if (!readTimestamps(queries.computeQueries.get(), computeBegin, computeEnd) ||
+		!readTimestamps(queries.graphicsQueries.get(), graphicsBegin, graphicsEnd)) {
+		previousGraphicsValid = false;
+		return;
+	}
+
+	// ticks after the compute work began
+	auto sinceBegin = [&](uint64_t ticks) {
+		return static_cast<int64_t>((ticks & timestampMask) - (computeBegin & timestampMask));
+	};
+	int64_t computeLength = sinceBegin(computeEnd);
+
+	// the part of the compute work inside a stretch of graphics work
+	auto overlap = [&](uint64_t begin, uint64_t end) {
+		int64_t from = std::max<int64_t>(sinceBegin(begin), 0);
+		int64_t to = std::min(sinceBegin(end), computeLength);
+		return static_cast<uint64_t>(std::max<int64_t>(to - from, 0));
+	};
+
+	// the previous frame's graphics, which it was submitted alongside, and this frame's up to its first wait on it
+	uint64_t frameOverlap = overlap(graphicsBegin, graphicsEnd);
+	if (previousGraphicsValid) {
+		frameOverlap += overlap(previousGraphicsBegin, previousGraphicsEnd);
+	}
+
+	computeTicks += static_cast<uint64_t>(std::max<int64_t>(computeLength, 0));
+	overlapTicks += frameOverlap;
+	measuredFrames++;
+	timedFrames++;
+
+	previousGraphicsBegin = graphicsBegin;
+	previousGraphicsEnd = graphicsEnd;
+	previousGraphicsValid = true;
+}
+
+VkCommandBuffer AsyncCompute::begin(int frame){
+
+	Frame &current = frames[frame];
+
+	// the frame's last submission has normally finished already, its graphics work waited on it
+	scheduler->wait(current.submitValue);
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (deviceDispatch.vkBeginCommandBuffer(current.commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("failed to start recording an async compute command buffer");
+	}
+
+	current.computeRecorded = timestampsSupported;
+	if (current.computeRecorded) {
+		deviceDispatch.vkCmdResetQueryPool(current.commandBuffer, current.computeQueries.get(), 0, 2);
+		deviceDispatch.vkCmdWriteTimestamp(current.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, current.computeQueries.get(), 0);
+	}
+
+	return current.commandBuffer;
+}
+
+uint64_t AsyncCompute::submit(int frame, uint64_t graphicsWaitValue){
+
+	Frame &current = frames[frame];
+
+	if (current.computeRecorded) {
+		deviceDispatch.vkCmdWriteTimestamp(current.commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, current.computeQueries.get(), 1);
+	}
+
+	if (deviceDispatch.vkEndCommandBuffer(current.commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to stop recording an async compute command buffer");
+	}
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &current.commandBuffer;
+
+	// on the graphics queue this is a wait on its own timeline, which is already in order
+	std::vector<TimelineWait> graphicsWaits;
+	if (graphicsWaitValue > 0) {
+		graphicsWaits.push_back({ graphicsScheduler->getSemaphore(), graphicsWaitValue, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT });
+	}
+
+	current.submitValue = scheduler->submit(queue, submitInfo, 0, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, graphicsWaits);
+	submittedCount++;
+	lastSubmitValue = current.submitValue;
+	return current.submitValue;
+}
+
+TimelineWait AsyncCompute::getWait(uint64_t value, VkPipelineStageFlags stages){
+	return { scheduler->getSemaphore(), value, stages };
+}
+
+void AsyncCompute::beginGraphics(VkCommandBuffer commandBuffer, int frame){
+
+	Frame &current = frames[frame];
+	current.graphicsRecorded = timestampsSupported;
+	if (current.graphicsRecorded) {
+		deviceDispatch.vkCmdResetQueryPool(commandBuffer, current.graphicsQueries.get(), 0, 2);
+		deviceDispatch.vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, current.graphicsQueries.get(), 0);
+	}
+}
+
+void AsyncCompute::endGraphics(VkCommandBuffer commandBuffer, int frame){
+
+	Frame &current = frames[frame];
+	if (current.graphicsRecorded) {
+		deviceDispatch.vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, current.graphicsQueries.get(), 1);
+	}
+}
+
+void AsyncCompute::log(){
+
+	if (measuredFrames == 0) {
+		return;
+	}
+
+	double computeMilliseconds = computeTicks * timestampPeriod * 1.0e-6 / measuredFrames;
+	double overlapMilliseconds = overlapTicks * timestampPeriod * 1.0e-6 / measuredFrames;
+	printf("async compute on the %s queue: %.3f ms a frame, %.3f ms (%.0f%%) of it alongside graphics work\n", dedicated ? "compute" : "graphics",
+		computeMilliseconds, overlapMilliseconds, computeTicks > 0 ? 100.0 * overlapTicks / computeTicks : 0.0);
+
+	computeTicks = 0;
+	overlapTicks = 0;
+	measuredFrames = 0;
+}
+
+bool AsyncCompute::check(){
+
+	bool passed = true;
+	if (submittedCount == 0) {
+		printf("ERROR: async compute never submitted\n");
+		passed = false;
+	}
+	else if (!scheduler->isComplete(lastSubmitValue)) {
+		printf("ERROR: async compute submission %llu never finished\n", static_cast<unsigned long long>(lastSubmitValue));
+		passed = false;
+	}
+
+	// a frame's timestamps are only read when the frame comes round again, so the last few never are
+	if (timestampsSupported && submittedCount > frames.size() && timedFrames == 0) {
+		printf("ERROR: no async compute timestamps came back\n");
+		passed = false;
+	}
+
+	printf("async compute on the %s queue: %llu submissions, %llu timed\n", dedicated ? "compute" : "graphics",
+		static_cast<unsigned long long>(submittedCount), static_cast<unsigned long long>(timedFrames));
+	return passed;
+}
+
+AsyncCompute::~AsyncCompute()
+{
+}
+
+bool AsyncCompute::readTimestamps(VkQueryPool queryPool, uint64_t &begin, uint64_t &end){
+
+	// the frame has finished so this doesn't wait
+	uint64_t results[4];
+	VkResult result = deviceDispatch.vkGetQueryPoolResults(device, queryPool, 0, 2, sizeof(results), results, 2 * sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+	if ((result != VK_SUCCESS && result != VK_NOT_READY) || results[1] == 0 || results[3] == 0) {
+		return false;
+	}
+
+	begin = results[0];
+	end = results[2];
+	return true;
+}
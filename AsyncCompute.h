@@ -0,0 +1,102 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "VulkanHandles.h"
+#include "DeviceDispatch.h"
+#include "FrameScheduler.h"
+
+// Compute work submitted on its own, ahead of each frame's graphics submission, so that it can run while the
+// graphics queue is still busy with the previous frame. On a queue family with compute but no graphics it gets a
+// timeline of its own: the frame waits on it, and it waits on whatever graphics submission last read what it writes.
+// Without one it falls back to the graphics queue and timeline, in the same order, so callers don't change.
+// Both queues are timestamped around each frame's work to measure how long compute ran while graphics was busy.
+// Device timestamps only have to be comparable within a queue, in practice all queues share one counter,
+// so the overlap is an estimate
+class AsyncCompute
+{
+public:
+	AsyncCompute();
+
+	// queue is of queueFamily, the graphics queue and family when there's no family for compute alone
+	void create(VkPhysicalDevice physicalDevice, VkDevice newDevice, VkQueue newQueue, uint32_t queueFamily, uint32_t graphicsQueueFamily,
+		FrameScheduler * newGraphicsScheduler, int framesInFlight);
+	void destroy();
+
+	bool isDedicated();							// on a queue of its own
+
+	// -- FRAME --
+	// take the frame's timestamps, after waiting on its graphics submission (which waited on its compute)
+	void collect(int frame);
+
+	// the frame's compute command buffer, recording
+	VkCommandBuffer begin(int frame);
+	// submit it once graphicsWaitValue (on the graphics timeline, 0 for none) is reached. returns the value to wait on
+	uint64_t submit(int frame, uint64_t graphicsWaitValue);
+	// for the graphics submission that reads value's results at stages
+	TimelineWait getWait(uint64_t value, VkPipelineStageFlags stages);
+
+	// - Graphics timestamps
+	// at the start and end of the frame's graphics command buffer, outside a render pass
+	void beginGraphics(VkCommandBuffer commandBuffer, int frame);
+	void endGraphics(VkCommandBuffer commandBuffer, int frame);
+
+	// - Statistics
+	// average compute time and how much of it overlapped graphics work since the last log, then start over
+	void log();
+
+	// whether everything submitted has finished and, with timestamps, some frames were timed, once nothing
+	// is recording. prints what is missing
+	bool check();
+
+	~AsyncCompute();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	VkQueue queue = VK_NULL_HANDLE;
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+
+	// own timeline on a dedicated queue, otherwise the graphics one
+	FrameScheduler computeScheduler;
+	FrameScheduler * graphicsScheduler = nullptr;
+	FrameScheduler * scheduler = nullptr;
+	bool dedicated = false;
+
+	// - Timestamps
+	bool timestampsSupported = false;			// both families have them
+	double timestampPeriod = 1.0;				// nanoseconds per tick
+	uint64_t timestampMask = ~0ull;				// valid bits of both families' timestamps
+
+	// - Frames
+	struct Frame {
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		uint64_t submitValue = 0;				// on scheduler's timeline
+		UniqueQueryPool computeQueries;			// begin and end of the compute work
+		UniqueQueryPool graphicsQueries;		// and of the graphics work
+		bool computeRecorded = false;
+		bool graphicsRecorded = false;
+	};
+	std::vector<Frame> frames;
+
+	// the last collected frame's graphics work, which the next frame's compute was submitted alongside
+	uint64_t previousGraphicsBegin = 0;
+	uint64_t previousGraphicsEnd = 0;
+	bool previousGraphicsValid = false;
+
+	// totals since the last log, in ticks
+	uint64_t computeTicks = 0;
+	uint64_t overlapTicks = 0;
+	uint32_t measuredFrames = 0;
+
+	// since create, for check
+	uint64_t submittedCount = 0;
+	uint64_t lastSubmitValue = 0;
+	uint64_t timedFrames = 0;
+
+	// begin and end of a pool, false if they aren't available
+	bool readTimestamps(VkQueryPool queryPool, uint64_t &begin, uint64_t &end);
+};
@@ -0,0 +1,182 @@
+#include "ComputePipeline.h"
+
+ComputePipeline::ComputePipeline()
+{
+}
+
+void ComputePipeline::create(VkDevice newDevice, ShaderManager * shaderManager, const std::string &shaderPath, uint32_t newStorageBufferCount,
+	uint32_t newPushConstantSize, uint32_t maxSets){
+
+	device = newDevice;
+	storageBufferCount = newStorageBufferCount;
+	pushConstantSize = newPushConstantSize;
+
+	// -- DESCRIPTOR SET LAYOUT --
+	std::vector<VkDescriptorSetLayoutBinding> bindings(storageBufferCount);
+	for (uint32_t i = 0; i < storageBufferCount; i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutCreateInfo.bindingCount = storageBufferCount;
+	layoutCreateInfo.pBindings = bindings.data();
+
+	VkDescriptorSetLayout layout;
+	if (vkCreateDescriptorSetLayout(device, &layoutCreateInfo, nullptr, &layout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor set layout for " + shaderPath);
+	}
+	setLayout = UniqueDescriptorSetLayout(device, layout);
+
+	// -- DESCRIPTOR POOL --
+	VkDescriptorPoolSize poolSize = {};
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount = maxSets * storageBufferCount;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = maxSets;
+	poolCreateInfo.poolSizeCount = storageBufferCount > 0 ? 1 : 0;
+	poolCreateInfo.pPoolSizes = &poolSize;
+
+	VkDescriptorPool pool;
+	if (vkCreateDescriptorPool(device, &poolCreateInfo, nullptr, &pool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor pool for " + shaderPath);
+	}
+	descriptorPool = UniqueDescriptorPool(device, pool);
+
+	// -- PIPELINE LAYOUT --
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = pushConstantSize;
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = 1;
+	pipelineLayoutCreateInfo.pSetLayouts = &layout;
+	pipelineLayoutCreateInfo.pushConstantRangeCount = pushConstantSize > 0 ? 1 : 0;
+	pipelineLayoutCreateInfo.pPushConstantRanges = pushConstantSize > 0 ? &pushConstantRange : nullptr;
+
+	VkPipelineLayout newPipelineLayout;
+	if (vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &newPipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout for " + shaderPath);
+	}
+	pipelineLayout = UniquePipelineLayout(device, newPipelineLayout);
+
+	// -- COMPUTE PIPELINE --
+	VkComputePipelineCreateInfo pipelineCreateInfo = {};
+	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineCreateInfo.stage.module = shaderManager->getModule(shaderPath);
+	pipelineCreateInfo.stage.pName = "main";
+	pipelineCreateInfo.layout = newPipelineLayout;
+
+	VkPipeline newPipeline;
+	VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &newPipeline);
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create compute pipeline for " + shaderPath);
+	}
+	pipeline = UniquePipeline(device, newPipeline);
+}
+
+void ComputePipeline::destroy(){
+
+	// sets go with their pool
+	pipeline.reset();
+	pipelineLayout.reset();
+	descriptorPool.reset();
+	setLayout.reset();
+}
+
+VkDescriptorSet ComputePipeline::createSet(const std::vector<VkBuffer> &buffers){
+
+	if (buffers.size() != storageBufferCount) {
+		throw std::runtime_error("compute descriptor set needs one buffer per binding");
+	}
+
+	VkDescriptorSetLayout layout = setLayout.get();
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool.get();
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &layout;
+
+	VkDescriptorSet set;
+	if (vkAllocateDescriptorSets(device, &allocInfo, &set) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate compute descriptor set");
+	}
+
+	std::vector<VkDescriptorBufferInfo> bufferInfos(buffers.size());
+	std::vector<VkWriteDescriptorSet> writes(buffers.size());
+	for (uint32_t i = 0; i < buffers.size(); i++) {
+		bufferInfos[i].buffer = buffers[i];
+		bufferInfos[i].offset = 0;
+		bufferInfos[i].range = VK_WHOLE_SIZE;
+
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = set;
+		writes[i].dstBinding = i;
+		writes[i].descriptorCount = 1;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[i].pBufferInfo = &bufferInfos[i];
+	}
+	vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+	return set;
+}
+
+void ComputePipeline::recordDispatch(VkCommandBuffer commandBuffer, VkDescriptorSet set, const void * pushConstants,
+	uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ){
+
+	bind(commandBuffer, set, pushConstants);
+	deviceDispatch.vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+}
+
+void ComputePipeline::recordDispatchIndirect(VkCommandBuffer commandBuffer, VkDescriptorSet set, const void * pushConstants, VkBuffer buffer, VkDeviceSize offset){
+
+	bind(commandBuffer, set, pushConstants);
+	deviceDispatch.vkCmdDispatchIndirect(commandBuffer, buffer, offset);
+}
+
+void ComputePipeline::recordBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStages, VkAccessFlags srcAccess,
+	VkPipelineStageFlags dstStages, VkAccessFlags dstAccess){
+
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+
+	deviceDispatch.vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void ComputePipeline::createStorageBuffer(VkPhysicalDevice physicalDevice, VkDevice device, DeviceAllocator * allocator, VkDeviceSize size,
+	VkBufferUsageFlags extraUsage, UniqueBuffer * buffer, UniqueDeviceMemory * memory, const std::vector<uint32_t> &queueFamilies){
+
+	// transfer destination so it can be cleared with vkCmdFillBuffer
+	VkBuffer newBuffer;
+	VkDeviceMemory newMemory;
+	createBuffer(physicalDevice, device, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | extraUsage,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &newBuffer, &newMemory, allocator, queueFamilies);
+	*memory = UniqueDeviceMemory(allocator, newMemory);
+	*buffer = UniqueBuffer(device, newBuffer);
+}
+
+ComputePipeline::~ComputePipeline()
+{
+}
+
+void ComputePipeline::bind(VkCommandBuffer commandBuffer, VkDescriptorSet set, const void * pushConstants){
+
+	deviceDispatch.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.get());
+	deviceDispatch.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout.get(), 0, 1, &set, 0, nullptr);
+	if (pushConstantSize > 0) {
+		deviceDispatch.vkCmdPushConstants(commandBuffer, pipelineLayout.get(), VK_SHADER_STAGE_COMPUTE_BIT, 0, pushConstantSize, pushConstants);
+	}
+}
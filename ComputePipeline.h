@@ -0,0 +1,59 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Utilities.h"
+#include "VulkanHandles.h"
+#include "ShaderManager.h"
+#include "DeviceDispatch.h"
+
+// One compute kernel: a shader reading and writing storage buffers (set 0, bindings 0 to storageBufferCount - 1)
+// with optional push constants, its pipeline, and a pool for the descriptor sets pointing it at buffers.
+// Kernels with the same buffer count have compatible set layouts, so a set made by one can be bound with another
+class ComputePipeline
+{
+public:
+	ComputePipeline();
+
+	void create(VkDevice newDevice, ShaderManager * shaderManager, const std::string &shaderPath, uint32_t newStorageBufferCount,
+		uint32_t newPushConstantSize, uint32_t maxSets = 1);
+	void destroy();
+
+	// set with each binding pointing at the whole of the buffer in the same position
+	VkDescriptorSet createSet(const std::vector<VkBuffer> &buffers);
+
+	// -- RECORD FUNCTIONS --
+	// pushConstants must hold the size given to create, or be nullptr without push constants
+	void recordDispatch(VkCommandBuffer commandBuffer, VkDescriptorSet set, const void * pushConstants,
+		uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
+	// group counts read from a VkDispatchIndirectCommand, e.g. written by an earlier dispatch
+	void recordDispatchIndirect(VkCommandBuffer commandBuffer, VkDescriptorSet set, const void * pushConstants, VkBuffer buffer, VkDeviceSize offset);
+
+	// memory barrier between dispatches (or a dispatch and the draws reading its results)
+	static void recordBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStages, VkAccessFlags srcAccess,
+		VkPipelineStageFlags dstStages, VkAccessFlags dstAccess);
+
+	// device local buffer for kernels to read and write, extraUsage adds e.g. vertex or indirect use.
+	// shared between queueFamilies when there's more than one, e.g. written on async compute and drawn on graphics
+	static void createStorageBuffer(VkPhysicalDevice physicalDevice, VkDevice device, DeviceAllocator * allocator, VkDeviceSize size,
+		VkBufferUsageFlags extraUsage, UniqueBuffer * buffer, UniqueDeviceMemory * memory, const std::vector<uint32_t> &queueFamilies = {});
+
+	~ComputePipeline();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	uint32_t storageBufferCount = 0;
+	uint32_t pushConstantSize = 0;
+
+	UniqueDescriptorSetLayout setLayout;
+	UniqueDescriptorPool descriptorPool;
+	UniquePipelineLayout pipelineLayout;
+	UniquePipeline pipeline;
+
+	void bind(VkCommandBuffer commandBuffer, VkDescriptorSet set, const void * pushConstants);
+};
@@ -0,0 +1,362 @@
+#include "DebugDraw.h"
+
+#include <cstring>
+#include <cmath>
+
+namespace {
+
+	// regions start on this boundary, enough for vertex buffer offsets on any device
+	const VkDeviceSize REGION_ALIGNMENT = 256;
+
+	// 3x5 glyphs for ASCII 32 to 95, three bits a row from the top row down, the left pixel in the high bit
+	const uint16_t FONT_GLYPHS[64] = {
+		0x0000, 0x2482, 0x5a00, 0x5f7d, 0x3c9e, 0x42a1, 0x2aab, 0x2400,
+		0x1491, 0x4494, 0x0aa8, 0x05d0, 0x0014, 0x01c0, 0x0002, 0x12a4,
+		0x7b6f, 0x2c97, 0x73e7, 0x72cf, 0x5bc9, 0x79cf, 0x79ef, 0x7252,
+		0x7bef, 0x7bcf, 0x0410, 0x0414, 0x1511, 0x0e38, 0x4454, 0x72c2,
+		0x7be7, 0x2bed, 0x6bae, 0x3923, 0x6b6e, 0x79a7, 0x79a4, 0x396b,
+		0x5bed, 0x7497, 0x126a, 0x5bad, 0x4927, 0x5fed, 0x6b6d, 0x2b6a,
+		0x6ba4, 0x2b73, 0x6bad, 0x388e, 0x7492, 0x5b6f, 0x5b6a, 0x5bfd,
+		0x5aad, 0x5a92, 0x72a7, 0x6926, 0x4889, 0x324b, 0x2a00, 0x0007,
+	};
+
+	// a glyph is 3 font pixels wide and 5 high, with one pixel between characters and lines
+	const float GLYPH_ADVANCE = 4.0f;
+	const float LINE_ADVANCE = 6.0f;
+
+	uint16_t findGlyph(char character){
+
+		if (character >= 'a' && character <= 'z') {
+			character = static_cast<char>(character - 'a' + 'A');
+		}
+		if (character < 32 || character > 95) {
+			character = '?';
+		}
+		return FONT_GLYPHS[character - 32];
+	}
+
+	glm::vec3 transformPoint(const glm::mat4 &transform, const glm::vec3 &point){
+
+		glm::vec4 transformed = transform * glm::vec4(point, 1.0f);
+		return glm::vec3(transformed.x, transformed.y, transformed.z) / transformed.w;
+	}
+}
+
+DebugDraw::DebugDraw()
+{
+}
+
+void DebugDraw::create(VkDevice newDevice, DeviceAllocator * newAllocator, PipelineManager * newPipelineManager,
+	VkExtent2D newScreenExtent, int framesInFlight, uint32_t newMaxVertices){
+
+	device = newDevice;
+	allocator = newAllocator;
+	pipelineManager = newPipelineManager;
+	screenExtent = newScreenExtent;
+	maxVertices = newMaxVertices;
+
+	// the identity matrix screen space triangles are drawn with comes first in every region
+	regionSize = (sizeof(glm::mat4) + static_cast<VkDeviceSize>(maxVertices) * sizeof(DebugVertex) + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT * REGION_ALIGNMENT;
+	VkDeviceSize bufferSize = regionSize * framesInFlight;
+
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = bufferSize;
+	bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkBuffer newBuffer;
+	VkResult result = vkCreateBuffer(device, &bufferInfo, nullptr, &newBuffer);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create the debug draw buffer");
+	}
+	buffer = UniqueBuffer(device, newBuffer);
+
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(device, newBuffer, &memRequirements);
+
+	// written once a frame and read once by the GPU, like the dynamic mesh: device local when the host can write it
+	VkDeviceMemory newMemory = allocator->tryAllocate(memRequirements,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	if (newMemory == VK_NULL_HANDLE) {
+		newMemory = allocator->allocate(memRequirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	}
+	memory = UniqueDeviceMemory(allocator, newMemory);
+	vkBindBufferMemory(device, newBuffer, newMemory, 0);
+
+	void * data;
+	vkMapMemory(device, newMemory, 0, bufferSize, 0, &data);
+	mapped = static_cast<uint8_t *>(data);
+
+	glm::mat4 identity = glm::mat4(1.0f);
+	for (int frame = 0; frame < framesInFlight; frame++) {
+		memcpy(mapped + frame * regionSize, &identity, sizeof(glm::mat4));
+	}
+	frames.assign(framesInFlight, FrameRegion());
+
+	// -- PIPELINES --
+	// blended, depth never written. identical states (the overlay and screen triangles) share a pipeline
+	for (int batch = 0; batch < BATCH_COUNT; batch++) {
+		PipelineState state;
+		state.vertexShader = "Shaders/debug.vert";
+		state.fragmentShader = "Shaders/debug.frag";
+		state.vertexLayout = VERTEX_LAYOUT_DEBUG;
+		state.topology = (batch == BATCH_LINES || batch == BATCH_LINES_OVERLAY) ? VK_PRIMITIVE_TOPOLOGY_LINE_LIST : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		state.cullMode = VK_CULL_MODE_NONE;
+		state.depthTestEnable = batch == BATCH_LINES || batch == BATCH_TRIANGLES;
+		state.depthWriteEnable = false;
+		pipelineHandles[batch] = pipelineManager->request(state);
+	}
+}
+
+void DebugDraw::destroy(){
+
+	// mapped memory has to be unmapped before it goes back to the allocator for recycling
+	if (mapped != nullptr) {
+		vkUnmapMemory(device, memory.get());
+		mapped = nullptr;
+	}
+	buffer.reset();
+	memory.reset();
+	frames.clear();
+	for (auto &batch : batches) {
+		batch = std::vector<DebugVertex>();
+	}
+}
+
+void DebugDraw::line(const glm::vec3 &from, const glm::vec3 &to, const glm::vec4 &color, bool overlay){
+
+	uint32_t packed = packColor(color);
+	DebugVertex * vertices = append(overlay ? BATCH_LINES_OVERLAY : BATCH_LINES, 2);
+	vertices[0] = { from, packed };
+	vertices[1] = { to, packed };
+}
+
+void DebugDraw::lines(const glm::vec3 * points, uint32_t pointCount, const glm::vec4 &color, bool overlay){
+
+	// one resize for all of them, then a plain loop the compiler can unroll
+	uint32_t packed = packColor(color);
+	pointCount -= pointCount % 2;
+	DebugVertex * vertices = append(overlay ? BATCH_LINES_OVERLAY : BATCH_LINES, pointCount);
+	for (uint32_t i = 0; i < pointCount; i++) {
+		vertices[i].position = points[i];
+		vertices[i].color = packed;
+	}
+}
+
+void DebugDraw::triangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c, const glm::vec4 &color, bool overlay){
+
+	uint32_t packed = packColor(color);
+	DebugVertex * vertices = append(overlay ? BATCH_TRIANGLES_OVERLAY : BATCH_TRIANGLES, 3);
+	vertices[0] = { a, packed };
+	vertices[1] = { b, packed };
+	vertices[2] = { c, packed };
+}
+
+void DebugDraw::box(const glm::vec3 &min, const glm::vec3 &max, const glm::vec4 &color, bool overlay){
+
+	std::array<glm::vec3, 8> corners;
+	for (int i = 0; i < 8; i++) {
+		corners[i] = glm::vec3((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+	}
+	addBoxEdges(corners, packColor(color), overlay);
+}
+
+void DebugDraw::box(const glm::mat4 &transform, const glm::vec4 &color, bool overlay){
+
+	std::array<glm::vec3, 8> corners;
+	for (int i = 0; i < 8; i++) {
+		corners[i] = transformPoint(transform, glm::vec3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f));
+	}
+	addBoxEdges(corners, packColor(color), overlay);
+}
+
+void DebugDraw::sphere(const glm::vec3 &center, float radius, const glm::vec4 &color, bool overlay, uint32_t segments){
+
+	uint32_t packed = packColor(color);
+	DebugVertex * vertices = append(overlay ? BATCH_LINES_OVERLAY : BATCH_LINES, segments * 6);
+
+	// circles in the xy, xz and yz planes, each segment from the previous point on the circle to the next
+	float step = 6.28318530718f / segments;
+	float previousCos = 1.0f;
+	float previousSin = 0.0f;
+	for (uint32_t i = 1; i <= segments; i++) {
+		float nextCos = std::cos(i * step);
+		float nextSin = std::sin(i * step);
+
+		DebugVertex * segment = vertices + (i - 1) * 6;
+		segment[0] = { center + glm::vec3(previousCos, previousSin, 0.0f) * radius, packed };
+		segment[1] = { center + glm::vec3(nextCos, nextSin, 0.0f) * radius, packed };
+		segment[2] = { center + glm::vec3(previousCos, 0.0f, previousSin) * radius, packed };
+		segment[3] = { center + glm::vec3(nextCos, 0.0f, nextSin) * radius, packed };
+		segment[4] = { center + glm::vec3(0.0f, previousCos, previousSin) * radius, packed };
+		segment[5] = { center + glm::vec3(0.0f, nextCos, nextSin) * radius, packed };
+
+		previousCos = nextCos;
+		previousSin = nextSin;
+	}
+}
+
+void DebugDraw::frustum(const glm::mat4 &viewProjection, const glm::vec4 &color, bool overlay){
+
+	// the corners of clip space taken back through the inverse
+	glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+	std::array<glm::vec3, 8> corners;
+	for (int i = 0; i < 8; i++) {
+		corners[i] = transformPoint(inverseViewProjection, glm::vec3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : 0.0f));
+	}
+	addBoxEdges(corners, packColor(color), overlay);
+}
+
+void DebugDraw::text(const glm::vec2 &position, const std::string &string, const glm::vec4 &color, float scale){
+
+	uint32_t packed = packColor(color);
+	glm::vec2 cursor = position;
+
+	for (char character : string) {
+		if (character == '\n') {
+			cursor = glm::vec2(position.x, cursor.y + LINE_ADVANCE * scale);
+			continue;
+		}
+
+		// each run of lit pixels in a row is one quad
+		uint16_t glyph = findGlyph(character);
+		for (int row = 0; row < 5; row++) {
+			int column = 0;
+			while (column < 3) {
+				if (!(glyph & (1 << (14 - row * 3 - column)))) {
+					column++;
+					continue;
+				}
+				int runStart = column;
+				while (column < 3 && (glyph & (1 << (14 - row * 3 - column)))) {
+					column++;
+				}
+				addScreenQuad(cursor + glm::vec2(runStart, row) * scale, cursor + glm::vec2(column, row + 1) * scale, packed);
+			}
+		}
+		cursor.x += GLYPH_ADVANCE * scale;
+	}
+}
+
+void DebugDraw::rect(const glm::vec2 &min, const glm::vec2 &max, const glm::vec4 &color){
+
+	addScreenQuad(min, max, packColor(color));
+}
+
+void DebugDraw::flush(int frame){
+
+	FrameRegion &region = frames[frame];
+	region = FrameRegion();
+
+	// every batch one after the other, written in order in one go (the memory may be write combined).
+	// what doesn't fit is dropped, whole primitives at a time
+	DebugVertex * destination = reinterpret_cast<DebugVertex *>(mapped + frame * regionSize + sizeof(glm::mat4));
+	uint32_t written = 0;
+	for (int batch = 0; batch < BATCH_COUNT; batch++) {
+		uint32_t primitiveSize = (batch == BATCH_LINES || batch == BATCH_LINES_OVERLAY) ? 2 : 3;
+		uint32_t count = static_cast<uint32_t>(std::min<size_t>(batches[batch].size(), maxVertices - written));
+		count -= count % primitiveSize;
+
+		memcpy(destination + written, batches[batch].data(), count * sizeof(DebugVertex));
+		region.firstVertex[batch] = written;
+		region.vertexCount[batch] = count;
+		region.droppedCount += static_cast<uint32_t>(batches[batch].size()) - count;
+		written += count;
+
+		batches[batch].clear();
+	}
+}
+
+uint32_t DebugDraw::recordDraws(VkCommandBuffer commandBuffer, int frame, bool overlay, VkBuffer transformBuffer, VkDeviceSize transformOffset){
+
+	static const Batch depthTestedBatches[] = { BATCH_LINES, BATCH_TRIANGLES };
+	static const Batch overlayBatches[] = { BATCH_LINES_OVERLAY, BATCH_TRIANGLES_OVERLAY, BATCH_SCREEN };
+
+	const Batch * drawnBatches = overlay ? overlayBatches : depthTestedBatches;
+	size_t drawnCount = overlay ? 3 : 2;
+
+	FrameRegion &region = frames[frame];
+	uint32_t drawCalls = 0;
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+
+	for (size_t i = 0; i < drawnCount; i++) {
+		Batch batch = drawnBatches[i];
+
+		// the placeholder pipeline has a different vertex input, so nothing is drawn until the batch's pipeline is ready
+		if (region.vertexCount[batch] == 0 || !pipelineManager->isReady(pipelineHandles[batch])) {
+			continue;
+		}
+
+		VkPipeline pipeline = pipelineManager->getPipeline(pipelineHandles[batch]);
+		if (pipeline != boundPipeline) {
+			deviceDispatch.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+			boundPipeline = pipeline;
+		}
+
+		// screen space triangles are already in clip space, their model matrix is the region's identity
+		VkBuffer vertexBuffers[] = { buffer.get(), batch == BATCH_SCREEN ? buffer.get() : transformBuffer };
+		VkDeviceSize offsets[] = { frame * regionSize + sizeof(glm::mat4), batch == BATCH_SCREEN ? frame * regionSize : transformOffset };
+		deviceDispatch.vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+		deviceDispatch.vkCmdDraw(commandBuffer, region.vertexCount[batch], 1, region.firstVertex[batch], 0);
+		drawCalls++;
+	}
+	return drawCalls;
+}
+
+uint32_t DebugDraw::getVertexCount(int frame){
+
+	uint32_t count = 0;
+	for (uint32_t batchCount : frames[frame].vertexCount) {
+		count += batchCount;
+	}
+	return count;
+}
+
+uint32_t DebugDraw::getDroppedCount(int frame){
+	return frames[frame].droppedCount;
+}
+
+DebugDraw::~DebugDraw()
+{
+}
+
+DebugVertex * DebugDraw::append(Batch batch, uint32_t count){
+
+	std::vector<DebugVertex> &vertices = batches[batch];
+	size_t first = vertices.size();
+	vertices.resize(first + count);
+	return vertices.data() + first;
+}
+
+void DebugDraw::addBoxEdges(const std::array<glm::vec3, 8> &corners, uint32_t color, bool overlay){
+
+	// corner i has bit 0, 1 and 2 set for the high x, y and z side, edges join corners one bit apart
+	DebugVertex * vertices = append(overlay ? BATCH_LINES_OVERLAY : BATCH_LINES, 24);
+	for (int i = 0; i < 8; i++) {
+		for (int axis = 1; axis < 8; axis <<= 1) {
+			if (!(i & axis)) {
+				*vertices++ = { corners[i], color };
+				*vertices++ = { corners[i | axis], color };
+			}
+		}
+	}
+}
+
+void DebugDraw::addScreenQuad(const glm::vec2 &min, const glm::vec2 &max, uint32_t color){
+
+	// pixels to clip space, y already points down in both
+	glm::vec2 scale = glm::vec2(2.0f / screenExtent.width, 2.0f / screenExtent.height);
+	glm::vec3 topLeft = glm::vec3(min.x * scale.x - 1.0f, min.y * scale.y - 1.0f, 0.0f);
+	glm::vec3 bottomRight = glm::vec3(max.x * scale.x - 1.0f, max.y * scale.y - 1.0f, 0.0f);
+	glm::vec3 topRight = glm::vec3(bottomRight.x, topLeft.y, 0.0f);
+	glm::vec3 bottomLeft = glm::vec3(topLeft.x, bottomRight.y, 0.0f);
+
+	DebugVertex * vertices = append(BATCH_SCREEN, 6);
+	vertices[0] = { topLeft, color };
+	vertices[1] = { topRight, color };
+	vertices[2] = { bottomRight, color };
+	vertices[3] = { topLeft, color };
+	vertices[4] = { bottomRight, color };
+	vertices[5] = { bottomLeft, color };
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <array>
+
+#include "Utilities.h"
+#include "VulkanHandles.h"
+#include "PipelineManager.h"
+
+// Immediate mode lines, shapes and text for debugging (bounds, culling results, profiler overlays).
+// Everything drawn between two flushes is accumulated on the CPU in one vertex list per batch, then flush copies
+// them all in to the frame's region of a persistently mapped buffer in one go. Each batch is a single draw:
+// lines and triangles, depth tested or overlaid on top, and screen space triangles (text and rects).
+// Scene space primitives are drawn with the scene root's transform, like dynamic geometry.
+// Not thread safe, draw from the thread that calls the renderer's draw
+class DebugDraw
+{
+public:
+	DebugDraw();
+
+	void create(VkDevice newDevice, DeviceAllocator * newAllocator, PipelineManager * newPipelineManager,
+		VkExtent2D newScreenExtent, int framesInFlight, uint32_t newMaxVertices);
+	void destroy();
+
+	// -- SCENE SPACE --
+	// overlay draws on top of everything instead of depth testing against the scene
+	void line(const glm::vec3 &from, const glm::vec3 &to, const glm::vec4 &color, bool overlay = false);
+	// pointCount / 2 segments from consecutive pairs of points, the fast way to draw many lines
+	void lines(const glm::vec3 * points, uint32_t pointCount, const glm::vec4 &color, bool overlay = false);
+	void triangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c, const glm::vec4 &color, bool overlay = false);
+	void box(const glm::vec3 &min, const glm::vec3 &max, const glm::vec4 &color, bool overlay = false);
+	// the -1 to 1 cube through transform, for oriented boxes
+	void box(const glm::mat4 &transform, const glm::vec4 &color, bool overlay = false);
+	// a circle around each axis
+	void sphere(const glm::vec3 &center, float radius, const glm::vec4 &color, bool overlay = false, uint32_t segments = 24);
+	// the volume a view projection matrix sees (depth 0 to 1)
+	void frustum(const glm::mat4 &viewProjection, const glm::vec4 &color, bool overlay = false);
+
+	// -- SCREEN SPACE --
+	// in pixels from the top left, always on top. text uses a built in 3x5 font (ASCII 32 to 95, lower case
+	// drawn as upper case) with each font pixel scale pixels wide, '\n' starts a new line
+	void text(const glm::vec2 &position, const std::string &string, const glm::vec4 &color, float scale = 2.0f);
+	void rect(const glm::vec2 &min, const glm::vec2 &max, const glm::vec4 &color);
+
+	// -- FRAME --
+	// once the GPU has finished with the frame's region: copy everything drawn since the last flush in to it and start over
+	void flush(int frame);
+
+	// the depth tested or the overlay batches of the frame, inside a render pass. scene space batches read their model
+	// matrix from transformBuffer at transformOffset. returns the draw calls recorded
+	uint32_t recordDraws(VkCommandBuffer commandBuffer, int frame, bool overlay, VkBuffer transformBuffer, VkDeviceSize transformOffset);
+
+	// - Statistics
+	uint32_t getVertexCount(int frame);				// flushed for the frame
+	uint32_t getDroppedCount(int frame);			// vertices that didn't fit in the frame's region
+
+	~DebugDraw();
+
+private:
+	enum Batch {
+		BATCH_LINES,
+		BATCH_TRIANGLES,
+		BATCH_LINES_OVERLAY,
+		BATCH_TRIANGLES_OVERLAY,
+		BATCH_SCREEN,								// screen space triangles, always on top
+		BATCH_COUNT
+	};
+
+	VkDevice device = VK_NULL_HANDLE;
+	DeviceAllocator * allocator = nullptr;
+	PipelineManager * pipelineManager = nullptr;
+	VkExtent2D screenExtent = {};
+	uint32_t maxVertices = 0;
+	VkDeviceSize regionSize = 0;					// one frame's identity matrix then vertices
+
+	// memory declared before its buffer, so the buffer is destroyed first
+	UniqueDeviceMemory memory;
+	UniqueBuffer buffer;
+	uint8_t * mapped = nullptr;
+
+	std::array<uint64_t, BATCH_COUNT> pipelineHandles = {};
+	std::array<std::vector<DebugVertex>, BATCH_COUNT> batches;		// drawn since the last flush, keeps its capacity
+
+	// - Per frame region
+	struct FrameRegion {
+		std::array<uint32_t, BATCH_COUNT> firstVertex = {};
+		std::array<uint32_t, BATCH_COUNT> vertexCount = {};
+		uint32_t droppedCount = 0;
+	};
+	std::vector<FrameRegion> frames;
+
+	// room for count vertices at the end of a batch
+	DebugVertex * append(Batch batch, uint32_t count);
+	void addBoxEdges(const std::array<glm::vec3, 8> &corners, uint32_t color, bool overlay);
+	void addScreenQuad(const glm::vec2 &min, const glm::vec2 &max, uint32_t color);
+};
@@ -0,0 +1,86 @@
+#include "DeletionQueue.h"
+
+#include <algorithm>
+#include <limits>
+
+DeletionQueue::DeletionQueue(){
+
+}
+
+void DeletionQueue::create(VkDevice newDevice, FrameScheduler * newScheduler, DeviceAllocator * newAllocator){
+	device = newDevice;
+	scheduler = newScheduler;
+	allocator = newAllocator;
+}
+
+template <typename T, typename DestroyFunction>
+void DeletionQueue::drain(std::deque<RetiredResource<T>> &resources, uint64_t completedValue, DestroyFunction destroyResource){
+
+	// values only increase, so stop at the first resource the GPU may still be using
+	while (!resources.empty() && resources.front().value <= completedValue) {
+		destroyResource(resources.front().handle);
+		resources.pop_front();
+	}
+}
+
+void DeletionQueue::retireBuffer(VkBuffer buffer, uint64_t value){
+	std::lock_guard<std::mutex> lock(queueMutex);
+	buffers.push_back({ getRetireValue(value), buffer });
+}
+
+void DeletionQueue::retireMemory(VkDeviceMemory memory, uint64_t value){
+	std::lock_guard<std::mutex> lock(queueMutex);
+	memoryBlocks.push_back({ getRetireValue(value), memory });
+}
+
+void DeletionQueue::retirePipeline(VkPipeline pipeline, uint64_t value){
+	std::lock_guard<std::mutex> lock(queueMutex);
+	pipelines.push_back({ getRetireValue(value), pipeline });
+}
+
+void DeletionQueue::retireImageView(VkImageView imageView, uint64_t value){
+	std::lock_guard<std::mutex> lock(queueMutex);
+	imageViews.push_back({ getRetireValue(value), imageView });
+}
+
+void DeletionQueue::collect(){
+
+	uint64_t completedValue = scheduler->getCompletedValue();
+
+	std::lock_guard<std::mutex> lock(queueMutex);
+
+	// resources go before the memory bound to them
+	drain(buffers, completedValue, [this](VkBuffer buffer) { vkDestroyBuffer(device, buffer, nullptr); });
+	drain(pipelines, completedValue, [this](VkPipeline pipeline) { vkDestroyPipeline(device, pipeline, nullptr); });
+	drain(imageViews, completedValue, [this](VkImageView imageView) { vkDestroyImageView(device, imageView, nullptr); });
+
+	// freed memory goes back to the allocator to be recycled
+	drain(memoryBlocks, completedValue, [this](VkDeviceMemory memory) { allocator->free(memory); });
+}
+
+void DeletionQueue::flush(){
+
+	std::lock_guard<std::mutex> lock(queueMutex);
+
+	uint64_t everything = std::numeric_limits<uint64_t>::max();
+	drain(buffers, everything, [this](VkBuffer buffer) { vkDestroyBuffer(device, buffer, nullptr); });
+	drain(pipelines, everything, [this](VkPipeline pipeline) { vkDestroyPipeline(device, pipeline, nullptr); });
+	drain(imageViews, everything, [this](VkImageView imageView) { vkDestroyImageView(device, imageView, nullptr); });
+	drain(memoryBlocks, everything, [this](VkDeviceMemory memory) { allocator->free(memory); });
+}
+
+DeletionQueue::~DeletionQueue(){
+
+}
+
+uint64_t DeletionQueue::getRetireValue(uint64_t value){
+
+	// by default wait for everything already submitted, since any of it may reference the resource
+	if (value == 0) {
+		value = scheduler->getLastSubmittedValue();
+	}
+
+	// waiting longer than needed is always safe, so never let values go backwards
+	lastRetiredValue = std::max(lastRetiredValue, value);
+	return lastRetiredValue;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <deque>
+#include <mutex>
+
+#include "FrameScheduler.h"
+#include "DeviceAllocator.h"
+
+// Holds GPU resources that have been removed but may still be used by submitted work.
+// Each resource is tagged with a timeline value and only destroyed once the GPU reaches it,
+// so content can be swapped out while frames are in flight without a vkDeviceWaitIdle
+class DeletionQueue
+{
+public:
+	DeletionQueue();
+
+	void create(VkDevice newDevice, FrameScheduler * newScheduler, DeviceAllocator * newAllocator);
+
+	// retire a resource until the given timeline value (0 = until everything submitted so far has finished)
+	void retireBuffer(VkBuffer buffer, uint64_t value = 0);
+	void retireMemory(VkDeviceMemory memory, uint64_t value = 0);
+	void retirePipeline(VkPipeline pipeline, uint64_t value = 0);
+	void retireImageView(VkImageView imageView, uint64_t value = 0);
+
+	// destroy resources whose timeline value has been reached
+	void collect();
+
+	// destroy everything, device must be idle
+	void flush();
+
+	~DeletionQueue();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	FrameScheduler * scheduler = nullptr;
+	DeviceAllocator * allocator = nullptr;
+
+	template <typename T>
+	struct RetiredResource {
+		uint64_t value;
+		T handle;
+	};
+
+	std::mutex queueMutex;
+	uint64_t lastRetiredValue = 0;		// values are kept increasing so each queue can be drained from the front
+
+	std::deque<RetiredResource<VkBuffer>> buffers;
+	std::deque<RetiredResource<VkDeviceMemory>> memoryBlocks;
+	std::deque<RetiredResource<VkPipeline>> pipelines;
+	std::deque<RetiredResource<VkImageView>> imageViews;
+
+	uint64_t getRetireValue(uint64_t value);
+
+	template <typename T, typename DestroyFunction>
+	void drain(std::deque<RetiredResource<T>> &resources, uint64_t completedValue, DestroyFunction destroyResource);
+};
@@ -0,0 +1,265 @@
+#include "DeviceAllocator.h"
+
+#include "Utilities.h"
+
+DeviceAllocator::DeviceAllocator(){
+
+}
+
+void DeviceAllocator::create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, bool newMemoryBudgetEnabled){
+	physicalDevice = newPhysicalDevice;
+	device = newDevice;
+	memoryBudgetEnabled = newMemoryBudgetEnabled;
+
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+	heapAllocatedBytes.assign(memoryProperties.memoryHeapCount, 0);
+	heapAllocatedAtQuery.assign(memoryProperties.memoryHeapCount, 0);
+
+	// budgets are reported per heap, the device local one is what resources are mostly placed in
+	bool foundDeviceLocal = false;
+	for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+		const VkMemoryHeap &heap = memoryProperties.memoryHeaps[i];
+		if ((heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) && (!foundDeviceLocal || heap.size > memoryProperties.memoryHeaps[deviceLocalHeap].size)) {
+			deviceLocalHeap = i;
+			foundDeviceLocal = true;
+		}
+	}
+
+	updateBudget();
+}
+
+void DeviceAllocator::destroy(){
+
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+
+	// only recycled blocks are owned here, live memory is freed by whoever allocated it
+	releaseRecycledBlocks();
+}
+
+VkDeviceMemory DeviceAllocator::allocate(const VkMemoryRequirements &memRequirements, VkMemoryPropertyFlags properties){
+
+	VkDeviceMemory memory = tryAllocate(memRequirements, properties);
+	if (memory == VK_NULL_HANDLE)
+	{
+		throw std::runtime_error("Failed to allocate Device Memory!");
+	}
+	return memory;
+}
+
+VkDeviceMemory DeviceAllocator::tryAllocate(const VkMemoryRequirements &memRequirements, VkMemoryPropertyFlags properties){
+
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+
+	uint32_t memoryTypeIndex;
+	if (!chooseMemoryType(memRequirements.memoryTypeBits, properties, memRequirements.size, &memoryTypeIndex)) {
+		return VK_NULL_HANDLE;
+	}
+
+	// look for the smallest recycled block of the same type that fits without wasting more than half of it
+	size_t bestBlock = freeBlocks.size();
+	for (size_t i = 0; i < freeBlocks.size(); i++) {
+
+		const Allocation &allocation = freeBlocks[i].allocation;
+		if (allocation.memoryTypeIndex != memoryTypeIndex || allocation.size < memRequirements.size || allocation.size > memRequirements.size * 2) {
+			continue;
+		}
+
+		if (bestBlock == freeBlocks.size() || allocation.size < freeBlocks[bestBlock].allocation.size) {
+			bestBlock = i;
+		}
+	}
+
+	if (bestBlock != freeBlocks.size()) {
+
+		// recycled memory always starts at offset 0, so any alignment requirement is met
+		FreeBlock block = freeBlocks[bestBlock];
+		freeBlocks[bestBlock] = freeBlocks.back();
+		freeBlocks.pop_back();
+
+		recycledBytes -= block.allocation.size;
+		liveAllocations[block.memory] = block.allocation;
+		return block.memory;
+	}
+
+	// nothing to recycle, allocate new memory from the driver
+	VkMemoryAllocateInfo memoryAllocInfo = {};
+	memoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memoryAllocInfo.allocationSize = memRequirements.size;
+	memoryAllocInfo.memoryTypeIndex = memoryTypeIndex;
+
+	VkDeviceMemory memory;
+	VkResult result = vkAllocateMemory(device, &memoryAllocInfo, nullptr, &memory);
+
+	// blocks kept for recycling may be what is in the way, give them back and try once more
+	if ((result == VK_ERROR_OUT_OF_DEVICE_MEMORY || result == VK_ERROR_OUT_OF_HOST_MEMORY) && !freeBlocks.empty()) {
+		releaseRecycledBlocks();
+		result = vkAllocateMemory(device, &memoryAllocInfo, nullptr, &memory);
+	}
+
+	if (result != VK_SUCCESS)
+	{
+		return VK_NULL_HANDLE;
+	}
+
+	liveAllocations[memory] = { memoryTypeIndex, memRequirements.size };
+	allocatedBytes += memRequirements.size;
+	heapAllocatedBytes[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex] += memRequirements.size;
+
+	return memory;
+}
+
+void DeviceAllocator::free(VkDeviceMemory memory){
+
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+
+	auto allocation = liveAllocations.find(memory);
+	if (allocation == liveAllocations.end()) {
+		throw std::runtime_error("Freeing memory that was not allocated by this allocator!");
+	}
+
+	FreeBlock block = { memory, allocation->second };
+	liveAllocations.erase(allocation);
+
+	// keep the block for recycling while under the limit, otherwise release it
+	if (recycledBytes + block.allocation.size <= maxRecycledBytes) {
+		freeBlocks.push_back(block);
+		recycledBytes += block.allocation.size;
+	}
+	else
+	{
+		vkFreeMemory(device, memory, nullptr);
+		allocatedBytes -= block.allocation.size;
+		heapAllocatedBytes[memoryProperties.memoryTypes[block.allocation.memoryTypeIndex].heapIndex] -= block.allocation.size;
+	}
+}
+
+VkDeviceSize DeviceAllocator::getSize(VkDeviceMemory memory){
+
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+
+	auto allocation = liveAllocations.find(memory);
+	if (allocation == liveAllocations.end()) {
+		throw std::runtime_error("Memory was not allocated by this allocator!");
+	}
+	return allocation->second.size;
+}
+
+uint32_t DeviceAllocator::getMemoryTypeIndex(VkDeviceMemory memory){
+
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+
+	auto allocation = liveAllocations.find(memory);
+	if (allocation == liveAllocations.end()) {
+		throw std::runtime_error("Memory was not allocated by this allocator!");
+	}
+	return allocation->second.memoryTypeIndex;
+}
+
+VkMemoryPropertyFlags DeviceAllocator::getPropertyFlags(VkDeviceMemory memory){
+	return memoryProperties.memoryTypes[getMemoryTypeIndex(memory)].propertyFlags;
+}
+
+VkDeviceSize DeviceAllocator::getAllocatedBytes(){
+
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+	return allocatedBytes;
+}
+
+VkDeviceSize DeviceAllocator::getRecycledBytes(){
+
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+	return recycledBytes;
+}
+
+void DeviceAllocator::updateBudget(){
+
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+
+	heapBudgets.resize(memoryProperties.memoryHeapCount);
+	heapAllocatedAtQuery = heapAllocatedBytes;
+
+	if (memoryBudgetEnabled) {
+
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+		budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+		VkPhysicalDeviceMemoryProperties2 properties = {};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		properties.pNext = &budgetProperties;
+		vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &properties);
+
+		for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+			heapBudgets[i].budget = budgetProperties.heapBudget[i];
+			heapBudgets[i].usage = budgetProperties.heapUsage[i];
+		}
+		return;
+	}
+
+	// without the extension only this allocator's memory is known about, so leave a margin for everything else
+	for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+		heapBudgets[i].budget = memoryProperties.memoryHeaps[i].size / 10 * 8;
+		heapBudgets[i].usage = heapAllocatedBytes[i];
+	}
+}
+
+std::vector<MemoryHeapBudget> DeviceAllocator::getHeapBudgets(){
+
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+
+	std::vector<MemoryHeapBudget> budgets(heapBudgets.size());
+	for (uint32_t i = 0; i < budgets.size(); i++) {
+		budgets[i] = getCurrentBudget(i);
+	}
+	return budgets;
+}
+
+MemoryHeapBudget DeviceAllocator::getDeviceLocalBudget(){
+
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+	return getCurrentBudget(deviceLocalHeap);
+}
+
+DeviceAllocator::~DeviceAllocator(){
+
+}
+
+bool DeviceAllocator::chooseMemoryType(uint32_t allowedTypes, VkMemoryPropertyFlags properties, VkDeviceSize size, uint32_t * memoryTypeIndex){
+
+	// first type with the properties whose heap can take the allocation, otherwise the first with the properties
+	// (the driver has the final say, and may still find room)
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+
+		const VkMemoryType &type = memoryProperties.memoryTypes[i];
+		if (!(allowedTypes & (1 << i)) || (type.propertyFlags & properties) != properties) {
+			continue;
+		}
+
+		MemoryHeapBudget budget = getCurrentBudget(type.heapIndex);
+		if (budget.usage + size <= budget.budget) {
+			*memoryTypeIndex = i;
+			return true;
+		}
+	}
+
+	return findMemoryTypeIndex(physicalDevice, allowedTypes, properties, memoryTypeIndex);
+}
+
+MemoryHeapBudget DeviceAllocator::getCurrentBudget(uint32_t heap){
+
+	// usage moves with this allocator's own allocations until the next query
+	MemoryHeapBudget budget = heapBudgets[heap];
+	VkDeviceSize usage = budget.usage + heapAllocatedBytes[heap];
+	budget.usage = usage > heapAllocatedAtQuery[heap] ? usage - heapAllocatedAtQuery[heap] : 0;
+	return budget;
+}
+
+void DeviceAllocator::releaseRecycledBlocks(){
+
+	for (auto &block : freeBlocks) {
+		vkFreeMemory(device, block.memory, nullptr);
+		allocatedBytes -= block.allocation.size;
+		heapAllocatedBytes[memoryProperties.memoryTypes[block.allocation.memoryTypeIndex].heapIndex] -= block.allocation.size;
+	}
+	freeBlocks.clear();
+	recycledBytes = 0;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+// how much of a memory heap may be used, and how much is
+struct MemoryHeapBudget {
+	VkDeviceSize budget;
+	VkDeviceSize usage;
+};
+
+// Hands out VkDeviceMemory for buffers and keeps freed blocks around so they can be
+// recycled by later allocations of the same memory type instead of going back to the driver.
+// Usage is tracked per heap against a budget, from VK_EXT_memory_budget when the device has it (which also counts
+// other processes), otherwise from this allocator's own allocations against most of the heap's size.
+// Memory comes from the first matching type whose heap has room, and recycled blocks are released to retry an
+// allocation the driver refuses
+class DeviceAllocator
+{
+public:
+	DeviceAllocator();
+
+	void create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, bool newMemoryBudgetEnabled = false);
+	void destroy();
+
+	VkDeviceMemory allocate(const VkMemoryRequirements &memRequirements, VkMemoryPropertyFlags properties);
+	// VK_NULL_HANDLE instead of throwing when no type has the properties or the driver is out of memory,
+	// for allocations with a fallback (e.g. device local host visible memory, then host memory)
+	VkDeviceMemory tryAllocate(const VkMemoryRequirements &memRequirements, VkMemoryPropertyFlags properties);
+	void free(VkDeviceMemory memory);
+
+	// size of a live allocation, for resources accounting for the memory they hold
+	VkDeviceSize getSize(VkDeviceMemory memory);
+	// memory type a live allocation came from, which may have more properties than were asked for
+	uint32_t getMemoryTypeIndex(VkDeviceMemory memory);
+	VkMemoryPropertyFlags getPropertyFlags(VkDeviceMemory memory);
+
+	VkDeviceSize getAllocatedBytes();
+	VkDeviceSize getRecycledBytes();
+
+	// re-query the budget, once a frame is enough. usage includes allocations made since the last query
+	void updateBudget();
+	std::vector<MemoryHeapBudget> getHeapBudgets();
+	MemoryHeapBudget getDeviceLocalBudget();		// largest device local heap
+
+	~DeviceAllocator();
+
+private:
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	VkPhysicalDeviceMemoryProperties memoryProperties = {};
+
+	struct Allocation {
+		uint32_t memoryTypeIndex;
+		VkDeviceSize size;
+	};
+
+	struct FreeBlock {
+		VkDeviceMemory memory;
+		Allocation allocation;
+	};
+
+	std::mutex allocatorMutex;
+	std::unordered_map<VkDeviceMemory, Allocation> liveAllocations;		// memory currently bound to a resource
+	std::vector<FreeBlock> freeBlocks;										// freed memory waiting to be recycled
+
+	VkDeviceSize allocatedBytes = 0;
+	VkDeviceSize recycledBytes = 0;
+	VkDeviceSize maxRecycledBytes = 64 * 1024 * 1024;						// anything freed beyond this goes back to the driver
+
+	// - Budget
+	bool memoryBudgetEnabled = false;
+	uint32_t deviceLocalHeap = 0;
+	std::vector<VkDeviceSize> heapAllocatedBytes;							// driver allocations, recycled blocks included
+	std::vector<VkDeviceSize> heapAllocatedAtQuery;							// heapAllocatedBytes when the budget was queried
+	std::vector<MemoryHeapBudget> heapBudgets;								// as of the last query
+
+	bool chooseMemoryType(uint32_t allowedTypes, VkMemoryPropertyFlags properties, VkDeviceSize size, uint32_t * memoryTypeIndex);
+	MemoryHeapBudget getCurrentBudget(uint32_t heap);
+	void releaseRecycledBlocks();
+};
@@ -0,0 +1,21 @@
+#include "DeviceDispatch.h"
+
+#include <string>
+
+DeviceDispatch deviceDispatch;
+
+void DeviceDispatch::load(VkDevice device){
+
+#define DEVICE_DISPATCH_LOAD(name) \
+	name = reinterpret_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name)); \
+	if (name == nullptr) { \
+		throw std::runtime_error(std::string("failed to load ") + #name); \
+	}
+	DEVICE_DISPATCH_COMMANDS(DEVICE_DISPATCH_LOAD)
+#undef DEVICE_DISPATCH_LOAD
+
+#define DEVICE_DISPATCH_LOAD_EXTENSION(name) \
+	name = reinterpret_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name));
+	DEVICE_DISPATCH_EXTENSION_COMMANDS(DEVICE_DISPATCH_LOAD_EXTENSION)
+#undef DEVICE_DISPATCH_LOAD_EXTENSION
+}
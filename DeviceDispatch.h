@@ -0,0 +1,65 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+
+// device commands recorded or called every frame. the table below is generated from this list, add a command here
+// and it is loaded with the rest
+#define DEVICE_DISPATCH_COMMANDS(X) \
+	X(vkBeginCommandBuffer) \
+	X(vkEndCommandBuffer) \
+	X(vkQueueSubmit) \
+	X(vkWaitSemaphores) \
+	X(vkGetSemaphoreCounterValue) \
+	X(vkGetQueryPoolResults) \
+	X(vkCmdBeginRenderPass) \
+	X(vkCmdEndRenderPass) \
+	X(vkCmdBindPipeline) \
+	X(vkCmdBindDescriptorSets) \
+	X(vkCmdBindVertexBuffers) \
+	X(vkCmdBindIndexBuffer) \
+	X(vkCmdPushConstants) \
+	X(vkCmdDraw) \
+	X(vkCmdDrawIndexed) \
+	X(vkCmdDrawIndexedIndirect) \
+	X(vkCmdDrawIndexedIndirectCount) \
+	X(vkCmdDrawIndirect) \
+	X(vkCmdDispatch) \
+	X(vkCmdDispatchIndirect) \
+	X(vkCmdPipelineBarrier) \
+	X(vkCmdCopyBuffer) \
+	X(vkCmdCopyBufferToImage) \
+	X(vkCmdCopyImageToBuffer) \
+	X(vkCmdBlitImage) \
+	X(vkCmdFillBuffer) \
+	X(vkCmdResetQueryPool) \
+	X(vkCmdWriteTimestamp) \
+	X(vkCmdBeginQuery) \
+	X(vkCmdEndQuery)
+
+// extension commands, null unless their extension is enabled on the device (the swapchain's too, when rendering headless)
+#define DEVICE_DISPATCH_EXTENSION_COMMANDS(X) \
+	X(vkQueuePresentKHR) \
+	X(vkAcquireNextImageKHR) \
+	X(vkCmdDrawMeshTasksEXT) \
+	X(vkCmdBeginRenderingKHR) \
+	X(vkCmdEndRenderingKHR) \
+	X(vkGetCalibratedTimestampsEXT)
+
+// Device level function pointers fetched once with vkGetDeviceProcAddr. Calls through the loader's exported
+// symbols go through a trampoline that looks up the device's dispatch table every time, these go straight to the
+// driver (or the first layer). There is one logical device, so the table is global like the loader's symbols
+struct DeviceDispatch {
+
+#define DEVICE_DISPATCH_MEMBER(name) PFN_##name name = nullptr;
+	DEVICE_DISPATCH_COMMANDS(DEVICE_DISPATCH_MEMBER)
+	DEVICE_DISPATCH_EXTENSION_COMMANDS(DEVICE_DISPATCH_MEMBER)
+#undef DEVICE_DISPATCH_MEMBER
+
+	// right after the device is created, before anything records. throws if a core command is missing
+	void load(VkDevice device);
+};
+
+extern DeviceDispatch deviceDispatch;
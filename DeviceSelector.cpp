@@ -0,0 +1,198 @@
+#include "DeviceSelector.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+namespace {
+
+	// each device type is a tier this far apart, everything else a device scores for stays well below it
+	const int64_t TYPE_TIER = 1000000;
+}
+
+DeviceCandidate DeviceSelector::describe(VkPhysicalDevice device, const std::vector<const char *> &optionalExtensions){
+
+	DeviceCandidate candidate;
+	candidate.device = device;
+
+	// -- PROPERTIES --
+	VkPhysicalDeviceIDProperties idProperties = {};
+	idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+	VkPhysicalDeviceProperties2 deviceProperties = {};
+	deviceProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	deviceProperties.pNext = &idProperties;
+	vkGetPhysicalDeviceProperties2(device, &deviceProperties);
+
+	candidate.name = deviceProperties.properties.deviceName;
+	candidate.type = deviceProperties.properties.deviceType;
+
+	char hexDigits[3];
+	for (uint32_t i = 0; i < VK_UUID_SIZE; i++) {
+		snprintf(hexDigits, sizeof(hexDigits), "%02x", idProperties.deviceUUID[i]);
+		candidate.uuid += hexDigits;
+	}
+
+	const VkPhysicalDeviceLimits &limits = deviceProperties.properties.limits;
+	candidate.maxImageDimension2D = limits.maxImageDimension2D;
+	candidate.maxComputeSharedMemorySize = limits.maxComputeSharedMemorySize;
+
+	// the limit can be above 1 while the feature is missing, only the feature lets draws be batched
+	VkPhysicalDeviceFeatures features;
+	vkGetPhysicalDeviceFeatures(device, &features);
+	candidate.multiDrawIndirect = features.multiDrawIndirect == VK_TRUE;
+
+	// -- MEMORY --
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
+
+	for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+		if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+			candidate.deviceLocalBytes = std::max(candidate.deviceLocalBytes, memoryProperties.memoryHeaps[i].size);
+		}
+	}
+
+	// -- QUEUES --
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilyList(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilyList.data());
+
+	for (const auto &queueFamily : queueFamilyList) {
+		if (queueFamily.queueCount == 0 || (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+			continue;
+		}
+		if (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) {
+			candidate.asyncComputeFamily = true;
+		}
+		else if (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT)
+		{
+			candidate.transferFamily = true;
+		}
+	}
+
+	// -- EXTENSIONS --
+	uint32_t extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+	std::vector<VkExtensionProperties> extensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+
+	for (const char * optionalExtension : optionalExtensions) {
+		for (const auto &extension : extensions) {
+			if (strcmp(optionalExtension, extension.extensionName) == 0) {
+				candidate.optionalExtensionCount++;
+				break;
+			}
+		}
+	}
+
+	return candidate;
+}
+
+int64_t DeviceSelector::score(const DeviceCandidate &candidate){
+
+	if (!candidate.suitable) {
+		return -1;
+	}
+
+	// type outweighs everything else put together, a discrete GPU is always worth more than an integrated one
+	int64_t score = 0;
+	switch (candidate.type) {
+	case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:		score += 4 * TYPE_TIER; break;
+	case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:	score += 3 * TYPE_TIER; break;
+	case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:		score += 2 * TYPE_TIER; break;
+	case VK_PHYSICAL_DEVICE_TYPE_CPU:				score += 0; break;
+	default:										score += TYPE_TIER; break;
+	}
+
+	// 1 per 16 MiB, up to 32 GiB
+	VkDeviceSize memoryMiB = candidate.deviceLocalBytes / (1024 * 1024);
+	score += static_cast<int64_t>(std::min<VkDeviceSize>(memoryMiB, 32768) / 16);
+
+	// queues the renderer can spread work over
+	score += candidate.presentOnGraphicsFamily ? 1000 : 0;
+	score += candidate.asyncComputeFamily ? 1500 : 0;
+	score += candidate.transferFamily ? 1000 : 0;
+
+	// optional features, each lets the renderer take a faster path
+	score += candidate.optionalExtensionCount * 2000;
+	score += candidate.multiDrawIndirect ? 2000 : 0;
+
+	// limits, only enough to break ties between otherwise similar devices. capped, drivers report odd values
+	score += std::min<uint32_t>(candidate.maxImageDimension2D / 1024, 100);
+	score += std::min<uint32_t>(candidate.maxComputeSharedMemorySize / 4096, 100);
+
+	return score;
+}
+
+bool DeviceSelector::matches(const DeviceCandidate &candidate, const std::string &nameOrUuid){
+
+	auto lower = [](std::string text) {
+		std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return text;
+	};
+
+	// UUIDs may be written with dashes (as drivers and tools often print them)
+	std::string uuid = lower(nameOrUuid);
+	uuid.erase(std::remove(uuid.begin(), uuid.end(), '-'), uuid.end());
+	if (!uuid.empty() && uuid == candidate.uuid) {
+		return true;
+	}
+
+	return !nameOrUuid.empty() && lower(candidate.name).find(lower(nameOrUuid)) != std::string::npos;
+}
+
+int DeviceSelector::select(std::vector<DeviceCandidate> &candidates, const std::string &nameOrUuid){
+
+	for (auto &candidate : candidates) {
+		candidate.score = score(candidate);
+	}
+
+	// the first suitable device the override names
+	if (!nameOrUuid.empty()) {
+		for (size_t i = 0; i < candidates.size(); i++) {
+			if (candidates[i].suitable && matches(candidates[i], nameOrUuid)) {
+				return static_cast<int>(i);
+			}
+		}
+		printf("WARNING: no suitable device matches \"%s\", choosing by score\n", nameOrUuid.c_str());
+	}
+
+	// highest score, ties go to the device enumerated first
+	int selected = -1;
+	for (size_t i = 0; i < candidates.size(); i++) {
+		if (candidates[i].suitable && (selected < 0 || candidates[i].score > candidates[selected].score)) {
+			selected = static_cast<int>(i);
+		}
+	}
+	return selected;
+}
+
+void DeviceSelector::report(const std::vector<DeviceCandidate> &candidates, int selected){
+
+	for (size_t i = 0; i < candidates.size(); i++) {
+		const DeviceCandidate &candidate = candidates[i];
+
+		printf("device %zu: %s (%s, %llu MiB, uuid %s): ", i, candidate.name.c_str(), getTypeName(candidate.type),
+			(unsigned long long)(candidate.deviceLocalBytes / (1024 * 1024)), candidate.uuid.c_str());
+		if (candidate.suitable) {
+			printf("score %lld%s\n", (long long)candidate.score, static_cast<int>(i) == selected ? ", selected" : "");
+		}
+		else
+		{
+			printf("unsuitable\n");
+		}
+	}
+}
+
+const char * DeviceSelector::getTypeName(VkPhysicalDeviceType type){
+
+	switch (type) {
+	case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:		return "discrete";
+	case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:	return "integrated";
+	case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:		return "virtual";
+	case VK_PHYSICAL_DEVICE_TYPE_CPU:				return "cpu";
+	default:										return "other";
+	}
+}
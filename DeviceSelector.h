@@ -0,0 +1,56 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// what device selection knows about one physical device. describe fills it from the device, everything else
+// only reads it, so scoring can be checked against made up candidates without a device
+struct DeviceCandidate {
+	VkPhysicalDevice device = VK_NULL_HANDLE;
+	std::string name;
+	std::string uuid;								// deviceUUID as 32 lowercase hex digits
+	VkPhysicalDeviceType type = VK_PHYSICAL_DEVICE_TYPE_OTHER;
+	bool suitable = false;							// meets the renderer's requirements, set by the caller
+
+	// - Memory
+	VkDeviceSize deviceLocalBytes = 0;				// largest device local heap
+
+	// - Queues
+	bool presentOnGraphicsFamily = false;			// one family does both, set by the caller (needs the surface)
+	bool asyncComputeFamily = false;				// compute without graphics
+	bool transferFamily = false;					// transfer only, a DMA engine
+
+	// - Extensions and limits
+	uint32_t optionalExtensionCount = 0;			// of the ones passed to describe
+	uint32_t maxImageDimension2D = 0;
+	uint32_t maxComputeSharedMemorySize = 0;
+	bool multiDrawIndirect = false;					// the feature, not just the limit
+
+	int64_t score = -1;								// -1 for unsuitable devices
+};
+
+// Picks the physical device to render with. Every suitable device is scored by type first (discrete, integrated,
+// virtual, other, then CPU implementations such as lavapipe), each type a tier no amount of memory, queue layout,
+// optional extensions or limits can climb out of, and by those within a tier.
+// An override (e.g. from an environment variable) names a device by part of its name or by UUID, and wins over
+// the scores as long as that device is suitable
+class DeviceSelector
+{
+public:
+	static DeviceCandidate describe(VkPhysicalDevice device, const std::vector<const char *> &optionalExtensions);
+
+	static int64_t score(const DeviceCandidate &candidate);
+	static bool matches(const DeviceCandidate &candidate, const std::string &nameOrUuid);
+
+	// scores every candidate, returns the index of the chosen one or -1 if none are suitable
+	static int select(std::vector<DeviceCandidate> &candidates, const std::string &nameOrUuid);
+
+	// one line per candidate with its score
+	static void report(const std::vector<DeviceCandidate> &candidates, int selected);
+
+	static const char * getTypeName(VkPhysicalDeviceType type);
+};
@@ -0,0 +1,167 @@
+#include "DynamicMesh.h"
+
+#include <cstring>
+
+namespace {
+
+	// regions start on this boundary, enough for vertex, index and storage buffer offsets on any device
+	const VkDeviceSize REGION_ALIGNMENT = 256;
+
+	VkDeviceSize alignRegion(VkDeviceSize size){
+
+		return (size + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT * REGION_ALIGNMENT;
+	}
+}
+
+DynamicMesh::DynamicMesh()
+{
+}
+
+void DynamicMesh::create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, DeviceAllocator * newAllocator, int framesInFlight,
+	uint32_t newMaxVertices, uint32_t newMaxIndices){
+
+	physicalDevice = newPhysicalDevice;
+	device = newDevice;
+	allocator = newAllocator;
+	maxVertices = newMaxVertices;
+	maxIndices = newMaxIndices;
+
+	indexOffset = alignRegion(maxVertices * sizeof(Vertex));
+	regionSize = alignRegion(indexOffset + maxIndices * sizeof(uint32_t));
+	VkDeviceSize bufferSize = regionSize * framesInFlight;
+
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = bufferSize;
+	bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkBuffer newBuffer;
+	VkResult result = vkCreateBuffer(device, &bufferInfo, nullptr, &newBuffer);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create a dynamic mesh buffer");
+	}
+	buffer = UniqueBuffer(device, newBuffer);
+
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(device, newBuffer, &memRequirements);
+
+	// the GPU reads device local memory at full speed, host writes to it go over the bus once (write combined).
+	// without resizable BAR (or once its heap is full) the buffer lives in host memory and the GPU reads it over the bus
+	VkDeviceMemory newMemory = allocator->tryAllocate(memRequirements,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	deviceLocal = newMemory != VK_NULL_HANDLE;
+	if (!deviceLocal) {
+		newMemory = allocator->allocate(memRequirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	}
+	memory = UniqueDeviceMemory(allocator, newMemory);
+	vkBindBufferMemory(device, newBuffer, newMemory, 0);
+
+	void * data;
+	vkMapMemory(device, newMemory, 0, bufferSize, 0, &data);
+	mapped = static_cast<uint8_t *>(data);
+
+	frames.assign(framesInFlight, FrameRegion());
+	currentFrame = 0;
+}
+
+void DynamicMesh::destroy(){
+
+	// mapped memory has to be unmapped before it goes back to the allocator for recycling
+	if (mapped != nullptr) {
+		vkUnmapMemory(device, memory.get());
+		mapped = nullptr;
+	}
+	buffer.reset();
+	memory.reset();
+	frames.clear();
+}
+
+void DynamicMesh::begin(int frame){
+
+	currentFrame = frame;
+	frames[frame] = FrameRegion();
+}
+
+Vertex * DynamicMesh::allocateVertices(uint32_t count, uint32_t * first){
+
+	FrameRegion &region = frames[currentFrame];
+	if (count > maxVertices - region.vertexCount) {
+		region.droppedCount++;
+		return nullptr;
+	}
+
+	*first = region.vertexCount;
+	region.vertexCount += count;
+	return reinterpret_cast<Vertex *>(mapped + currentFrame * regionSize) + *first;
+}
+
+uint32_t * DynamicMesh::allocateIndices(uint32_t count, uint32_t * first){
+
+	FrameRegion &region = frames[currentFrame];
+	if (count > maxIndices - region.indexCount) {
+		region.droppedCount++;
+		return nullptr;
+	}
+
+	*first = region.indexCount;
+	region.indexCount += count;
+	return reinterpret_cast<uint32_t *>(mapped + currentFrame * regionSize + indexOffset) + *first;
+}
+
+bool DynamicMesh::addVertices(const Vertex * vertices, uint32_t count, uint32_t * first){
+
+	// written in order in one go, the memory may be write combined and is never read back
+	Vertex * destination = allocateVertices(count, first);
+	if (destination == nullptr) {
+		return false;
+	}
+	memcpy(destination, vertices, count * sizeof(Vertex));
+	return true;
+}
+
+bool DynamicMesh::addIndices(const uint32_t * indices, uint32_t count, uint32_t * first){
+
+	uint32_t * destination = allocateIndices(count, first);
+	if (destination == nullptr) {
+		return false;
+	}
+	memcpy(destination, indices, count * sizeof(uint32_t));
+	return true;
+}
+
+VkBuffer DynamicMesh::getBuffer(){
+	return buffer.get();
+}
+
+VkDeviceSize DynamicMesh::getVertexOffset(int frame){
+	return frame * regionSize;
+}
+
+VkDeviceSize DynamicMesh::getIndexOffset(int frame){
+	return frame * regionSize + indexOffset;
+}
+
+uint32_t DynamicMesh::getVertexCount(int frame){
+	return frames[frame].vertexCount;
+}
+
+uint32_t DynamicMesh::getIndexCount(int frame){
+	return frames[frame].indexCount;
+}
+
+VkDeviceSize DynamicMesh::getStreamedBytes(int frame){
+	return frames[frame].vertexCount * sizeof(Vertex) + frames[frame].indexCount * sizeof(uint32_t);
+}
+
+uint32_t DynamicMesh::getDroppedCount(int frame){
+	return frames[frame].droppedCount;
+}
+
+bool DynamicMesh::isDeviceLocal(){
+	return deviceLocal;
+}
+
+DynamicMesh::~DynamicMesh()
+{
+}
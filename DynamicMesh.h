@@ -0,0 +1,80 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <vector>
+#include <functional>
+
+#include "Utilities.h"
+#include "VulkanHandles.h"
+
+// Geometry written by the CPU every frame (debug lines, UI, CPU particles). One buffer holds a vertex and index
+// region per frame in flight and stays mapped, vertices are written straight in to memory the GPU reads,
+// with no staging copy. Device local host visible memory (resizable BAR) is used when the device has it, plain
+// host visible memory otherwise. Both are coherent, so nothing needs flushing.
+// A frame's region may only be written once the GPU has finished the frame that last used it
+class DynamicMesh
+{
+public:
+	DynamicMesh();
+
+	void create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, DeviceAllocator * newAllocator, int framesInFlight,
+		uint32_t newMaxVertices, uint32_t newMaxIndices);
+	void destroy();
+
+	// start writing the frame's region, dropping what it held
+	void begin(int frame);
+
+	// room for count vertices / indices in the current frame's region, or nullptr (and counted as dropped) if it is full.
+	// first is set to the index of the first one, for indices referring to vertices written this frame
+	Vertex * allocateVertices(uint32_t count, uint32_t * first);
+	uint32_t * allocateIndices(uint32_t count, uint32_t * first);
+
+	// - Copies in to the region, false if it is full
+	bool addVertices(const Vertex * vertices, uint32_t count, uint32_t * first);
+	bool addIndices(const uint32_t * indices, uint32_t count, uint32_t * first);
+
+	// -- DRAW --
+	VkBuffer getBuffer();
+	VkDeviceSize getVertexOffset(int frame);
+	VkDeviceSize getIndexOffset(int frame);
+	uint32_t getVertexCount(int frame);
+	uint32_t getIndexCount(int frame);
+
+	// - Statistics
+	VkDeviceSize getStreamedBytes(int frame);		// vertex and index bytes written for the frame
+	uint32_t getDroppedCount(int frame);			// allocations that didn't fit
+	bool isDeviceLocal();
+
+	~DynamicMesh();
+
+private:
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	DeviceAllocator * allocator = nullptr;
+
+	uint32_t maxVertices = 0;
+	uint32_t maxIndices = 0;
+	VkDeviceSize regionSize = 0;					// one frame's vertices then indices
+	VkDeviceSize indexOffset = 0;					// of the indices within a region
+	bool deviceLocal = false;
+
+	// memory declared before its buffer, so the buffer is destroyed first
+	UniqueDeviceMemory memory;
+	UniqueBuffer buffer;
+	uint8_t * mapped = nullptr;
+
+	// - Per frame region
+	struct FrameRegion {
+		uint32_t vertexCount = 0;
+		uint32_t indexCount = 0;
+		uint32_t droppedCount = 0;
+	};
+	std::vector<FrameRegion> frames;
+	int currentFrame = 0;
+};
+
+// fills a dynamic mesh for a frame, after begin
+using DynamicGeometryCallback = std::function<void(DynamicMesh &)>;
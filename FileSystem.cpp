@@ -0,0 +1,564 @@
+#include "FileSystem.h"
+
+#include <cstring>
+#include <fstream>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#if FILE_SYSTEM_USE_IO_URING
+#include <liburing.h>
+#endif
+
+#include "Profiler.h"
+
+namespace {
+
+	const char ARCHIVE_MAGIC[4] = { 'V', 'K', 'P', 'K' };
+	const uint32_t ARCHIVE_VERSION = 1;
+	const size_t ARCHIVE_HEADER_SIZE = 16;
+	const size_t ARCHIVE_ENTRY_SIZE = 24;
+	const size_t ARCHIVE_DATA_ALIGNMENT = 16;		// keeps SPIR-V and vertex data word aligned inside the mapping
+
+	// batched files up to this size are read in to memory, bigger ones are cheaper to map
+	const size_t BATCH_READ_LIMIT = 256 * 1024;
+	const unsigned BATCH_QUEUE_DEPTH = 64;
+
+	uint32_t readUint32(const uint8_t * bytes){
+
+		uint32_t value;
+		memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+
+	uint64_t readUint64(const uint8_t * bytes){
+
+		uint64_t value;
+		memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+
+	void writeUint32(std::vector<uint8_t> &bytes, size_t offset, uint32_t value){
+
+		memcpy(bytes.data() + offset, &value, sizeof(value));
+	}
+
+	void writeUint64(std::vector<uint8_t> &bytes, size_t offset, uint64_t value){
+
+		memcpy(bytes.data() + offset, &value, sizeof(value));
+	}
+
+	size_t alignUp(size_t value, size_t alignment){
+
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+#ifdef __linux__
+	// the rest of a read the ring (or nothing) has started, false if the file ended early or failed
+	bool readFully(int fd, uint8_t * data, size_t size, size_t done){
+
+		while (done < size) {
+			ssize_t result = pread(fd, data + done, size - done, static_cast<off_t>(done));
+			if (result < 0 && errno == EINTR) {
+				continue;
+			}
+			if (result <= 0) {
+				return false;
+			}
+			done += static_cast<size_t>(result);
+		}
+		return true;
+	}
+#endif
+}
+
+// -- ASSET FILE --
+AssetFile::AssetFile(AssetFile &&other) noexcept
+	: mapping(other.mapping), mappingSize(other.mappingSize), buffer(std::move(other.buffer)), view(other.view), open(other.open), archived(other.archived)
+{
+	other.mapping = nullptr;
+	other.mappingSize = 0;
+	other.view = FileView();
+	other.open = false;
+}
+
+AssetFile &AssetFile::operator=(AssetFile &&other) noexcept {
+
+	if (this != &other) {
+		reset();
+		mapping = other.mapping;
+		mappingSize = other.mappingSize;
+		buffer = std::move(other.buffer);
+		view = other.view;
+		open = other.open;
+		archived = other.archived;
+
+		other.mapping = nullptr;
+		other.mappingSize = 0;
+		other.view = FileView();
+		other.open = false;
+	}
+	return *this;
+}
+
+AssetFile AssetFile::fromBuffer(std::vector<uint8_t> &&bytes){
+
+	AssetFile file;
+	file.buffer = std::move(bytes);
+	file.view.data = file.buffer.data();
+	file.view.size = file.buffer.size();
+	file.open = true;
+	return file;
+}
+
+AssetFile::~AssetFile(){
+
+	reset();
+}
+
+void AssetFile::reset(){
+
+#ifdef __linux__
+	if (mapping != nullptr) {
+		munmap(mapping, mappingSize);
+	}
+#endif
+	mapping = nullptr;
+	mappingSize = 0;
+	buffer.clear();
+	view = FileView();
+	open = false;
+	archived = false;
+}
+
+// -- FILE SYSTEM --
+FileSystem::FileSystem()
+{
+}
+
+void FileSystem::create(){
+
+}
+
+void FileSystem::destroy(){
+
+	archiveEntries.clear();
+	archives.clear();
+}
+
+void FileSystem::mountArchive(const std::string &archivePath){
+
+	PROFILE_FUNCTION();
+
+	// the index is read once, the data pages are only touched when a file in it is opened
+	AssetFile archive = mapFile(archivePath, FileAccess::Random);
+	indexArchive(archivePath, archive);
+	archives.push_back(std::move(archive));
+}
+
+void FileSystem::mountArchive(const std::string &name, std::vector<uint8_t> &&archiveData){
+
+	AssetFile archive = AssetFile::fromBuffer(std::move(archiveData));
+	indexArchive(name, archive);
+	archives.push_back(std::move(archive));
+}
+
+bool FileSystem::exists(const std::string &path) const {
+
+	if (isArchived(path)) {
+		return true;
+	}
+
+	std::ifstream file(path, std::ios::binary);
+	return file.is_open();
+}
+
+bool FileSystem::isArchived(const std::string &path) const {
+
+	return !archiveEntries.empty() && archiveEntries.count(normalisePath(path)) > 0;
+}
+
+AssetFile FileSystem::open(const std::string &path, FileAccess access) const {
+
+	AssetFile file;
+	if (findArchived(path, &file)) {
+		return file;
+	}
+
+	return mapFile(path, access);
+}
+
+std::vector<AssetFile> FileSystem::openBatch(const std::vector<std::string> &paths) const {
+
+	PROFILE_FUNCTION();
+
+	std::vector<AssetFile> files(paths.size());
+
+#ifdef __linux__
+	// small files are opened and sized first, then all read together
+	struct PendingRead {
+		size_t file;
+		int fd;
+		size_t size;
+		size_t done;
+		bool inFlight;				// submitted to the ring and not completed, the kernel may still write the buffer
+	};
+	std::vector<PendingRead> pending;
+
+	for (size_t i = 0; i < paths.size(); i++) {
+
+		if (findArchived(paths[i], &files[i])) {
+			continue;
+		}
+
+		int fd = ::open(paths[i].c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			continue;
+		}
+
+		struct stat fileStatus;
+		if (fstat(fd, &fileStatus) != 0) {
+			close(fd);
+			continue;
+		}
+
+		size_t size = static_cast<size_t>(fileStatus.st_size);
+		if (size > BATCH_READ_LIMIT) {
+			close(fd);
+			try
+			{
+				files[i] = mapFile(paths[i], FileAccess::Sequential);
+			}
+			catch (const std::runtime_error &)
+			{
+				// left not open
+			}
+			continue;
+		}
+
+		files[i].buffer.resize(size);
+		pending.push_back({ i, fd, size, 0, false });
+	}
+
+#if FILE_SYSTEM_USE_IO_URING
+	struct io_uring ring;
+	if (!pending.empty() && io_uring_queue_init(BATCH_QUEUE_DEPTH, &ring, 0) == 0) {
+
+		size_t submitted = 0;
+		size_t completed = 0;
+		while (completed < submitted || submitted < pending.size()) {
+
+			// keep the ring full
+			while (submitted < pending.size() && submitted - completed < BATCH_QUEUE_DEPTH) {
+				struct io_uring_sqe * sqe = io_uring_get_sqe(&ring);
+				if (sqe == nullptr) {
+					break;
+				}
+				PendingRead &read = pending[submitted];
+				io_uring_prep_read(sqe, read.fd, files[read.file].buffer.data(), static_cast<unsigned>(read.size), 0);
+				io_uring_sqe_set_data(sqe, &read);
+				read.inFlight = true;
+				submitted++;
+			}
+			io_uring_submit(&ring);
+
+			struct io_uring_cqe * cqe;
+			int result = io_uring_wait_cqe(&ring, &cqe);
+			if (result == -EINTR) {
+				continue;
+			}
+			if (result < 0) {
+				break;
+			}
+
+			PendingRead * read = static_cast<PendingRead *>(io_uring_cqe_get_data(cqe));
+			if (cqe->res > 0) {
+				read->done = static_cast<size_t>(cqe->res);
+			}
+			read->inFlight = false;
+			io_uring_cqe_seen(&ring, cqe);
+			completed++;
+		}
+
+		// the ring is given up on and plain reads finish whatever it didn't, but not until the reads still in
+		// flight are cancelled and have completed, or they could write in to the buffers under the plain reads
+		if (completed < submitted) {
+			for (auto &read : pending) {
+				struct io_uring_sqe * sqe = read.inFlight ? io_uring_get_sqe(&ring) : nullptr;
+				if (sqe != nullptr) {
+					io_uring_prep_cancel(sqe, &read, 0);
+					io_uring_sqe_set_data(sqe, nullptr);
+				}
+			}
+			io_uring_submit(&ring);
+
+			// cancellations complete too, only the reads are counted
+			while (completed < submitted) {
+				struct io_uring_cqe * cqe;
+				int result = io_uring_wait_cqe(&ring, &cqe);
+				if (result == -EINTR) {
+					continue;
+				}
+				if (result < 0) {
+					break;
+				}
+
+				PendingRead * read = static_cast<PendingRead *>(io_uring_cqe_get_data(cqe));
+				if (read != nullptr) {
+					if (cqe->res > 0) {
+						read->done = static_cast<size_t>(cqe->res);
+					}
+					read->inFlight = false;
+					completed++;
+				}
+				io_uring_cqe_seen(&ring, cqe);
+			}
+		}
+
+		io_uring_queue_exit(&ring);
+
+		// the ring can't even be drained, which leaves reads that may still land. their files fail and their
+		// buffers are leaked rather than freed under the kernel
+		for (auto &read : pending) {
+			if (read.inFlight) {
+				new std::vector<uint8_t>(std::move(files[read.file].buffer));
+			}
+		}
+	}
+#endif
+
+	// short reads, and everything when there is no ring
+	for (auto &read : pending) {
+		AssetFile &file = files[read.file];
+		if (!read.inFlight && readFully(read.fd, file.buffer.data(), read.size, read.done)) {
+			file.view.data = file.buffer.data();
+			file.view.size = file.buffer.size();
+			file.open = true;
+		}
+		else
+		{
+			file.buffer.clear();
+		}
+		close(read.fd);
+	}
+#else
+	for (size_t i = 0; i < paths.size(); i++) {
+		try
+		{
+			files[i] = open(paths[i]);
+		}
+		catch (const std::runtime_error &)
+		{
+			// left not open
+		}
+	}
+#endif
+
+	return files;
+}
+
+void FileSystem::writeArchive(const std::string &archivePath, const std::vector<std::string> &filePaths){
+
+	std::vector<std::string> names;
+	size_t nameTableSize = 0;
+	for (const auto &filePath : filePaths) {
+		names.push_back(normalisePath(filePath));
+		nameTableSize += names.back().size();
+	}
+
+	std::vector<uint8_t> header(ARCHIVE_HEADER_SIZE + filePaths.size() * ARCHIVE_ENTRY_SIZE + nameTableSize);
+	memcpy(header.data(), ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+	writeUint32(header, 4, ARCHIVE_VERSION);
+	writeUint32(header, 8, static_cast<uint32_t>(filePaths.size()));
+	writeUint32(header, 12, static_cast<uint32_t>(nameTableSize));
+
+	std::ofstream archive(archivePath, std::ios::binary);
+	if (!archive.is_open()) {
+		throw std::runtime_error("failed to create archive " + archivePath);
+	}
+
+	// data goes after the header, so it is written once the header's offsets are known
+	std::vector<std::vector<char>> contents;
+	size_t nameOffset = ARCHIVE_HEADER_SIZE + filePaths.size() * ARCHIVE_ENTRY_SIZE;
+	size_t dataOffset = alignUp(header.size(), ARCHIVE_DATA_ALIGNMENT);
+	for (size_t i = 0; i < filePaths.size(); i++) {
+
+		std::ifstream file(filePaths[i], std::ios::binary | std::ios::ate);
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open a file " + filePaths[i]);
+		}
+		std::vector<char> content(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(content.data(), content.size());
+
+		size_t entry = ARCHIVE_HEADER_SIZE + i * ARCHIVE_ENTRY_SIZE;
+		writeUint64(header, entry, dataOffset);
+		writeUint64(header, entry + 8, content.size());
+		writeUint32(header, entry + 16, static_cast<uint32_t>(nameOffset));
+		writeUint32(header, entry + 20, static_cast<uint32_t>(names[i].size()));
+		memcpy(header.data() + nameOffset, names[i].data(), names[i].size());
+
+		nameOffset += names[i].size();
+		dataOffset = alignUp(dataOffset + content.size(), ARCHIVE_DATA_ALIGNMENT);
+		contents.push_back(std::move(content));
+	}
+
+	const char padding[ARCHIVE_DATA_ALIGNMENT] = {};
+	archive.write(reinterpret_cast<const char *>(header.data()), header.size());
+	size_t written = header.size();
+	for (const auto &content : contents) {
+		archive.write(padding, alignUp(written, ARCHIVE_DATA_ALIGNMENT) - written);
+		written = alignUp(written, ARCHIVE_DATA_ALIGNMENT);
+		archive.write(content.data(), content.size());
+		written += content.size();
+	}
+
+	if (!archive.good()) {
+		throw std::runtime_error("failed to write archive " + archivePath);
+	}
+}
+
+FileSystem::~FileSystem()
+{
+}
+
+void FileSystem::indexArchive(const std::string &name, const AssetFile &archive){
+
+	const uint8_t * data = archive.getData();
+	size_t size = archive.getSize();
+
+	if (size < ARCHIVE_HEADER_SIZE || memcmp(data, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0) {
+		throw std::runtime_error("not an archive: " + name);
+	}
+	if (readUint32(data + 4) != ARCHIVE_VERSION) {
+		throw std::runtime_error("unsupported archive version in " + name);
+	}
+
+	uint64_t entryCount = readUint32(data + 8);
+	if (ARCHIVE_HEADER_SIZE + entryCount * ARCHIVE_ENTRY_SIZE > size) {
+		throw std::runtime_error("truncated archive " + name);
+	}
+
+	// check everything before adding anything, a bad archive leaves the mounted ones as they were
+	std::vector<std::pair<std::string, FileView>> entries;
+	for (uint64_t i = 0; i < entryCount; i++) {
+
+		const uint8_t * entry = data + ARCHIVE_HEADER_SIZE + i * ARCHIVE_ENTRY_SIZE;
+		uint64_t dataOffset = readUint64(entry);
+		uint64_t dataSize = readUint64(entry + 8);
+		uint64_t nameOffset = readUint32(entry + 16);
+		uint64_t nameLength = readUint32(entry + 20);
+
+		if (dataOffset > size || dataSize > size - dataOffset || nameOffset > size || nameLength > size - nameOffset) {
+			throw std::runtime_error("truncated archive " + name);
+		}
+
+		FileView view;
+		view.data = data + dataOffset;
+		view.size = static_cast<size_t>(dataSize);
+		entries.emplace_back(std::string(reinterpret_cast<const char *>(data + nameOffset), static_cast<size_t>(nameLength)), view);
+	}
+
+	for (auto &entry : entries) {
+		archiveEntries[entry.first] = entry.second;
+	}
+}
+
+bool FileSystem::findArchived(const std::string &path, AssetFile * file) const {
+
+	if (archiveEntries.empty()) {
+		return false;
+	}
+
+	auto entry = archiveEntries.find(normalisePath(path));
+	if (entry == archiveEntries.end()) {
+		return false;
+	}
+
+	*file = AssetFile();
+	file->view = entry->second;
+	file->open = true;
+	file->archived = true;
+	return true;
+}
+
+std::string FileSystem::normalisePath(const std::string &path){
+
+	std::string normalised = path;
+	for (auto &c : normalised) {
+		if (c == '\\') {
+			c = '/';
+		}
+	}
+	while (normalised.compare(0, 2, "./") == 0) {
+		normalised.erase(0, 2);
+	}
+	return normalised;
+}
+
+AssetFile FileSystem::mapFile(const std::string &path, FileAccess access){
+
+#ifdef __linux__
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		throw std::runtime_error("failed to open a file " + path);
+	}
+
+	struct stat fileStatus;
+	if (fstat(fd, &fileStatus) != 0) {
+		close(fd);
+		throw std::runtime_error("failed to open a file " + path);
+	}
+
+	AssetFile file;
+	file.open = true;
+
+	// nothing to map for an empty file
+	size_t size = static_cast<size_t>(fileStatus.st_size);
+	if (size == 0) {
+		close(fd);
+		return file;
+	}
+
+	void * mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		throw std::runtime_error("failed to map a file " + path);
+	}
+
+	// whole file reads also start reading ahead now, before the first page fault
+	if (access == FileAccess::Sequential) {
+		madvise(mapping, size, MADV_SEQUENTIAL);
+		madvise(mapping, size, MADV_WILLNEED);
+	}
+	else
+	{
+		madvise(mapping, size, MADV_RANDOM);
+	}
+
+	file.mapping = mapping;
+	file.mappingSize = size;
+	file.view.data = static_cast<const uint8_t *>(mapping);
+	file.view.size = size;
+	return file;
+#else
+	// no mapping here, the file is read in to memory instead
+	(void)access;
+
+	std::ifstream stream(path, std::ios::binary | std::ios::ate);
+	if (!stream.is_open()) {
+		throw std::runtime_error("failed to open a file " + path);
+	}
+
+	std::vector<uint8_t> bytes(static_cast<size_t>(stream.tellg()));
+	stream.seekg(0);
+	stream.read(reinterpret_cast<char *>(bytes.data()), bytes.size());
+
+	return AssetFile::fromBuffer(std::move(bytes));
+#endif
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// batched reads go through io_uring on Linux when built with -DFILE_SYSTEM_USE_IO_URING=1 (and linked with -luring),
+// otherwise each file of a batch is read on its own. opt in, liburing being installed doesn't mean it is linked
+#ifndef FILE_SYSTEM_USE_IO_URING
+#define FILE_SYSTEM_USE_IO_URING 0
+#endif
+
+// read-only bytes of a file, valid while the AssetFile (or mounted archive) it came from is alive
+struct FileView {
+	const uint8_t * data = nullptr;
+	size_t size = 0;
+};
+
+// how a file's pages will be read, passed on to the kernel as a madvise hint
+enum class FileAccess {
+	Sequential,			// read once front to back (shaders, whole assets), pages are read ahead aggressively
+	Random				// read in pieces (streamed meshes), no read ahead
+};
+
+// Move-only file contents. Either a read-only mapping of the file, a buffer it was read in to
+// (batched reads and compiled shaders), or a view in to a mounted archive
+class AssetFile
+{
+public:
+	AssetFile() {}
+
+	AssetFile(const AssetFile &) = delete;
+	AssetFile &operator=(const AssetFile &) = delete;
+
+	AssetFile(AssetFile &&other) noexcept;
+	AssetFile &operator=(AssetFile &&other) noexcept;
+
+	// takes over bytes produced in memory
+	static AssetFile fromBuffer(std::vector<uint8_t> &&bytes);
+
+	FileView getView() const { return view; }
+	const uint8_t * getData() const { return view.data; }
+	size_t getSize() const { return view.size; }
+
+	// false for files a batch failed to read
+	bool isOpen() const { return open; }
+	// contents come from a mounted archive rather than a file of their own on disk
+	bool isArchived() const { return archived; }
+
+	~AssetFile();
+
+private:
+	friend class FileSystem;
+
+	void * mapping = nullptr;
+	size_t mappingSize = 0;
+	std::vector<uint8_t> buffer;
+	FileView view;
+	bool open = false;
+	bool archived = false;
+
+	void reset();
+};
+
+// Read-only asset I/O. Files are mapped instead of copied in to memory, so loaders consume the
+// page cache directly, and archives mounted in to a virtual file system are looked up before the disk.
+// An archive is one mapping with an index of paths in to it:
+// - header: "VKPK", version, entry count, name table size (uint32_t each, little endian)
+// - entries: data offset, data size (uint64_t), name offset, name length (uint32_t)
+// - the name table, then each file's data aligned to 16 bytes from the start of the archive
+// Mount archives before other threads open files, opening is safe from any thread afterwards
+class FileSystem
+{
+public:
+	FileSystem();
+
+	void create();
+	void destroy();
+
+	// archives mounted later win over earlier ones for the same path. throws if the archive is invalid
+	void mountArchive(const std::string &archivePath);
+	void mountArchive(const std::string &name, std::vector<uint8_t> &&archiveData);
+
+	bool exists(const std::string &path) const;
+	// whether opening the path reads it from a mounted archive
+	bool isArchived(const std::string &path) const;
+
+	// whole file, from a mounted archive or else mapped from disk. throws if the file can't be opened
+	AssetFile open(const std::string &path, FileAccess access = FileAccess::Sequential) const;
+
+	// many files at once, in the order asked for. small files are read with one batch of io_uring reads
+	// (each file read on its own without it), large ones are mapped. files that can't be read are returned not open
+	std::vector<AssetFile> openBatch(const std::vector<std::string> &paths) const;
+
+	// pack files in to an archive mountArchive can read, stored under the paths as given
+	static void writeArchive(const std::string &archivePath, const std::vector<std::string> &filePaths);
+
+	~FileSystem();
+
+private:
+	std::vector<AssetFile> archives;
+	std::unordered_map<std::string, FileView> archiveEntries;		// by normalised path, views in to archives
+
+	void indexArchive(const std::string &name, const AssetFile &archive);
+	bool findArchived(const std::string &path, AssetFile * file) const;
+
+	static std::string normalisePath(const std::string &path);
+	static AssetFile mapFile(const std::string &path, FileAccess access);
+};
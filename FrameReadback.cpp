@@ -0,0 +1,276 @@
+#include "FrameReadback.h"
+
+#include <cstdio>
+
+#include "Utilities.h"
+
+FrameReadback::FrameReadback(){
+
+}
+
+void FrameReadback::create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, DeviceAllocator * newAllocator, FrameScheduler * newScheduler,
+	VkExtent2D newExtent, VkFormat newFormat, ReadbackCallback newCallback, uint32_t ringSize){
+
+	physicalDevice = newPhysicalDevice;
+	device = newDevice;
+	allocator = newAllocator;
+	scheduler = newScheduler;
+	extent = newExtent;
+	format = newFormat;
+	callback = newCallback;
+
+	// rows are copied tightly packed, 4 bytes a pixel
+	switch (format) {
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+		break;
+	default:
+		throw std::runtime_error("frame readback only supports 8 bit RGBA / BGRA formats");
+	}
+
+	// cached memory is much faster for the CPU to read, but may need invalidating before each read
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	VkMemoryPropertyFlags cachedProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+	VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+		if ((memoryProperties.memoryTypes[i].propertyFlags & cachedProperties) == cachedProperties) {
+			properties = cachedProperties;
+			break;
+		}
+	}
+
+	VkDeviceSize bufferSize = VkDeviceSize(extent.width) * extent.height * 4;
+
+	for (uint32_t i = 0; i < ringSize; i++) {
+
+		auto slot = std::make_unique<Slot>();
+
+		VkBuffer buffer;
+		VkDeviceMemory memory;
+		createBuffer(physicalDevice, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, properties, &buffer, &memory, allocator);
+		slot->memory = UniqueDeviceMemory(allocator, memory);
+		slot->buffer = UniqueBuffer(device, buffer);
+
+		// whether it needs invalidating depends on the type the allocator picked, not the first cached one
+		slot->hostCoherent = (allocator->getPropertyFlags(memory) & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+		void * data;
+		vkMapMemory(device, memory, 0, bufferSize, 0, &data);
+		slot->mapped = static_cast<uint8_t *>(data);
+
+		slots.push_back(std::move(slot));
+	}
+
+	stopping = false;
+	writer = std::thread(&FrameReadback::writerLoop, this);
+}
+
+void FrameReadback::destroy(){
+
+	// the writer finishes everything it was already handed before stopping
+	{
+		std::lock_guard<std::mutex> lock(writerMutex);
+		stopping = true;
+	}
+	writerCondition.notify_all();
+	if (writer.joinable()) {
+		writer.join();
+	}
+
+	for (auto &slot : slots) {
+		if (slot->mapped != nullptr) {
+			vkUnmapMemory(device, slot->memory.get());
+		}
+	}
+	slots.clear();
+	writerQueue.clear();
+	nextSlot = 0;
+	nextCollect = 0;
+}
+
+bool FrameReadback::recordCopy(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout imageLayout, uint64_t frameNumber){
+
+	// the consumer is a whole ring behind, drop the frame rather than wait for it
+	Slot &slot = *slots[nextSlot];
+	if (slot.state.load() != SLOT_FREE) {
+		droppedFrames++;
+		return false;
+	}
+
+	// -- TO TRANSFER SOURCE --
+	VkImageMemoryBarrier imageBarrier = {};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	imageBarrier.oldLayout = imageLayout;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = image;
+	imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageBarrier.subresourceRange.baseMipLevel = 0;
+	imageBarrier.subresourceRange.levelCount = 1;
+	imageBarrier.subresourceRange.baseArrayLayer = 0;
+	imageBarrier.subresourceRange.layerCount = 1;
+
+	deviceDispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+	// -- COPY --
+	VkBufferImageCopy region = {};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;							// 0 means tightly packed
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { extent.width, extent.height, 1 };
+
+	deviceDispatch.vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer.get(), 1, &region);
+
+	// -- BACK TO ITS LAYOUT --
+	imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	imageBarrier.dstAccessMask = 0;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.newLayout = imageLayout;
+
+	// the host reads the buffer once the timeline value is reached
+	VkBufferMemoryBarrier bufferBarrier = {};
+	bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.buffer = slot.buffer.get();
+	bufferBarrier.offset = 0;
+	bufferBarrier.size = VK_WHOLE_SIZE;
+
+	deviceDispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+		0, 0, nullptr, 1, &bufferBarrier, 1, &imageBarrier);
+
+	slot.frameNumber = frameNumber;
+	slot.state = SLOT_RECORDED;
+	nextSlot = (nextSlot + 1) % slots.size();
+
+	return true;
+}
+
+void FrameReadback::setSubmitValue(uint64_t value){
+
+	for (auto &slot : slots) {
+		if (slot->state.load() == SLOT_RECORDED) {
+			slot->value = value;
+			slot->state = SLOT_SUBMITTED;
+		}
+	}
+}
+
+void FrameReadback::collect(){
+
+	// in ring order, so the writer sees frames in the order they were rendered
+	while (true) {
+
+		Slot &slot = *slots[nextCollect];
+		if (slot.state.load() != SLOT_SUBMITTED || !scheduler->isComplete(slot.value)) {
+			break;
+		}
+
+		if (!slot.hostCoherent) {
+			VkMappedMemoryRange range = {};
+			range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+			range.memory = slot.memory.get();
+			range.offset = 0;
+			range.size = VK_WHOLE_SIZE;
+			vkInvalidateMappedMemoryRanges(device, 1, &range);
+		}
+
+		slot.state = SLOT_WRITING;
+		{
+			std::lock_guard<std::mutex> lock(writerMutex);
+			writerQueue.push_back(nextCollect);
+		}
+		writerCondition.notify_one();
+
+		nextCollect = (nextCollect + 1) % slots.size();
+	}
+}
+
+uint64_t FrameReadback::getDroppedFrameCount(){
+	return droppedFrames;
+}
+
+void FrameReadback::writePPM(const ReadbackImage &image, const std::string &filename){
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open a file for writing");
+	}
+
+	file << "P6\n" << image.width << " " << image.height << "\n255\n";
+
+	// PPM is packed RGB, swap blue and red back for BGRA images
+	bool bgra = image.format == VK_FORMAT_B8G8R8A8_UNORM || image.format == VK_FORMAT_B8G8R8A8_SRGB;
+
+	std::vector<char> row(image.width * 3);
+	for (uint32_t y = 0; y < image.height; y++) {
+
+		const uint8_t * pixel = image.data + y * image.rowPitch;
+		for (uint32_t x = 0; x < image.width; x++, pixel += 4) {
+			row[x * 3] = bgra ? pixel[2] : pixel[0];
+			row[x * 3 + 1] = pixel[1];
+			row[x * 3 + 2] = bgra ? pixel[0] : pixel[2];
+		}
+		file.write(row.data(), row.size());
+	}
+}
+
+FrameReadback::~FrameReadback(){
+
+}
+
+void FrameReadback::writerLoop(){
+
+	while (true) {
+
+		uint32_t slotIndex;
+		{
+			std::unique_lock<std::mutex> lock(writerMutex);
+			writerCondition.wait(lock, [this]() { return stopping || !writerQueue.empty(); });
+
+			if (writerQueue.empty()) {
+				return;
+			}
+			slotIndex = writerQueue.front();
+			writerQueue.pop_front();
+		}
+
+		Slot &slot = *slots[slotIndex];
+
+		ReadbackImage image = {};
+		image.data = slot.mapped;
+		image.width = extent.width;
+		image.height = extent.height;
+		image.rowPitch = extent.width * 4;
+		image.format = format;
+		image.frameNumber = slot.frameNumber;
+
+		// a failing consumer loses the frame, not the writer thread
+		try
+		{
+			callback(image);
+		}
+		catch (const std::exception &e)
+		{
+			printf("ERROR: frame readback callback failed: %s\n", e.what());
+		}
+
+		// the render thread may reuse the buffer from here on
+		slot.state = SLOT_FREE;
+	}
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "FrameScheduler.h"
+#include "VulkanHandles.h"
+#include "DeviceDispatch.h"
+
+// one frame copied back to the host, only valid during the callback
+struct ReadbackImage {
+	const uint8_t * data;
+	uint32_t width;
+	uint32_t height;
+	uint32_t rowPitch;					// bytes per row
+	VkFormat format;
+	uint64_t frameNumber;
+};
+
+using ReadbackCallback = std::function<void(const ReadbackImage &)>;
+
+// Copies rendered images back to host memory without stalling the frame.
+// Each copy goes to the next buffer of a ring of persistently mapped host buffers and is only looked at once the
+// timeline has passed the frame's submission, a few frames later. Finished images are handed to a writer thread
+// that runs the callback (encode, compare, write to disk), so a slow consumer never blocks rendering:
+// if it falls a whole ring behind, frames are dropped and counted instead.
+// Works on any image that can be a transfer source, nothing depends on a swapchain
+class FrameReadback
+{
+public:
+	FrameReadback();
+
+	void create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, DeviceAllocator * newAllocator, FrameScheduler * newScheduler,
+		VkExtent2D newExtent, VkFormat newFormat, ReadbackCallback newCallback, uint32_t ringSize = 4);
+	// waits for the writer thread to finish the images it was handed
+	void destroy();
+
+	// record a copy of the whole image after its last write, it is left in the layout it was in.
+	// returns false when the frame was dropped because every buffer is still waiting on the writer
+	bool recordCopy(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout imageLayout, uint64_t frameNumber);
+
+	// timeline value of the submission holding the copies recorded since the last call
+	void setSubmitValue(uint64_t value);
+
+	// once a frame: hand finished copies to the writer thread
+	void collect();
+
+	uint64_t getDroppedFrameCount();
+
+	// binary PPM, for regression images
+	static void writePPM(const ReadbackImage &image, const std::string &filename);
+
+	~FrameReadback();
+
+private:
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	DeviceAllocator * allocator = nullptr;
+	FrameScheduler * scheduler = nullptr;
+
+	VkExtent2D extent = {};
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	ReadbackCallback callback;
+
+	// - Ring
+	enum SlotState {
+		SLOT_FREE,
+		SLOT_RECORDED,			// copy recorded, not submitted yet
+		SLOT_SUBMITTED,			// waiting for the GPU
+		SLOT_WRITING			// owned by the writer thread
+	};
+	struct Slot {
+		UniqueDeviceMemory memory;
+		UniqueBuffer buffer;
+		uint8_t * mapped = nullptr;
+		bool hostCoherent = true;				// of the memory type it was allocated from
+		std::atomic<int> state{ SLOT_FREE };
+		uint64_t value = 0;
+		uint64_t frameNumber = 0;
+	};
+	std::vector<std::unique_ptr<Slot>> slots;
+	uint32_t nextSlot = 0;							// slots are used and collected in ring order
+	uint32_t nextCollect = 0;
+	std::atomic<uint64_t> droppedFrames{ 0 };
+
+	// - Writer thread
+	std::thread writer;
+	std::mutex writerMutex;
+	std::condition_variable writerCondition;
+	std::deque<uint32_t> writerQueue;
+	bool stopping = false;
+
+	void writerLoop();
+};
@@ -0,0 +1,204 @@
+#include "FrameScheduler.h"
+
+#include <limits>
+#include <algorithm>
+#include <iterator>
+
+FrameScheduler::FrameScheduler(){
+
+}
+
+void FrameScheduler::create(VkDevice newDevice, int framesInFlight){
+
+	device = newDevice;
+	frameValues.assign(framesInFlight, 0);
+
+	// timeline semaphore type information, starting value of 0 (nothing submitted yet)
+	VkSemaphoreTypeCreateInfo timelineCreateInfo = {};
+	timelineCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	timelineCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	timelineCreateInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreCreateInfo.pNext = &timelineCreateInfo;
+
+	VkResult result = vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &timeline);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create a timeline semaphore");
+	}
+}
+
+void FrameScheduler::destroy(){
+
+	if (timeline == VK_NULL_HANDLE) {
+		return;
+	}
+
+	// caller guarantees the device is idle, so every deferred task is safe to run
+	for (auto &task : deferredTasks) {
+		task.callback();
+	}
+	deferredTasks.clear();
+
+	vkDestroySemaphore(device, timeline, nullptr);
+	timeline = VK_NULL_HANDLE;
+}
+
+uint64_t FrameScheduler::submit(VkQueue queue, const VkSubmitInfo &submitInfo, uint64_t waitValue, VkPipelineStageFlags waitStage,
+	const std::vector<TimelineWait> &otherWaits){
+
+	// binary semaphores in the submission ignore their value, so pad them with 0
+	std::vector<VkSemaphore> waitSemaphores(submitInfo.pWaitSemaphores, submitInfo.pWaitSemaphores + submitInfo.waitSemaphoreCount);
+	std::vector<VkPipelineStageFlags> waitStages(submitInfo.pWaitDstStageMask, submitInfo.pWaitDstStageMask + submitInfo.waitSemaphoreCount);
+	std::vector<uint64_t> waitValues(submitInfo.waitSemaphoreCount, 0);
+
+	std::vector<VkSemaphore> signalSemaphores(submitInfo.pSignalSemaphores, submitInfo.pSignalSemaphores + submitInfo.signalSemaphoreCount);
+	std::vector<uint64_t> signalValues(submitInfo.signalSemaphoreCount, 0);
+
+	// optionally wait on an earlier point of the timeline (e.g. an upload this work reads from)
+	if (waitValue > 0) {
+		waitSemaphores.push_back(timeline);
+		waitStages.push_back(waitStage);
+		waitValues.push_back(waitValue);
+	}
+
+	// and on other queues' timelines
+	for (const TimelineWait &otherWait : otherWaits) {
+		waitSemaphores.push_back(otherWait.semaphore);
+		waitStages.push_back(otherWait.stages);
+		waitValues.push_back(otherWait.value);
+	}
+
+	signalSemaphores.push_back(timeline);
+	signalValues.push_back(0);
+
+	std::lock_guard<std::mutex> lock(submitMutex);
+
+	// value is picked under the lock so values reach the queue in increasing order
+	uint64_t signalValue = lastSubmittedValue + 1;
+	signalValues.back() = signalValue;
+
+	VkTimelineSemaphoreSubmitInfo timelineSubmitInfo = {};
+	timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineSubmitInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+	timelineSubmitInfo.pWaitSemaphoreValues = waitValues.data();
+	timelineSubmitInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+	timelineSubmitInfo.pSignalSemaphoreValues = signalValues.data();
+
+	VkSubmitInfo timelineInfo = submitInfo;
+	timelineInfo.pNext = &timelineSubmitInfo;
+	timelineInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+	timelineInfo.pWaitSemaphores = waitSemaphores.data();
+	timelineInfo.pWaitDstStageMask = waitStages.data();
+	timelineInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+	timelineInfo.pSignalSemaphores = signalSemaphores.data();
+
+	VkResult result = deviceDispatch.vkQueueSubmit(queue, 1, &timelineInfo, VK_NULL_HANDLE);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to submit command buffer to Queue");
+	}
+
+	lastSubmittedValue = signalValue;
+	return signalValue;
+}
+
+VkResult FrameScheduler::present(VkQueue queue, const VkPresentInfoKHR &presentInfo){
+
+	std::lock_guard<std::mutex> lock(submitMutex);
+	return deviceDispatch.vkQueuePresentKHR(queue, &presentInfo);
+}
+
+uint64_t FrameScheduler::getCompletedValue(){
+
+	uint64_t value = 0;
+	deviceDispatch.vkGetSemaphoreCounterValue(device, timeline, &value);
+
+	// several threads can query at once, only ever move the cached value forward
+	uint64_t cached = completedValue;
+	while (value > cached && !completedValue.compare_exchange_weak(cached, value)) {
+	}
+
+	return completedValue;
+}
+
+uint64_t FrameScheduler::getLastSubmittedValue(){
+	return lastSubmittedValue;
+}
+
+bool FrameScheduler::isComplete(uint64_t value){
+
+	// check cached value first to avoid querying the driver
+	if (value <= completedValue) {
+		return true;
+	}
+	return value <= getCompletedValue();
+}
+
+void FrameScheduler::wait(uint64_t value){
+
+	if (isComplete(value)) {
+		return;
+	}
+
+	VkSemaphoreWaitInfo waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &timeline;
+	waitInfo.pValues = &value;
+
+	VkResult result = deviceDispatch.vkWaitSemaphores(device, &waitInfo, std::numeric_limits<uint64_t>::max());
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to wait on timeline semaphore");
+	}
+
+	getCompletedValue();
+}
+
+void FrameScheduler::waitForFrame(int frame){
+	wait(frameValues[frame]);
+}
+
+void FrameScheduler::setFrameValue(int frame, uint64_t value){
+	frameValues[frame] = value;
+}
+
+void FrameScheduler::deferUntil(uint64_t value, std::function<void()> callback){
+
+	// already reached, no need to queue it
+	if (isComplete(value)) {
+		callback();
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(deferredMutex);
+	deferredTasks.push_back({ value, std::move(callback) });
+}
+
+void FrameScheduler::collect(){
+
+	uint64_t completed = getCompletedValue();
+
+	// pull out tasks that are ready, run them outside the lock
+	std::vector<DeferredTask> readyTasks;
+	{
+		std::lock_guard<std::mutex> lock(deferredMutex);
+		auto firstReady = std::partition(deferredTasks.begin(), deferredTasks.end(), [completed](const DeferredTask &task) {
+			return task.value > completed;
+		});
+		std::move(firstReady, deferredTasks.end(), std::back_inserter(readyTasks));
+		deferredTasks.erase(firstReady, deferredTasks.end());
+	}
+
+	for (auto &task : readyTasks) {
+		task.callback();
+	}
+}
+
+VkSemaphore FrameScheduler::getSemaphore(){
+	return timeline;
+}
+
+FrameScheduler::~FrameScheduler(){
+
+}
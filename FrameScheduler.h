@@ -0,0 +1,74 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <atomic>
+
+#include "DeviceDispatch.h"
+
+// a value on another timeline semaphore a submission waits for, e.g. a frame waiting on async compute
+struct TimelineWait {
+	VkSemaphore semaphore = VK_NULL_HANDLE;
+	uint64_t value = 0;
+	VkPipelineStageFlags stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+};
+
+// Schedules all GPU work against a single Vulkan 1.2 timeline semaphore.
+// Every submission (frame, upload, compute) signals the next value on the timeline,
+// so the CPU can wait on exactly the value it depends on rather than a per-frame fence
+class FrameScheduler
+{
+public:
+	FrameScheduler();
+
+	void create(VkDevice newDevice, int framesInFlight);
+	void destroy();
+
+	// submit work to a queue that signals the next timeline value, returns that value.
+	// one scheduler per queue that runs alongside the others: values have to be signalled in order
+	uint64_t submit(VkQueue queue, const VkSubmitInfo &submitInfo, uint64_t waitValue = 0, VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		const std::vector<TimelineWait> &otherWaits = {});
+
+	// present under the same lock, the presentation queue may be the queue other threads submit to
+	VkResult present(VkQueue queue, const VkPresentInfoKHR &presentInfo);
+
+	// timeline queries
+	uint64_t getCompletedValue();
+	uint64_t getLastSubmittedValue();
+	bool isComplete(uint64_t value);
+	void wait(uint64_t value);
+
+	// frame in flight tracking
+	void waitForFrame(int frame);
+	void setFrameValue(int frame, uint64_t value);
+
+	// defer work (e.g. resource deletion) until the GPU reaches the given value
+	void deferUntil(uint64_t value, std::function<void()> callback);
+	void collect();
+
+	VkSemaphore getSemaphore();
+
+	~FrameScheduler();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	VkSemaphore timeline = VK_NULL_HANDLE;
+
+	std::mutex submitMutex;							// keeps value order and queue submission order the same
+	std::atomic<uint64_t> lastSubmittedValue{ 0 };	// last value handed to a submission
+	std::atomic<uint64_t> completedValue{ 0 };		// cached counter value, only ever grows
+
+	std::vector<uint64_t> frameValues;				// value signalled by the last submission of each frame in flight
+
+	struct DeferredTask {
+		uint64_t value;
+		std::function<void()> callback;
+	};
+	std::mutex deferredMutex;
+	std::vector<DeferredTask> deferredTasks;
+};
@@ -0,0 +1,204 @@
+#include "GpuProfiler.h"
+
+GpuProfiler::GpuProfiler()
+{
+}
+
+void GpuProfiler::create(VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice newDevice, uint32_t queueFamily, int framesInFlight,
+	bool calibratedTimestampsEnabled, uint32_t newMaxScopes){
+
+	device = newDevice;
+	maxScopes = newMaxScopes;
+
+	// -- TIMESTAMP SUPPORT --
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+	timestampPeriod = deviceProperties.limits.timestampPeriod;
+
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilyList(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilyList.data());
+
+	uint32_t validBits = queueFamily < queueFamilyCount ? queueFamilyList[queueFamily].timestampValidBits : 0;
+	supported = validBits > 0;
+	timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+	if (!supported) {
+		return;
+	}
+
+	// -- CALIBRATION --
+	// only useful if the device can sample the clock the profiler uses
+#ifdef __linux__
+	if (calibratedTimestampsEnabled) {
+		auto getTimeDomains = reinterpret_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(
+			vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT"));
+
+		bool hasDevice = false;
+		bool hasMonotonic = false;
+		if (getTimeDomains != nullptr) {
+			uint32_t domainCount = 0;
+			getTimeDomains(physicalDevice, &domainCount, nullptr);
+			std::vector<VkTimeDomainEXT> domains(domainCount);
+			getTimeDomains(physicalDevice, &domainCount, domains.data());
+
+			for (VkTimeDomainEXT domain : domains) {
+				hasDevice = hasDevice || domain == VK_TIME_DOMAIN_DEVICE_EXT;
+				hasMonotonic = hasMonotonic || domain == VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+			}
+		}
+
+		calibrated = hasDevice && hasMonotonic && deviceDispatch.vkGetCalibratedTimestampsEXT != nullptr;
+	}
+#else
+	(void)instance;
+	(void)calibratedTimestampsEnabled;
+#endif
+
+	// -- QUERY POOLS --
+	VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+	queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolCreateInfo.queryCount = maxScopes * 2;
+
+	frames.resize(framesInFlight);
+	for (auto &frame : frames) {
+		VkQueryPool queryPool;
+		VkResult result = vkCreateQueryPool(device, &queryPoolCreateInfo, nullptr, &queryPool);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error("failed to create a timestamp query pool");
+		}
+		frame.queryPool = UniqueQueryPool(device, queryPool);
+		frame.scopeNames.reserve(maxScopes);
+	}
+	results.resize(maxScopes * 4);
+
+	gpuTrack = Profiler::createTrack("GPU");
+}
+
+void GpuProfiler::destroy(){
+
+	frames.clear();
+	results.clear();
+	calibrated = false;
+	supported = false;
+}
+
+void GpuProfiler::collect(int frame){
+
+	if (!supported) {
+		return;
+	}
+
+	FrameQueries &queries = frames[frame];
+	if (!queries.recorded || queries.scopeNames.empty()) {
+		return;
+	}
+	queries.recorded = false;
+
+	// the frame has finished so this doesn't wait, scopes whose queries aren't available are skipped
+	uint32_t queryCount = static_cast<uint32_t>(queries.scopeNames.size()) * 2;
+	VkResult result = deviceDispatch.vkGetQueryPoolResults(device, queries.queryPool.get(), 0, queryCount, queryCount * 2 * sizeof(uint64_t), results.data(),
+		2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+	if (result != VK_SUCCESS && result != VK_NOT_READY) {
+		return;
+	}
+
+	// a tick and the CPU time it corresponds to
+	uint64_t referenceTicks = results[0] & timestampMask;
+	uint64_t referenceTime = queries.submitTime;
+	if (!calibrate(referenceTicks, referenceTime) && referenceTime == 0) {
+		return;
+	}
+
+	auto toCpuTime = [&](uint64_t ticks) {
+		int64_t delta = static_cast<int64_t>((ticks & timestampMask) - referenceTicks);
+		return referenceTime + static_cast<uint64_t>(static_cast<int64_t>(delta * timestampPeriod));
+	};
+
+	for (size_t i = 0; i < queries.scopeNames.size(); i++) {
+		const uint64_t * begin = &results[i * 4];
+		const uint64_t * end = &results[i * 4 + 2];
+		if (begin[1] == 0 || end[1] == 0) {
+			continue;
+		}
+		Profiler::recordOnTrack(gpuTrack, queries.scopeNames[i], toCpuTime(begin[0]), toCpuTime(end[0]));
+	}
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, int frame){
+
+	if (!supported) {
+		return;
+	}
+
+	FrameQueries &queries = frames[frame];
+	queries.scopeNames.clear();
+	queries.recorded = Profiler::isEnabled();
+
+	if (queries.recorded) {
+		deviceDispatch.vkCmdResetQueryPool(commandBuffer, queries.queryPool.get(), 0, maxScopes * 2);
+	}
+}
+
+uint32_t GpuProfiler::beginScope(VkCommandBuffer commandBuffer, int frame, const char * name){
+
+	if (!supported) {
+		return UINT32_MAX;
+	}
+
+	FrameQueries &queries = frames[frame];
+	if (!queries.recorded || queries.scopeNames.size() >= maxScopes) {
+		return UINT32_MAX;
+	}
+
+	uint32_t scope = static_cast<uint32_t>(queries.scopeNames.size());
+	queries.scopeNames.push_back(name);
+	deviceDispatch.vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queries.queryPool.get(), scope * 2);
+	return scope;
+}
+
+void GpuProfiler::endScope(VkCommandBuffer commandBuffer, int frame, uint32_t scope){
+
+	if (scope == UINT32_MAX) {
+		return;
+	}
+
+	// after everything before it has finished, so the scope covers all of its work
+	deviceDispatch.vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frames[frame].queryPool.get(), scope * 2 + 1);
+}
+
+void GpuProfiler::setSubmitTime(int frame, uint64_t time){
+
+	if (!frames.empty()) {
+		frames[frame].submitTime = time;
+	}
+}
+
+GpuProfiler::~GpuProfiler()
+{
+}
+
+bool GpuProfiler::calibrate(uint64_t &gpuTicks, uint64_t &cpuTime){
+
+	if (!calibrated) {
+		return false;
+	}
+
+	VkCalibratedTimestampInfoEXT timestampInfos[2] = {};
+	timestampInfos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+	timestampInfos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+	timestampInfos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+	timestampInfos[1].timeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+
+	uint64_t timestamps[2];
+	uint64_t maxDeviation;
+	if (deviceDispatch.vkGetCalibratedTimestampsEXT(device, 2, timestampInfos, timestamps, &maxDeviation) != VK_SUCCESS) {
+		return false;
+	}
+
+	// steady_clock is CLOCK_MONOTONIC in nanoseconds here
+	gpuTicks = timestamps[0] & timestampMask;
+	cpuTime = timestamps[1];
+	return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "VulkanHandles.h"
+#include "Profiler.h"
+#include "DeviceDispatch.h"
+
+// Times GPU work with timestamp queries and records it on the profiler's "GPU" track, next to the CPU scopes.
+// Each frame in flight has its own query pool, read back without waiting once the frame has finished on the GPU.
+// GPU ticks are put on the CPU clock with VK_EXT_calibrated_timestamps when the device can sample the same clock as
+// the steady clock (CLOCK_MONOTONIC, so Linux only). Otherwise each frame's first timestamp is lined up with its
+// submission, which is only approximate: durations are exact but a frame's work appears slightly early
+class GpuProfiler
+{
+public:
+	GpuProfiler();
+
+	void create(VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice newDevice, uint32_t queueFamily, int framesInFlight,
+		bool calibratedTimestampsEnabled, uint32_t newMaxScopes = 64);
+	void destroy();
+
+	// record this frame's timestamps, once its previous submission has finished (after waiting on the frame)
+	void collect(int frame);
+
+	// reset the frame's queries, at the start of its command buffer and outside a render pass.
+	// nothing is recorded for frames started while the profiler is disabled
+	void beginFrame(VkCommandBuffer commandBuffer, int frame);
+
+	// name must outlive the profiler. returns the scope to end, scopes past the frame's maximum aren't timed
+	uint32_t beginScope(VkCommandBuffer commandBuffer, int frame, const char * name);
+	void endScope(VkCommandBuffer commandBuffer, int frame, uint32_t scope);
+
+	// CPU time the frame was submitted, for lining timestamps up without calibration
+	void setSubmitTime(int frame, uint64_t time);
+
+	~GpuProfiler();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+
+	bool supported = false;					// the queue family has timestamps
+	double timestampPeriod = 1.0;			// nanoseconds per tick
+	uint64_t timestampMask = ~0ull;			// valid bits of a timestamp
+	uint32_t maxScopes = 0;
+	uint32_t gpuTrack = 0;
+
+	bool calibrated = false;				// device and CLOCK_MONOTONIC timestamps can be sampled together
+
+	// - Frames
+	struct FrameQueries {
+		UniqueQueryPool queryPool;					// begin and end timestamp per scope
+		std::vector<const char *> scopeNames;		// scopes recorded in the frame's last submission
+		bool recorded = false;						// the pool was reset in the last submission
+		uint64_t submitTime = 0;
+	};
+	std::vector<FrameQueries> frames;
+
+	std::vector<uint64_t> results;			// timestamp and availability pairs
+
+	// GPU tick and CPU time at the same moment, false without calibration
+	bool calibrate(uint64_t &gpuTicks, uint64_t &cpuTime);
+};
@@ -0,0 +1,224 @@
+#include "GpuStatistics.h"
+
+#include <cstdio>
+
+namespace {
+
+	// counted statistics, results come back in bit order
+	const VkQueryPipelineStatisticFlags STATISTIC_FLAGS =
+		VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+	const uint32_t STATISTIC_COUNT = 7;
+	const uint32_t RESULT_STRIDE = STATISTIC_COUNT + 1;		// then availability
+}
+
+GpuStatistics::GpuStatistics()
+{
+}
+
+void GpuStatistics::create(VkDevice newDevice, int framesInFlight, bool newPipelineStatisticsEnabled, uint32_t newMaxPasses){
+
+	device = newDevice;
+	pipelineStatisticsEnabled = newPipelineStatisticsEnabled;
+	maxPasses = newMaxPasses;
+
+	frames.resize(framesInFlight);
+	for (auto &frame : frames) {
+		frame.passes.reserve(maxPasses);
+	}
+
+	// without the feature only the recorder counts are kept
+	if (!pipelineStatisticsEnabled) {
+		return;
+	}
+
+	VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+	queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolCreateInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+	queryPoolCreateInfo.queryCount = maxPasses;
+	queryPoolCreateInfo.pipelineStatistics = STATISTIC_FLAGS;
+
+	for (auto &frame : frames) {
+		VkQueryPool queryPool;
+		VkResult result = vkCreateQueryPool(device, &queryPoolCreateInfo, nullptr, &queryPool);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error("failed to create a pipeline statistics query pool");
+		}
+		frame.queryPool = UniqueQueryPool(device, queryPool);
+	}
+	results.resize(maxPasses * RESULT_STRIDE);
+}
+
+void GpuStatistics::destroy(){
+
+	frames.clear();
+	statistics.clear();
+	results.clear();
+	enabled = false;
+}
+
+void GpuStatistics::setEnabled(bool newEnabled){
+	enabled = newEnabled;
+}
+
+bool GpuStatistics::isEnabled(){
+	return enabled;
+}
+
+bool GpuStatistics::hasPipelineStatistics(){
+	return pipelineStatisticsEnabled;
+}
+
+void GpuStatistics::collect(int frame){
+
+	FrameQueries &queries = frames[frame];
+	if (!queries.recorded) {
+		return;
+	}
+	queries.recorded = false;
+
+	// the frame has finished so this doesn't wait, counters of unavailable queries are left at zero
+	uint32_t passCount = static_cast<uint32_t>(queries.passes.size());
+	if (queries.queryPool && passCount > 0) {
+		VkResult result = deviceDispatch.vkGetQueryPoolResults(device, queries.queryPool.get(), 0, passCount, passCount * RESULT_STRIDE * sizeof(uint64_t),
+			results.data(), RESULT_STRIDE * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+		for (uint32_t i = 0; i < passCount && (result == VK_SUCCESS || result == VK_NOT_READY); i++) {
+			const uint64_t * counters = &results[i * RESULT_STRIDE];
+			if (counters[STATISTIC_COUNT] == 0) {
+				continue;
+			}
+
+			PassStatistics &pass = queries.passes[i];
+			pass.inputVertices = counters[0];
+			pass.inputPrimitives = counters[1];
+			pass.vertexInvocations = counters[2];
+			pass.clippingInvocations = counters[3];
+			pass.clippingPrimitives = counters[4];
+			pass.fragmentInvocations = counters[5];
+			pass.computeInvocations = counters[6];
+		}
+	}
+
+	statistics = queries.passes;
+}
+
+void GpuStatistics::beginFrame(VkCommandBuffer commandBuffer, int frame){
+
+	FrameQueries &queries = frames[frame];
+	queries.passes.clear();
+	queries.openPass = UINT32_MAX;
+	queries.recorded = enabled;
+
+	if (queries.recorded && queries.queryPool) {
+		deviceDispatch.vkCmdResetQueryPool(commandBuffer, queries.queryPool.get(), 0, maxPasses);
+	}
+}
+
+uint32_t GpuStatistics::beginPass(VkCommandBuffer commandBuffer, int frame, const std::string &name){
+
+	FrameQueries &queries = frames[frame];
+	if (!queries.recorded || queries.passes.size() >= maxPasses) {
+		return UINT32_MAX;
+	}
+
+	uint32_t pass = static_cast<uint32_t>(queries.passes.size());
+	queries.passes.emplace_back();
+	queries.passes.back().name = name;
+	queries.openPass = pass;
+
+	if (queries.queryPool) {
+		deviceDispatch.vkCmdBeginQuery(commandBuffer, queries.queryPool.get(), pass, 0);
+	}
+	return pass;
+}
+
+void GpuStatistics::endPass(VkCommandBuffer commandBuffer, int frame, uint32_t pass){
+
+	if (pass == UINT32_MAX) {
+		return;
+	}
+
+	FrameQueries &queries = frames[frame];
+	queries.openPass = UINT32_MAX;
+
+	if (queries.queryPool) {
+		deviceDispatch.vkCmdEndQuery(commandBuffer, queries.queryPool.get(), pass);
+	}
+}
+
+void GpuStatistics::countDraws(int frame, uint32_t drawCalls, uint64_t triangles){
+
+	FrameQueries &queries = frames[frame];
+	if (queries.openPass == UINT32_MAX) {
+		return;
+	}
+
+	PassStatistics &pass = queries.passes[queries.openPass];
+	pass.drawCalls += drawCalls;
+	pass.submittedTriangles += triangles;
+}
+
+void GpuStatistics::countBinds(int frame, uint32_t pipelines, uint32_t descriptorSets, uint32_t buffers){
+
+	FrameQueries &queries = frames[frame];
+	if (queries.openPass == UINT32_MAX) {
+		return;
+	}
+
+	PassStatistics &pass = queries.passes[queries.openPass];
+	pass.pipelineBinds += pipelines;
+	pass.descriptorSetBinds += descriptorSets;
+	pass.bufferBinds += buffers;
+}
+
+const std::vector<PassStatistics> &GpuStatistics::getPassStatistics(){
+	return statistics;
+}
+
+PassStatistics GpuStatistics::getFrameTotals(){
+
+	PassStatistics totals;
+	totals.name = "frame";
+	for (const auto &pass : statistics) {
+		totals.drawCalls += pass.drawCalls;
+		totals.pipelineBinds += pass.pipelineBinds;
+		totals.descriptorSetBinds += pass.descriptorSetBinds;
+		totals.bufferBinds += pass.bufferBinds;
+		totals.submittedTriangles += pass.submittedTriangles;
+		totals.inputVertices += pass.inputVertices;
+		totals.inputPrimitives += pass.inputPrimitives;
+		totals.vertexInvocations += pass.vertexInvocations;
+		totals.clippingInvocations += pass.clippingInvocations;
+		totals.clippingPrimitives += pass.clippingPrimitives;
+		totals.fragmentInvocations += pass.fragmentInvocations;
+		totals.computeInvocations += pass.computeInvocations;
+	}
+	return totals;
+}
+
+void GpuStatistics::log(uint64_t pixelCount){
+
+	// vertex invocations per input vertex is what the post transform cache left to shade (1.0 means no reuse),
+	// overdraw is fragments per pixel of the render area
+	for (const auto &pass : statistics) {
+		double shadedPerVertex = pass.inputVertices > 0 ? static_cast<double>(pass.vertexInvocations) / pass.inputVertices : 0.0;
+		double overdraw = pixelCount > 0 ? static_cast<double>(pass.fragmentInvocations) / pixelCount : 0.0;
+
+		printf("pass %s: %u draws, %u pipeline / %u set / %u buffer binds, %llu triangles submitted, %llu primitives in, %llu after clipping, "
+			"%.2f shaded per vertex, %.2fx overdraw, %llu compute invocations\n",
+			pass.name.c_str(), pass.drawCalls, pass.pipelineBinds, pass.descriptorSetBinds, pass.bufferBinds,
+			(unsigned long long)pass.submittedTriangles, (unsigned long long)pass.inputPrimitives,
+			(unsigned long long)pass.clippingPrimitives,
+			shadedPerVertex, overdraw, (unsigned long long)pass.computeInvocations);
+	}
+}
+
+GpuStatistics::~GpuStatistics()
+{
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "VulkanHandles.h"
+#include "DeviceDispatch.h"
+
+// what one pass of a frame did. recorder counts are made on the CPU while recording, the rest come from a
+// pipeline statistics query around the pass (zero without the pipelineStatisticsQuery feature)
+struct PassStatistics {
+	std::string name;
+
+	// - Recorder
+	uint32_t drawCalls = 0;					// direct and indirect draw commands
+	uint32_t pipelineBinds = 0;
+	uint32_t descriptorSetBinds = 0;
+	uint32_t bufferBinds = 0;				// vertex and index buffer binds
+	uint64_t submittedTriangles = 0;		// most the draws can produce, indirect draws may be culled to fewer on the GPU
+
+	// - Pipeline statistics
+	uint64_t inputVertices = 0;				// input assembly
+	uint64_t inputPrimitives = 0;
+	uint64_t vertexInvocations = 0;			// fewer than inputVertices when the post transform cache hits
+	uint64_t clippingInvocations = 0;		// primitives reaching clipping
+	uint64_t clippingPrimitives = 0;		// primitives leaving it
+	uint64_t fragmentInvocations = 0;		// over the pixels covered gives overdraw
+	uint64_t computeInvocations = 0;
+};
+
+// Per pass GPU counters and recorder counts. Each frame in flight has its own query pool, read back without
+// waiting once the frame has finished, so the statistics are from a few frames ago but never stall the frame.
+// Pipeline statistics queries can't nest, so passes must not overlap (render graph passes don't).
+// Mesh shader draws aren't counted by the vertex / input assembly statistics
+class GpuStatistics
+{
+public:
+	GpuStatistics();
+
+	void create(VkDevice newDevice, int framesInFlight, bool newPipelineStatisticsEnabled, uint32_t newMaxPasses = 32);
+	void destroy();
+
+	// frames aren't counted until enabled
+	void setEnabled(bool newEnabled);
+	bool isEnabled();
+	bool hasPipelineStatistics();
+
+	// take this frame's results, once its previous submission has finished (after waiting on the frame)
+	void collect(int frame);
+
+	// reset the frame's queries, at the start of its command buffer and outside a render pass
+	void beginFrame(VkCommandBuffer commandBuffer, int frame);
+
+	// name is copied. returns the pass to end, passes past the frame's maximum aren't counted
+	uint32_t beginPass(VkCommandBuffer commandBuffer, int frame, const std::string &name);
+	void endPass(VkCommandBuffer commandBuffer, int frame, uint32_t pass);
+
+	// recorder counts, added to the frame's open pass
+	void countDraws(int frame, uint32_t drawCalls, uint64_t triangles);
+	void countBinds(int frame, uint32_t pipelines, uint32_t descriptorSets, uint32_t buffers);
+
+	// passes of the most recently collected frame, and everything they did together
+	const std::vector<PassStatistics> &getPassStatistics();
+	PassStatistics getFrameTotals();
+
+	// one line per pass of the most recently collected frame, pixelCount is the render area for overdraw
+	void log(uint64_t pixelCount);
+
+	~GpuStatistics();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+
+	bool enabled = false;
+	bool pipelineStatisticsEnabled = false;
+	uint32_t maxPasses = 0;
+
+	// - Frames
+	struct FrameQueries {
+		UniqueQueryPool queryPool;					// one pipeline statistics query per pass
+		std::vector<PassStatistics> passes;			// passes of the frame's last submission
+		uint32_t openPass = UINT32_MAX;				// pass recorder counts go to
+		bool recorded = false;
+	};
+	std::vector<FrameQueries> frames;
+
+	std::vector<PassStatistics> statistics;			// last collected frame
+	std::vector<uint64_t> results;					// counters and availability of each query
+};
@@ -0,0 +1,387 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <chrono>
+
+// deque of the thread running, so run() pushes to the caller's own deque
+static thread_local JobSystem * currentJobSystem = nullptr;
+static thread_local uint32_t currentQueueIndex = 0;
+
+// failed steals before an idle worker goes to sleep
+static const int IDLE_SPIN_COUNT = 64;
+
+JobSystem::JobSystem(){
+
+}
+
+void JobSystem::create(uint32_t workerCount){
+
+	if (workerCount == 0) {
+		uint32_t coreCount = std::thread::hardware_concurrency();
+		workerCount = coreCount > 1 ? coreCount - 1 : 1;
+	}
+
+	mainThreadId = std::this_thread::get_id();
+	Profiler::setThreadName("main");
+	currentJobSystem = this;
+	currentQueueIndex = 0;
+
+	stopping = false;
+	queuedJobs = 0;
+	uncountedError = nullptr;
+
+	// every deque exists before any worker can steal from it
+	queues.resize(workerCount + 1);
+	for (auto &queue : queues) {
+		queue = std::make_unique<WorkerQueue>();
+	}
+
+	for (uint32_t i = 0; i < workerCount; i++) {
+		workers.emplace_back(&JobSystem::workerLoop, this, i + 1);
+	}
+}
+
+void JobSystem::destroy(){
+
+	// jobs that haven't started are dropped, wait on their counters first to finish them
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wakeCondition.notify_all();
+
+	for (auto &worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+	queues.clear();
+	mainThreadJobs.clear();
+
+	if (currentJobSystem == this) {
+		currentJobSystem = nullptr;
+	}
+}
+
+void JobSystem::run(std::function<void()> job, JobCounter * counter){
+
+	if (counter != nullptr) {
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	}
+	push(wrapJob(std::move(job), counter));
+}
+
+void JobSystem::runAfter(JobCounter * dependency, std::function<void()> job, JobCounter * counter){
+
+	// counted straight away, so waiting on the counter also waits for the held back job
+	if (counter != nullptr) {
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	}
+	std::function<void()> wrappedJob = wrapJob(std::move(job), counter);
+
+	// checked under the lock the last finishing job takes to release continuations, so it can't be missed
+	{
+		std::lock_guard<std::mutex> lock(dependency->continuationMutex);
+		if (!dependency->isDone()) {
+			dependency->continuations.push_back(std::move(wrappedJob));
+			return;
+		}
+	}
+	push(std::move(wrappedJob));
+}
+
+void JobSystem::parallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t, uint32_t)> &job, JobCounter * counter){
+
+	if (batchSize == 0) {
+		batchSize = 1;
+	}
+
+	// one copy shared by every batch, the caller's may be gone before they run
+	auto sharedJob = std::make_shared<std::function<void(uint32_t, uint32_t)>>(job);
+	for (uint32_t begin = 0; begin < count; begin += batchSize) {
+		uint32_t end = std::min(begin + batchSize, count);
+		run([sharedJob, begin, end]() { (*sharedJob)(begin, end); }, counter);
+	}
+}
+
+void JobSystem::runOnMainThread(std::function<void()> job, JobCounter * counter){
+
+	if (counter != nullptr) {
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	std::lock_guard<std::mutex> lock(mainThreadMutex);
+	mainThreadJobs.push_back(wrapJob(std::move(job), counter));
+}
+
+void JobSystem::runMainThreadJobs(){
+
+	if (!isMainThread()) {
+		throw std::runtime_error("main thread jobs can only be run on the main thread");
+	}
+
+	// taken all at once, jobs queued while these run wait for the next call
+	std::deque<std::function<void()>> jobs;
+	{
+		std::lock_guard<std::mutex> lock(mainThreadMutex);
+		jobs.swap(mainThreadJobs);
+	}
+
+	for (auto &job : jobs) {
+		job();
+	}
+
+	rethrowUncountedError();
+}
+
+void JobSystem::wait(JobCounter * counter){
+
+	bool mainThread = isMainThread();
+	uint32_t queueIndex = getQueueIndex();
+
+	// help out rather than block, the jobs being waited on may be sitting in this thread's own deque
+	while (!counter->isDone()) {
+
+		if (mainThread) {
+			runMainThreadJobs();
+		}
+
+		if (!tryRunJob(queueIndex)) {
+			std::this_thread::yield();
+		}
+	}
+
+	// first failure of the counter's jobs is rethrown on the waiting thread
+	std::exception_ptr error;
+	{
+		std::lock_guard<std::mutex> lock(counter->continuationMutex);
+		error = counter->error;
+		counter->error = nullptr;
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+
+	if (mainThread) {
+		rethrowUncountedError();
+	}
+}
+
+uint32_t JobSystem::getThreadCount(){
+	return static_cast<uint32_t>(workers.size() + 1);
+}
+
+bool JobSystem::isMainThread(){
+	return std::this_thread::get_id() == mainThreadId;
+}
+
+void JobSystem::benchmark(uint32_t jobCount){
+
+	if (jobCount == 0) {
+		return;
+	}
+
+	using Clock = std::chrono::steady_clock;
+	auto nanosecondsPerJob = [](Clock::time_point start, uint32_t count) {
+		return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+	};
+
+	// -- EMPTY JOBS --
+	// queued from the main thread and stolen by the workers, so this is mostly push, steal and counter overhead
+	JobCounter emptyJobs;
+	Clock::time_point start = Clock::now();
+	for (uint32_t i = 0; i < jobCount; i++) {
+		run([]() {}, &emptyJobs);
+	}
+	wait(&emptyJobs);
+	double emptyTime = nanosecondsPerJob(start, jobCount);
+
+	// -- PARALLEL FOR --
+	// a little work in every batch, against running the same batches inline on this thread
+	const uint32_t batchWork = 1000;
+	std::vector<uint32_t> results(jobCount);
+	auto work = [&results](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			uint32_t value = i;
+			for (uint32_t j = 0; j < batchWork; j++) {
+				value = value * 1664525u + 1013904223u;
+			}
+			results[i] = value;
+		}
+	};
+
+	start = Clock::now();
+	work(0, jobCount);
+	double inlineTime = nanosecondsPerJob(start, jobCount);
+
+	JobCounter batchJobs;
+	start = Clock::now();
+	parallelFor(jobCount, 1, work, &batchJobs);
+	wait(&batchJobs);
+	double batchTime = nanosecondsPerJob(start, jobCount);
+
+	// -- DEPENDENCY CHAIN --
+	// every job is held back until the one before it has finished, so nothing runs in parallel and this is the
+	// latency of releasing a continuation
+	uint32_t chainLength = std::min<uint32_t>(jobCount, 10000);
+	std::vector<std::unique_ptr<JobCounter>> chain(chainLength);
+	for (auto &counter : chain) {
+		counter = std::make_unique<JobCounter>();
+	}
+
+	start = Clock::now();
+	run([]() {}, chain[0].get());
+	for (uint32_t i = 1; i < chainLength; i++) {
+		runAfter(chain[i - 1].get(), []() {}, chain[i].get());
+	}
+	wait(chain[chainLength - 1].get());
+	double chainTime = nanosecondsPerJob(start, chainLength);
+
+	printf("job system with %u threads, %u jobs: %.1f ns an empty job, %.1f ns a batch of %u steps (%.1f ns inline, %.2fx), "
+		"%.1f ns a dependency hop over %u jobs\n", getThreadCount(), jobCount, emptyTime, batchTime, batchWork, inlineTime,
+		batchTime > 0.0 ? inlineTime / batchTime : 0.0, chainTime, chainLength);
+}
+
+JobSystem::~JobSystem(){
+
+}
+
+void JobSystem::workerLoop(uint32_t index){
+
+	currentJobSystem = this;
+	currentQueueIndex = index;
+	Profiler::setThreadName("worker " + std::to_string(index));
+
+	int idleCount = 0;
+	while (!stopping) {
+
+		if (tryRunJob(index)) {
+			idleCount = 0;
+			continue;
+		}
+
+		// new work usually follows shortly, so spin briefly before paying for a sleep and wake up
+		if (++idleCount < IDLE_SPIN_COUNT) {
+			std::this_thread::yield();
+			continue;
+		}
+		idleCount = 0;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepingWorkers++;
+		wakeCondition.wait(lock, [this]() { return stopping || queuedJobs.load() > 0; });
+		sleepingWorkers--;
+	}
+}
+
+void JobSystem::push(std::function<void()> job){
+
+	WorkerQueue &queue = *queues[getQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(std::move(job));
+	}
+	queuedJobs++;
+
+	// a sleeper checks queuedJobs after counting itself, so either it sees this job or this sees it asleep
+	if (sleepingWorkers.load() > 0) {
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		wakeCondition.notify_one();
+	}
+}
+
+bool JobSystem::tryRunJob(uint32_t index){
+
+	std::function<void()> job;
+
+	// own deque from the back (newest first)
+	{
+		WorkerQueue &queue = *queues[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty()) {
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+		}
+	}
+
+	// otherwise steal the oldest job of another thread, starting after this one so thieves spread out
+	for (size_t i = 1; !job && i < queues.size(); i++) {
+
+		WorkerQueue &queue = *queues[(index + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty()) {
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+		}
+	}
+
+	if (!job) {
+		return false;
+	}
+
+	queuedJobs--;
+	job();
+	return true;
+}
+
+void JobSystem::finishJob(JobCounter * counter){
+
+	if (counter == nullptr || counter->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+		return;
+	}
+
+	// last job of the counter, release whatever was waiting on it
+	std::vector<std::function<void()>> continuations;
+	{
+		std::lock_guard<std::mutex> lock(counter->continuationMutex);
+		continuations.swap(counter->continuations);
+	}
+
+	for (auto &continuation : continuations) {
+		push(std::move(continuation));
+	}
+}
+
+std::function<void()> JobSystem::wrapJob(std::function<void()> job, JobCounter * counter){
+
+	return [this, job = std::move(job), counter]() {
+
+		// a throwing job must still count as finished, or its waiter would spin forever
+		try
+		{
+			job();
+		}
+		catch (...)
+		{
+			// with no counter there is no waiter to hand it to, so the main thread rethrows it instead
+			std::mutex &mutex = counter != nullptr ? counter->continuationMutex : errorMutex;
+			std::exception_ptr &error = counter != nullptr ? counter->error : uncountedError;
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!error) {
+				error = std::current_exception();
+			}
+		}
+
+		finishJob(counter);
+	};
+}
+
+void JobSystem::rethrowUncountedError(){
+
+	std::exception_ptr error;
+	{
+		std::lock_guard<std::mutex> lock(errorMutex);
+		error = uncountedError;
+		uncountedError = nullptr;
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+uint32_t JobSystem::getQueueIndex(){
+
+	// threads that aren't workers share the main thread's deque
+	return currentJobSystem == this ? currentQueueIndex : 0;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <string>
+
+#include "Profiler.h"
+
+// Counts the unfinished jobs of a group. Jobs can be made to wait for a counter, they are held back
+// (not polled) until it reaches zero. A counter must not be reused until everything waiting on it has started
+struct JobCounter {
+	std::atomic<int> pending{ 0 };
+
+	// - Jobs waiting for pending to reach zero
+	std::mutex continuationMutex;
+	std::vector<std::function<void()>> continuations;
+	std::exception_ptr error;						// first exception thrown by one of its jobs
+
+	bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+// Work stealing job scheduler, has no Vulkan dependency so it can be used by anything.
+// Every worker (and the main thread) owns a deque: its own jobs are pushed and popped at the back so the most
+// recent (cache warm) work runs first, idle workers steal the oldest job from the front of someone else's deque.
+// Waiting on a counter runs other jobs meanwhile instead of blocking, so jobs may wait on jobs they started.
+// Jobs that must run on the main thread (window events, presentation) go to a separate queue only it drains
+class JobSystem
+{
+public:
+	JobSystem();
+
+	// the calling thread becomes the main thread. 0 workers means one per core besides the main thread
+	void create(uint32_t workerCount = 0);
+	void destroy();
+
+	// queue a job, counter (optional) is incremented now and decremented once the job has run
+	void run(std::function<void()> job, JobCounter * counter = nullptr);
+
+	// queue a job once dependency has reached zero
+	void runAfter(JobCounter * dependency, std::function<void()> job, JobCounter * counter = nullptr);
+
+	// split [0, count) in to batches of batchSize, job(begin, end) runs once per batch
+	void parallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t, uint32_t)> &job, JobCounter * counter);
+
+	// queue a job for the main thread, it runs in its next wait or runMainThreadJobs
+	void runOnMainThread(std::function<void()> job, JobCounter * counter = nullptr);
+
+	// also rethrows the first exception thrown by a job queued without a counter, since nothing else waits for those
+	void runMainThreadJobs();
+
+	// run jobs until the counter reaches zero, then rethrow the first exception its jobs threw.
+	// on the main thread, an exception from a job without a counter is rethrown as well
+	void wait(JobCounter * counter);
+
+	uint32_t getThreadCount();			// workers + the main thread
+	bool isMainThread();
+
+	// time queueing and waiting on jobCount empty jobs, splitting a small loop over jobCount batches and a chain of
+	// runAfter hops, and print the cost a job. call from the main thread while nothing else is queued
+	void benchmark(uint32_t jobCount);
+
+	~JobSystem();
+
+private:
+	// - Deques
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> jobs;
+	};
+	std::vector<std::unique_ptr<WorkerQueue>> queues;		// index 0 belongs to the main thread
+	std::vector<std::thread> workers;
+
+	std::mutex mainThreadMutex;
+	std::deque<std::function<void()>> mainThreadJobs;
+	std::thread::id mainThreadId;
+
+	// - Errors
+	std::mutex errorMutex;
+	std::exception_ptr uncountedError;						// first exception thrown by a job without a counter
+
+	// - Sleeping
+	std::atomic<uint32_t> queuedJobs{ 0 };					// jobs in any deque, idle workers sleep while it is zero
+	std::atomic<uint32_t> sleepingWorkers{ 0 };
+	std::atomic<bool> stopping{ false };
+	std::mutex sleepMutex;
+	std::condition_variable wakeCondition;
+
+	void workerLoop(uint32_t index);
+	void push(std::function<void()> job);
+	bool tryRunJob(uint32_t index);
+	void finishJob(JobCounter * counter);
+	std::function<void()> wrapJob(std::function<void()> job, JobCounter * counter);
+	void rethrowUncountedError();
+	uint32_t getQueueIndex();
+};
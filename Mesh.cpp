@@ -1,110 +1,172 @@
-#include "Mesh.h"
-
-
-
-Mesh::Mesh(){
-
-}
-
-Mesh::Mesh(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<Vertex>* vertices, std::vector<uint32_t> * indices){
-
-	vertexCount = vertices->size();
-	indexCount = indices->size();
-	physicalDevice = newPhysicalDevice;
-	device = newDevice;
-	createVertexBuffer(transferQueue, transferCommandPool, vertices);
-	createIndexBuffer(transferQueue, transferCommandPool, indices);
-}
-
-int Mesh::getVertexCount(){
-	return vertexCount;
-}
-
-VkBuffer Mesh::getVertexBuffer(){
-	return vertexBuffer;
-}
-
-int Mesh::getIndexCount()
-{
-	return indexCount;
-}
-
-VkBuffer Mesh::getIndexBuffer(){
-	return indexBuffer;
-}
-
-void Mesh::destroyBuffers(){
-
-	vkDestroyBuffer(device, vertexBuffer, nullptr);
-	vkFreeMemory(device, vertexBufferMemory, nullptr);
-	vkDestroyBuffer(device, indexBuffer, nullptr);
-	vkFreeMemory(device, indexBufferMemory, nullptr);
-}
-
-
-Mesh::~Mesh(){
-
-}
-
-void Mesh::createVertexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<Vertex> * vertices){
-
-	// get size of buffer needed for vertices
-	VkDeviceSize bufferSize = sizeof(Vertex) * vertices->size();
-
-	// temp buffer to "stage" vertex data before transferring to gpu
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-
-	// create buffer and allocate memory to it
-	createBuffer(physicalDevice, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, &stagingBufferMemory);
-
-
-
-	// MAP MEMORY TO VERTEX BUFFER
-	void * data;																// 1. Create pointer to a point in normal memory
-	vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);			// 2. "Map" the vertex buffer memory to that point
-	memcpy(data, vertices->data(), (size_t)bufferSize);							// 3. Copy memory from vertices vector to the point
-	vkUnmapMemory(device, stagingBufferMemory);									// 4. Unmap the vertex buffer memory
-
-	// create buffer with transfer destintation bit to mark as recipient of transfer data
-	createBuffer(physicalDevice, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &vertexBuffer, &vertexBufferMemory);
-
-	// copy staging buffer to vertex buffer on GPU
-	copyBuffer(device, transferQueue, transferCommandPool, stagingBuffer, vertexBuffer, bufferSize);
-
-	// clean up staging buffer parts
-	vkDestroyBuffer(device, stagingBuffer, nullptr);
-	vkFreeMemory(device, stagingBufferMemory, nullptr);
-}
-
-void Mesh::createIndexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<uint32_t>* indices){
-
-	// get size of buffer needed for indices
-	VkDeviceSize bufferSize = sizeof(uint32_t) * indices->size();
-
-	// temp buffer to "stage" index data before transferring to gpu
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-	createBuffer(physicalDevice, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &stagingBuffer, &stagingBufferMemory);
-
-	// MAP MEMORY TO VERTEX BUFFER
-	void * data;																
-	vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);			
-	memcpy(data, indices->data(), (size_t)bufferSize);							
-	vkUnmapMemory(device, stagingBufferMemory);									
-
-	// create buffer for index data on GPU access only area
-	createBuffer(physicalDevice, device, bufferSize, 
-		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &indexBuffer, &indexBufferMemory);
-
-	// copy from staging buffer to GPU access buffer
-	copyBuffer(device, transferQueue, transferCommandPool, stagingBuffer, indexBuffer, bufferSize);
-
-	// destroy + release stagomg niffer resources
-	vkDestroyBuffer(device, stagingBuffer, nullptr);
-	vkFreeMemory(device, stagingBufferMemory, nullptr);
-}
-
+#include "Mesh.h"
+
+
+
+Mesh::Mesh(){
+
+}
+
+Mesh::Mesh(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, UploadManager * uploadManager, DeviceAllocator * newAllocator, std::vector<Vertex>* vertices, std::vector<uint32_t> * indices){
+
+	vertexCount = vertices->size();
+	indexCount = indices->size();
+	physicalDevice = newPhysicalDevice;
+	device = newDevice;
+	allocator = newAllocator;
+	calculateBounds(vertices);
+
+	// the index buffer is uploaded in meshlet order, same triangles so the plain draw is unchanged
+	hostMeshlets = buildMeshlets(*vertices, *indices);
+	meshletCount = static_cast<int>(hostMeshlets.meshlets.size());
+
+	// shaders read the triangle bytes as packed uints, so round up to a whole uint
+	hostMeshlets.triangles.resize((hostMeshlets.triangles.size() + 3) & ~size_t(3), 0);
+
+	hostVertices = *vertices;
+	createBuffers(uploadManager);
+}
+
+int Mesh::getVertexCount(){
+	return vertexCount;
+}
+
+VkBuffer Mesh::getVertexBuffer(){
+	return vertexBuffer.get();
+}
+
+int Mesh::getIndexCount()
+{
+	return indexCount;
+}
+
+VkBuffer Mesh::getIndexBuffer(){
+	return indexBuffer.get();
+}
+
+int Mesh::getMeshletCount(){
+	return meshletCount;
+}
+
+VkBuffer Mesh::getMeshletBuffer(){
+	return meshletBuffer.get();
+}
+
+VkBuffer Mesh::getMeshletVertexBuffer(){
+	return meshletVertexBuffer.get();
+}
+
+VkBuffer Mesh::getMeshletTriangleBuffer(){
+	return meshletTriangleBuffer.get();
+}
+
+glm::vec3 Mesh::getBoundsMin(){
+	return boundsMin;
+}
+
+glm::vec3 Mesh::getBoundsMax(){
+	return boundsMax;
+}
+
+void Mesh::retireBuffers(DeletionQueue * deletionQueue){
+
+	// frames in flight may still be drawing this mesh, so hand ownership to the deletion queue
+	// and destroy once they have finished
+	deletionQueue->retireBuffer(vertexBuffer.release());
+	deletionQueue->retireMemory(vertexBufferMemory.release());
+	deletionQueue->retireBuffer(indexBuffer.release());
+	deletionQueue->retireMemory(indexBufferMemory.release());
+	deletionQueue->retireBuffer(meshletBuffer.release());
+	deletionQueue->retireMemory(meshletBufferMemory.release());
+	deletionQueue->retireBuffer(meshletVertexBuffer.release());
+	deletionQueue->retireMemory(meshletVertexBufferMemory.release());
+	deletionQueue->retireBuffer(meshletTriangleBuffer.release());
+	deletionQueue->retireMemory(meshletTriangleBufferMemory.release());
+	residentBytes = 0;
+}
+
+bool Mesh::isResident(){
+	return static_cast<bool>(vertexBuffer);
+}
+
+VkDeviceSize Mesh::getResidentBytes(){
+	return residentBytes;
+}
+
+void Mesh::evict(DeletionQueue * deletionQueue){
+
+	if (isResident()) {
+		retireBuffers(deletionQueue);
+	}
+}
+
+void Mesh::reload(UploadManager * uploadManager){
+
+	if (!isResident()) {
+		createBuffers(uploadManager);
+	}
+}
+
+Mesh::~Mesh(){
+	// buffers and memory are released by their handle owners
+}
+
+void Mesh::calculateBounds(std::vector<Vertex> * vertices){
+
+	if (vertices->empty()) {
+		return;
+	}
+
+	// axis aligned box around every vertex, used for culling
+	boundsMin = (*vertices)[0].pos;
+	boundsMax = (*vertices)[0].pos;
+	for (const auto &vertex : *vertices) {
+		boundsMin = glm::min(boundsMin, vertex.pos);
+		boundsMax = glm::max(boundsMax, vertex.pos);
+	}
+}
+
+void Mesh::createBuffers(UploadManager * uploadManager){
+
+	createVertexBuffer(uploadManager, &hostVertices);
+	createIndexBuffer(uploadManager, &hostMeshlets.indices);
+	createMeshletBuffers(uploadManager, &hostMeshlets);
+}
+
+void Mesh::createVertexBuffer(UploadManager * uploadManager, std::vector<Vertex> * vertices){
+
+	// also a storage buffer so the mesh shader can fetch vertices itself
+	createDeviceBuffer(uploadManager, vertices->data(), sizeof(Vertex) * vertices->size(),
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &vertexBuffer, &vertexBufferMemory);
+}
+
+void Mesh::createIndexBuffer(UploadManager * uploadManager, std::vector<uint32_t>* indices){
+
+	createDeviceBuffer(uploadManager, indices->data(), sizeof(uint32_t) * indices->size(),
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT, &indexBuffer, &indexBufferMemory);
+}
+
+void Mesh::createMeshletBuffers(UploadManager * uploadManager, MeshletData * meshletData){
+
+	createDeviceBuffer(uploadManager, meshletData->meshlets.data(), sizeof(Meshlet) * meshletData->meshlets.size(),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &meshletBuffer, &meshletBufferMemory);
+	createDeviceBuffer(uploadManager, meshletData->vertices.data(), sizeof(uint32_t) * meshletData->vertices.size(),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &meshletVertexBuffer, &meshletVertexBufferMemory);
+	createDeviceBuffer(uploadManager, meshletData->triangles.data(), meshletData->triangles.size(),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &meshletTriangleBuffer, &meshletTriangleBufferMemory);
+}
+
+void Mesh::createDeviceBuffer(UploadManager * uploadManager, const void * bufferData, VkDeviceSize bufferSize, VkBufferUsageFlags bufferUsage,
+	UniqueBuffer * deviceBuffer, UniqueDeviceMemory * deviceBufferMemory){
+
+	// create buffer with transfer destintation bit to mark as recipient of transfer data, in GPU access only memory
+	VkBuffer buffer;
+	VkDeviceMemory memory;
+	createBuffer(physicalDevice, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | bufferUsage,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &buffer, &memory, allocator);
+	*deviceBufferMemory = UniqueDeviceMemory(allocator, memory);
+	*deviceBuffer = UniqueBuffer(device, buffer);
+	residentBytes += allocator->getSize(memory);
+
+	// staged on this thread's staging block, the copy is submitted with the upload manager's next flush
+	uploadManager->uploadBuffer(deviceBuffer->get(), bufferData, bufferSize);
+}
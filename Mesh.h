@@ -1,44 +1,98 @@
-#pragma once
-
-#define GLFW_INCLUDE_VULKAN
-#include <GLFW/glfw3.h>
-
-#include <vector>
-
-#include "Utilities.h"
-
-class Mesh
-{
-public:
-	Mesh();
-	Mesh(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, 
-		VkQueue transferQueue, VkCommandPool transferCommandPool, 
-		std::vector<Vertex> * vertices, std::vector<uint32_t> * indices);
-
-	int getVertexCount();
-	VkBuffer getVertexBuffer();
-
-	int getIndexCount();
-	VkBuffer getIndexBuffer();
-
-	void destroyBuffers();
-
-	~Mesh();
-
-private:
-	int vertexCount;
-	VkBuffer vertexBuffer;
-	VkDeviceMemory vertexBufferMemory;
-
-	int indexCount;
-	VkBuffer indexBuffer;
-	VkDeviceMemory indexBufferMemory;
-
-	VkPhysicalDevice physicalDevice;
-	VkDevice device;
-
-	void createVertexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<Vertex> * vertices);
-	void createIndexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<uint32_t> * indices);
-
-};
-
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+#include "Utilities.h"
+#include "DeletionQueue.h"
+#include "VulkanHandles.h"
+#include "Meshlet.h"
+#include "UploadManager.h"
+
+// Mesh owns its GPU buffers, so it can be moved but never copied.
+// It is split in to meshlets on load, the index buffer holds the triangles in meshlet order
+// so each meshlet can also be drawn as its own index range.
+// Construction is thread safe, buffer contents go through the upload manager and are on the GPU
+// once its next flush has been submitted.
+// The mesh keeps a host copy of its data, so its buffers can be evicted to free device memory and reloaded later
+class Mesh
+{
+public:
+	Mesh();
+	Mesh(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, UploadManager * uploadManager, DeviceAllocator * newAllocator,
+		std::vector<Vertex> * vertices, std::vector<uint32_t> * indices);
+
+	Mesh(const Mesh &) = delete;
+	Mesh &operator=(const Mesh &) = delete;
+	Mesh(Mesh &&) = default;
+	Mesh &operator=(Mesh &&) = default;
+
+	int getVertexCount();
+	VkBuffer getVertexBuffer();
+
+	int getIndexCount();
+	VkBuffer getIndexBuffer();
+
+	// meshlets, and the meshlet vertex / triangle lists read by the mesh shader
+	int getMeshletCount();
+	VkBuffer getMeshletBuffer();
+	VkBuffer getMeshletVertexBuffer();
+	VkBuffer getMeshletTriangleBuffer();
+
+	// object space bounding box of the vertices
+	glm::vec3 getBoundsMin();
+	glm::vec3 getBoundsMax();
+
+	void retireBuffers(DeletionQueue * deletionQueue);
+
+	// - Residency
+	// an evicted mesh keeps its counts and bounds but has no buffers until it is reloaded
+	bool isResident();
+	VkDeviceSize getResidentBytes();				// device memory held by the buffers
+	void evict(DeletionQueue * deletionQueue);
+	void reload(UploadManager * uploadManager);
+
+	~Mesh();
+
+private:
+	// memory declared before its buffer, so the buffer is destroyed first
+	int vertexCount = 0;
+	UniqueDeviceMemory vertexBufferMemory;
+	UniqueBuffer vertexBuffer;
+
+	int indexCount = 0;
+	UniqueDeviceMemory indexBufferMemory;
+	UniqueBuffer indexBuffer;
+
+	int meshletCount = 0;
+	UniqueDeviceMemory meshletBufferMemory;
+	UniqueBuffer meshletBuffer;
+	UniqueDeviceMemory meshletVertexBufferMemory;
+	UniqueBuffer meshletVertexBuffer;
+	UniqueDeviceMemory meshletTriangleBufferMemory;
+	UniqueBuffer meshletTriangleBuffer;
+
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+
+	// host copies the buffers are made from
+	std::vector<Vertex> hostVertices;
+	MeshletData hostMeshlets;
+	VkDeviceSize residentBytes = 0;
+
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	DeviceAllocator * allocator = nullptr;
+
+	void calculateBounds(std::vector<Vertex> * vertices);
+	void createBuffers(UploadManager * uploadManager);
+	void createVertexBuffer(UploadManager * uploadManager, std::vector<Vertex> * vertices);
+	void createIndexBuffer(UploadManager * uploadManager, std::vector<uint32_t> * indices);
+	void createMeshletBuffers(UploadManager * uploadManager, MeshletData * meshletData);
+	void createDeviceBuffer(UploadManager * uploadManager, const void * bufferData, VkDeviceSize bufferSize, VkBufferUsageFlags bufferUsage,
+		UniqueBuffer * deviceBuffer, UniqueDeviceMemory * deviceBufferMemory);
+
+};
+
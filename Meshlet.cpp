@@ -0,0 +1,132 @@
+#include "Meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+
+static void calculateMeshletBounds(const std::vector<Vertex> &vertices, const MeshletData &data, Meshlet &meshlet){
+
+	// bounding sphere centered on the box around the meshlet's vertices
+	glm::vec3 boundsMin = vertices[data.vertices[meshlet.vertexOffset]].pos;
+	glm::vec3 boundsMax = boundsMin;
+	for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+		const glm::vec3 &pos = vertices[data.vertices[meshlet.vertexOffset + i]].pos;
+		boundsMin = glm::min(boundsMin, pos);
+		boundsMax = glm::max(boundsMax, pos);
+	}
+
+	glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	float radius = 0.0f;
+	for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+		radius = std::max(radius, glm::length(vertices[data.vertices[meshlet.vertexOffset + i]].pos - center));
+	}
+
+	meshlet.sphere = glm::vec4(center, radius);
+
+	// cutoff above 1 never passes the cone test, so the meshlet is only frustum culled
+	meshlet.cone = glm::vec4(0.0f, 0.0f, 0.0f, 2.0f);
+
+	// normal cone: axis is the average triangle normal, its width is set by the normal furthest from it
+	std::vector<glm::vec3> normals;
+	normals.reserve(meshlet.triangleCount);
+	glm::vec3 normalSum(0.0f);
+	for (uint32_t i = 0; i < meshlet.triangleCount; i++) {
+
+		const uint8_t * triangle = &data.triangles[meshlet.triangleOffset + i * 3];
+		glm::vec3 a = vertices[data.vertices[meshlet.vertexOffset + triangle[0]]].pos;
+		glm::vec3 b = vertices[data.vertices[meshlet.vertexOffset + triangle[1]]].pos;
+		glm::vec3 c = vertices[data.vertices[meshlet.vertexOffset + triangle[2]]].pos;
+
+		// clockwise front faces, so this normal points out of the front
+		glm::vec3 normal = glm::cross(c - a, b - a);
+		float area = glm::length(normal);
+		if (area == 0.0f) {
+			continue;
+		}
+
+		normals.push_back(normal / area);
+		normalSum += normal / area;
+	}
+
+	float axisLength = glm::length(normalSum);
+	if (normals.empty() || axisLength == 0.0f) {
+		return;
+	}
+
+	glm::vec3 axis = normalSum / axisLength;
+	float minimumDot = 1.0f;
+	for (const auto &normal : normals) {
+		minimumDot = std::min(minimumDot, glm::dot(normal, axis));
+	}
+
+	// some triangle faces (nearly) sideways to the axis, every view sees at least one front face
+	if (minimumDot <= 0.1f) {
+		return;
+	}
+
+	// the meshlet is back facing when the view direction is within 90 degrees minus the cone's half angle of the axis
+	meshlet.cone = glm::vec4(axis, std::sqrt(1.0f - minimumDot * minimumDot));
+}
+
+MeshletData buildMeshlets(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, uint32_t maxVertices, uint32_t maxTriangles){
+
+	// triangles store meshlet vertices in a byte
+	maxVertices = std::min(maxVertices, 256u);
+
+	MeshletData data;
+	data.indices.reserve(indices.size());
+	data.triangles.reserve(indices.size());
+
+	// position of each mesh vertex in the meshlet being built, -1 if it isn't in it yet
+	std::vector<int32_t> localIndex(vertices.size(), -1);
+
+	Meshlet meshlet = {};
+	auto finishMeshlet = [&]() {
+
+		if (meshlet.triangleCount == 0) {
+			return;
+		}
+
+		calculateMeshletBounds(vertices, data, meshlet);
+		data.meshlets.push_back(meshlet);
+
+		for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+			localIndex[data.vertices[meshlet.vertexOffset + i]] = -1;
+		}
+
+		meshlet = {};
+		meshlet.vertexOffset = static_cast<uint32_t>(data.vertices.size());
+		meshlet.triangleOffset = static_cast<uint32_t>(data.triangles.size());
+	};
+
+	// greedy: triangles are added in order until the next one doesn't fit.
+	// index order from the source usually has good locality, so meshlets come out spatially coherent
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+
+		uint32_t newVertices = 0;
+		for (size_t corner = 0; corner < 3; corner++) {
+			if (localIndex[indices[i + corner]] < 0) {
+				newVertices++;
+			}
+		}
+
+		if (meshlet.vertexCount + newVertices > maxVertices || meshlet.triangleCount + 1 > maxTriangles) {
+			finishMeshlet();
+		}
+
+		for (size_t corner = 0; corner < 3; corner++) {
+
+			uint32_t vertex = indices[i + corner];
+			if (localIndex[vertex] < 0) {
+				localIndex[vertex] = static_cast<int32_t>(meshlet.vertexCount++);
+				data.vertices.push_back(vertex);
+			}
+
+			data.triangles.push_back(static_cast<uint8_t>(localIndex[vertex]));
+			data.indices.push_back(vertex);
+		}
+		meshlet.triangleCount++;
+	}
+	finishMeshlet();
+
+	return data;
+}
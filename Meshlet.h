@@ -0,0 +1,36 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <GLM/glm.hpp>
+
+#include <vector>
+
+#include "Utilities.h"
+
+// meshlet size limits, 64 vertices / 124 triangles fits the mesh shader output of every vendor
+const uint32_t MESHLET_MAX_VERTICES = 64;
+const uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+// one meshlet as the cull, task and mesh shaders see it (std430 layout)
+struct Meshlet {
+	glm::vec4 sphere;				// bounding sphere, center xyz and radius
+	glm::vec4 cone;					// normal cone, axis xyz and cutoff (> 1 when it can't be cone culled)
+	uint32_t vertexOffset;			// first entry in the meshlet vertex list
+	uint32_t vertexCount;
+	uint32_t triangleOffset;		// first byte in the meshlet triangle list, also the first index in the mesh's index buffer
+	uint32_t triangleCount;
+};
+
+// a mesh split in to meshlets
+struct MeshletData {
+	std::vector<Meshlet> meshlets;
+	std::vector<uint32_t> vertices;				// meshlet vertex -> mesh vertex
+	std::vector<uint8_t> triangles;				// 3 meshlet vertices per triangle
+	std::vector<uint32_t> indices;				// the mesh's triangles in meshlet order, for drawing without mesh shaders
+};
+
+// split an indexed triangle list in to meshlets, keeping the triangles in their original order.
+// front faces are clockwise (matching the default pipeline), the normal cones point out of the front faces
+MeshletData buildMeshlets(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices,
+	uint32_t maxVertices = MESHLET_MAX_VERTICES, uint32_t maxTriangles = MESHLET_MAX_TRIANGLES);
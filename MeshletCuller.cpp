@@ -0,0 +1,419 @@
+#include "MeshletCuller.h"
+
+#include <algorithm>
+#include <array>
+
+// draw slot of meshes that aren't culled per meshlet
+static const uint32_t NO_DRAW_OFFSET = ~0u;
+
+MeshletCuller::MeshletCuller(){
+
+}
+
+void MeshletCuller::create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, ShaderManager * shaderManager, DeviceAllocator * newAllocator,
+	OcclusionCuller * occlusionCuller, SceneGraph * sceneGraph, int framesInFlight, bool newCompactDraws, bool newMultiDrawIndirect, bool newUseMeshShaders,
+	uint32_t newMaxMeshes, uint32_t newMaxMeshlets){
+
+	physicalDevice = newPhysicalDevice;
+	device = newDevice;
+	allocator = newAllocator;
+	compactDraws = newCompactDraws;
+	multiDrawIndirect = newMultiDrawIndirect;
+	useMeshShaders = newUseMeshShaders;
+	maxMeshes = std::min(newMaxMeshes, occlusionCuller->getMaxObjects());
+	maxMeshlets = newMaxMeshlets;
+
+	// extension commands aren't exported by the loader, the dispatch table fetched it from the device
+	if (useMeshShaders && deviceDispatch.vkCmdDrawMeshTasksEXT == nullptr) {
+		throw std::runtime_error("failed to load vkCmdDrawMeshTasksEXT");
+	}
+
+	setCamera(glm::mat4(1.0f), camera);
+
+	createBuffers(framesInFlight, occlusionCuller, sceneGraph);
+	createDescriptorSets();
+	createPipeline(shaderManager);
+}
+
+void MeshletCuller::destroy(){
+
+	frames.clear();
+
+	cullPipeline.reset();
+	cullPipelineLayout.reset();
+	descriptorPool.reset();
+	setLayout.reset();
+
+}
+
+void MeshletCuller::setMeshes(int frame, const std::vector<MeshletCullMesh> &meshes, uint64_t meshListVersion){
+
+	FrameBuffers &frameBuffers = frames[frame];
+	size_t meshCount = std::min<size_t>(meshes.size(), maxMeshes);
+	frameBuffers.meshes.resize(meshCount);
+
+	// each mesh gets a run of draw slots, mesh shaders draw straight from the task shader so need none
+	uint32_t drawOffset = 0;
+	for (size_t j = 0; j < meshCount; j++) {
+
+		MeshRange &range = frameBuffers.meshes[j];
+		range.meshletCount = meshes[j].meshletCount;
+		range.instanceIndex = meshes[j].instanceIndex;
+		range.modelMatrix = meshes[j].modelMatrix;
+
+		if (useMeshShaders) {
+			range.drawOffset = 0;
+		}
+		else if (drawOffset + range.meshletCount <= maxMeshlets)
+		{
+			range.drawOffset = drawOffset;
+			drawOffset += range.meshletCount;
+		}
+		else
+		{
+			range.drawOffset = NO_DRAW_OFFSET;
+		}
+	}
+
+	// sets are only in use by this frame's previous submission, which has finished.
+	// meshes without meshlets (e.g. evicted ones) have no buffers, their sets are never bound
+	if (frameBuffers.meshListVersion != meshListVersion) {
+		for (size_t j = 0; j < meshCount; j++) {
+			if (meshes[j].meshletCount > 0) {
+				writeDescriptorSet(frameBuffers, j, meshes[j]);
+			}
+		}
+		frameBuffers.meshListVersion = meshListVersion;
+	}
+}
+
+void MeshletCuller::setCamera(const glm::mat4 &viewProjection, const glm::vec4 &newCamera){
+
+	camera = newCamera;
+
+	// frustum planes from the rows of the matrix, vulkan clip space is -w <= x, y <= w and 0 <= z <= w
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++) {
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+	}
+
+	frustumPlanes[0] = rows[3] + rows[0];
+	frustumPlanes[1] = rows[3] - rows[0];
+	frustumPlanes[2] = rows[3] + rows[1];
+	frustumPlanes[3] = rows[3] - rows[1];
+	frustumPlanes[4] = rows[2];
+	frustumPlanes[5] = rows[3] - rows[2];
+
+	// normalized so distances compare against the bounding sphere radius
+	for (auto &plane : frustumPlanes) {
+		plane = plane / glm::length(glm::vec3(plane.x, plane.y, plane.z));
+	}
+}
+
+bool MeshletCuller::isMeshCulled(int frame, size_t mesh){
+	return mesh < frames[frame].meshes.size() && frames[frame].meshes[mesh].drawOffset != NO_DRAW_OFFSET;
+}
+
+VkDescriptorSetLayout MeshletCuller::getDescriptorSetLayout(){
+	return setLayout.get();
+}
+
+void MeshletCuller::recordCull(VkCommandBuffer commandBuffer, int frame, bool latePhase){
+
+	FrameBuffers &frameBuffers = frames[frame];
+
+	// meshlet counts start from zero every frame
+	if (compactDraws && !useMeshShaders && !latePhase) {
+		deviceDispatch.vkCmdFillBuffer(commandBuffer, frameBuffers.countBuffer.get(), 0, VK_WHOLE_SIZE, 0);
+	}
+
+	// the occlusion culler's draws for this phase (and the count reset) must land before they are read
+	VkPipelineStageFlags cullStage = useMeshShaders ? VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	deviceDispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, cullStage,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	// the task shader culls while drawing
+	if (useMeshShaders) {
+		return;
+	}
+
+	deviceDispatch.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline.get());
+
+	for (size_t j = 0; j < frameBuffers.meshes.size(); j++) {
+
+		if (!isMeshCulled(frame, j) || frameBuffers.meshes[j].meshletCount == 0) {
+			continue;
+		}
+
+		MeshletConstants constants = getConstants(frame, j, latePhase);
+
+		deviceDispatch.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout.get(), 0, 1, &frameBuffers.descriptorSets[j], 0, nullptr);
+		deviceDispatch.vkCmdPushConstants(commandBuffer, cullPipelineLayout.get(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		deviceDispatch.vkCmdDispatch(commandBuffer, (frameBuffers.meshes[j].meshletCount + 63) / 64, 1, 1);
+	}
+
+	// meshlet draws and counts are read by the render pass
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+	deviceDispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+uint32_t MeshletCuller::recordDraw(VkCommandBuffer commandBuffer, int frame, size_t mesh, bool latePhase, VkPipelineLayout graphicsPipelineLayout){
+
+	FrameBuffers &frameBuffers = frames[frame];
+	const MeshRange &range = frameBuffers.meshes[mesh];
+	if (range.meshletCount == 0) {
+		return 0;
+	}
+
+	// one task workgroup per 32 meshlets, each launches a mesh workgroup per meshlet that survives
+	if (useMeshShaders) {
+
+		MeshletConstants constants = getConstants(frame, mesh, latePhase);
+
+		deviceDispatch.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipelineLayout, 0, 1, &frameBuffers.descriptorSets[mesh], 0, nullptr);
+		deviceDispatch.vkCmdPushConstants(commandBuffer, graphicsPipelineLayout, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, 0, sizeof(constants), &constants);
+		deviceDispatch.vkCmdDrawMeshTasksEXT(commandBuffer, (range.meshletCount + 31) / 32, 1, 1);
+		return 1;
+	}
+
+	VkBuffer drawBuffer = latePhase ? frameBuffers.lateDrawBuffer.get() : frameBuffers.earlyDrawBuffer.get();
+	VkDeviceSize drawOffset = range.drawOffset * sizeof(VkDrawIndexedIndirectCommand);
+
+	if (compactDraws) {
+		VkDeviceSize countOffset = (mesh * 2 + (latePhase ? 1 : 0)) * sizeof(uint32_t);
+		deviceDispatch.vkCmdDrawIndexedIndirectCount(commandBuffer, drawBuffer, drawOffset, frameBuffers.countBuffer.get(), countOffset,
+			range.meshletCount, sizeof(VkDrawIndexedIndirectCommand));
+		return 1;
+	}
+	else if (multiDrawIndirect)
+	{
+		// culled meshlets are left in place with an instance count of 0
+		deviceDispatch.vkCmdDrawIndexedIndirect(commandBuffer, drawBuffer, drawOffset, range.meshletCount, sizeof(VkDrawIndexedIndirectCommand));
+		return 1;
+	}
+	else
+	{
+		for (uint32_t i = 0; i < range.meshletCount; i++) {
+			deviceDispatch.vkCmdDrawIndexedIndirect(commandBuffer, drawBuffer, drawOffset + i * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+		}
+		return range.meshletCount;
+	}
+}
+
+MeshletCuller::~MeshletCuller(){
+
+}
+
+void MeshletCuller::createBuffers(int framesInFlight, OcclusionCuller * occlusionCuller, SceneGraph * sceneGraph){
+
+	// mesh shaders need no draw buffers, they are only kept so every set has something bound
+	VkDeviceSize drawSize = (useMeshShaders ? 1 : maxMeshlets) * sizeof(VkDrawIndexedIndirectCommand);
+	VkDeviceSize countSize = maxMeshes * 2 * sizeof(uint32_t);
+
+	VkBuffer buffer;
+	VkDeviceMemory memory;
+
+	frames.resize(framesInFlight);
+	for (int i = 0; i < framesInFlight; i++) {
+
+		FrameBuffers &frame = frames[i];
+		frame.earlyObjectDrawBuffer = occlusionCuller->getEarlyDrawBuffer(i);
+		frame.lateObjectDrawBuffer = occlusionCuller->getLateDrawBuffer(i);
+		frame.instanceBuffer = sceneGraph->getInstanceBuffer(i);
+
+		createBuffer(physicalDevice, device, drawSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &buffer, &memory, allocator);
+		frame.earlyDrawMemory = UniqueDeviceMemory(allocator, memory);
+		frame.earlyDrawBuffer = UniqueBuffer(device, buffer);
+
+		createBuffer(physicalDevice, device, drawSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &buffer, &memory, allocator);
+		frame.lateDrawMemory = UniqueDeviceMemory(allocator, memory);
+		frame.lateDrawBuffer = UniqueBuffer(device, buffer);
+
+		createBuffer(physicalDevice, device, countSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &buffer, &memory, allocator);
+		frame.countMemory = UniqueDeviceMemory(allocator, memory);
+		frame.countBuffer = UniqueBuffer(device, buffer);
+	}
+}
+
+void MeshletCuller::createDescriptorSets(){
+
+	// -- DESCRIPTOR SET LAYOUT --
+	// meshlets, early / late object draws, early / late meshlet draws, meshlet counts,
+	// then the meshlet vertices, meshlet triangles, vertices and model matrices read by the mesh shader
+	VkShaderStageFlags stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	if (useMeshShaders) {
+		stageFlags |= VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT;
+	}
+
+	std::array<VkDescriptorSetLayoutBinding, 10> bindings = {};
+	for (uint32_t i = 0; i < bindings.size(); i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = stageFlags;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutCreateInfo.pBindings = bindings.data();
+
+	VkDescriptorSetLayout layout;
+	if (vkCreateDescriptorSetLayout(device, &layoutCreateInfo, nullptr, &layout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create meshlet descriptor set layout");
+	}
+	setLayout = UniqueDescriptorSetLayout(device, layout);
+
+	// -- DESCRIPTOR POOL --
+	uint32_t setCount = maxMeshes * static_cast<uint32_t>(frames.size());
+
+	VkDescriptorPoolSize poolSize = {};
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount = setCount * static_cast<uint32_t>(bindings.size());
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = setCount;
+	poolCreateInfo.poolSizeCount = 1;
+	poolCreateInfo.pPoolSizes = &poolSize;
+
+	VkDescriptorPool pool;
+	if (vkCreateDescriptorPool(device, &poolCreateInfo, nullptr, &pool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create meshlet descriptor pool");
+	}
+	descriptorPool = UniqueDescriptorPool(device, pool);
+
+	// -- ALLOCATE --
+	// written once the meshes are known, see setMeshes
+	std::vector<VkDescriptorSetLayout> layouts(maxMeshes, layout);
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = pool;
+	allocInfo.descriptorSetCount = maxMeshes;
+	allocInfo.pSetLayouts = layouts.data();
+
+	for (auto &frame : frames) {
+		frame.descriptorSets.resize(maxMeshes);
+		if (vkAllocateDescriptorSets(device, &allocInfo, frame.descriptorSets.data()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate meshlet descriptor sets");
+		}
+	}
+}
+
+void MeshletCuller::createPipeline(ShaderManager * shaderManager){
+
+	// -- PIPELINE LAYOUT --
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(MeshletConstants);
+
+	VkDescriptorSetLayout layout = setLayout.get();
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = 1;
+	pipelineLayoutCreateInfo.pSetLayouts = &layout;
+	pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+	pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+	VkPipelineLayout pipelineLayout;
+	if (vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create meshlet cull pipeline layout");
+	}
+	cullPipelineLayout = UniquePipelineLayout(device, pipelineLayout);
+
+	// the compute pass is only needed without mesh shaders
+	if (useMeshShaders) {
+		return;
+	}
+
+	// -- COMPUTE PIPELINE --
+	VkComputePipelineCreateInfo pipelineCreateInfo = {};
+	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineCreateInfo.stage.module = shaderManager->getModule("Shaders/meshlet_cull.comp");
+	pipelineCreateInfo.stage.pName = "main";
+	pipelineCreateInfo.layout = pipelineLayout;
+
+	VkPipeline pipeline;
+	VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &pipeline);
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create meshlet cull pipeline");
+	}
+	cullPipeline = UniquePipeline(device, pipeline);
+}
+
+void MeshletCuller::writeDescriptorSet(FrameBuffers &frame, size_t mesh, const MeshletCullMesh &cullMesh){
+
+	std::array<VkDescriptorBufferInfo, 10> bufferInfos = {};
+	bufferInfos[0].buffer = cullMesh.meshletBuffer;
+	bufferInfos[1].buffer = frame.earlyObjectDrawBuffer;
+	bufferInfos[2].buffer = frame.lateObjectDrawBuffer;
+	bufferInfos[3].buffer = frame.earlyDrawBuffer.get();
+	bufferInfos[4].buffer = frame.lateDrawBuffer.get();
+	bufferInfos[5].buffer = frame.countBuffer.get();
+	bufferInfos[6].buffer = cullMesh.meshletVertexBuffer;
+	bufferInfos[7].buffer = cullMesh.meshletTriangleBuffer;
+	bufferInfos[8].buffer = cullMesh.vertexBuffer;
+	bufferInfos[9].buffer = frame.instanceBuffer;
+
+	std::array<VkWriteDescriptorSet, 10> writes = {};
+	for (uint32_t i = 0; i < writes.size(); i++) {
+
+		bufferInfos[i].offset = 0;
+		bufferInfos[i].range = VK_WHOLE_SIZE;
+
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = frame.descriptorSets[mesh];
+		writes[i].dstBinding = i;
+		writes[i].descriptorCount = 1;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[i].pBufferInfo = &bufferInfos[i];
+	}
+
+	vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+MeshletConstants MeshletCuller::getConstants(int frame, size_t mesh, bool latePhase){
+
+	const MeshRange &range = frames[frame].meshes[mesh];
+
+	// meshlet bounds and cones stay in object space, so the planes and camera are moved in to it instead.
+	// a plane transforms by the transposed model matrix, renormalized so distances are in object units again
+	MeshletConstants constants = {};
+	glm::mat4 transposedModel = glm::transpose(range.modelMatrix);
+	for (int i = 0; i < 6; i++) {
+		glm::vec4 plane = transposedModel * frustumPlanes[i];
+		constants.frustumPlanes[i] = plane / glm::length(glm::vec3(plane.x, plane.y, plane.z));
+	}
+
+	// cone tests are only approximate under non uniform scale, they assume normals transform like directions
+	glm::vec4 objectCamera = glm::inverse(range.modelMatrix) * camera;
+	if (camera.w == 0.0f) {
+		glm::vec3 direction = glm::normalize(glm::vec3(objectCamera.x, objectCamera.y, objectCamera.z));
+		objectCamera = glm::vec4(direction, 0.0f);
+	}
+	constants.camera = objectCamera;
+	constants.objectIndex = static_cast<uint32_t>(mesh);
+	constants.instanceIndex = range.instanceIndex;
+	constants.drawOffset = range.drawOffset;
+	constants.flags = (latePhase ? MESHLET_FLAG_LATE_PHASE : 0) | (compactDraws ? MESHLET_FLAG_COMPACT_DRAWS : 0);
+
+	return constants;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <GLM/glm.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+#include "Utilities.h"
+#include "VulkanHandles.h"
+#include "ShaderManager.h"
+#include "OcclusionCuller.h"
+#include "SceneGraph.h"
+#include "DeviceDispatch.h"
+
+// one mesh's meshlet buffers, see Mesh
+struct MeshletCullMesh {
+	VkBuffer meshletBuffer;
+	VkBuffer meshletVertexBuffer;
+	VkBuffer meshletTriangleBuffer;
+	VkBuffer vertexBuffer;
+	uint32_t meshletCount;
+	glm::mat4 modelMatrix;			// meshlet bounds are in object space
+	uint32_t instanceIndex;			// scene graph node holding the model matrix
+};
+
+// push constants shared by the meshlet cull, task and mesh shaders (128 bytes, the guaranteed minimum)
+struct MeshletConstants {
+	glm::vec4 frustumPlanes[6];		// object space, xyz normal pointing in to the frustum, w distance
+	glm::vec4 camera;				// object space, xyz position (w = 1), or view direction for orthographic views (w = 0)
+	uint32_t objectIndex;			// the mesh's object in the occlusion culler
+	uint32_t instanceIndex;			// the mesh's model matrix in the instance buffer
+	uint32_t drawOffset;			// first draw slot of the mesh
+	uint32_t flags;
+};
+
+const uint32_t MESHLET_FLAG_LATE_PHASE = 1;			// read / write the late phase buffers
+const uint32_t MESHLET_FLAG_COMPACT_DRAWS = 2;		// pack visible meshlets and count them, instead of one draw per meshlet
+
+// Culls each mesh's meshlets against the frustum and their normal cones, after the occlusion culler
+// has decided which meshes are drawn in a phase. Meshlets of meshes the occlusion culler rejected are skipped.
+// Without mesh shaders a compute pass writes an indexed indirect draw per visible meshlet (its index range),
+// with VK_EXT_mesh_shader the task shader does the same tests and the mesh shader draws the survivors
+class MeshletCuller
+{
+public:
+	MeshletCuller();
+
+	void create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, ShaderManager * shaderManager, DeviceAllocator * newAllocator,
+		OcclusionCuller * occlusionCuller, SceneGraph * sceneGraph, int framesInFlight, bool newCompactDraws, bool newMultiDrawIndirect, bool newUseMeshShaders,
+		uint32_t newMaxMeshes = 1024, uint32_t newMaxMeshlets = 65536);
+	void destroy();
+
+	// meshes to cull this frame, in occlusion culler object order. meshListVersion changes whenever the mesh list does,
+	// descriptor sets are only rewritten then
+	void setMeshes(int frame, const std::vector<MeshletCullMesh> &meshes, uint64_t meshListVersion);
+	void setCamera(const glm::mat4 &viewProjection, const glm::vec4 &newCamera);
+
+	// whether the mesh is drawn per meshlet this frame, meshes that didn't fit are left to the occlusion culler's draw
+	bool isMeshCulled(int frame, size_t mesh);
+
+	// set layout and push constants of the task / mesh shaders, the graphics pipeline layout has to include them
+	VkDescriptorSetLayout getDescriptorSetLayout();
+
+	// -- RECORD FUNCTIONS --
+	// after the occlusion culler's cull of the same phase
+	void recordCull(VkCommandBuffer commandBuffer, int frame, bool latePhase);
+	// inside the render pass, with the mesh's vertex and index buffers (or the mesh shader pipeline) bound.
+	// returns the number of draw commands recorded
+	uint32_t recordDraw(VkCommandBuffer commandBuffer, int frame, size_t mesh, bool latePhase, VkPipelineLayout graphicsPipelineLayout);
+
+	~MeshletCuller();
+
+private:
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	DeviceAllocator * allocator = nullptr;
+
+	uint32_t maxMeshes = 0;
+	uint32_t maxMeshlets = 0;
+	bool compactDraws = false;					// vkCmdDrawIndexedIndirectCount available
+	bool multiDrawIndirect = false;				// otherwise one indirect draw per meshlet
+	bool useMeshShaders = false;
+
+	glm::vec4 frustumPlanes[6];
+	glm::vec4 camera = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+
+	// where a mesh's meshlets went this frame
+	struct MeshRange {
+		uint32_t drawOffset;
+		uint32_t meshletCount;
+		uint32_t instanceIndex;
+		glm::mat4 modelMatrix;
+	};
+
+	// - Per frame buffers
+	struct FrameBuffers {
+		std::vector<MeshRange> meshes;
+		uint64_t meshListVersion = ~0ull;
+		UniqueDeviceMemory earlyDrawMemory;
+		UniqueBuffer earlyDrawBuffer;
+		UniqueDeviceMemory lateDrawMemory;
+		UniqueBuffer lateDrawBuffer;
+		UniqueDeviceMemory countMemory;
+		UniqueBuffer countBuffer;					// visible meshlets of each mesh and phase, when compacting
+		VkBuffer earlyObjectDrawBuffer = VK_NULL_HANDLE;
+		VkBuffer lateObjectDrawBuffer = VK_NULL_HANDLE;
+		VkBuffer instanceBuffer = VK_NULL_HANDLE;		// scene graph's model matrices, read by the mesh shader
+		std::vector<VkDescriptorSet> descriptorSets;	// one per mesh
+	};
+	std::vector<FrameBuffers> frames;
+
+	// - Pipeline
+	UniqueDescriptorPool descriptorPool;
+	UniqueDescriptorSetLayout setLayout;
+	UniquePipelineLayout cullPipelineLayout;
+	UniquePipeline cullPipeline;
+
+	void createBuffers(int framesInFlight, OcclusionCuller * occlusionCuller, SceneGraph * sceneGraph);
+	void createDescriptorSets();
+	void createPipeline(ShaderManager * shaderManager);
+	void writeDescriptorSet(FrameBuffers &frame, size_t mesh, const MeshletCullMesh &cullMesh);
+	MeshletConstants getConstants(int frame, size_t mesh, bool latePhase);
+};
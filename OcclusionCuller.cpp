@@ -0,0 +1,508 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+// push constants of the reduce shader
+struct ReduceConstants {
+	int32_t inputSize[2];
+	int32_t outputSize[2];
+};
+
+// push constants of the cull shader
+struct CullConstants {
+	glm::mat4 viewProjection;
+	float pyramidSize[2];
+	uint32_t objectCount;
+	uint32_t latePhase;
+};
+
+OcclusionCuller::OcclusionCuller(){
+
+}
+
+void OcclusionCuller::create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, ShaderManager * shaderManager, DeviceAllocator * newAllocator,
+	VkImageView depthImageView, VkExtent2D depthExtent, int framesInFlight, uint32_t newMaxObjects){
+
+	physicalDevice = newPhysicalDevice;
+	device = newDevice;
+	allocator = newAllocator;
+	depthSize = depthExtent;
+	maxObjects = newMaxObjects;
+
+	createDepthPyramid();
+	createBuffers(framesInFlight);
+	createDescriptorSets(depthImageView);
+	createPipelines(shaderManager);
+}
+
+void OcclusionCuller::destroy(){
+
+	// mapped memory has to be unmapped before it goes back to the allocator for recycling
+	for (auto &frame : frames) {
+		if (frame.mappedObjects != nullptr) {
+			vkUnmapMemory(device, frame.objectMemory.get());
+		}
+		if (frame.mappedStats != nullptr) {
+			vkUnmapMemory(device, frame.statsMemory.get());
+		}
+	}
+	frames.clear();
+
+	if (mappedVisibility != nullptr) {
+		vkUnmapMemory(device, visibilityMemory.get());
+		mappedVisibility = nullptr;
+	}
+	visibilityBuffer.reset();
+	visibilityMemory.reset();
+
+	cullPipeline.reset();
+	reducePipeline.reset();
+	cullPipelineLayout.reset();
+	reducePipelineLayout.reset();
+	reduceDescriptorSets.clear();
+	descriptorPool.reset();
+	cullSetLayout.reset();
+	reduceSetLayout.reset();
+
+	pyramidSampler.reset();
+	pyramidLevelViews.clear();
+	pyramidView.reset();
+	pyramidImage.reset();
+	pyramidMemory.reset();
+}
+
+void OcclusionCuller::setObjects(int frame, const std::vector<CullObject> &objects){
+
+	FrameBuffers &frameBuffers = frames[frame];
+	frameBuffers.objectCount = static_cast<int>(std::min<size_t>(objects.size(), maxObjects));
+
+	// memory is host coherent, so writes are visible to the GPU once the frame is submitted
+	memcpy(frameBuffers.mappedObjects, objects.data(), frameBuffers.objectCount * sizeof(CullObject));
+}
+
+void OcclusionCuller::setViewProjection(const glm::mat4 &newViewProjection){
+	viewProjection = newViewProjection;
+}
+
+uint32_t OcclusionCuller::getMaxObjects(){
+	return maxObjects;
+}
+
+void OcclusionCuller::recordEarlyCull(VkCommandBuffer commandBuffer, int frame){
+
+	// occluded counter starts from zero every frame
+	deviceDispatch.vkCmdFillBuffer(commandBuffer, frames[frame].statsBuffer.get(), 0, sizeof(uint32_t), 0);
+
+	// the counter reset, and the visibility written by the previous frame's late phase, must land before culling
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	deviceDispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	recordCull(commandBuffer, frame, 0);
+}
+
+void OcclusionCuller::recordDepthPyramid(VkCommandBuffer commandBuffer){
+
+	// every level is rewritten, so previous contents can be discarded once the last cull has read them
+	VkImageMemoryBarrier pyramidBarrier = {};
+	pyramidBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	pyramidBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	pyramidBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	pyramidBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	pyramidBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	pyramidBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	pyramidBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	pyramidBarrier.image = pyramidImage.get();
+	pyramidBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	pyramidBarrier.subresourceRange.baseMipLevel = 0;
+	pyramidBarrier.subresourceRange.levelCount = pyramidLevels;
+	pyramidBarrier.subresourceRange.baseArrayLayer = 0;
+	pyramidBarrier.subresourceRange.layerCount = 1;
+
+	deviceDispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &pyramidBarrier);
+
+	deviceDispatch.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, reducePipeline.get());
+
+	VkExtent2D inputSize = depthSize;
+	for (uint32_t level = 0; level < pyramidLevels; level++) {
+
+		VkExtent2D outputSize = { std::max(pyramidSize.width >> level, 1u), std::max(pyramidSize.height >> level, 1u) };
+
+		ReduceConstants constants = {};
+		constants.inputSize[0] = static_cast<int32_t>(inputSize.width);
+		constants.inputSize[1] = static_cast<int32_t>(inputSize.height);
+		constants.outputSize[0] = static_cast<int32_t>(outputSize.width);
+		constants.outputSize[1] = static_cast<int32_t>(outputSize.height);
+
+		deviceDispatch.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, reducePipelineLayout.get(), 0, 1, &reduceDescriptorSets[level], 0, nullptr);
+		deviceDispatch.vkCmdPushConstants(commandBuffer, reducePipelineLayout.get(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		deviceDispatch.vkCmdDispatch(commandBuffer, (outputSize.width + 7) / 8, (outputSize.height + 7) / 8, 1);
+
+		// next level (and finally the cull shader) reads this one
+		pyramidBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		pyramidBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		pyramidBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+		pyramidBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		pyramidBarrier.subresourceRange.baseMipLevel = level;
+		pyramidBarrier.subresourceRange.levelCount = 1;
+
+		deviceDispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &pyramidBarrier);
+
+		inputSize = outputSize;
+	}
+}
+
+void OcclusionCuller::recordLateCull(VkCommandBuffer commandBuffer, int frame){
+
+	recordCull(commandBuffer, frame, 1);
+
+	// the counter is read by the host once the frame finishes
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+	deviceDispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+VkBuffer OcclusionCuller::getEarlyDrawBuffer(int frame){
+	return frames[frame].earlyDrawBuffer.get();
+}
+
+VkBuffer OcclusionCuller::getLateDrawBuffer(int frame){
+	return frames[frame].lateDrawBuffer.get();
+}
+
+uint32_t OcclusionCuller::getOccludedCount(int frame){
+	return *static_cast<uint32_t *>(frames[frame].mappedStats);
+}
+
+bool OcclusionCuller::isObjectVisible(uint32_t object){
+	return object < maxObjects && static_cast<const uint32_t *>(mappedVisibility)[object] != 0;
+}
+
+OcclusionCuller::~OcclusionCuller(){
+
+}
+
+void OcclusionCuller::createDepthPyramid(){
+
+	// pyramid is rounded down to a power of two so every level halves exactly
+	pyramidSize.width = 1;
+	while (pyramidSize.width * 2 <= depthSize.width) pyramidSize.width *= 2;
+	pyramidSize.height = 1;
+	while (pyramidSize.height * 2 <= depthSize.height) pyramidSize.height *= 2;
+
+	pyramidLevels = 1;
+	while ((std::max(pyramidSize.width, pyramidSize.height) >> pyramidLevels) > 0) pyramidLevels++;
+
+	VkImage image;
+	VkDeviceMemory memory;
+	createImage(physicalDevice, device, pyramidSize.width, pyramidSize.height, pyramidLevels, VK_FORMAT_R32_SFLOAT,
+		VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &image, &memory, allocator);
+	pyramidMemory = UniqueDeviceMemory(allocator, memory);
+	pyramidImage = UniqueImage(device, image);
+
+	pyramidView = UniqueImageView(device, createImageView(device, image, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, 0, pyramidLevels));
+	for (uint32_t level = 0; level < pyramidLevels; level++) {
+		pyramidLevelViews.emplace_back(device, createImageView(device, image, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, level, 1));
+	}
+
+	// point sampling, the shaders pick the exact texels they need
+	VkSamplerCreateInfo samplerCreateInfo = {};
+	samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerCreateInfo.magFilter = VK_FILTER_NEAREST;
+	samplerCreateInfo.minFilter = VK_FILTER_NEAREST;
+	samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerCreateInfo.minLod = 0.0f;
+	samplerCreateInfo.maxLod = static_cast<float>(pyramidLevels);
+
+	VkSampler sampler;
+	VkResult result = vkCreateSampler(device, &samplerCreateInfo, nullptr, &sampler);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create depth pyramid sampler");
+	}
+	pyramidSampler = UniqueSampler(device, sampler);
+}
+
+void OcclusionCuller::createBuffers(int framesInFlight){
+
+	VkDeviceSize objectSize = maxObjects * sizeof(CullObject);
+	VkDeviceSize drawSize = maxObjects * sizeof(VkDrawIndexedIndirectCommand);
+	VkDeviceSize visibilitySize = maxObjects * sizeof(uint32_t);
+
+	VkBuffer buffer;
+	VkDeviceMemory memory;
+
+	frames.resize(framesInFlight);
+	for (auto &frame : frames) {
+
+		createBuffer(physicalDevice, device, objectSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &buffer, &memory, allocator);
+		frame.objectMemory = UniqueDeviceMemory(allocator, memory);
+		frame.objectBuffer = UniqueBuffer(device, buffer);
+		vkMapMemory(device, memory, 0, objectSize, 0, &frame.mappedObjects);
+
+		createBuffer(physicalDevice, device, drawSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &buffer, &memory, allocator);
+		frame.earlyDrawMemory = UniqueDeviceMemory(allocator, memory);
+		frame.earlyDrawBuffer = UniqueBuffer(device, buffer);
+
+		createBuffer(physicalDevice, device, drawSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &buffer, &memory, allocator);
+		frame.lateDrawMemory = UniqueDeviceMemory(allocator, memory);
+		frame.lateDrawBuffer = UniqueBuffer(device, buffer);
+
+		createBuffer(physicalDevice, device, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &buffer, &memory, allocator);
+		frame.statsMemory = UniqueDeviceMemory(allocator, memory);
+		frame.statsBuffer = UniqueBuffer(device, buffer);
+		vkMapMemory(device, memory, 0, sizeof(uint32_t), 0, &frame.mappedStats);
+		memset(frame.mappedStats, 0, sizeof(uint32_t));
+	}
+
+	// everything starts visible so the first frame draws it all in the early phase
+	createBuffer(physicalDevice, device, visibilitySize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &buffer, &memory, allocator);
+	visibilityMemory = UniqueDeviceMemory(allocator, memory);
+	visibilityBuffer = UniqueBuffer(device, buffer);
+
+	// left mapped so the host can see what was visible
+	vkMapMemory(device, memory, 0, visibilitySize, 0, &mappedVisibility);
+	std::vector<uint32_t> visible(maxObjects, 1);
+	memcpy(mappedVisibility, visible.data(), (size_t)visibilitySize);
+}
+
+void OcclusionCuller::createDescriptorSets(VkImageView depthImageView){
+
+	// -- DESCRIPTOR SET LAYOUTS --
+	// reduce: previous level (or the depth buffer) in, next level out
+	std::array<VkDescriptorSetLayoutBinding, 2> reduceBindings = {};
+	reduceBindings[0].binding = 0;
+	reduceBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	reduceBindings[0].descriptorCount = 1;
+	reduceBindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	reduceBindings[1].binding = 1;
+	reduceBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	reduceBindings[1].descriptorCount = 1;
+	reduceBindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	// cull: objects, early draws, late draws, visibility, stats, then the pyramid
+	std::array<VkDescriptorSetLayoutBinding, 6> cullBindings = {};
+	for (uint32_t i = 0; i < cullBindings.size(); i++) {
+		cullBindings[i].binding = i;
+		cullBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		cullBindings[i].descriptorCount = 1;
+		cullBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+	cullBindings[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+	VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+
+	VkDescriptorSetLayout setLayout;
+	layoutCreateInfo.bindingCount = static_cast<uint32_t>(reduceBindings.size());
+	layoutCreateInfo.pBindings = reduceBindings.data();
+	if (vkCreateDescriptorSetLayout(device, &layoutCreateInfo, nullptr, &setLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create depth pyramid descriptor set layout");
+	}
+	reduceSetLayout = UniqueDescriptorSetLayout(device, setLayout);
+
+	layoutCreateInfo.bindingCount = static_cast<uint32_t>(cullBindings.size());
+	layoutCreateInfo.pBindings = cullBindings.data();
+	if (vkCreateDescriptorSetLayout(device, &layoutCreateInfo, nullptr, &setLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create cull descriptor set layout");
+	}
+	cullSetLayout = UniqueDescriptorSetLayout(device, setLayout);
+
+	// -- DESCRIPTOR POOL --
+	uint32_t frameCount = static_cast<uint32_t>(frames.size());
+
+	std::array<VkDescriptorPoolSize, 3> poolSizes = {};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[0].descriptorCount = pyramidLevels + frameCount;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	poolSizes[1].descriptorCount = pyramidLevels;
+	poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[2].descriptorCount = 5 * frameCount;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = pyramidLevels + frameCount;
+	poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolCreateInfo.pPoolSizes = poolSizes.data();
+
+	VkDescriptorPool pool;
+	if (vkCreateDescriptorPool(device, &poolCreateInfo, nullptr, &pool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create occlusion culling descriptor pool");
+	}
+	descriptorPool = UniqueDescriptorPool(device, pool);
+
+	// -- ALLOCATE --
+	std::vector<VkDescriptorSetLayout> reduceLayouts(pyramidLevels, reduceSetLayout.get());
+	reduceDescriptorSets.resize(pyramidLevels);
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = pool;
+	allocInfo.descriptorSetCount = pyramidLevels;
+	allocInfo.pSetLayouts = reduceLayouts.data();
+	if (vkAllocateDescriptorSets(device, &allocInfo, reduceDescriptorSets.data()) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate depth pyramid descriptor sets");
+	}
+
+	std::vector<VkDescriptorSetLayout> cullLayouts(frameCount, cullSetLayout.get());
+	std::vector<VkDescriptorSet> cullSets(frameCount);
+
+	allocInfo.descriptorSetCount = frameCount;
+	allocInfo.pSetLayouts = cullLayouts.data();
+	if (vkAllocateDescriptorSets(device, &allocInfo, cullSets.data()) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate cull descriptor sets");
+	}
+
+	// -- WRITE --
+	for (uint32_t level = 0; level < pyramidLevels; level++) {
+
+		// first level reduces the depth buffer itself
+		VkDescriptorImageInfo inputInfo = {};
+		inputInfo.sampler = pyramidSampler.get();
+		inputInfo.imageView = level == 0 ? depthImageView : pyramidLevelViews[level - 1].get();
+		inputInfo.imageLayout = level == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo outputInfo = {};
+		outputInfo.imageView = pyramidLevelViews[level].get();
+		outputInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		std::array<VkWriteDescriptorSet, 2> writes = {};
+		for (uint32_t i = 0; i < writes.size(); i++) {
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = reduceDescriptorSets[level];
+			writes[i].dstBinding = i;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = reduceBindings[i].descriptorType;
+		}
+		writes[0].pImageInfo = &inputInfo;
+		writes[1].pImageInfo = &outputInfo;
+
+		vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	for (uint32_t frame = 0; frame < frameCount; frame++) {
+
+		frames[frame].cullDescriptorSet = cullSets[frame];
+
+		std::array<VkDescriptorBufferInfo, 5> bufferInfos = {};
+		bufferInfos[0].buffer = frames[frame].objectBuffer.get();
+		bufferInfos[1].buffer = frames[frame].earlyDrawBuffer.get();
+		bufferInfos[2].buffer = frames[frame].lateDrawBuffer.get();
+		bufferInfos[3].buffer = visibilityBuffer.get();
+		bufferInfos[4].buffer = frames[frame].statsBuffer.get();
+		for (auto &bufferInfo : bufferInfos) {
+			bufferInfo.offset = 0;
+			bufferInfo.range = VK_WHOLE_SIZE;
+		}
+
+		VkDescriptorImageInfo pyramidInfo = {};
+		pyramidInfo.sampler = pyramidSampler.get();
+		pyramidInfo.imageView = pyramidView.get();
+		pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		std::array<VkWriteDescriptorSet, 6> writes = {};
+		for (uint32_t i = 0; i < writes.size(); i++) {
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = cullSets[frame];
+			writes[i].dstBinding = i;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = cullBindings[i].descriptorType;
+			if (i < bufferInfos.size()) {
+				writes[i].pBufferInfo = &bufferInfos[i];
+			}
+		}
+		writes[5].pImageInfo = &pyramidInfo;
+
+		vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+}
+
+void OcclusionCuller::createPipelines(ShaderManager * shaderManager){
+
+	// -- PIPELINE LAYOUTS --
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = 1;
+	pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+	pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+	VkDescriptorSetLayout setLayout = reduceSetLayout.get();
+	pipelineLayoutCreateInfo.pSetLayouts = &setLayout;
+	pushConstantRange.size = sizeof(ReduceConstants);
+
+	VkPipelineLayout layout;
+	if (vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &layout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create depth pyramid pipeline layout");
+	}
+	reducePipelineLayout = UniquePipelineLayout(device, layout);
+
+	setLayout = cullSetLayout.get();
+	pushConstantRange.size = sizeof(CullConstants);
+
+	if (vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &layout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create cull pipeline layout");
+	}
+	cullPipelineLayout = UniquePipelineLayout(device, layout);
+
+	// -- COMPUTE PIPELINES --
+	reducePipeline = UniquePipeline(device, createComputePipeline(shaderManager->getModule("Shaders/hiz.comp"), reducePipelineLayout.get()));
+	cullPipeline = UniquePipeline(device, createComputePipeline(shaderManager->getModule("Shaders/cull.comp"), cullPipelineLayout.get()));
+}
+
+VkPipeline OcclusionCuller::createComputePipeline(VkShaderModule module, VkPipelineLayout layout){
+
+	VkComputePipelineCreateInfo pipelineCreateInfo = {};
+	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineCreateInfo.stage.module = module;
+	pipelineCreateInfo.stage.pName = "main";
+	pipelineCreateInfo.layout = layout;
+
+	VkPipeline pipeline;
+	VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &pipeline);
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create compute pipeline");
+	}
+
+	return pipeline;
+}
+
+void OcclusionCuller::recordCull(VkCommandBuffer commandBuffer, int frame, uint32_t latePhase){
+
+	CullConstants constants = {};
+	constants.viewProjection = viewProjection;
+	constants.pyramidSize[0] = static_cast<float>(pyramidSize.width);
+	constants.pyramidSize[1] = static_cast<float>(pyramidSize.height);
+	constants.objectCount = static_cast<uint32_t>(frames[frame].objectCount);
+	constants.latePhase = latePhase;
+
+	deviceDispatch.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline.get());
+	deviceDispatch.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout.get(), 0, 1, &frames[frame].cullDescriptorSet, 0, nullptr);
+	deviceDispatch.vkCmdPushConstants(commandBuffer, cullPipelineLayout.get(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	deviceDispatch.vkCmdDispatch(commandBuffer, (constants.objectCount + 63) / 64, 1, 1);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <GLM/glm.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+#include "Utilities.h"
+#include "VulkanHandles.h"
+#include "ShaderManager.h"
+#include "DeviceDispatch.h"
+
+// one object as the cull shader sees it (std430 layout)
+struct CullObject {
+	glm::vec4 boundsMin;			// world space bounding box
+	glm::vec4 boundsMax;
+	uint32_t indexCount;			// written in to the object's indirect draw
+	uint32_t padding[3];
+};
+
+// Two phase occlusion culling against a hierarchical depth (Hi-Z) pyramid.
+// Early phase draws what was visible last frame, the pyramid is then built from that depth
+// and the late phase tests every object against it, drawing only the ones that just became visible.
+// Each object gets one indexed indirect draw per phase, culled objects have an instance count of 0
+class OcclusionCuller
+{
+public:
+	OcclusionCuller();
+
+	void create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, ShaderManager * shaderManager, DeviceAllocator * newAllocator,
+		VkImageView depthImageView, VkExtent2D depthExtent, int framesInFlight, uint32_t newMaxObjects = 1024);
+	void destroy();
+
+	// objects to cull this frame, anything past getMaxObjects() isn't culled
+	void setObjects(int frame, const std::vector<CullObject> &objects);
+	void setViewProjection(const glm::mat4 &newViewProjection);
+	uint32_t getMaxObjects();
+
+	// -- RECORD FUNCTIONS --
+	// before the early render pass. the draw buffers are written by compute, the caller makes the writes
+	// visible to the indirect draws
+	void recordEarlyCull(VkCommandBuffer commandBuffer, int frame);
+	// after the early render pass, its depth attachment must be in SHADER_READ_ONLY_OPTIMAL
+	void recordDepthPyramid(VkCommandBuffer commandBuffer);
+	// before the late render pass
+	void recordLateCull(VkCommandBuffer commandBuffer, int frame);
+
+	// indirect draws for each phase, one VkDrawIndexedIndirectCommand per object
+	VkBuffer getEarlyDrawBuffer(int frame);
+	VkBuffer getLateDrawBuffer(int frame);
+
+	// objects rejected by the depth pyramid, only valid once the frame's submission has finished
+	uint32_t getOccludedCount(int frame);
+
+	// whether the object passed the last late phase to finish. frames still in flight may be rewriting it,
+	// so it is a hint for things like residency rather than an exact answer
+	bool isObjectVisible(uint32_t object);
+
+	~OcclusionCuller();
+
+private:
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	DeviceAllocator * allocator = nullptr;
+
+	uint32_t maxObjects = 0;
+	glm::mat4 viewProjection = glm::mat4(1.0f);
+
+	// - Depth pyramid
+	VkExtent2D depthSize = {};
+	VkExtent2D pyramidSize = {};
+	uint32_t pyramidLevels = 0;
+	UniqueDeviceMemory pyramidMemory;
+	UniqueImage pyramidImage;
+	UniqueImageView pyramidView;						// every level, sampled by the cull shader
+	std::vector<UniqueImageView> pyramidLevelViews;		// one level each, written by the reduce shader
+	UniqueSampler pyramidSampler;
+
+	// - Per frame buffers
+	struct FrameBuffers {
+		int objectCount = 0;
+		UniqueDeviceMemory objectMemory;
+		UniqueBuffer objectBuffer;						// host visible, rewritten every frame
+		UniqueDeviceMemory earlyDrawMemory;
+		UniqueBuffer earlyDrawBuffer;
+		UniqueDeviceMemory lateDrawMemory;
+		UniqueBuffer lateDrawBuffer;
+		UniqueDeviceMemory statsMemory;
+		UniqueBuffer statsBuffer;						// host visible occluded object counter
+		void * mappedObjects = nullptr;
+		void * mappedStats = nullptr;
+		VkDescriptorSet cullDescriptorSet = VK_NULL_HANDLE;
+	};
+	std::vector<FrameBuffers> frames;
+
+	// visibility from the last late phase, shared by every frame since they run in order on one queue
+	UniqueDeviceMemory visibilityMemory;
+	UniqueBuffer visibilityBuffer;
+	void * mappedVisibility = nullptr;
+
+	// - Pipelines
+	UniqueDescriptorPool descriptorPool;
+	UniqueDescriptorSetLayout reduceSetLayout;
+	UniqueDescriptorSetLayout cullSetLayout;
+	std::vector<VkDescriptorSet> reduceDescriptorSets;	// one per pyramid level
+	UniquePipelineLayout reducePipelineLayout;
+	UniquePipelineLayout cullPipelineLayout;
+	UniquePipeline reducePipeline;
+	UniquePipeline cullPipeline;
+
+	void createDepthPyramid();
+	void createBuffers(int framesInFlight);
+	void createDescriptorSets(VkImageView depthImageView);
+	void createPipelines(ShaderManager * shaderManager);
+	VkPipeline createComputePipeline(VkShaderModule module, VkPipelineLayout layout);
+	void recordCull(VkCommandBuffer commandBuffer, int frame, uint32_t latePhase);
+};
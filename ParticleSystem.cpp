@@ -0,0 +1,207 @@
+#include "ParticleSystem.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace {
+
+	const uint32_t GROUP_SIZE = 64;				// local_size_x of the emit and simulate kernels
+
+	// a control buffer, as the kernels see it
+	struct ParticleControl {
+		VkDrawIndirectCommand draw;				// instanceCount is the live particle count
+		VkDispatchIndirectCommand simulate;
+		uint32_t simulateCount;
+	};
+
+	struct EmitConstants {
+		glm::vec4 position;						// w: lifetime
+		glm::vec4 velocity;						// w: spread
+		uint32_t color;
+		uint32_t count;
+		uint32_t seed;
+		uint32_t maxParticles;
+	};
+
+	struct PrepareConstants {
+		uint32_t maxParticles;
+	};
+
+	struct SimulateConstants {
+		glm::vec4 gravity;						// w: delta time
+	};
+}
+
+ParticleSystem::ParticleSystem()
+{
+}
+
+void ParticleSystem::create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, ShaderManager * shaderManager, DeviceAllocator * allocator,
+	uint32_t newMaxParticles, const std::vector<uint32_t> &queueFamilies){
+
+	device = newDevice;
+	maxParticles = newMaxParticles;
+
+	emitKernel.create(device, shaderManager, "Shaders/particle_emit.comp", 4, sizeof(EmitConstants));
+	prepareKernel.create(device, shaderManager, "Shaders/particle_prepare.comp", 4, sizeof(PrepareConstants));
+	simulateKernel.create(device, shaderManager, "Shaders/particle_simulate.comp", 4, sizeof(SimulateConstants), 2);
+
+	for (size_t i = 0; i < particleBuffers.size(); i++) {
+		ComputePipeline::createStorageBuffer(newPhysicalDevice, device, allocator, sizeof(ParticleControl), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			&controlBuffers[i], &controlMemory[i], queueFamilies);
+		ComputePipeline::createStorageBuffer(newPhysicalDevice, device, allocator, static_cast<VkDeviceSize>(maxParticles) * sizeof(Particle),
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &particleBuffers[i], &particleMemory[i], queueFamilies);
+	}
+
+	sets[0] = simulateKernel.createSet({ controlBuffers[0].get(), particleBuffers[0].get(), controlBuffers[1].get(), particleBuffers[1].get() });
+	sets[1] = simulateKernel.createSet({ controlBuffers[1].get(), particleBuffers[1].get(), controlBuffers[0].get(), particleBuffers[0].get() });
+
+	emitRemainder = 0.0f;
+	pendingBurst = 0;
+	emitCount = 0;
+	source = 0;
+	current = 0;
+	cleared = false;
+	drawValues = {};
+}
+
+void ParticleSystem::destroy(){
+
+	simulateKernel.destroy();
+	prepareKernel.destroy();
+	emitKernel.destroy();
+
+	for (size_t i = 0; i < particleBuffers.size(); i++) {
+		particleBuffers[i].reset();
+		particleMemory[i].reset();
+		controlBuffers[i].reset();
+		controlMemory[i].reset();
+	}
+	sets = {};
+}
+
+void ParticleSystem::setEmitter(const ParticleEmitter &newEmitter){
+	emitter = newEmitter;
+}
+
+void ParticleSystem::emitBurst(uint32_t count){
+	pendingBurst += count;
+}
+
+void ParticleSystem::update(float newDeltaTime){
+
+	deltaTime = newDeltaTime;
+
+	// clamped before the conversion, a long stall would otherwise ask for more than fit
+	float wanted = std::min(emitter.rate * deltaTime + emitRemainder, static_cast<float>(maxParticles));
+	uint32_t fromRate = static_cast<uint32_t>(wanted);
+	emitRemainder = wanted - fromRate;
+
+	emitCount = static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(fromRate) + pendingBurst, maxParticles));
+	pendingBurst = 0;
+
+	// new random numbers for every update (LCG step)
+	seed = seed * 1664525u + 1013904223u;
+
+	source = current;
+	current = 1 - current;
+}
+
+void ParticleSystem::recordUpdate(VkCommandBuffer commandBuffer){
+
+	VkDescriptorSet set = sets[source];
+	VkBuffer destinationControl = controlBuffers[current].get();
+
+	// dispatch arguments are read at the indirect stage, which compute queues have too
+	VkPipelineStageFlags previousStages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+	VkAccessFlags previousAccess = VK_ACCESS_SHADER_WRITE_BIT;
+
+	// the source's live count is read before anything is written, so both start from zero
+	if (!cleared) {
+		for (auto &controlBuffer : controlBuffers) {
+			deviceDispatch.vkCmdFillBuffer(commandBuffer, controlBuffer.get(), 0, sizeof(ParticleControl), 0);
+		}
+		previousStages |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+		previousAccess |= VK_ACCESS_TRANSFER_WRITE_BIT;
+		cleared = true;
+	}
+
+	// the last update's writes are visible and its reads of what is written now have finished
+	ComputePipeline::recordBarrier(commandBuffer, previousStages, previousAccess,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+	// -- PREPARE --
+	PrepareConstants prepareConstants = {};
+	prepareConstants.maxParticles = maxParticles;
+	prepareKernel.recordDispatch(commandBuffer, set, &prepareConstants, 1);
+	ComputePipeline::recordBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+	// -- SIMULATE --
+	// as many groups as prepare counted live particles, nothing is dispatched once they have all died
+	SimulateConstants simulateConstants = {};
+	simulateConstants.gravity = glm::vec4(emitter.gravity, deltaTime);
+	simulateKernel.recordDispatchIndirect(commandBuffer, set, &simulateConstants, destinationControl, offsetof(ParticleControl, simulate));
+
+	// -- EMIT --
+	// after the survivors, so it can tell how much room is left
+	if (emitCount > 0) {
+		ComputePipeline::recordBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+		EmitConstants emitConstants = {};
+		emitConstants.position = glm::vec4(emitter.position, emitter.lifetime);
+		emitConstants.velocity = glm::vec4(emitter.velocity, emitter.spread);
+		emitConstants.color = packColor(emitter.color);
+		emitConstants.count = emitCount;
+		emitConstants.seed = seed;
+		emitConstants.maxParticles = maxParticles;
+
+		emitKernel.recordDispatch(commandBuffer, set, &emitConstants, (emitCount + GROUP_SIZE - 1) / GROUP_SIZE);
+	}
+}
+
+void ParticleSystem::recordDraw(VkCommandBuffer commandBuffer){
+
+	VkBuffer vertexBuffer = particleBuffers[current].get();
+	VkDeviceSize offset = 0;
+	deviceDispatch.vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+	deviceDispatch.vkCmdDrawIndirect(commandBuffer, controlBuffers[current].get(), offsetof(ParticleControl, draw), 1, sizeof(VkDrawIndirectCommand));
+}
+
+void ParticleSystem::recordCountCopy(VkCommandBuffer commandBuffer, VkBuffer destination, VkDeviceSize offset){
+
+	ComputePipeline::recordBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+	VkBufferCopy region = {};
+	region.srcOffset = offsetof(ParticleControl, draw) + offsetof(VkDrawIndirectCommand, instanceCount);
+	region.dstOffset = offset;
+	region.size = sizeof(uint32_t);
+	deviceDispatch.vkCmdCopyBuffer(commandBuffer, controlBuffers[current].get(), destination, 1, &region);
+}
+
+VkBuffer ParticleSystem::getControlBuffer(){
+	return controlBuffers[current].get();
+}
+
+VkBuffer ParticleSystem::getParticleBuffer(){
+	return particleBuffers[current].get();
+}
+
+uint32_t ParticleSystem::getMaxParticles(){
+	return maxParticles;
+}
+
+void ParticleSystem::setDrawValue(uint64_t value){
+	drawValues[current] = value;
+}
+
+uint64_t ParticleSystem::getWriteWaitValue(){
+	return drawValues[current];
+}
+
+ParticleSystem::~ParticleSystem()
+{
+}
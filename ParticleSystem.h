@@ -0,0 +1,103 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <array>
+
+#include "Utilities.h"
+#include "VulkanHandles.h"
+#include "ComputePipeline.h"
+
+// where new particles appear and how they move, in clip space like the scene (y points down the screen)
+struct ParticleEmitter {
+	float rate = 0.0f;										// particles a second, 0 emits nothing
+	glm::vec3 position = glm::vec3(0.0f, 0.5f, 0.5f);
+	glm::vec3 velocity = glm::vec3(0.0f, -1.2f, 0.0f);
+	float spread = 0.4f;									// random velocity up to this added on x and y
+	glm::vec3 gravity = glm::vec3(0.0f, 1.5f, 0.0f);
+	float lifetime = 1.5f;									// seconds
+	glm::vec4 color = glm::vec4(1.0f, 0.6f, 0.2f, 1.0f);
+};
+
+// Particles that live entirely on the GPU, in two buffers that take turns being drawn. Each update reads the one
+// drawn last and writes the other, in three dispatches:
+// - prepare: turn the source's live count in to the simulate dispatch's group count and reset the destination's count
+// - simulate: move and age every live particle and append the survivors to the destination, which compacts them
+// - emit: append new particles after the survivors
+// The survivors are counted straight in to a VkDrawIndirectCommand (six vertices a particle), so drawing needs
+// no count from the CPU and nothing per particle is ever read back. The update only reads what the last draw reads,
+// so it can run on another queue while that draw is still going.
+// Each particle buffer has a control buffer: the draw command, then the simulate dispatch's VkDispatchIndirectCommand
+// that fills it, then that dispatch's count
+class ParticleSystem
+{
+public:
+	ParticleSystem();
+
+	// queueFamilies share the buffers when the update and the draw are on different families
+	void create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, ShaderManager * shaderManager, DeviceAllocator * allocator,
+		uint32_t newMaxParticles, const std::vector<uint32_t> &queueFamilies = {});
+	void destroy();
+
+	void setEmitter(const ParticleEmitter &newEmitter);
+	// emit count particles on the next update as well as the emitter's rate
+	void emitBurst(uint32_t count);
+
+	// on the CPU before recording: work out the emit count and which buffer the update writes
+	void update(float deltaTime);
+
+	// -- RECORD FUNCTIONS --
+	// the update's dispatches, synchronized against the previous update. the submission has to wait for the
+	// draw of the buffer it writes (getWriteWaitValue), and what reads the results for its compute shader writes
+	void recordUpdate(VkCommandBuffer commandBuffer);
+	// inside a render pass with a VERTEX_LAYOUT_PARTICLE pipeline bound
+	void recordDraw(VkCommandBuffer commandBuffer);
+
+	// copy the live count the last update left in to destination at offset, to check the kernels ran.
+	// the submission has to finish before the next update overwrites it
+	void recordCountCopy(VkCommandBuffer commandBuffer, VkBuffer destination, VkDeviceSize offset);
+
+	// buffers the update writes and the draw reads, after update the ones this frame draws
+	VkBuffer getControlBuffer();
+	VkBuffer getParticleBuffer();
+	uint32_t getMaxParticles();
+
+	// - Cross queue
+	// timeline value of the submission that draws this frame's buffers, after update
+	void setDrawValue(uint64_t value);
+	// the last draw of the buffers the next recordUpdate writes, after update. 0 if they were never drawn
+	uint64_t getWriteWaitValue();
+
+	~ParticleSystem();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	uint32_t maxParticles = 0;
+
+	ComputePipeline emitKernel;
+	ComputePipeline prepareKernel;
+	ComputePipeline simulateKernel;
+
+	// memory declared before its buffers, so the buffers are destroyed first
+	std::array<UniqueDeviceMemory, 2> controlMemory;
+	std::array<UniqueBuffer, 2> controlBuffers;
+	std::array<UniqueDeviceMemory, 2> particleMemory;
+	std::array<UniqueBuffer, 2> particleBuffers;
+	std::array<uint64_t, 2> drawValues = {};		// last draw of each pair
+
+	// every kernel binds source control, source particles, destination control, destination particles. one set per
+	// direction, made by the simulate kernel and shared by the others through their compatible layouts
+	std::array<VkDescriptorSet, 2> sets = {};
+
+	ParticleEmitter emitter;
+	float emitRemainder = 0.0f;					// fraction of a particle carried to the next update
+	uint32_t pendingBurst = 0;
+	uint32_t emitCount = 0;						// this update's
+	float deltaTime = 0.0f;
+	uint32_t seed = 0;
+	uint32_t source = 0;						// particle buffer the update reads
+	uint32_t current = 0;						// and the one it writes, which is drawn
+	bool cleared = false;						// control buffers zeroed by the first update
+};
@@ -0,0 +1,640 @@
+#include "PipelineManager.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+
+#include "Utilities.h"
+
+// -- PIPELINE STATE --
+bool PipelineState::operator==(const PipelineState &other) const {
+	return vertexShader == other.vertexShader
+		&& fragmentShader == other.fragmentShader
+		&& taskShader == other.taskShader
+		&& meshShader == other.meshShader
+		&& vertexLayout == other.vertexLayout
+		&& topology == other.topology
+		&& polygonMode == other.polygonMode
+		&& cullMode == other.cullMode
+		&& frontFace == other.frontFace
+		&& blendEnable == other.blendEnable
+		&& depthTestEnable == other.depthTestEnable
+		&& depthWriteEnable == other.depthWriteEnable;
+}
+
+uint64_t PipelineState::hash() const {
+
+	// FNV-1a over every field of the state
+	uint64_t value = 14695981039346656037ull;
+	auto combine = [&value](const void * data, size_t size) {
+		const unsigned char * bytes = static_cast<const unsigned char *>(data);
+		for (size_t i = 0; i < size; i++) {
+			value ^= bytes[i];
+			value *= 1099511628211ull;
+		}
+	};
+
+	combine(vertexShader.data(), vertexShader.size());
+	combine(fragmentShader.data(), fragmentShader.size());
+	combine(taskShader.data(), taskShader.size());
+	combine(meshShader.data(), meshShader.size());
+	combine(&vertexLayout, sizeof(vertexLayout));
+	combine(&topology, sizeof(topology));
+	combine(&polygonMode, sizeof(polygonMode));
+	combine(&cullMode, sizeof(cullMode));
+	combine(&frontFace, sizeof(frontFace));
+	combine(&blendEnable, sizeof(blendEnable));
+	combine(&depthTestEnable, sizeof(depthTestEnable));
+	combine(&depthWriteEnable, sizeof(depthWriteEnable));
+
+	return value;
+}
+
+// -- PIPELINE MANAGER --
+PipelineManager::PipelineManager(){
+
+}
+
+void PipelineManager::create(VkDevice newDevice, const RenderTarget &newRenderTarget, VkPipelineLayout newPipelineLayout, VkExtent2D newExtent,
+	ShaderManager * newShaderManager, DeletionQueue * newDeletionQueue, uint32_t workerCount){
+
+	device = newDevice;
+	renderTarget = newRenderTarget;
+	pipelineLayout = newPipelineLayout;
+	extent = newExtent;
+	shaderManager = newShaderManager;
+	deletionQueue = newDeletionQueue;
+
+	// one cache shared by every worker, the driver synchronizes access to it internally
+	VkPipelineCacheCreateInfo cacheCreateInfo = {};
+	cacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+	VkResult result = vkCreatePipelineCache(device, &cacheCreateInfo, nullptr, &pipelineCache);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline cache");
+	}
+
+	// leave a core for the main thread
+	if (workerCount == 0) {
+		workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	}
+
+	stopping = false;
+	for (uint32_t i = 0; i < workerCount; i++) {
+		workers.emplace_back(&PipelineManager::workerLoop, this);
+	}
+}
+
+void PipelineManager::destroy(){
+
+	// stop workers, anything still queued is dropped
+	{
+		std::lock_guard<std::mutex> lock(variantMutex);
+		stopping = true;
+		pendingVariants.clear();
+	}
+	workAvailable.notify_all();
+
+	for (auto &worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+
+	variants.clear();
+	hasPlaceholder = false;
+
+	if (pipelineCache != VK_NULL_HANDLE) {
+		vkDestroyPipelineCache(device, pipelineCache, nullptr);
+		pipelineCache = VK_NULL_HANDLE;
+	}
+}
+
+uint64_t PipelineManager::request(const PipelineState &state){
+
+	uint64_t handle;
+	bool added;
+	{
+		std::lock_guard<std::mutex> lock(variantMutex);
+		PipelineVariant * variant = findOrAddVariant(state, &handle, &added);
+
+		// identical request already compiled or queued, share it
+		if (!added) {
+			return handle;
+		}
+
+		variant->queued = true;
+		pendingVariants.push_back(variant);
+	}
+	workAvailable.notify_one();
+
+	return handle;
+}
+
+uint64_t PipelineManager::requestNow(const PipelineState &state){
+
+	uint64_t handle;
+	bool added;
+	PipelineVariant * variant;
+	{
+		std::lock_guard<std::mutex> lock(variantMutex);
+		variant = findOrAddVariant(state, &handle, &added);
+		if (added) {
+			compilingCount++;
+		}
+	}
+
+	if (added) {
+		compileVariant(variant);
+	}
+	else
+	{
+		// already queued on a worker, wait for it to finish
+		std::unique_lock<std::mutex> lock(variantMutex);
+		workDone.wait(lock, [variant]() { return variant->ready.load(); });
+	}
+
+	if (variant->failed) {
+		throw std::runtime_error("failed to create graphics pipeline");
+	}
+
+	return handle;
+}
+
+VkPipeline PipelineManager::getPipeline(uint64_t handle){
+
+	std::lock_guard<std::mutex> lock(variantMutex);
+
+	auto variant = variants.find(handle);
+	if (variant == variants.end() || !variant->second->ready || variant->second->failed) {
+		if (!hasPlaceholder) {
+			return VK_NULL_HANDLE;
+		}
+		variant = variants.find(placeholderHandle);
+	}
+
+	return variant->second->pipeline.get();
+}
+
+bool PipelineManager::isReady(uint64_t handle){
+
+	std::lock_guard<std::mutex> lock(variantMutex);
+
+	auto variant = variants.find(handle);
+	return variant != variants.end() && variant->second->ready;
+}
+
+void PipelineManager::setPlaceholder(uint64_t handle){
+
+	std::lock_guard<std::mutex> lock(variantMutex);
+
+	auto variant = variants.find(handle);
+	if (variant == variants.end() || !variant->second->ready || variant->second->failed) {
+		throw std::runtime_error("placeholder pipeline must be compiled before use");
+	}
+
+	placeholderHandle = handle;
+	hasPlaceholder = true;
+}
+
+void PipelineManager::waitIdle(){
+
+	std::unique_lock<std::mutex> lock(variantMutex);
+	workDone.wait(lock, [this]() { return pendingVariants.empty() && compilingCount == 0; });
+}
+
+void PipelineManager::update(){
+
+	// -- SWAP IN REBUILT PIPELINES --
+	// done here rather than on the worker so the old pipeline is retired after the last frame
+	// that recorded it was submitted, and before the next frame records the new one
+	{
+		std::lock_guard<std::mutex> lock(variantMutex);
+
+		for (auto &variant : variants) {
+			if (variant.second->rebuiltPipeline) {
+				deletionQueue->retirePipeline(variant.second->pipeline.release());
+				variant.second->pipeline = std::move(variant.second->rebuiltPipeline);
+			}
+		}
+	}
+
+	// -- REBUILD PIPELINES FOR CHANGED SHADERS --
+	std::vector<std::string> changedShaders = shaderManager->pollChanges();
+	if (changedShaders.empty()) {
+		return;
+	}
+
+	// old shader modules are destroyed by the reload, so no worker may be using them
+	waitIdle();
+
+	std::vector<std::string> reloadedShaders;
+	for (const auto &shader : changedShaders) {
+		if (shaderManager->reload(shader)) {
+			reloadedShaders.push_back(shader);
+		}
+	}
+
+	if (reloadedShaders.empty()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(variantMutex);
+
+		// only variants built from a reloaded shader need rebuilding
+		for (auto &variant : variants) {
+
+			PipelineVariant * rebuild = variant.second.get();
+			bool usesShader = false;
+			for (const std::string * shader : { &rebuild->state.vertexShader, &rebuild->state.fragmentShader, &rebuild->state.taskShader, &rebuild->state.meshShader }) {
+				if (!shader->empty() && std::find(reloadedShaders.begin(), reloadedShaders.end(), *shader) != reloadedShaders.end()) {
+					usesShader = true;
+				}
+			}
+
+			if (usesShader && rebuild->ready && !rebuild->queued) {
+				rebuild->queued = true;
+				pendingVariants.push_back(rebuild);
+			}
+		}
+	}
+	workAvailable.notify_all();
+}
+
+void PipelineManager::reportCompileTimes(){
+
+	std::lock_guard<std::mutex> lock(variantMutex);
+
+	for (const auto &variant : variants) {
+
+		if (!variant.second->ready) {
+			printf("pipeline %016llx: compiling\n", (unsigned long long)variant.first);
+		}
+		else if (variant.second->failed)
+		{
+			printf("pipeline %016llx: failed\n", (unsigned long long)variant.first);
+		}
+		else
+		{
+			printf("pipeline %016llx: %.2f ms\n", (unsigned long long)variant.first, variant.second->compileMilliseconds);
+		}
+	}
+}
+
+PipelineManager::~PipelineManager(){
+
+}
+
+PipelineManager::PipelineVariant * PipelineManager::findOrAddVariant(const PipelineState &state, uint64_t * handle, bool * added){
+
+	// step past any (very unlikely) hash collision with a different state
+	uint64_t key = state.hash();
+	auto existing = variants.find(key);
+	while (existing != variants.end() && !(existing->second->state == state)) {
+		key++;
+		existing = variants.find(key);
+	}
+
+	*handle = key;
+	if (existing != variants.end()) {
+		*added = false;
+		return existing->second.get();
+	}
+
+	std::unique_ptr<PipelineVariant> variant(new PipelineVariant());
+	variant->state = state;
+
+	PipelineVariant * newVariant = variant.get();
+	variants[key] = std::move(variant);
+
+	*added = true;
+	return newVariant;
+}
+
+void PipelineManager::compileVariant(PipelineVariant * variant){
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	bool failed = false;
+	try
+	{
+		pipeline = compilePipeline(variant->state);
+	}
+	catch (const std::runtime_error &e)
+	{
+		// worker threads can't throw back to the caller, the placeholder stays in use
+		printf("ERROR: %s\n", e.what());
+		failed = true;
+	}
+
+	auto endTime = std::chrono::steady_clock::now();
+
+	{
+		std::lock_guard<std::mutex> lock(variantMutex);
+
+		if (!variant->pipeline) {
+			variant->pipeline = UniquePipeline(device, pipeline);
+			variant->failed = failed;
+		}
+		else if (!failed)
+		{
+			// a rebuild, frames may still be recording with the current pipeline so leave the swap to update()
+			variant->rebuiltPipeline = UniquePipeline(device, pipeline);
+		}
+		// a failed rebuild keeps the pipeline that already works
+
+		variant->compileMilliseconds = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+		variant->ready = true;
+		compilingCount--;
+	}
+	workDone.notify_all();
+}
+
+void PipelineManager::workerLoop(){
+
+	while (true) {
+
+		PipelineVariant * variant;
+		{
+			std::unique_lock<std::mutex> lock(variantMutex);
+			workAvailable.wait(lock, [this]() { return stopping || !pendingVariants.empty(); });
+
+			if (stopping) {
+				return;
+			}
+
+			variant = pendingVariants.front();
+			pendingVariants.pop_front();
+			variant->queued = false;
+			compilingCount++;
+		}
+
+		compileVariant(variant);
+	}
+}
+
+VkPipeline PipelineManager::compilePipeline(const PipelineState &state){
+
+	// mesh shader pipelines fetch their own vertices, so have no vertex shader or vertex input
+	bool meshPipeline = !state.meshShader.empty();
+
+	// --SHADER STAGE CREATION INFORMATION --
+	// shader modules come from the shader manager's cache, shared with every other variant using them
+	VkPipelineShaderStageCreateInfo shaderStageCreateInfo = {};
+	shaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStageCreateInfo.pName = "main";									// entry point in to shader
+
+	// graphics pipeline creation info requires an array of shader stage creates
+	std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+
+	if (meshPipeline) {
+
+		if (!state.taskShader.empty()) {
+			shaderStageCreateInfo.stage = VK_SHADER_STAGE_TASK_BIT_EXT;
+			shaderStageCreateInfo.module = shaderManager->getModule(state.taskShader);
+			shaderStages.push_back(shaderStageCreateInfo);
+		}
+
+		shaderStageCreateInfo.stage = VK_SHADER_STAGE_MESH_BIT_EXT;
+		shaderStageCreateInfo.module = shaderManager->getModule(state.meshShader);
+		shaderStages.push_back(shaderStageCreateInfo);
+	}
+	else
+	{
+		// Vertex stage creation information
+		shaderStageCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;						// shader stage name
+		shaderStageCreateInfo.module = shaderManager->getModule(state.vertexShader);	// shader module to be used by stage
+		shaderStages.push_back(shaderStageCreateInfo);
+	}
+
+	// Fragment stage creation information
+	shaderStageCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shaderStageCreateInfo.module = shaderManager->getModule(state.fragmentShader);
+	shaderStages.push_back(shaderStageCreateInfo);
+
+	// how the data for a single vertex (including info like position, color, normals etc) isas a whole
+	VkVertexInputBindingDescription bindingDescription = {};
+	bindingDescription.binding = 0;									// can bind multiple source of data. this defines which one
+	bindingDescription.stride = sizeof(Vertex);						// size of a single vertex object
+	bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;		// how to move between data after each vertex
+																	// VK_VERTEX_INPUT_RATE_VERTEX		move onto next vertex
+																	// VK_VERTEX_INPUT_RATE_INSTANCE	move to a vertex for the next instance
+
+	// model matrices come from the scene graph's instance buffer, one per draw
+	VkVertexInputBindingDescription instanceBindingDescription = {};
+	instanceBindingDescription.binding = 1;
+	instanceBindingDescription.stride = sizeof(glm::mat4);
+	instanceBindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions = { bindingDescription, instanceBindingDescription };
+
+	// how the data for an attribute is defined within a vertex
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+	VkVertexInputAttributeDescription attributeDescription = {};
+
+	if (state.vertexLayout == VERTEX_LAYOUT_PARTICLE) {
+		// one particle per instance straight from the simulation's buffer, the quad's corners come from gl_VertexIndex
+		bindingDescription.stride = sizeof(Particle);
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+		bindingDescriptions = { bindingDescription };
+
+		attributeDescription.binding = 0;
+		attributeDescription.location = 0;
+		attributeDescription.format = VK_FORMAT_R32G32B32_SFLOAT;
+		attributeDescription.offset = offsetof(Particle, position);
+		attributeDescriptions.push_back(attributeDescription);
+
+		attributeDescription.location = 1;
+		attributeDescription.format = VK_FORMAT_R8G8B8A8_UNORM;
+		attributeDescription.offset = offsetof(Particle, color);
+		attributeDescriptions.push_back(attributeDescription);
+
+		attributeDescription.location = 2;
+		attributeDescription.format = VK_FORMAT_R32_SFLOAT;
+		attributeDescription.offset = offsetof(Particle, life);
+		attributeDescriptions.push_back(attributeDescription);
+	}
+	else if (state.vertexLayout == VERTEX_LAYOUT_DEBUG) {
+		// packed position and color, the model matrix binding is kept
+		bindingDescriptions[0].stride = sizeof(DebugVertex);
+
+		attributeDescription.binding = 0;
+		attributeDescription.location = 0;
+		attributeDescription.format = VK_FORMAT_R32G32B32_SFLOAT;
+		attributeDescription.offset = offsetof(DebugVertex, position);
+		attributeDescriptions.push_back(attributeDescription);
+
+		attributeDescription.location = 1;
+		attributeDescription.format = VK_FORMAT_R8G8B8A8_UNORM;
+		attributeDescription.offset = offsetof(DebugVertex, color);
+		attributeDescriptions.push_back(attributeDescription);
+	}
+	else {
+		// position attribute
+		attributeDescription.binding = 0;								// which binding the data is at (should be the same as above
+		attributeDescription.location = 0;								// location in shader where data will be read from
+		attributeDescription.format = VK_FORMAT_R32G32B32_SFLOAT;		// format the data will be ( helps define size of data)
+		attributeDescription.offset = offsetof(Vertex, pos);			// where this attribute is defined in the data for single vertex
+		attributeDescriptions.push_back(attributeDescription);
+
+		// color and texture coordinate attributes, the position only layout skips them
+		if (state.vertexLayout != VERTEX_LAYOUT_POSITION) {
+			attributeDescription.location = 1;
+			attributeDescription.offset = offsetof(Vertex, col);
+			attributeDescriptions.push_back(attributeDescription);
+
+			// after the model matrix's locations
+			attributeDescription.location = 6;
+			attributeDescription.format = VK_FORMAT_R32G32_SFLOAT;
+			attributeDescription.offset = offsetof(Vertex, tex);
+			attributeDescriptions.push_back(attributeDescription);
+		}
+	}
+
+	// model matrix attribute, a mat4 takes one location per column. particles have none
+	if (state.vertexLayout != VERTEX_LAYOUT_PARTICLE) {
+		for (uint32_t column = 0; column < 4; column++) {
+			attributeDescription.binding = 1;
+			attributeDescription.location = 2 + column;
+			attributeDescription.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			attributeDescription.offset = column * sizeof(glm::vec4);
+			attributeDescriptions.push_back(attributeDescription);
+		}
+	}
+
+	// -- VERTEX INPUT --
+	VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = {};
+	vertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+	vertexInputCreateInfo.pVertexBindingDescriptions = bindingDescriptions.data();						// list of vertex binding descriptions (data spacing, stride info)
+	vertexInputCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+	vertexInputCreateInfo.pVertexAttributeDescriptions = attributeDescriptions.data();					// list of vertex attribute descriptions (data format and where to bind to or from)
+
+	// -- INPUT ASSEMBLY --
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = state.topology;							// primitive type to assemble
+	inputAssembly.primitiveRestartEnable = VK_FALSE;					// allow overriding of strip topology to start new primitives
+
+	// -- VIEWPORT & SCISSOR --
+	// create a viewport info struct
+	VkViewport viewport = {};
+	viewport.x = 0.0f;									// x start coordinate
+	viewport.y = 0.0f;									// y start coordinate
+	viewport.width = (float)extent.width;				// width of viewport
+	viewport.height = (float)extent.height;				// height of viewport
+	viewport.minDepth = 0.0f;							// min framebuffer depth
+	viewport.maxDepth = 1.0f;							// max framebuffer depth
+
+	// create a scissor info struct
+	VkRect2D scissor = {};
+	scissor.offset = { 0,0 };							// offset to use region from
+	scissor.extent = extent;							// extent to describe region to use, starting at offset
+
+	VkPipelineViewportStateCreateInfo viewportStateCreateInfo = {};
+	viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportStateCreateInfo.viewportCount = 1;
+	viewportStateCreateInfo.pViewports = &viewport;
+	viewportStateCreateInfo.scissorCount = 1;
+	viewportStateCreateInfo.pScissors = &scissor;
+
+	// -- RASTERIZER --
+	VkPipelineRasterizationStateCreateInfo rasterizerCreateInfo = {};
+	rasterizerCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizerCreateInfo.depthClampEnable = VK_FALSE;				// change if fragments beyond near or far plane are clipped (default) or clamped to plane (needs gpu feature if other setting)
+	rasterizerCreateInfo.rasterizerDiscardEnable = VK_FALSE;		// wether to discard data and sckip rasterizer, never creates fragments, only for pipeline without framebuffer
+	rasterizerCreateInfo.polygonMode = state.polygonMode;			// how to handle filling points between vertices (needs gpu feature if other setting)
+	rasterizerCreateInfo.lineWidth = 1.0f;							// how thic lines should be when drawn (needs gpu feature if other setting)
+	rasterizerCreateInfo.cullMode = state.cullMode;					// which face of a tri to cull
+	rasterizerCreateInfo.frontFace = state.frontFace;				// winding to determine which side is front
+	rasterizerCreateInfo.depthBiasEnable = VK_FALSE;				// whether to add depth bias to fragments (good for stopping "shadow_acne" in shadow mapping
+
+
+	// -- MULTISAMPLING --
+	VkPipelineMultisampleStateCreateInfo multisamplingCreateInfo = {};
+	multisamplingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisamplingCreateInfo.sampleShadingEnable = VK_FALSE;					// enable multisample shading or not
+	multisamplingCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;	// number of samples to use per fragment
+
+
+	// -- BLENDING --
+	// blending decides how to blend a new color being written to a fragment with the old value
+
+	// blend attachment state (how blending is handled)
+	VkPipelineColorBlendAttachmentState colorState = {};
+	colorState.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;	// color to apply blending to
+	colorState.blendEnable = state.blendEnable ? VK_TRUE : VK_FALSE;																		// enable blending
+
+	// blending use equation (srcColorBlendFactor * new color) colorBlendOp (destColorBlendFactor * old color)
+	colorState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	colorState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	colorState.colorBlendOp = VK_BLEND_OP_ADD;
+
+	// summarized: (VK_BLEND_FACTOR_SRC_ALPHA * new color) * (VKL_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA * old color)
+	//			   (new color alpha * new color) * ((1- new color alpha) * new color)
+
+	colorState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	colorState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	colorState.alphaBlendOp = VK_BLEND_OP_ADD;
+
+	// summmarized: (1 * new alpha) + (0 * old alpha) = new alpha
+
+	VkPipelineColorBlendStateCreateInfo colorBlendingCreateInfo = {};
+	colorBlendingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlendingCreateInfo.logicOpEnable = VK_FALSE;				// alternative to calculations is to use logical operations
+	colorBlendingCreateInfo.attachmentCount = 1;
+	colorBlendingCreateInfo.pAttachments = &colorState;
+
+	// -- DEPTH STENCIL TESTING --
+	VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo = {};
+	depthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencilCreateInfo.depthTestEnable = state.depthTestEnable ? VK_TRUE : VK_FALSE;		// enable checking depth to determine fragment write
+	depthStencilCreateInfo.depthWriteEnable = state.depthWriteEnable ? VK_TRUE : VK_FALSE;		// enable writing to depth buffer (to replace old values)
+	depthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;						// comparison operation that allows an overwrite (equal keeps draw order for flat geometry)
+	depthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;									// depth bounds test: does the depth value exist between two bounds
+	depthStencilCreateInfo.stencilTestEnable = VK_FALSE;										// enable stencil test
+
+
+	// -- GRAPHICS PIPELINE CREATION --
+	VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
+	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());	// number of shader stages
+	pipelineCreateInfo.pStages = shaderStages.data();									// list of shader stages
+	pipelineCreateInfo.pVertexInputState = meshPipeline ? nullptr : &vertexInputCreateInfo;		// all the fixed function pipeline states
+	pipelineCreateInfo.pInputAssemblyState = meshPipeline ? nullptr : &inputAssembly;
+	pipelineCreateInfo.pViewportState = &viewportStateCreateInfo;
+	pipelineCreateInfo.pDynamicState = nullptr;
+	pipelineCreateInfo.pRasterizationState = &rasterizerCreateInfo;
+	pipelineCreateInfo.pMultisampleState = &multisamplingCreateInfo;
+	pipelineCreateInfo.pColorBlendState = &colorBlendingCreateInfo;
+	pipelineCreateInfo.pDepthStencilState = &depthStencilCreateInfo;
+	pipelineCreateInfo.layout = pipelineLayout;							// pipeline layout pipeline should use
+	pipelineCreateInfo.renderPass = renderTarget.renderPass;			// render pass description the pipeline is compatible with
+	pipelineCreateInfo.subpass = 0;										// subpass of render pass to use with pipeline
+
+	// without a render pass the attachment formats are given instead, for dynamic rendering
+	VkPipelineRenderingCreateInfoKHR renderingCreateInfo = {};
+	renderingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+	renderingCreateInfo.colorAttachmentCount = 1;
+	renderingCreateInfo.pColorAttachmentFormats = &renderTarget.colorFormat;
+	renderingCreateInfo.depthAttachmentFormat = renderTarget.depthFormat;
+	if (renderTarget.renderPass == VK_NULL_HANDLE) {
+		pipelineCreateInfo.pNext = &renderingCreateInfo;
+	}
+
+	// pipeline derivatives, can create multiple pipelines that derive from one another for optimization
+	pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;				// existing pipeline to derive from
+	pipelineCreateInfo.basePipelineIndex = -1;							// or index of pipeline being created to derive from
+
+	// create graphics pipeline, shared cache lets workers reuse each other's compiled state
+	VkPipeline pipeline;
+	VkResult result = vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline);
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create graphics pipeline");
+	}
+
+	return pipeline;
+}
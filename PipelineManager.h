@@ -0,0 +1,127 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "VulkanHandles.h"
+#include "ShaderManager.h"
+#include "DeletionQueue.h"
+
+// which attributes of Vertex a pipeline reads
+enum VertexLayout {
+	VERTEX_LAYOUT_POSITION_COLOR,		// position + color + texture coordinates (default)
+	VERTEX_LAYOUT_POSITION,				// position only (e.g. depth only passes)
+	VERTEX_LAYOUT_PARTICLE,				// one Particle per instance, no vertex buffer or model matrix
+	VERTEX_LAYOUT_DEBUG					// DebugVertex position + packed color, with the model matrix
+};
+
+// what every pipeline renders to: a render pass, or with dynamic rendering (no render pass) the formats of the
+// attachments that vkCmdBeginRendering will be given
+struct RenderTarget {
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+	VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+};
+
+// everything that makes one graphics pipeline variant different from another
+struct PipelineState {
+	std::string vertexShader = "Shaders/shader.vert";
+	std::string fragmentShader = "Shaders/shader.frag";
+	std::string taskShader;				// optional, mesh shader pipelines only
+	std::string meshShader;				// set for a mesh shader pipeline, replaces the vertex shader and vertex input
+	VertexLayout vertexLayout = VERTEX_LAYOUT_POSITION_COLOR;
+	VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+	VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+	VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+	bool blendEnable = true;
+	bool depthTestEnable = true;
+	bool depthWriteEnable = true;
+
+	bool operator==(const PipelineState &other) const;
+	uint64_t hash() const;
+};
+
+// Builds graphics pipeline variants on worker threads that share one VkPipelineCache.
+// Variants are keyed by a hash of their full state so identical requests are only compiled once,
+// and a placeholder pipeline is handed out until a variant has finished compiling.
+// When a shader changes on disk only the variants using it are rebuilt, the old pipeline stays in use meanwhile
+class PipelineManager
+{
+public:
+	PipelineManager();
+
+	void create(VkDevice newDevice, const RenderTarget &newRenderTarget, VkPipelineLayout newPipelineLayout, VkExtent2D newExtent,
+		ShaderManager * newShaderManager, DeletionQueue * newDeletionQueue, uint32_t workerCount = 0);
+	void destroy();
+
+	// queue a variant for compilation on a worker thread, returns the handle to look it up with
+	uint64_t request(const PipelineState &state);
+
+	// compile a variant on the calling thread and wait for it (e.g. the placeholder itself)
+	uint64_t requestNow(const PipelineState &state);
+
+	// pipeline for the handle, or the placeholder while it is still compiling
+	VkPipeline getPipeline(uint64_t handle);
+	bool isReady(uint64_t handle);
+	void setPlaceholder(uint64_t handle);
+
+	// block until every queued variant has compiled
+	void waitIdle();
+
+	// once a frame before recording: swap in rebuilt pipelines and queue rebuilds for changed shaders
+	void update();
+
+	// print compile time of every variant
+	void reportCompileTimes();
+
+	~PipelineManager();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	RenderTarget renderTarget;
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+	VkExtent2D extent = {};
+	VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+	ShaderManager * shaderManager = nullptr;
+	DeletionQueue * deletionQueue = nullptr;
+
+	struct PipelineVariant {
+		PipelineState state;
+		UniquePipeline pipeline;
+		UniquePipeline rebuiltPipeline;			// finished rebuild waiting for update() to swap it in
+		std::atomic<bool> ready{ false };
+		bool failed = false;
+		bool queued = false;
+		double compileMilliseconds = 0.0;
+	};
+
+	std::mutex variantMutex;
+	std::condition_variable workAvailable;
+	std::condition_variable workDone;
+	std::unordered_map<uint64_t, std::unique_ptr<PipelineVariant>> variants;
+	std::deque<PipelineVariant *> pendingVariants;
+	size_t compilingCount = 0;
+	bool stopping = false;
+	std::vector<std::thread> workers;
+
+	// looked up on every use, so a rebuilt placeholder is picked up in the same swap that retires the old one
+	uint64_t placeholderHandle = 0;
+	bool hasPlaceholder = false;
+
+	PipelineVariant * findOrAddVariant(const PipelineState &state, uint64_t * handle, bool * added);
+	void compileVariant(PipelineVariant * variant);
+	VkPipeline compilePipeline(const PipelineState &state);
+	void workerLoop();
+};
@@ -0,0 +1,265 @@
+#include "Profiler.h"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+	struct ProfileEvent {
+		const char * name;
+		uint64_t start;
+		uint64_t end;
+		uint32_t track;
+	};
+
+	// one ring entry. sequence is 2n + 1 while the nth event of the thread is written in to it and 2n + 2 once it
+	// is complete, a reader that sees the same even value before and after copying has a consistent event
+	struct EventSlot {
+		std::atomic<uint64_t> sequence{ 0 };
+		std::atomic<const char *> name{ nullptr };
+		std::atomic<uint64_t> start{ 0 };
+		std::atomic<uint64_t> end{ 0 };
+		std::atomic<uint32_t> track{ 0 };
+	};
+
+	// enough for a few seconds of a busy thread, the oldest events are overwritten after that
+	const uint64_t EVENTS_PER_THREAD = 64 * 1024;
+
+	// written only by its thread, read by exports
+	struct ThreadBuffer {
+		uint32_t track = 0;
+		std::unique_ptr<EventSlot[]> slots;
+		std::atomic<uint64_t> written{ 0 };		// events ever recorded, the ring position is this modulo its size
+	};
+
+	std::atomic<bool> profilerEnabled{ false };
+
+	// buffers outlive their threads so their events can still be exported
+	std::mutex registryMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+	std::vector<std::string> trackNames;
+
+	thread_local ThreadBuffer * localBuffer = nullptr;
+
+	ThreadBuffer * getLocalBuffer() {
+
+		// first event of the thread, registering it is the only time recording takes a lock
+		if (localBuffer == nullptr) {
+
+			std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+			buffer->slots.reset(new EventSlot[EVENTS_PER_THREAD]);
+
+			std::lock_guard<std::mutex> lock(registryMutex);
+			buffer->track = static_cast<uint32_t>(trackNames.size());
+			trackNames.push_back("thread " + std::to_string(buffer->track));
+			localBuffer = buffer.get();
+			threadBuffers.push_back(std::move(buffer));
+		}
+		return localBuffer;
+	}
+
+	std::string escapeJson(const std::string &text) {
+
+		std::string escaped;
+		for (char c : text) {
+			if (c == '"' || c == '\\') {
+				escaped += '\\';
+			}
+			escaped += c;
+		}
+		return escaped;
+	}
+}
+
+void Profiler::setEnabled(bool enabled){
+	profilerEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Profiler::isEnabled(){
+	return profilerEnabled.load(std::memory_order_relaxed);
+}
+
+uint64_t Profiler::now(){
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Profiler::record(const char * name, uint64_t start, uint64_t end){
+	recordOnTrack(getLocalBuffer()->track, name, start, end);
+}
+
+void Profiler::recordOnTrack(uint32_t track, const char * name, uint64_t start, uint64_t end){
+
+	ThreadBuffer * buffer = getLocalBuffer();
+
+	// the sequence is made odd before the fields change and even again after, relaxed stores are plain stores on
+	// x86 and ARM so this costs no more than writing the event did
+	uint64_t index = buffer->written.load(std::memory_order_relaxed);
+	EventSlot &slot = buffer->slots[index % EVENTS_PER_THREAD];
+	slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.start.store(start, std::memory_order_relaxed);
+	slot.end.store(end, std::memory_order_relaxed);
+	slot.track.store(track, std::memory_order_relaxed);
+
+	slot.sequence.store(index * 2 + 2, std::memory_order_release);
+	buffer->written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::setThreadName(const std::string &name){
+
+	uint32_t track = getLocalBuffer()->track;
+
+	std::lock_guard<std::mutex> lock(registryMutex);
+	trackNames[track] = name;
+}
+
+uint32_t Profiler::createTrack(const std::string &name){
+
+	std::lock_guard<std::mutex> lock(registryMutex);
+	trackNames.push_back(name);
+	return static_cast<uint32_t>(trackNames.size() - 1);
+}
+
+void Profiler::exportTrace(const std::string &filename, double windowSeconds){
+
+	// -- COPY --
+	std::vector<ProfileEvent> events;
+	std::vector<std::string> names;
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+		names = trackNames;
+
+		for (auto &buffer : threadBuffers) {
+
+			uint64_t written = buffer->written.load(std::memory_order_acquire);
+			uint64_t first = written > EVENTS_PER_THREAD ? written - EVENTS_PER_THREAD : 0;
+
+			// the thread keeps recording while this copies, a slot it is writing or has moved on to a later event
+			// in is skipped
+			for (uint64_t i = first; i < written; i++) {
+
+				EventSlot &slot = buffer->slots[i % EVENTS_PER_THREAD];
+				uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+				if (sequence != i * 2 + 2) {
+					continue;
+				}
+
+				ProfileEvent event;
+				event.name = slot.name.load(std::memory_order_relaxed);
+				event.start = slot.start.load(std::memory_order_relaxed);
+				event.end = slot.end.load(std::memory_order_relaxed);
+				event.track = slot.track.load(std::memory_order_relaxed);
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+					events.push_back(event);
+				}
+			}
+		}
+	}
+
+	if (events.empty()) {
+		return;
+	}
+
+	// -- WINDOW --
+	uint64_t latest = 0;
+	uint64_t earliest = UINT64_MAX;
+	for (auto &event : events) {
+		latest = std::max(latest, event.end);
+	}
+	if (windowSeconds > 0.0) {
+		uint64_t window = static_cast<uint64_t>(windowSeconds * 1.0e9);
+		uint64_t windowStart = latest > window ? latest - window : 0;
+		events.erase(std::remove_if(events.begin(), events.end(), [windowStart](const ProfileEvent &event) {
+			return event.end < windowStart;
+		}), events.end());
+	}
+	for (auto &event : events) {
+		earliest = std::min(earliest, event.start);
+	}
+
+	// -- WRITE --
+	std::ofstream file(filename);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open a file for writing");
+	}
+
+	// complete ("X") events, times in microseconds from the earliest one
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	for (size_t i = 0; i < names.size(); i++) {
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"name\":\"" << escapeJson(names[i]) << "\"}},\n";
+	}
+
+	file.precision(3);
+	file << std::fixed;
+	for (size_t i = 0; i < events.size(); i++) {
+		const ProfileEvent &event = events[i];
+		file << "{\"name\":\"" << escapeJson(event.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.track <<
+			",\"ts\":" << (event.start - earliest) / 1000.0 << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}" <<
+			(i + 1 < events.size() ? ",\n" : "\n");
+	}
+	file << "]}\n";
+}
+
+void Profiler::benchmark(uint32_t scopeCount){
+
+	if (scopeCount == 0) {
+		return;
+	}
+
+	bool wasEnabled = isEnabled();
+
+	// workSteps of work, in a scope like the functions PROFILE_FUNCTION is put on or bare. best of a few runs
+	auto step = [](uint32_t value, uint32_t workSteps) {
+		for (uint32_t j = 0; j < workSteps; j++) {
+			value = value * 1664525u + 1013904223u;
+		}
+		return value;
+	};
+	volatile uint32_t sink = 0;
+	auto nanosecondsPerLoop = [&](bool scoped, bool enabled, uint32_t workSteps) {
+		setEnabled(enabled);
+		double best = 0.0;
+		for (int run = 0; run < 3; run++) {
+			uint64_t start = now();
+			for (uint32_t i = 0; i < scopeCount; i++) {
+				if (scoped) {
+					ProfileScope scope("profilerBenchmark");
+					sink = step(i, workSteps);
+				}
+				else
+				{
+					sink = step(i, workSteps);
+				}
+			}
+			double nanoseconds = static_cast<double>(now() - start) / scopeCount;
+			best = run == 0 ? nanoseconds : std::min(best, nanoseconds);
+		}
+		return best;
+	};
+
+	const uint32_t workSteps = 1000;
+	double emptyDisabled = nanosecondsPerLoop(true, false, 0);
+	double emptyEnabled = nanosecondsPerLoop(true, true, 0);
+	double work = nanosecondsPerLoop(false, false, workSteps);
+	double workDisabled = nanosecondsPerLoop(true, false, workSteps);
+	double workEnabled = nanosecondsPerLoop(true, true, workSteps);
+	setEnabled(wasEnabled);
+
+	auto overhead = [work](double nanoseconds) {
+		return work > 0.0 ? 100.0 * (nanoseconds - work) / work : 0.0;
+	};
+	// a scope costs the same whatever it is around, so it stays under 1% around a hundred times its cost
+	printf("profiler, %u scopes: %.1f ns an empty scope disabled, %.1f ns enabled. around %.0f ns of work %.2f%% overhead disabled, "
+		"%.2f%% enabled, under 1%% enabled around %.0f ns or more\n", scopeCount, emptyDisabled, emptyEnabled, work, overhead(workDisabled),
+		overhead(workEnabled), std::max(workEnabled - work, 0.0) * 100.0);
+}
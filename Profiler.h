@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <cstdint>
+
+// the profiling macros compile to nothing when built with -DPROFILER_ENABLED=0
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+// Scoped profiler exporting Chrome trace JSON (chrome://tracing or ui.perfetto.dev), has no Vulkan dependency.
+// Every thread records in to its own fixed ring of events without locking: only that thread writes it, and an export
+// reads each slot under a sequence number (a seqlock), skipping slots the thread was writing or has written over
+// since. Every field is an atomic, so copying while the thread records is not a data race. The rings always hold each
+// thread's most recent events, so an export is a rolling window of the last few seconds (or of a given length).
+// Timelines that aren't threads (e.g. the GPU) get their own tracks.
+// Times are nanoseconds of the steady clock, which timestamps from elsewhere must be converted to
+class Profiler
+{
+public:
+	// off to begin with, scopes are only recorded while enabled and cost one relaxed load otherwise
+	static void setEnabled(bool enabled);
+	static bool isEnabled();
+
+	static uint64_t now();
+
+	// name must outlive the profiler, e.g. a string literal
+	static void record(const char * name, uint64_t start, uint64_t end);
+	static void recordOnTrack(uint32_t track, const char * name, uint64_t start, uint64_t end);
+
+	// name shown for the calling thread's track, and a new track for events that don't happen on a thread
+	static void setThreadName(const std::string &name);
+	static uint32_t createTrack(const std::string &name);
+
+	// every buffered event, or only the last windowSeconds of them
+	static void exportTrace(const std::string &filename, double windowSeconds = 0.0);
+
+	// time scopeCount empty scopes and scopes around about a microsecond of work, disabled and enabled, and print
+	// the cost a scope and the overhead on the work. leaves the enabled state as it was
+	static void benchmark(uint32_t scopeCount);
+};
+
+// records the time from its construction to its destruction
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char * newName) : name(newName), start(Profiler::isEnabled() ? Profiler::now() : 0) {}
+
+	ProfileScope(const ProfileScope &) = delete;
+	ProfileScope &operator=(const ProfileScope &) = delete;
+
+	~ProfileScope() {
+		if (start != 0) {
+			Profiler::record(name, start, Profiler::now());
+		}
+	}
+
+private:
+	const char * name;
+	uint64_t start;
+};
+
+#if PROFILER_ENABLED
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#endif
@@ -0,0 +1,727 @@
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "Utilities.h"
+
+// accesses that write, anything else only needs an execution dependency to be overwritten
+static const VkAccessFlags WRITE_ACCESS = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+	VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+// -- DUMP HELPERS --
+static std::string flagNames(uint32_t flags, const std::vector<std::pair<uint32_t, const char *>> &names){
+
+	std::string result;
+	for (auto &name : names) {
+		if (flags & name.first) {
+			result += result.empty() ? "" : "|";
+			result += name.second;
+			flags &= ~name.first;
+		}
+	}
+
+	// anything without a name is shown as a number
+	if (flags != 0 || result.empty()) {
+		std::stringstream remaining;
+		remaining << (result.empty() ? "" : "|") << "0x" << std::hex << flags;
+		result += remaining.str();
+	}
+	return result;
+}
+
+static std::string stageNames(VkPipelineStageFlags stages){
+	return flagNames(stages, {
+		{ VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, "TOP" },
+		{ VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, "DRAW_INDIRECT" },
+		{ VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, "VERTEX_INPUT" },
+		{ VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, "VERTEX" },
+		{ VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT, "TASK" },
+		{ VK_PIPELINE_STAGE_MESH_SHADER_BIT_EXT, "MESH" },
+		{ VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, "FRAGMENT" },
+		{ VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT, "EARLY_TESTS" },
+		{ VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, "LATE_TESTS" },
+		{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, "COLOR_OUTPUT" },
+		{ VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, "COMPUTE" },
+		{ VK_PIPELINE_STAGE_TRANSFER_BIT, "TRANSFER" },
+		{ VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, "BOTTOM" },
+		{ VK_PIPELINE_STAGE_HOST_BIT, "HOST" },
+		{ VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, "ALL" } });
+}
+
+static std::string accessNames(VkAccessFlags access){
+	return flagNames(access, {
+		{ VK_ACCESS_INDIRECT_COMMAND_READ_BIT, "INDIRECT_READ" },
+		{ VK_ACCESS_SHADER_READ_BIT, "SHADER_READ" },
+		{ VK_ACCESS_SHADER_WRITE_BIT, "SHADER_WRITE" },
+		{ VK_ACCESS_COLOR_ATTACHMENT_READ_BIT, "COLOR_READ" },
+		{ VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, "COLOR_WRITE" },
+		{ VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, "DEPTH_READ" },
+		{ VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, "DEPTH_WRITE" },
+		{ VK_ACCESS_TRANSFER_READ_BIT, "TRANSFER_READ" },
+		{ VK_ACCESS_TRANSFER_WRITE_BIT, "TRANSFER_WRITE" },
+		{ VK_ACCESS_HOST_READ_BIT, "HOST_READ" },
+		{ VK_ACCESS_MEMORY_READ_BIT, "MEMORY_READ" } });
+}
+
+static std::string layoutName(VkImageLayout layout){
+
+	switch (layout) {
+	case VK_IMAGE_LAYOUT_UNDEFINED: return "UNDEFINED";
+	case VK_IMAGE_LAYOUT_GENERAL: return "GENERAL";
+	case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL: return "COLOR_ATTACHMENT";
+	case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL: return "DEPTH_ATTACHMENT";
+	case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL: return "SHADER_READ_ONLY";
+	case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL: return "TRANSFER_SRC";
+	case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: return "TRANSFER_DST";
+	case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR: return "PRESENT_SRC";
+	default: return std::to_string(static_cast<int>(layout));
+	}
+}
+
+RenderGraph::RenderGraph(){
+
+}
+
+void RenderGraph::create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, DeviceAllocator * newAllocator){
+	physicalDevice = newPhysicalDevice;
+	device = newDevice;
+	allocator = newAllocator;
+}
+
+void RenderGraph::destroy(){
+
+	// views and images go before the memory they are bound to
+	for (auto &resource : resources) {
+		resource.transientView.reset();
+		resource.transientImage.reset();
+	}
+	resources.clear();
+	memorySlots.clear();
+	passes.clear();
+	finalBarriers.clear();
+	compiled = false;
+}
+
+uint32_t RenderGraph::importImage(const std::string &name, VkImageAspectFlags aspect, ResourceState initialState, ResourceState finalState){
+
+	if (compiled) {
+		throw std::runtime_error("render graph is already compiled");
+	}
+
+	Resource resource;
+	resource.name = name;
+	resource.isImage = true;
+	resource.imported = true;
+	resource.aspect = aspect;
+	resource.initialState = initialState;
+	resource.finalState = finalState;
+	resources.push_back(std::move(resource));
+
+	return static_cast<uint32_t>(resources.size() - 1);
+}
+
+uint32_t RenderGraph::importBuffer(const std::string &name, ResourceState initialState){
+
+	if (compiled) {
+		throw std::runtime_error("render graph is already compiled");
+	}
+
+	Resource resource;
+	resource.name = name;
+	resource.isImage = false;
+	resource.imported = true;
+	resource.initialState = initialState;
+	resources.push_back(std::move(resource));
+
+	return static_cast<uint32_t>(resources.size() - 1);
+}
+
+void RenderGraph::setImportedImage(uint32_t resource, VkImage image){
+
+	if (resource >= resources.size() || !resources[resource].imported || !resources[resource].isImage) {
+		throw std::runtime_error("not an imported render graph image");
+	}
+	resources[resource].image = image;
+}
+
+void RenderGraph::setImportedBuffer(uint32_t resource, VkBuffer buffer){
+
+	if (resource >= resources.size() || !resources[resource].imported || resources[resource].isImage) {
+		throw std::runtime_error("not an imported render graph buffer");
+	}
+	resources[resource].buffer = buffer;
+}
+
+uint32_t RenderGraph::createTransientImage(const std::string &name, VkFormat format, VkExtent2D extent, VkImageUsageFlags usage, VkImageAspectFlags aspect){
+
+	if (compiled) {
+		throw std::runtime_error("render graph is already compiled");
+	}
+
+	Resource resource;
+	resource.name = name;
+	resource.isImage = true;
+	resource.imported = false;
+	resource.aspect = aspect;
+	resource.format = format;
+	resource.extent = extent;
+	resource.usage = usage;
+	resources.push_back(std::move(resource));
+
+	return static_cast<uint32_t>(resources.size() - 1);
+}
+
+VkImageView RenderGraph::getImageView(uint32_t resource){
+
+	if (resource >= resources.size() || !resources[resource].transientView) {
+		throw std::runtime_error("render graph image has no view, it isn't transient or the graph isn't compiled");
+	}
+	return resources[resource].transientView.get();
+}
+
+uint32_t RenderGraph::addPass(const std::string &name, std::function<void(VkCommandBuffer)> record){
+
+	if (compiled) {
+		throw std::runtime_error("render graph is already compiled");
+	}
+
+	Pass pass;
+	pass.name = name;
+	pass.record = record;
+	passes.push_back(std::move(pass));
+
+	return static_cast<uint32_t>(passes.size() - 1);
+}
+
+void RenderGraph::readImage(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout){
+	addAccess(pass, resource, { stages, access, layout }, false, true);
+}
+
+void RenderGraph::writeImage(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout){
+	addAccess(pass, resource, { stages, access, layout }, true, true);
+}
+
+void RenderGraph::readBuffer(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access){
+	addAccess(pass, resource, { stages, access, VK_IMAGE_LAYOUT_UNDEFINED }, false, false);
+}
+
+void RenderGraph::writeBuffer(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access){
+	addAccess(pass, resource, { stages, access, VK_IMAGE_LAYOUT_UNDEFINED }, true, false);
+}
+
+void RenderGraph::setSideEffects(uint32_t pass){
+
+	if (pass >= passes.size()) {
+		throw std::runtime_error("render graph pass doesn't exist");
+	}
+	passes[pass].sideEffects = true;
+}
+
+void RenderGraph::compile(){
+
+	if (compiled) {
+		throw std::runtime_error("render graph is already compiled");
+	}
+
+	cullPasses();
+	findLifetimes();
+	createTransients();
+
+	// transients start from the state their memory was left in by the previous execution, which may still be
+	// running. so barriers are worked out once to find that state, then again for real
+	std::vector<Tracking> tracking;
+	computeBarriers(tracking);
+	computeBarriers(tracking);
+
+	compiled = true;
+}
+
+void RenderGraph::execute(VkCommandBuffer commandBuffer, int frame, GpuProfiler * profiler, GpuStatistics * statistics){
+
+	if (!compiled) {
+		throw std::runtime_error("render graph isn't compiled");
+	}
+
+	for (auto &pass : passes) {
+		if (pass.culled) {
+			continue;
+		}
+
+		// the pass's barriers count towards its time, they are waits it causes
+		uint32_t scope = profiler != nullptr ? profiler->beginScope(commandBuffer, frame, pass.name.c_str()) : UINT32_MAX;
+		uint32_t statisticsPass = statistics != nullptr ? statistics->beginPass(commandBuffer, frame, pass.name) : UINT32_MAX;
+
+		recordBarriers(commandBuffer, pass.barriers);
+		pass.record(commandBuffer);
+
+		if (statistics != nullptr) {
+			statistics->endPass(commandBuffer, frame, statisticsPass);
+		}
+		if (profiler != nullptr) {
+			profiler->endScope(commandBuffer, frame, scope);
+		}
+	}
+
+	recordBarriers(commandBuffer, finalBarriers);
+}
+
+void RenderGraph::dump(const std::string &filename){
+
+	if (!compiled) {
+		throw std::runtime_error("render graph isn't compiled");
+	}
+
+	std::ofstream file(filename);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open a file for writing");
+	}
+
+	auto barrierLines = [this](const std::vector<Barrier> &barriers) {
+		std::string lines;
+		for (auto &barrier : barriers) {
+			const Resource &resource = resources[barrier.resource];
+			lines += "  " + resource.name + ": " + stageNames(barrier.src.stages) + " " + accessNames(barrier.src.access) +
+				" -> " + stageNames(barrier.dst.stages) + " " + accessNames(barrier.dst.access);
+			if (resource.isImage && barrier.src.layout != barrier.dst.layout) {
+				lines += ", " + layoutName(barrier.src.layout) + " -> " + layoutName(barrier.dst.layout);
+			}
+			lines += "\\l";
+		}
+		return lines;
+	};
+
+	file << "digraph RenderGraph {\n";
+	file << "\trankdir=LR;\n";
+	file << "\tnode [fontname=\"monospace\", fontsize=10];\n";
+	file << "\tedge [fontname=\"monospace\", fontsize=9];\n\n";
+
+	// -- PASSES --
+	// in execution order, each with the barriers recorded before it
+	uint32_t order = 0;
+	for (size_t i = 0; i < passes.size(); i++) {
+
+		const Pass &pass = passes[i];
+		file << "\tpass" << i << " [shape=box, ";
+		if (pass.culled) {
+			file << "style=dashed, color=gray, label=\"" << pass.name << " (removed)\"];\n";
+			continue;
+		}
+
+		file << "label=\"" << order++ << ": " << pass.name << (pass.sideEffects ? " (side effects)" : "") << "\\l";
+		if (!pass.barriers.empty()) {
+			file << "barriers:\\l" << barrierLines(pass.barriers);
+		}
+		file << "\"];\n";
+	}
+
+	if (!finalBarriers.empty()) {
+		file << "\tfinal [shape=box, label=\"after the last pass:\\l" << barrierLines(finalBarriers) << "\"];\n";
+	}
+	file << "\n";
+
+	// -- RESOURCES --
+	for (size_t i = 0; i < resources.size(); i++) {
+
+		const Resource &resource = resources[i];
+		file << "\tresource" << i << " [shape=ellipse, label=\"" << resource.name << "\\n";
+		if (resource.imported) {
+			file << (resource.isImage ? "imported image" : "imported buffer");
+		}
+		else if (resource.memorySlot >= 0)
+		{
+			const MemorySlot &slot = memorySlots[resource.memorySlot];
+			file << resource.extent.width << "x" << resource.extent.height << ", memory slot " << resource.memorySlot <<
+				" (" << slot.requirements.size / 1024 << " KB, shared by " << slot.resources.size() << ")";
+		}
+		else
+		{
+			file << "unused";
+		}
+		file << "\"];\n";
+	}
+	file << "\n";
+
+	// -- ACCESSES --
+	for (size_t i = 0; i < passes.size(); i++) {
+		for (auto &access : passes[i].accesses) {
+
+			std::string label = stageNames(access.state.stages);
+			if (resources[access.resource].isImage) {
+				label += "\\n" + layoutName(access.state.layout);
+			}
+
+			if (access.write) {
+				file << "\tpass" << i << " -> resource" << access.resource;
+			}
+			else
+			{
+				file << "\tresource" << access.resource << " -> pass" << i;
+			}
+			file << " [label=\"" << label << "\"" << (passes[i].culled ? ", style=dashed, color=gray" : "") << "];\n";
+		}
+	}
+
+	file << "}\n";
+}
+
+RenderGraph::~RenderGraph(){
+
+}
+
+void RenderGraph::addAccess(uint32_t pass, uint32_t resource, ResourceState state, bool write, bool image){
+
+	if (compiled) {
+		throw std::runtime_error("render graph is already compiled");
+	}
+	if (pass >= passes.size() || resource >= resources.size()) {
+		throw std::runtime_error("render graph pass or resource doesn't exist");
+	}
+	if (resources[resource].isImage != image) {
+		throw std::runtime_error("render graph resource used as the wrong type");
+	}
+
+	// several uses of one resource in a pass become one access, they can't need different layouts
+	for (auto &access : passes[pass].accesses) {
+		if (access.resource == resource) {
+			if (access.state.layout != state.layout) {
+				throw std::runtime_error("render graph pass uses an image in two layouts");
+			}
+			access.state.stages |= state.stages;
+			access.state.access |= state.access;
+			access.write = access.write || write;
+			return;
+		}
+	}
+
+	passes[pass].accesses.push_back({ resource, state, write });
+}
+
+void RenderGraph::cullPasses(){
+
+	// walk backwards: a pass stays if it has side effects, writes an imported resource,
+	// or writes something a later pass that stays reads
+	std::vector<bool> needed(resources.size(), false);
+
+	for (size_t i = passes.size(); i-- > 0;) {
+
+		Pass &pass = passes[i];
+
+		bool keep = pass.sideEffects;
+		for (auto &access : pass.accesses) {
+			if (access.write && (resources[access.resource].imported || needed[access.resource])) {
+				keep = true;
+			}
+		}
+
+		pass.culled = !keep;
+		if (keep) {
+			for (auto &access : pass.accesses) {
+				if (!access.write || access.state.access & ~WRITE_ACCESS) {
+					needed[access.resource] = true;
+				}
+			}
+		}
+	}
+}
+
+void RenderGraph::findLifetimes(){
+
+	for (size_t i = 0; i < passes.size(); i++) {
+
+		if (passes[i].culled) {
+			continue;
+		}
+
+		for (auto &access : passes[i].accesses) {
+			Resource &resource = resources[access.resource];
+			if (resource.firstPass < 0) {
+				resource.firstPass = static_cast<int32_t>(i);
+			}
+			resource.lastPass = static_cast<int32_t>(i);
+		}
+	}
+}
+
+void RenderGraph::createTransients(){
+
+	// -- IMAGES --
+	std::vector<uint32_t> transients;
+	std::vector<VkMemoryRequirements> requirements(resources.size());
+
+	for (uint32_t i = 0; i < resources.size(); i++) {
+
+		Resource &resource = resources[i];
+		if (resource.imported || resource.firstPass < 0) {
+			continue;
+		}
+
+		VkImageCreateInfo imageCreateInfo = {};
+		imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageCreateInfo.extent = { resource.extent.width, resource.extent.height, 1 };
+		imageCreateInfo.mipLevels = 1;
+		imageCreateInfo.arrayLayers = 1;
+		imageCreateInfo.format = resource.format;
+		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageCreateInfo.usage = resource.usage;
+		imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VkImage image;
+		if (vkCreateImage(device, &imageCreateInfo, nullptr, &image) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create a render graph image");
+		}
+		resource.transientImage = UniqueImage(device, image);
+		resource.image = image;
+
+		vkGetImageMemoryRequirements(device, image, &requirements[i]);
+		transients.push_back(i);
+	}
+
+	// -- ALIASING --
+	// in order of first use, each image goes in the smallest slot whose last user is finished with it
+	std::sort(transients.begin(), transients.end(), [this](uint32_t a, uint32_t b) {
+		return resources[a].firstPass < resources[b].firstPass;
+	});
+
+	for (uint32_t index : transients) {
+
+		Resource &resource = resources[index];
+		const VkMemoryRequirements &needs = requirements[index];
+
+		int32_t bestSlot = -1;
+		for (size_t s = 0; s < memorySlots.size(); s++) {
+
+			MemorySlot &slot = memorySlots[s];
+			if (resources[slot.resources.back()].lastPass >= resource.firstPass || (slot.requirements.memoryTypeBits & needs.memoryTypeBits) == 0) {
+				continue;
+			}
+
+			if (bestSlot < 0 || slot.requirements.size < memorySlots[bestSlot].requirements.size) {
+				bestSlot = static_cast<int32_t>(s);
+			}
+		}
+
+		if (bestSlot < 0) {
+			MemorySlot slot;
+			slot.requirements = needs;
+			memorySlots.push_back(std::move(slot));
+			bestSlot = static_cast<int32_t>(memorySlots.size() - 1);
+		}
+
+		MemorySlot &slot = memorySlots[bestSlot];
+		slot.requirements.size = std::max(slot.requirements.size, needs.size);
+		slot.requirements.alignment = std::max(slot.requirements.alignment, needs.alignment);
+		slot.requirements.memoryTypeBits &= needs.memoryTypeBits;
+		slot.resources.push_back(index);
+		resource.memorySlot = bestSlot;
+	}
+
+	// -- MEMORY --
+	for (auto &slot : memorySlots) {
+
+		VkDeviceMemory memory = allocator->allocate(slot.requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		slot.memory = UniqueDeviceMemory(allocator, memory);
+
+		// the first user of a slot follows its last user of the previous execution
+		for (size_t i = 0; i < slot.resources.size(); i++) {
+
+			Resource &resource = resources[slot.resources[i]];
+			resource.previousInSlot = static_cast<int32_t>(i > 0 ? slot.resources[i - 1] : slot.resources.back());
+
+			vkBindImageMemory(device, resource.image, memory, 0);
+			resource.transientView = UniqueImageView(device, createImageView(device, resource.image, resource.format, resource.aspect));
+		}
+	}
+}
+
+void RenderGraph::computeBarriers(std::vector<Tracking> &tracking){
+
+	// end state of the previous execution, empty the first time round
+	std::vector<Tracking> previous = tracking;
+
+	// imported resources start as the caller says, transients when they are first used
+	tracking.assign(resources.size(), Tracking());
+	for (size_t i = 0; i < resources.size(); i++) {
+		if (resources[i].imported) {
+			tracking[i].layout = resources[i].initialState.layout;
+			tracking[i].writeStages = resources[i].initialState.stages;
+			tracking[i].writeAccess = resources[i].initialState.access & WRITE_ACCESS;
+		}
+	}
+
+	for (auto &pass : passes) {
+
+		pass.barriers.clear();
+		if (pass.culled) {
+			continue;
+		}
+
+		for (auto &access : pass.accesses) {
+
+			const Resource &resource = resources[access.resource];
+			Tracking &state = tracking[access.resource];
+
+			// aliased memory has to wait for whatever used it last, its contents are discarded
+			if (!resource.imported && static_cast<int32_t>(&pass - passes.data()) == resource.firstPass) {
+
+				bool firstInSlot = memorySlots[resource.memorySlot].resources.front() == access.resource;
+				const Tracking * last = nullptr;
+				if (!firstInSlot) {
+					last = &tracking[resource.previousInSlot];
+				}
+				else if (!previous.empty())
+				{
+					last = &previous[resource.previousInSlot];
+				}
+
+				state = Tracking();
+				if (last != nullptr) {
+					state.writeStages = last->writeStages | last->readStages;
+					state.writeAccess = last->writeAccess;
+				}
+			}
+
+			Barrier barrier;
+			barrier.resource = access.resource;
+			barrier.src.layout = state.layout;
+			barrier.dst = access.state;
+
+			bool layoutChange = resource.isImage && access.state.layout != state.layout;
+			if (access.write || layoutChange) {
+
+				// writes wait for the last write and every read since, layout changes are writes too
+				barrier.src.stages = state.writeStages | state.readStages;
+				barrier.src.access = state.writeAccess;
+				if (layoutChange || barrier.src.stages != 0) {
+					pass.barriers.push_back(barrier);
+				}
+
+				state.layout = access.state.layout;
+				state.writeStages = access.state.stages;
+				if (access.write) {
+					state.writeAccess = access.state.access & WRITE_ACCESS;
+					state.readStages = 0;
+					state.visibleStages = 0;
+					state.visibleAccess = 0;
+				}
+				else
+				{
+					// a transition is visible to the reads it was made for
+					state.writeAccess = 0;
+					state.readStages = access.state.stages;
+					state.visibleStages = access.state.stages;
+					state.visibleAccess = access.state.access;
+				}
+			}
+			else
+			{
+				// read in the same layout, only needs a barrier if the last write isn't visible to it yet
+				bool visible = (access.state.stages & ~state.visibleStages) == 0 && (access.state.access & ~state.visibleAccess) == 0;
+				if (state.writeStages != 0 && !visible) {
+					barrier.src.stages = state.writeStages;
+					barrier.src.access = state.writeAccess;
+					pass.barriers.push_back(barrier);
+
+					state.visibleStages |= access.state.stages;
+					state.visibleAccess |= access.state.access;
+				}
+				state.readStages |= access.state.stages;
+			}
+		}
+	}
+
+	// -- FINAL LAYOUTS --
+	finalBarriers.clear();
+	for (uint32_t i = 0; i < resources.size(); i++) {
+
+		const Resource &resource = resources[i];
+		if (!resource.imported || !resource.isImage || resource.finalState.layout == VK_IMAGE_LAYOUT_UNDEFINED ||
+			resource.finalState.layout == tracking[i].layout) {
+			continue;
+		}
+
+		Barrier barrier;
+		barrier.resource = i;
+		barrier.src.stages = tracking[i].writeStages | tracking[i].readStages;
+		barrier.src.access = tracking[i].writeAccess;
+		barrier.src.layout = tracking[i].layout;
+		barrier.dst = resource.finalState;
+		finalBarriers.push_back(barrier);
+	}
+}
+
+void RenderGraph::recordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier> &barriers){
+
+	if (barriers.empty()) {
+		return;
+	}
+
+	// the whole batch goes in one call
+	VkPipelineStageFlags srcStages = 0;
+	VkPipelineStageFlags dstStages = 0;
+	std::vector<VkImageMemoryBarrier> imageBarriers;
+	std::vector<VkBufferMemoryBarrier> bufferBarriers;
+
+	for (auto &barrier : barriers) {
+
+		const Resource &resource = resources[barrier.resource];
+		srcStages |= barrier.src.stages;
+		dstStages |= barrier.dst.stages;
+
+		if (resource.isImage) {
+
+			if (resource.image == VK_NULL_HANDLE) {
+				throw std::runtime_error("render graph image " + resource.name + " has no image set");
+			}
+
+			VkImageMemoryBarrier imageBarrier = {};
+			imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			imageBarrier.srcAccessMask = barrier.src.access;
+			imageBarrier.dstAccessMask = barrier.dst.access;
+			imageBarrier.oldLayout = barrier.src.layout;
+			imageBarrier.newLayout = barrier.dst.layout;
+			imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.image = resource.image;
+			imageBarrier.subresourceRange.aspectMask = resource.aspect;
+			imageBarrier.subresourceRange.baseMipLevel = 0;
+			imageBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+			imageBarrier.subresourceRange.baseArrayLayer = 0;
+			imageBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+			imageBarriers.push_back(imageBarrier);
+		}
+		else
+		{
+			if (resource.buffer == VK_NULL_HANDLE) {
+				throw std::runtime_error("render graph buffer " + resource.name + " has no buffer set");
+			}
+
+			VkBufferMemoryBarrier bufferBarrier = {};
+			bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			bufferBarrier.srcAccessMask = barrier.src.access;
+			bufferBarrier.dstAccessMask = barrier.dst.access;
+			bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			bufferBarrier.buffer = resource.buffer;
+			bufferBarrier.offset = 0;
+			bufferBarrier.size = VK_WHOLE_SIZE;
+			bufferBarriers.push_back(bufferBarrier);
+		}
+	}
+
+	// nothing earlier to wait for (e.g. a transient's first ever use) still needs a valid stage
+	if (srcStages == 0) {
+		srcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	}
+	if (dstStages == 0) {
+		dstStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	}
+
+	deviceDispatch.vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0, 0, nullptr,
+		static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+		static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+}
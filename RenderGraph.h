@@ -0,0 +1,156 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "DeviceAllocator.h"
+#include "VulkanHandles.h"
+#include "GpuProfiler.h"
+#include "GpuStatistics.h"
+#include "DeviceDispatch.h"
+
+// how a pass uses a resource, or the state an imported resource is in before / after the graph
+struct ResourceState {
+	VkPipelineStageFlags stages = 0;
+	VkAccessFlags access = 0;
+	VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;		// images only
+};
+
+// Records a frame as passes that declare which images and buffers they read and write.
+// compile works out everything the passes would otherwise have to write by hand:
+// - passes whose results nothing reads are removed (writing an imported resource, or being marked as having
+//   side effects, keeps a pass)
+// - each remaining pass gets one batch of image / buffer barriers covering exactly the hazards and layout changes
+//   its accesses need, read after read in the same layout needs none
+// - transient images whose lifetimes don't overlap are placed in the same memory
+// Passes run in the order they were added, which is always valid as a pass can only depend on the ones before it.
+// Resources a pass keeps to itself (e.g. a culler's internal buffers) are still synchronized by the pass
+class RenderGraph
+{
+public:
+	RenderGraph();
+
+	void create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, DeviceAllocator * newAllocator);
+	void destroy();
+
+	// -- RESOURCES --
+	// images and buffers owned elsewhere, their handles can change between executions (e.g. the swapchain image).
+	// initial is what earlier work left them in, images are moved to finalState's layout after the last pass
+	uint32_t importImage(const std::string &name, VkImageAspectFlags aspect, ResourceState initialState, ResourceState finalState);
+	uint32_t importBuffer(const std::string &name, ResourceState initialState = ResourceState());
+	void setImportedImage(uint32_t resource, VkImage image);
+	void setImportedBuffer(uint32_t resource, VkBuffer buffer);
+
+	// image created by compile, contents don't survive from one execution to the next
+	uint32_t createTransientImage(const std::string &name, VkFormat format, VkExtent2D extent, VkImageUsageFlags usage, VkImageAspectFlags aspect);
+	VkImageView getImageView(uint32_t resource);
+
+	// -- PASSES --
+	uint32_t addPass(const std::string &name, std::function<void(VkCommandBuffer)> record);
+	void readImage(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout);
+	void writeImage(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout);
+	void readBuffer(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access);
+	void writeBuffer(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access);
+	// the pass writes something the graph can't see, it is never removed
+	void setSideEffects(uint32_t pass);
+
+	// cull passes, work out barriers and create transient images. passes and resources can't be added afterwards
+	void compile();
+
+	// record every pass with its barriers, imported handles must be set. each pass is timed on the GPU with a profiler,
+	// and counted with statistics
+	void execute(VkCommandBuffer commandBuffer, int frame = 0, GpuProfiler * profiler = nullptr, GpuStatistics * statistics = nullptr);
+
+	// compiled graph as Graphviz dot: passes in order with their barriers, removed passes, and transient memory
+	void dump(const std::string &filename);
+
+	~RenderGraph();
+
+private:
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	DeviceAllocator * allocator = nullptr;
+
+	bool compiled = false;
+
+	// - Resources
+	struct Resource {
+		std::string name;
+		bool isImage;
+		bool imported;
+		VkImageAspectFlags aspect = 0;
+		ResourceState initialState;
+		ResourceState finalState;
+
+		// imported handles, or the transient image
+		VkImage image = VK_NULL_HANDLE;
+		VkBuffer buffer = VK_NULL_HANDLE;
+
+		// - Transient
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		VkExtent2D extent = {};
+		VkImageUsageFlags usage = 0;
+		UniqueImage transientImage;
+		UniqueImageView transientView;
+		int32_t memorySlot = -1;
+		int32_t previousInSlot = -1;			// transient that used the memory before this one, or the slot's last one
+		int32_t firstPass = -1;					// lifetime in execution order
+		int32_t lastPass = -1;
+	};
+	std::vector<Resource> resources;
+
+	// memory shared by transients whose lifetimes don't overlap
+	struct MemorySlot {
+		VkMemoryRequirements requirements;
+		std::vector<uint32_t> resources;		// in lifetime order
+		UniqueDeviceMemory memory;
+	};
+	std::vector<MemorySlot> memorySlots;
+
+	// - Passes
+	struct Access {
+		uint32_t resource;
+		ResourceState state;
+		bool write;
+	};
+
+	// compiled barrier, handles are looked up at execution since imported ones change
+	struct Barrier {
+		uint32_t resource;
+		ResourceState src;
+		ResourceState dst;
+	};
+
+	struct Pass {
+		std::string name;
+		std::function<void(VkCommandBuffer)> record;
+		std::vector<Access> accesses;
+		bool sideEffects = false;
+		bool culled = false;
+		std::vector<Barrier> barriers;			// recorded before the pass in one batch
+	};
+	std::vector<Pass> passes;
+	std::vector<Barrier> finalBarriers;			// imported images to their final layouts
+
+	// - Tracking, what a resource was last used for while barriers are worked out
+	struct Tracking {
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags writeStages = 0;		// last write or layout transition
+		VkAccessFlags writeAccess = 0;
+		VkPipelineStageFlags readStages = 0;		// reads since then
+		VkPipelineStageFlags visibleStages = 0;		// stages / access the last write was already made visible to
+		VkAccessFlags visibleAccess = 0;
+	};
+
+	void addAccess(uint32_t pass, uint32_t resource, ResourceState state, bool write, bool image);
+	void cullPasses();
+	void findLifetimes();
+	void createTransients();
+	void computeBarriers(std::vector<Tracking> &tracking);
+	void recordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier> &barriers);
+};
@@ -0,0 +1,287 @@
+#include "SceneGraph.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCENE_GRAPH_USE_SSE 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// -- MATRIX HELPERS --
+// local matrix (translation * rotation * scale) of one node, column major
+static inline void composeLocalMatrix(const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale, float * local){
+
+	float xx = rotation.x * rotation.x, yy = rotation.y * rotation.y, zz = rotation.z * rotation.z;
+	float xy = rotation.x * rotation.y, xz = rotation.x * rotation.z, yz = rotation.y * rotation.z;
+	float wx = rotation.w * rotation.x, wy = rotation.w * rotation.y, wz = rotation.w * rotation.z;
+
+	local[0] = (1.0f - 2.0f * (yy + zz)) * scale.x;
+	local[1] = 2.0f * (xy + wz) * scale.x;
+	local[2] = 2.0f * (xz - wy) * scale.x;
+	local[3] = 0.0f;
+
+	local[4] = 2.0f * (xy - wz) * scale.y;
+	local[5] = (1.0f - 2.0f * (xx + zz)) * scale.y;
+	local[6] = 2.0f * (yz + wx) * scale.y;
+	local[7] = 0.0f;
+
+	local[8] = 2.0f * (xz + wy) * scale.z;
+	local[9] = 2.0f * (yz - wx) * scale.z;
+	local[10] = (1.0f - 2.0f * (xx + yy)) * scale.z;
+	local[11] = 0.0f;
+
+	local[12] = position.x;
+	local[13] = position.y;
+	local[14] = position.z;
+	local[15] = 1.0f;
+}
+
+// world = parent * local for column major matrices, each result column is stored to the node's world matrix
+// and the instance buffer from the same register, so the (write combined) GPU copy is never read back
+static inline void multiplyMatrices(const float * parent, const float * local, float * world, float * gpuWorld){
+
+#if defined(__AVX__)
+	// two result columns per iteration, each parent column repeated in both halves
+	__m256 parent0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(parent));
+	__m256 parent1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(parent + 4));
+	__m256 parent2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(parent + 8));
+	__m256 parent3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(parent + 12));
+
+	for (int column = 0; column < 16; column += 8) {
+		__m256 localColumns = _mm256_loadu_ps(local + column);
+
+		__m256 result = _mm256_mul_ps(parent0, _mm256_shuffle_ps(localColumns, localColumns, 0x00));
+		result = _mm256_add_ps(result, _mm256_mul_ps(parent1, _mm256_shuffle_ps(localColumns, localColumns, 0x55)));
+		result = _mm256_add_ps(result, _mm256_mul_ps(parent2, _mm256_shuffle_ps(localColumns, localColumns, 0xAA)));
+		result = _mm256_add_ps(result, _mm256_mul_ps(parent3, _mm256_shuffle_ps(localColumns, localColumns, 0xFF)));
+
+		_mm256_storeu_ps(world + column, result);
+		_mm256_storeu_ps(gpuWorld + column, result);
+	}
+#elif defined(SCENE_GRAPH_USE_SSE)
+	__m128 parent0 = _mm_loadu_ps(parent);
+	__m128 parent1 = _mm_loadu_ps(parent + 4);
+	__m128 parent2 = _mm_loadu_ps(parent + 8);
+	__m128 parent3 = _mm_loadu_ps(parent + 12);
+
+	for (int column = 0; column < 16; column += 4) {
+		__m128 result = _mm_mul_ps(parent0, _mm_set1_ps(local[column]));
+		result = _mm_add_ps(result, _mm_mul_ps(parent1, _mm_set1_ps(local[column + 1])));
+		result = _mm_add_ps(result, _mm_mul_ps(parent2, _mm_set1_ps(local[column + 2])));
+		result = _mm_add_ps(result, _mm_mul_ps(parent3, _mm_set1_ps(local[column + 3])));
+
+		_mm_storeu_ps(world + column, result);
+		_mm_storeu_ps(gpuWorld + column, result);
+	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	float32x4_t parent0 = vld1q_f32(parent);
+	float32x4_t parent1 = vld1q_f32(parent + 4);
+	float32x4_t parent2 = vld1q_f32(parent + 8);
+	float32x4_t parent3 = vld1q_f32(parent + 12);
+
+	for (int column = 0; column < 16; column += 4) {
+		float32x4_t localColumn = vld1q_f32(local + column);
+
+		float32x4_t result = vmulq_laneq_f32(parent0, localColumn, 0);
+		result = vfmaq_laneq_f32(result, parent1, localColumn, 1);
+		result = vfmaq_laneq_f32(result, parent2, localColumn, 2);
+		result = vfmaq_laneq_f32(result, parent3, localColumn, 3);
+
+		vst1q_f32(world + column, result);
+		vst1q_f32(gpuWorld + column, result);
+	}
+#else
+	for (int column = 0; column < 16; column += 4) {
+		for (int row = 0; row < 4; row++) {
+			world[column + row] = parent[row] * local[column] + parent[4 + row] * local[column + 1]
+				+ parent[8 + row] * local[column + 2] + parent[12 + row] * local[column + 3];
+		}
+	}
+	memcpy(gpuWorld, world, sizeof(float) * 16);
+#endif
+}
+
+void transformBounds(const glm::mat4 &matrix, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, glm::vec3 * outMin, glm::vec3 * outMax){
+
+	// transform the center, and grow the half size by the absolute value of each axis (Arvo)
+	glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	glm::vec3 halfSize = (boundsMax - boundsMin) * 0.5f;
+
+	glm::vec4 worldCenter = matrix * glm::vec4(center, 1.0f);
+	glm::vec3 worldHalfSize(0.0f);
+	for (int row = 0; row < 3; row++) {
+		for (int column = 0; column < 3; column++) {
+			worldHalfSize[row] += std::fabs(matrix[column][row]) * halfSize[column];
+		}
+	}
+
+	*outMin = glm::vec3(worldCenter.x, worldCenter.y, worldCenter.z) - worldHalfSize;
+	*outMax = glm::vec3(worldCenter.x, worldCenter.y, worldCenter.z) + worldHalfSize;
+}
+
+// -- SCENE GRAPH --
+SceneGraph::SceneGraph(){
+
+}
+
+void SceneGraph::create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, DeviceAllocator * newAllocator, int newFramesInFlight, uint32_t newMaxNodes){
+
+	physicalDevice = newPhysicalDevice;
+	device = newDevice;
+	allocator = newAllocator;
+	framesInFlight = newFramesInFlight;
+	maxNodes = newMaxNodes;
+
+	parents.reserve(maxNodes);
+	positions.reserve(maxNodes);
+	rotations.reserve(maxNodes);
+	scales.reserve(maxNodes);
+	worldMatrices.reserve(maxNodes);
+	dirty.reserve(maxNodes);
+	pendingFrames.reserve(maxNodes);
+
+	// host visible and persistently mapped, the update writes matrices in place
+	VkDeviceSize instanceSize = maxNodes * sizeof(glm::mat4);
+
+	frames.resize(framesInFlight);
+	for (auto &frame : frames) {
+
+		VkBuffer buffer;
+		VkDeviceMemory memory;
+		createBuffer(physicalDevice, device, instanceSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &buffer, &memory, allocator);
+		frame.instanceMemory = UniqueDeviceMemory(allocator, memory);
+		frame.instanceBuffer = UniqueBuffer(device, buffer);
+
+		void * data;
+		vkMapMemory(device, memory, 0, instanceSize, 0, &data);
+		frame.mappedInstances = static_cast<glm::mat4 *>(data);
+	}
+}
+
+void SceneGraph::destroy(){
+
+	// mapped memory has to be unmapped before it goes back to the allocator for recycling
+	for (auto &frame : frames) {
+		if (frame.mappedInstances != nullptr) {
+			vkUnmapMemory(device, frame.instanceMemory.get());
+		}
+	}
+	frames.clear();
+
+	parents.clear();
+	positions.clear();
+	rotations.clear();
+	scales.clear();
+	worldMatrices.clear();
+	dirty.clear();
+	pendingFrames.clear();
+}
+
+uint32_t SceneGraph::addNode(int32_t parent, const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale){
+
+	if (parents.size() >= maxNodes) {
+		throw std::runtime_error("scene graph is full");
+	}
+
+	// a parent added later would be updated after its children
+	if (parent >= static_cast<int32_t>(parents.size())) {
+		throw std::runtime_error("scene graph parent must be added before its children");
+	}
+
+	parents.push_back(parent);
+	positions.push_back(position);
+	rotations.push_back(rotation);
+	scales.push_back(scale);
+	worldMatrices.push_back(glm::mat4(1.0f));
+	dirty.push_back(1);
+	pendingFrames.push_back(0);
+
+	return static_cast<uint32_t>(parents.size() - 1);
+}
+
+void SceneGraph::setPosition(uint32_t node, const glm::vec3 &position){
+	positions[node] = position;
+	dirty[node] = 1;
+}
+
+void SceneGraph::setRotation(uint32_t node, const glm::quat &rotation){
+	rotations[node] = rotation;
+	dirty[node] = 1;
+}
+
+void SceneGraph::setScale(uint32_t node, const glm::vec3 &scale){
+	scales[node] = scale;
+	dirty[node] = 1;
+}
+
+const glm::mat4 &SceneGraph::getWorldMatrix(uint32_t node){
+	return worldMatrices[node];
+}
+
+uint32_t SceneGraph::getNodeCount(){
+	return static_cast<uint32_t>(parents.size());
+}
+
+void SceneGraph::update(int frame){
+
+	PROFILE_FUNCTION();
+
+	float * gpuMatrices = reinterpret_cast<float *>(frames[frame].mappedInstances);
+	uint32_t nodeCount = static_cast<uint32_t>(parents.size());
+
+	// one pass front to back over the arrays, parents are always finished before their children
+	for (uint32_t i = 0; i < nodeCount; i++) {
+
+		// a recomputed parent has already marked itself, so the whole subtree below it follows
+		int32_t parent = parents[i];
+		if (parent >= 0 && dirty[parent]) {
+			dirty[i] = 1;
+		}
+
+		float * world = &worldMatrices[i][0][0];
+		float * gpuWorld = gpuMatrices + i * 16;
+
+		if (!dirty[i]) {
+
+			// unchanged, but this frame's buffer may predate a recent change
+			if (pendingFrames[i] > 0) {
+				memcpy(gpuWorld, world, sizeof(glm::mat4));
+				pendingFrames[i]--;
+			}
+			continue;
+		}
+
+		float local[16];
+		composeLocalMatrix(positions[i], rotations[i], scales[i], local);
+
+		if (parent < 0) {
+			memcpy(world, local, sizeof(local));
+			memcpy(gpuWorld, local, sizeof(local));
+		}
+		else
+		{
+			multiplyMatrices(&worldMatrices[parent][0][0], local, world, gpuWorld);
+		}
+
+		// every other frame's buffer gets the new matrix on its next update
+		pendingFrames[i] = static_cast<uint8_t>(framesInFlight - 1);
+	}
+
+	// flags are only cleared now, children read their parent's flag during the pass
+	std::fill(dirty.begin(), dirty.end(), 0);
+}
+
+VkBuffer SceneGraph::getInstanceBuffer(int frame){
+	return frames[frame].instanceBuffer.get();
+}
+
+SceneGraph::~SceneGraph(){
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/quaternion.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+#include "Utilities.h"
+#include "VulkanHandles.h"
+#include "Profiler.h"
+
+// Transform hierarchy stored as structure of arrays, one entry per node in every array.
+// Nodes are only ever added after their parent, so parents always come before their children and
+// world matrices are updated in a single front to back pass without recursion.
+// Only nodes whose local transform (or an ancestor's) changed are recomputed, and each result is written
+// straight in to the frame's instance buffer, which the vertex and mesh shaders read the model matrix from
+class SceneGraph
+{
+public:
+	SceneGraph();
+
+	void create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, DeviceAllocator * newAllocator, int newFramesInFlight, uint32_t newMaxNodes = 131072);
+	void destroy();
+
+	// parent -1 makes a root node, otherwise the parent must already exist. returns the node's index
+	uint32_t addNode(int32_t parent, const glm::vec3 &position = glm::vec3(0.0f), const glm::quat &rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+		const glm::vec3 &scale = glm::vec3(1.0f));
+
+	// -- LOCAL TRANSFORM --
+	void setPosition(uint32_t node, const glm::vec3 &position);
+	void setRotation(uint32_t node, const glm::quat &rotation);
+	void setScale(uint32_t node, const glm::vec3 &scale);
+
+	// world matrix as of the last update
+	const glm::mat4 &getWorldMatrix(uint32_t node);
+	uint32_t getNodeCount();
+
+	// recompute dirty world matrices and bring the frame's instance buffer up to date.
+	// called once per frame, in frame order, before anything reading the instance buffer is recorded
+	void update(int frame);
+
+	// one mat4 per node, host visible and rewritten by update
+	VkBuffer getInstanceBuffer(int frame);
+
+	~SceneGraph();
+
+private:
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	DeviceAllocator * allocator = nullptr;
+
+	int framesInFlight = 0;
+	uint32_t maxNodes = 0;
+
+	// - Nodes
+	std::vector<int32_t> parents;
+	std::vector<glm::vec3> positions;
+	std::vector<glm::quat> rotations;
+	std::vector<glm::vec3> scales;
+	std::vector<glm::mat4> worldMatrices;
+	std::vector<uint8_t> dirty;					// local transform changed since the last update
+	std::vector<uint8_t> pendingFrames;			// other frames' instance buffers still holding an old world matrix
+
+	// - Per frame instance buffers
+	struct FrameBuffers {
+		UniqueDeviceMemory instanceMemory;
+		UniqueBuffer instanceBuffer;
+		glm::mat4 * mappedInstances = nullptr;
+	};
+	std::vector<FrameBuffers> frames;
+};
+
+// box around a transformed bounding box
+void transformBounds(const glm::mat4 &matrix, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, glm::vec3 * outMin, glm::vec3 * outMax);
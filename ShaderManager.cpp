@@ -0,0 +1,393 @@
+#include "ShaderManager.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+#include <shaderc/shaderc.hpp>
+
+#include "Utilities.h"
+
+// -- HELPERS --
+static std::string getExtension(const std::string &path){
+
+	size_t dot = path.find_last_of('.');
+	return dot == std::string::npos ? std::string() : path.substr(dot + 1);
+}
+
+static std::string getDirectory(const std::string &path){
+
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+}
+
+static std::string getFileName(const std::string &path){
+
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+static bool isGlslSource(const std::string &path){
+
+	std::string extension = getExtension(path);
+	return extension == "vert" || extension == "frag" || extension == "comp" || extension == "geom" || extension == "task" || extension == "mesh";
+}
+
+static time_t getModifiedTime(const std::string &path){
+
+	struct stat fileStatus;
+	if (stat(path.c_str(), &fileStatus) != 0) {
+		return 0;
+	}
+
+	return fileStatus.st_mtime;
+}
+
+static uint64_t hashSpirv(FileView spirv){
+
+	// FNV-1a over the SPIR-V words
+	uint64_t value = 14695981039346656037ull;
+	for (size_t i = 0; i < spirv.size; i++) {
+		value ^= spirv.data[i];
+		value *= 1099511628211ull;
+	}
+
+	return value;
+}
+
+static bool isValidSpirv(const AssetFile &spirv){
+
+	// the module reads the code as words straight from the file's memory, mappings and archive entries are aligned
+	return spirv.isOpen() && spirv.getSize() != 0 && spirv.getSize() % sizeof(uint32_t) == 0
+		&& reinterpret_cast<uintptr_t>(spirv.getData()) % alignof(uint32_t) == 0;
+}
+
+// -- SHADER MANAGER --
+ShaderManager::ShaderManager(){
+
+}
+
+void ShaderManager::create(VkDevice newDevice, FileSystem * newFileSystem){
+
+	device = newDevice;
+	fileSystem = newFileSystem;
+
+#ifdef __linux__
+	// non blocking so polling once a frame never stalls
+	watchDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (watchDescriptor < 0) {
+		printf("ERROR: failed to start watching shader files, hot reload disabled\n");
+	}
+#endif
+}
+
+void ShaderManager::destroy(){
+
+	std::lock_guard<std::mutex> lock(shaderMutex);
+
+	for (auto &module : modules) {
+		vkDestroyShaderModule(device, module.second.module, nullptr);
+	}
+	modules.clear();
+	sources.clear();
+
+#ifdef __linux__
+	if (watchDescriptor >= 0) {
+		close(watchDescriptor);
+		watchDescriptor = -1;
+	}
+	watchedDirectories.clear();
+#endif
+}
+
+VkShaderModule ShaderManager::getModule(const std::string &path){
+
+	{
+		std::lock_guard<std::mutex> lock(shaderMutex);
+
+		auto source = sources.find(path);
+		if (source != sources.end()) {
+			return modules[source->second.contentHash].module;
+		}
+	}
+
+	// load outside the lock so workers can compile different shaders at the same time
+	AssetFile spirv = loadSpirv(path);
+
+	std::lock_guard<std::mutex> lock(shaderMutex);
+
+	// another thread may have loaded the same path meanwhile
+	auto source = sources.find(path);
+	if (source == sources.end()) {
+		addSource(path, path, spirv);
+		source = sources.find(path);
+	}
+
+	return modules[source->second.contentHash].module;
+}
+
+void ShaderManager::preload(const std::vector<std::string> &paths){
+
+	std::vector<std::string> requestedPaths;
+	{
+		std::lock_guard<std::mutex> lock(shaderMutex);
+
+		for (const auto &path : paths) {
+			if (sources.count(path) == 0) {
+				requestedPaths.push_back(path);
+			}
+		}
+	}
+
+	// sources are read in one batch, then compiled outside the lock
+	std::vector<AssetFile> files = fileSystem->openBatch(requestedPaths);
+
+	for (size_t i = 0; i < files.size(); i++) {
+		if (!files[i].isOpen() || !isGlslSource(requestedPaths[i])) {
+			continue;
+		}
+		try
+		{
+			files[i] = compileGlsl(requestedPaths[i], files[i]);
+		}
+		catch (const std::runtime_error &)
+		{
+			files[i] = AssetFile();
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(shaderMutex);
+
+	for (size_t i = 0; i < files.size(); i++) {
+		if (isValidSpirv(files[i]) && sources.count(requestedPaths[i]) == 0) {
+			addSource(requestedPaths[i], requestedPaths[i], files[i]);
+		}
+	}
+}
+
+std::vector<std::string> ShaderManager::pollChanges(){
+
+	std::vector<std::string> changedShaders;
+
+	std::lock_guard<std::mutex> lock(shaderMutex);
+
+#ifdef __linux__
+	if (watchDescriptor >= 0) {
+
+		// editors often save by writing a new file and renaming it over the old one,
+		// so directories are watched and events matched back to the files by name
+		alignas(struct inotify_event) char buffer[4096];
+		ssize_t length;
+		while ((length = read(watchDescriptor, buffer, sizeof(buffer))) > 0) {
+
+			for (char * event = buffer; event < buffer + length; event += sizeof(struct inotify_event) + reinterpret_cast<struct inotify_event *>(event)->len) {
+
+				const struct inotify_event * fileEvent = reinterpret_cast<const struct inotify_event *>(event);
+				if (fileEvent->len == 0) {
+					continue;
+				}
+
+				auto directory = watchedDirectories.find(fileEvent->wd);
+				if (directory == watchedDirectories.end()) {
+					continue;
+				}
+
+				for (const auto &source : sources) {
+					if (!source.second.archived && getDirectory(source.second.filePath) == directory->second && getFileName(source.second.filePath) == fileEvent->name
+						&& std::find(changedShaders.begin(), changedShaders.end(), source.first) == changedShaders.end()) {
+						changedShaders.push_back(source.first);
+					}
+				}
+			}
+		}
+
+		return changedShaders;
+	}
+#endif
+
+	// no file watching available, compare modification times instead
+	for (const auto &source : sources) {
+		if (!source.second.archived && getModifiedTime(source.second.filePath) != source.second.modifiedTime) {
+			changedShaders.push_back(source.first);
+		}
+	}
+
+	return changedShaders;
+}
+
+bool ShaderManager::reload(const std::string &path){
+
+	AssetFile spirv;
+	try
+	{
+		spirv = loadSpirv(path);
+	}
+	catch (const std::runtime_error &e)
+	{
+		// keep using the old module until the shader is fixed
+		printf("ERROR: %s\n", e.what());
+
+		std::lock_guard<std::mutex> lock(shaderMutex);
+		auto source = sources.find(path);
+		if (source != sources.end()) {
+			source->second.modifiedTime = getModifiedTime(source->second.filePath);
+		}
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(shaderMutex);
+
+	auto source = sources.find(path);
+	if (source == sources.end()) {
+		return false;
+	}
+	source->second.modifiedTime = getModifiedTime(source->second.filePath);
+
+	// saved without any change to the compiled code
+	uint64_t contentHash = hashSpirv(spirv.getView());
+	if (contentHash == source->second.contentHash) {
+		return false;
+	}
+
+	addModule(spirv.getView());
+	releaseModule(source->second.contentHash);
+	source->second.contentHash = contentHash;
+
+	return true;
+}
+
+ShaderManager::~ShaderManager(){
+
+}
+
+AssetFile ShaderManager::loadSpirv(const std::string &path){
+
+	AssetFile file = fileSystem->open(path);
+	if (isGlslSource(path)) {
+		return compileGlsl(path, file);
+	}
+
+	if (!isValidSpirv(file)) {
+		throw std::runtime_error("invalid SPIR-V in " + path);
+	}
+
+	return file;
+}
+
+AssetFile ShaderManager::compileGlsl(const std::string &path, const AssetFile &source){
+
+	shaderc_shader_kind kind = shaderc_glsl_infer_from_source;
+	std::string extension = getExtension(path);
+	if (extension == "vert") kind = shaderc_vertex_shader;
+	else if (extension == "frag") kind = shaderc_fragment_shader;
+	else if (extension == "comp") kind = shaderc_compute_shader;
+	else if (extension == "geom") kind = shaderc_geometry_shader;
+	else if (extension == "task") kind = shaderc_task_shader;
+	else if (extension == "mesh") kind = shaderc_mesh_shader;
+
+	shaderc::CompileOptions options;
+	options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+
+	// VK_EXT_mesh_shader needs SPIR-V 1.4
+	if (kind == shaderc_task_shader || kind == shaderc_mesh_shader) {
+		options.SetTargetSpirv(shaderc_spirv_version_1_4);
+	}
+	options.SetOptimizationLevel(shaderc_optimization_level_performance);
+
+	// compiler objects are cheap and not shared, so workers can compile at the same time.
+	// the source is compiled straight from the file's memory
+	shaderc::Compiler compiler;
+	shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(reinterpret_cast<const char *>(source.getData()), source.getSize(),
+		kind, path.c_str(), options);
+
+	if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+		throw std::runtime_error("failed to compile shader " + path + "\n" + result.GetErrorMessage());
+	}
+
+	return AssetFile::fromBuffer(std::vector<uint8_t>(reinterpret_cast<const uint8_t *>(result.cbegin()), reinterpret_cast<const uint8_t *>(result.cend())));
+}
+
+void ShaderManager::addSource(const std::string &path, const std::string &filePath, const AssetFile &spirv){
+
+	bool archived = fileSystem->isArchived(filePath);
+	uint64_t contentHash = addModule(spirv.getView());
+	sources[path] = { filePath, contentHash, archived ? 0 : getModifiedTime(filePath), archived };
+
+	if (!archived) {
+		watchFile(filePath);
+	}
+}
+
+uint64_t ShaderManager::addModule(FileView spirv){
+
+	// identical code from another path shares the existing module
+	uint64_t contentHash = hashSpirv(spirv);
+	auto existing = modules.find(contentHash);
+	if (existing != modules.end()) {
+		existing->second.users++;
+		return contentHash;
+	}
+
+	// shader module creation information
+	VkShaderModuleCreateInfo shaderModuleCreateInfo = {};
+	shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	shaderModuleCreateInfo.codeSize = spirv.size;										// size of code in bytes
+	shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t *>(spirv.data);		// pointer to code, aligned (see isValidSpirv)
+
+	VkShaderModule shaderModule;
+	VkResult result = vkCreateShaderModule(device, &shaderModuleCreateInfo, nullptr, &shaderModule);
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create the shader module");
+	}
+
+	modules[contentHash] = { shaderModule, 1 };
+	return contentHash;
+}
+
+void ShaderManager::releaseModule(uint64_t contentHash){
+
+	auto module = modules.find(contentHash);
+	if (module == modules.end()) {
+		return;
+	}
+
+	// pipelines keep their own copy of the code, so the module can go as soon as nothing resolves to it
+	if (--module->second.users == 0) {
+		vkDestroyShaderModule(device, module->second.module, nullptr);
+		modules.erase(module);
+	}
+}
+
+void ShaderManager::watchFile(const std::string &filePath){
+
+#ifdef __linux__
+	if (watchDescriptor < 0) {
+		return;
+	}
+
+	std::string directory = getDirectory(filePath);
+	for (const auto &watched : watchedDirectories) {
+		if (watched.second == directory) {
+			return;
+		}
+	}
+
+	int watch = inotify_add_watch(watchDescriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if (watch < 0) {
+		printf("ERROR: failed to watch %s for shader changes\n", directory.c_str());
+		return;
+	}
+
+	watchedDirectories[watch] = directory;
+#else
+	(void)filePath;
+#endif
+}
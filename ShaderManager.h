@@ -0,0 +1,81 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <ctime>
+
+#include "FileSystem.h"
+
+// GLSL sources are always compiled at runtime, no precompiled SPIR-V ships with them.
+// link with -lshaderc_combined (part of the Vulkan SDK)
+#if !__has_include(<shaderc/shaderc.hpp>)
+#error "shaderc is required to build ShaderManager, install the Vulkan SDK or libshaderc"
+#endif
+
+// Loads shaders (GLSL sources or SPIR-V) and caches one VkShaderModule per unique SPIR-V content,
+// so every pipeline using the same shader shares a module and the file is only read once.
+// Files come from the file system, mapped (or from a mounted archive) and handed to Vulkan without copying.
+// Source files on disk are watched so changed shaders can be reloaded without restarting
+class ShaderManager
+{
+public:
+	ShaderManager();
+
+	void create(VkDevice newDevice, FileSystem * newFileSystem);
+	void destroy();
+
+	// module for a shader path, loaded (and compiled if GLSL) on first use. safe to call from any thread
+	VkShaderModule getModule(const std::string &path);
+
+	// load (and compile) the modules of many shaders with one batched read, before they are asked for.
+	// shaders that fail to load are skipped here and report their error from getModule
+	void preload(const std::vector<std::string> &paths);
+
+	// paths of loaded shaders whose file changed on disk since they were loaded
+	std::vector<std::string> pollChanges();
+
+	// reload a changed shader, returns true if its module changed
+	// no pipeline may be in the middle of being created with the old module when this is called
+	bool reload(const std::string &path);
+
+	~ShaderManager();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	FileSystem * fileSystem = nullptr;
+
+	struct ShaderModule {
+		VkShaderModule module;
+		uint32_t users;					// number of shader paths currently resolving to this content
+	};
+
+	struct ShaderSource {
+		std::string filePath;			// file actually read
+		uint64_t contentHash;
+		time_t modifiedTime;
+		bool archived;					// read from a mounted archive, never reloaded
+	};
+
+	std::mutex shaderMutex;
+	std::unordered_map<uint64_t, ShaderModule> modules;			// keyed by hash of the SPIR-V
+	std::unordered_map<std::string, ShaderSource> sources;		// keyed by requested path
+
+#ifdef __linux__
+	int watchDescriptor = -1;									// inotify instance
+	std::unordered_map<int, std::string> watchedDirectories;	// inotify watch -> directory
+#endif
+
+	// SPIR-V for a shader path, compiling GLSL sources
+	AssetFile loadSpirv(const std::string &path);
+	AssetFile compileGlsl(const std::string &path, const AssetFile &source);
+	void addSource(const std::string &path, const std::string &filePath, const AssetFile &spirv);
+	uint64_t addModule(FileView spirv);
+	void releaseModule(uint64_t contentHash);
+	void watchFile(const std::string &filePath);
+};
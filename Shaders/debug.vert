@@ -0,0 +1,14 @@
+#version 450
+
+// debug lines and triangles, positioned like the scene's vertices
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec4 col;
+layout (location = 2) in mat4 model;		// the scene root's, or identity for screen space
+
+layout (location = 0) out vec4 fragCol;
+
+void main() {
+    gl_Position = model * vec4(pos, 1.0);
+    fragCol = col;
+}
@@ -0,0 +1,15 @@
+#version 450
+
+layout (location = 0) in vec4 fragColor;
+layout (location = 1) in vec2 fragCorner;
+
+layout (location = 0) out vec4 outColor;
+
+void main() {
+    // round with a soft edge
+    float alpha = fragColor.a * (1.0 - smoothstep(0.5, 1.0, length(fragCorner)));
+    if (alpha <= 0.0) {
+        discard;
+    }
+    outColor = vec4(fragColor.rgb, alpha);
+}
@@ -0,0 +1,26 @@
+#version 450
+
+// one particle per instance, expanded to a quad from gl_VertexIndex (no vertex buffer of its own)
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec4 color;
+layout (location = 2) in float life;
+
+layout (location = 0) out vec4 fragColor;
+layout (location = 1) out vec2 fragCorner;
+
+const float PARTICLE_SIZE = 0.008;       // half width, in clip space
+
+const vec2 corners[6] = vec2[](
+    vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+    vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0)
+);
+
+void main() {
+    vec2 corner = corners[gl_VertexIndex];
+    gl_Position = vec4(position.xy + corner * PARTICLE_SIZE, position.z, 1.0);
+
+    // fade out over the last half second
+    fragColor = vec4(color.rgb, color.a * clamp(life * 2.0, 0.0, 1.0));
+    fragCorner = corner;
+}
@@ -1,9 +1,12 @@
-#version 450
-
-layout (location = 0) in vec3 fragCol;
-
-layout (location = 0) out vec4 outColor;    // final output color (must also have location)
-
-void main(){
-    outColor = vec4(fragCol, 1.0);
+#version 450
+
+layout (location = 0) in vec3 fragCol;
+layout (location = 1) in vec2 fragTex;
+
+layout (set = 1, binding = 0) uniform sampler2D textureSampler;    // the mesh's texture, from the texture manager
+
+layout (location = 0) out vec4 outColor;    // final output color (must also have location)
+
+void main(){
+    outColor = texture(textureSampler, fragTex) * vec4(fragCol, 1.0);
 }
\ No newline at end of file
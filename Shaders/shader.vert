@@ -1,12 +1,16 @@
-#version 450 // version 4.5
-
-layout (location = 0) in vec3 pos;
-layout (location = 1) in vec3 col;
-
-layout(location = 0) out vec3 fragCol;
-
-void main(){
-    gl_Position = vec4(pos,1.0);
-    
-    fragCol = col;
-}
\ No newline at end of file
+#version 450 // version 4.5
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec3 col;
+layout (location = 2) in mat4 model;		// per instance, from the scene graph
+layout (location = 6) in vec2 tex;
+
+layout(location = 0) out vec3 fragCol;
+layout(location = 1) out vec2 fragTex;
+
+void main(){
+    gl_Position = model * vec4(pos,1.0);
+    
+    fragCol = col;
+    fragTex = tex;
+}
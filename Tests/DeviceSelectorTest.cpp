@@ -0,0 +1,76 @@
+// Checks device selection against made up devices, needs no GPU or display. Exits non zero on failure.
+// Build it next to the renderer and run it, e.g. from the repository root:
+//   g++ -std=c++17 -I. Tests/DeviceSelectorTest.cpp DeviceSelector.cpp -lvulkan -o DeviceSelectorTest && ./DeviceSelectorTest
+#include "DeviceSelector.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+int main() {
+
+	bool passed = true;
+	auto check = [&passed](bool condition, const char * description) {
+		if (!condition) {
+			printf("ERROR: device selector test failed: %s\n", description);
+			passed = false;
+		}
+	};
+
+	// the least a suitable device can score for anything but its type, and the most
+	auto makeCandidate = [](const char * name, const char * uuid, VkPhysicalDeviceType type, bool best) {
+		DeviceCandidate candidate;
+		candidate.name = name;
+		candidate.uuid = uuid;
+		candidate.type = type;
+		candidate.suitable = true;
+		if (best) {
+			candidate.deviceLocalBytes = VkDeviceSize(1) << 50;
+			candidate.presentOnGraphicsFamily = true;
+			candidate.asyncComputeFamily = true;
+			candidate.transferFamily = true;
+			candidate.optionalExtensionCount = 64;
+			candidate.maxImageDimension2D = ~0u;
+			candidate.maxComputeSharedMemorySize = ~0u;
+			candidate.multiDrawIndirect = true;
+		}
+		return candidate;
+	};
+
+	// -- TYPE ORDER --
+	// the worst device of each type beats the best of the next
+	VkPhysicalDeviceType order[] = { VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU, VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU,
+		VK_PHYSICAL_DEVICE_TYPE_OTHER, VK_PHYSICAL_DEVICE_TYPE_CPU };
+	for (size_t i = 0; i + 1 < sizeof(order) / sizeof(order[0]); i++) {
+		std::vector<DeviceCandidate> candidates = {
+			makeCandidate("better", "", order[i + 1], true),
+			makeCandidate("worse", "", order[i], false)
+		};
+		std::string description = std::string(DeviceSelector::getTypeName(order[i])) + " over " + DeviceSelector::getTypeName(order[i + 1]);
+		check(DeviceSelector::select(candidates, "") == 1, description.c_str());
+	}
+
+	// within a type the better device wins, and unsuitable devices never do
+	std::vector<DeviceCandidate> candidates = {
+		makeCandidate("Lesser GPU", "00112233445566778899aabbccddeeff", VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, false),
+		makeCandidate("Greater GPU", "ffeeddccbbaa99887766554433221100", VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, true),
+		makeCandidate("llvmpipe (LLVM 15.0.7, 256 bits)", "0123456789abcdef0123456789abcdef", VK_PHYSICAL_DEVICE_TYPE_CPU, false),
+		makeCandidate("Broken GPU", "", VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, true)
+	};
+	candidates[3].suitable = false;
+	candidates[3].deviceLocalBytes = VkDeviceSize(1) << 60;
+	check(DeviceSelector::select(candidates, "") == 1, "better device of the same type");
+	check(candidates[3].score == -1, "unsuitable devices score -1");
+
+	// -- OVERRIDE --
+	check(DeviceSelector::select(candidates, "LLVMPIPE") == 2, "override by part of the name, any case");
+	check(DeviceSelector::select(candidates, "00112233-4455-6677-8899-AABBCCDDEEFF") == 0, "override by UUID with dashes");
+	check(DeviceSelector::select(candidates, "0123456789abcdef0123456789abcdef") == 2, "override by UUID");
+	check(DeviceSelector::select(candidates, "GPU") == 0, "override matching several devices takes the first");
+	check(DeviceSelector::select(candidates, "Broken") == 1, "override naming an unsuitable device falls back to the scores");
+	check(DeviceSelector::select(candidates, "no such device") == 1, "override matching nothing falls back to the scores");
+
+	printf("device selector test %s\n", passed ? "passed" : "failed");
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,505 @@
+#include "TextureManager.h"
+
+#include <algorithm>
+
+#include "Utilities.h"
+
+// one sampler per level of detail clamp, enough for textures up to 32768 texels across
+static const uint32_t MAX_TEXTURE_MIP_LEVELS = 16;
+
+// texel block of the formats textures can be made from, 1x1 for uncompressed formats
+static bool getFormatBlock(VkFormat format, uint32_t * blockWidth, uint32_t * blockHeight, uint32_t * blockBytes){
+
+	*blockWidth = 4;
+	*blockHeight = 4;
+
+	switch (format) {
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+		*blockWidth = 1;
+		*blockHeight = 1;
+		*blockBytes = 4;
+		return true;
+
+	// - BC
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+	case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+	case VK_FORMAT_BC4_UNORM_BLOCK:
+	case VK_FORMAT_BC4_SNORM_BLOCK:
+		*blockBytes = 8;
+		return true;
+	case VK_FORMAT_BC2_UNORM_BLOCK:
+	case VK_FORMAT_BC2_SRGB_BLOCK:
+	case VK_FORMAT_BC3_UNORM_BLOCK:
+	case VK_FORMAT_BC3_SRGB_BLOCK:
+	case VK_FORMAT_BC5_UNORM_BLOCK:
+	case VK_FORMAT_BC5_SNORM_BLOCK:
+	case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+	case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+	case VK_FORMAT_BC7_SRGB_BLOCK:
+		*blockBytes = 16;
+		return true;
+
+	// - ETC2 / EAC
+	case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+	case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+	case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+		*blockBytes = 8;
+		return true;
+	case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+	case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+	case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+		*blockBytes = 16;
+		return true;
+
+	// - ASTC, every block is 16 bytes whatever its size
+	case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+	case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+		*blockBytes = 16;
+		return true;
+	case VK_FORMAT_ASTC_5x5_UNORM_BLOCK:
+	case VK_FORMAT_ASTC_5x5_SRGB_BLOCK:
+		*blockWidth = 5;
+		*blockHeight = 5;
+		*blockBytes = 16;
+		return true;
+	case VK_FORMAT_ASTC_6x6_UNORM_BLOCK:
+	case VK_FORMAT_ASTC_6x6_SRGB_BLOCK:
+		*blockWidth = 6;
+		*blockHeight = 6;
+		*blockBytes = 16;
+		return true;
+	case VK_FORMAT_ASTC_8x8_UNORM_BLOCK:
+	case VK_FORMAT_ASTC_8x8_SRGB_BLOCK:
+		*blockWidth = 8;
+		*blockHeight = 8;
+		*blockBytes = 16;
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+// level 0 is in TRANSFER_SRC with its data, every level ends up SHADER_READ_ONLY
+static void recordMipChain(VkCommandBuffer commandBuffer, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels){
+
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	// every level but the first ready to be written, in one barrier
+	if (mipLevels > 1) {
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.subresourceRange.baseMipLevel = 1;
+		barrier.subresourceRange.levelCount = mipLevels - 1;
+
+		deviceDispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	// each level is a linear filtered blit of the one before, which becomes the source for the next
+	barrier.subresourceRange.levelCount = 1;
+	for (uint32_t level = 1; level < mipLevels; level++) {
+
+		VkImageBlit blit = {};
+		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.srcSubresource.mipLevel = level - 1;
+		blit.srcSubresource.baseArrayLayer = 0;
+		blit.srcSubresource.layerCount = 1;
+		blit.srcOffsets[1] = { int32_t(std::max(width >> (level - 1), 1u)), int32_t(std::max(height >> (level - 1), 1u)), 1 };
+		blit.dstSubresource = blit.srcSubresource;
+		blit.dstSubresource.mipLevel = level;
+		blit.dstOffsets[1] = { int32_t(std::max(width >> level, 1u)), int32_t(std::max(height >> level, 1u)), 1 };
+
+		deviceDispatch.vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1, &blit, VK_FILTER_LINEAR);
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.subresourceRange.baseMipLevel = level;
+
+		deviceDispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	// the whole chain to shader reads at once
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = mipLevels;
+
+	deviceDispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+TextureManager::TextureManager(){
+
+}
+
+void TextureManager::create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, DeviceAllocator * newAllocator, UploadManager * newUploadManager,
+	int framesInFlight, uint32_t newMaxTextures, VkDeviceSize newStreamBytesPerFrame){
+
+	physicalDevice = newPhysicalDevice;
+	device = newDevice;
+	allocator = newAllocator;
+	uploadManager = newUploadManager;
+	frameCount = static_cast<uint32_t>(framesInFlight);
+	maxTextures = newMaxTextures;
+	streamBytesPerFrame = newStreamBytesPerFrame;
+
+	createSamplers();
+	createDescriptorPool();
+}
+
+void TextureManager::destroy(){
+
+	// descriptor sets go with the pool
+	std::lock_guard<std::mutex> lock(textureMutex);
+	textures.clear();
+
+	descriptorPool.reset();
+	setLayout.reset();
+	samplers.clear();
+}
+
+uint32_t TextureManager::createTexture(uint32_t width, uint32_t height, VkFormat format, std::vector<std::vector<uint8_t>> levels){
+
+	if (width == 0 || height == 0 || levels.empty()) {
+		throw std::runtime_error("texture has no data");
+	}
+	if (getMipLevelCount(width, height) > MAX_TEXTURE_MIP_LEVELS) {
+		throw std::runtime_error("texture is too large");
+	}
+	if (levels.size() > getMipLevelCount(width, height)) {
+		throw std::runtime_error("texture has more mip levels than its size allows");
+	}
+	for (uint32_t level = 0; level < levels.size(); level++) {
+		if (levels[level].size() != getLevelSize(format, width, height, level)) {
+			throw std::runtime_error("texture level data doesn't match its size and format");
+		}
+	}
+	if (!isFormatSupported(format)) {
+		throw std::runtime_error("texture format is not supported by the device");
+	}
+
+	// a single level is turned in to a full chain on the GPU, when the format can be blitted with linear filtering
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+
+	VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	bool generateMips = levels.size() == 1 && (formatProperties.optimalTilingFeatures & blitFeatures) == blitFeatures;
+
+	auto texture = std::make_unique<Texture>();
+
+	// sets are allocated first, running out of them (more than maxTextures) fails before anything is uploaded
+	{
+		std::lock_guard<std::mutex> lock(textureMutex);
+
+		std::vector<VkDescriptorSetLayout> layouts(frameCount, setLayout.get());
+		texture->descriptorSets.resize(frameCount);
+
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = descriptorPool.get();
+		allocInfo.descriptorSetCount = frameCount;
+		allocInfo.pSetLayouts = layouts.data();
+		if (vkAllocateDescriptorSets(device, &allocInfo, texture->descriptorSets.data()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate texture descriptor sets");
+		}
+	}
+
+	texture->format = format;
+	texture->width = width;
+	texture->height = height;
+	texture->mipLevels = generateMips ? getMipLevelCount(width, height) : static_cast<uint32_t>(levels.size());
+
+	// -- IMAGE --
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	if (generateMips) {
+		usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	}
+
+	VkImage image;
+	VkDeviceMemory memory;
+	createImage(physicalDevice, device, width, height, texture->mipLevels, format, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &image, &memory, allocator);
+	texture->memory = UniqueDeviceMemory(allocator, memory);
+	texture->image = UniqueImage(device, image);
+	texture->view = UniqueImageView(device, createImageView(device, image, format, VK_IMAGE_ASPECT_COLOR_BIT, 0, texture->mipLevels));
+
+	// -- UPLOAD --
+	uint32_t mipLevels = texture->mipLevels;
+	if (generateMips) {
+
+		uploadManager->uploadImage(image, levels[0].data(), levels[0].size(), 0, { width, height }, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+		uploadManager->recordAfterCopies([image, width, height, mipLevels](VkCommandBuffer commandBuffer) {
+			recordMipChain(commandBuffer, image, width, height, mipLevels);
+		});
+		texture->residentLevel = 0;
+	}
+	else
+	{
+		// the coarsest level now so there is something to draw, the rest are streamed by update
+		uint32_t coarsest = mipLevels - 1;
+		VkExtent2D extent = { std::max(width >> coarsest, 1u), std::max(height >> coarsest, 1u) };
+		uploadManager->uploadImage(image, levels[coarsest].data(), levels[coarsest].size(), coarsest, extent, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		// levels still to come are put in the layout the view is used in, the sampler keeps them from being read
+		if (coarsest > 0) {
+			uploadManager->recordAfterCopies([image, coarsest](VkCommandBuffer commandBuffer) {
+
+				VkImageMemoryBarrier barrier = {};
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = 0;
+				barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.image = image;
+				barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				barrier.subresourceRange.baseMipLevel = 0;
+				barrier.subresourceRange.levelCount = coarsest;
+				barrier.subresourceRange.baseArrayLayer = 0;
+				barrier.subresourceRange.layerCount = 1;
+
+				deviceDispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+					0, 0, nullptr, 0, nullptr, 1, &barrier);
+			});
+		}
+
+		texture->residentLevel = coarsest;
+		levels.pop_back();
+		texture->pendingLevels = std::move(levels);
+	}
+
+	// -- DESCRIPTORS --
+	// new sets aren't used by anything yet, so every frame's can be written now
+	std::lock_guard<std::mutex> lock(textureMutex);
+
+	texture->frameVersions.resize(frameCount);
+	for (uint32_t frame = 0; frame < frameCount; frame++) {
+		writeDescriptorSet(*texture, frame);
+	}
+
+	textures.push_back(std::move(texture));
+	return static_cast<uint32_t>(textures.size() - 1);
+}
+
+bool TextureManager::isFormatSupported(VkFormat format){
+
+	uint32_t blockWidth, blockHeight, blockBytes;
+	if (!getFormatBlock(format, &blockWidth, &blockHeight, &blockBytes)) {
+		return false;
+	}
+
+	// compressed formats report no features unless the device has textureCompressionBC / ETC2 / ASTC_LDR
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+
+	VkFormatFeatureFlags features = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+	return (formatProperties.optimalTilingFeatures & features) == features;
+}
+
+VkFormat TextureManager::chooseFormat(const std::vector<VkFormat> &candidates){
+
+	for (VkFormat format : candidates) {
+		if (isFormatSupported(format)) {
+			return format;
+		}
+	}
+
+	return VK_FORMAT_UNDEFINED;
+}
+
+VkDeviceSize TextureManager::getLevelSize(VkFormat format, uint32_t width, uint32_t height, uint32_t level){
+
+	uint32_t blockWidth, blockHeight, blockBytes;
+	if (!getFormatBlock(format, &blockWidth, &blockHeight, &blockBytes)) {
+		throw std::runtime_error("textures can't be made from this format");
+	}
+
+	// partial blocks at the edges still take a whole block
+	VkDeviceSize blocksAcross = (std::max(width >> level, 1u) + blockWidth - 1) / blockWidth;
+	VkDeviceSize blocksDown = (std::max(height >> level, 1u) + blockHeight - 1) / blockHeight;
+	return blocksAcross * blocksDown * blockBytes;
+}
+
+uint32_t TextureManager::getMipLevelCount(uint32_t width, uint32_t height){
+
+	uint32_t levels = 1;
+	for (uint32_t size = std::max(width, height); size > 1; size >>= 1) {
+		levels++;
+	}
+	return levels;
+}
+
+void TextureManager::update(int frame){
+
+	PROFILE_FUNCTION();
+
+	std::lock_guard<std::mutex> lock(textureMutex);
+
+	// -- STREAM --
+	// smallest pending level of any texture first, so every texture sharpens a step before any gets its finest level.
+	// the first level always goes, so a level larger than the whole budget still arrives
+	VkDeviceSize streamedBytes = 0;
+	while (true) {
+
+		Texture * next = nullptr;
+		for (auto &texture : textures) {
+			if (!texture->pendingLevels.empty() &&
+				(next == nullptr || texture->pendingLevels.back().size() < next->pendingLevels.back().size())) {
+				next = texture.get();
+			}
+		}
+		if (next == nullptr) {
+			break;
+		}
+
+		std::vector<uint8_t> &data = next->pendingLevels.back();
+		if (streamedBytes > 0 && streamedBytes + data.size() > streamBytesPerFrame) {
+			break;
+		}
+
+		// the level reaches the GPU in the flush ahead of this frame's submission, so it can be sampled this frame
+		uint32_t level = next->residentLevel - 1;
+		VkExtent2D extent = { std::max(next->width >> level, 1u), std::max(next->height >> level, 1u) };
+		uploadManager->uploadImage(next->image.get(), data.data(), data.size(), level, extent, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		streamedBytes += data.size();
+		next->pendingLevels.pop_back();
+		next->residentLevel = level;
+		next->version++;
+	}
+
+	// -- DESCRIPTORS --
+	// this frame's sets were last used by its previous submission, which has finished
+	for (auto &texture : textures) {
+		if (texture->frameVersions[frame] != texture->version) {
+			writeDescriptorSet(*texture, frame);
+		}
+	}
+}
+
+VkDescriptorSetLayout TextureManager::getDescriptorSetLayout(){
+	return setLayout.get();
+}
+
+VkDescriptorSet TextureManager::getDescriptorSet(int frame, uint32_t texture){
+
+	std::lock_guard<std::mutex> lock(textureMutex);
+
+	if (texture >= textures.size()) {
+		throw std::runtime_error("texture doesn't exist");
+	}
+	return textures[texture]->descriptorSets[frame];
+}
+
+TextureManager::~TextureManager(){
+
+}
+
+void TextureManager::createSamplers(){
+
+	// trilinear filtering, the minimum level of detail is how textures that are still streaming skip missing levels
+	VkSamplerCreateInfo samplerCreateInfo = {};
+	samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
+	samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
+	samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerCreateInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+	for (uint32_t level = 0; level < MAX_TEXTURE_MIP_LEVELS; level++) {
+
+		samplerCreateInfo.minLod = static_cast<float>(level);
+
+		VkSampler sampler;
+		if (vkCreateSampler(device, &samplerCreateInfo, nullptr, &sampler) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create texture sampler");
+		}
+		samplers.emplace_back(device, sampler);
+	}
+}
+
+void TextureManager::createDescriptorPool(){
+
+	// -- DESCRIPTOR SET LAYOUT --
+	VkDescriptorSetLayoutBinding binding = {};
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	binding.descriptorCount = 1;
+	binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutCreateInfo.bindingCount = 1;
+	layoutCreateInfo.pBindings = &binding;
+
+	VkDescriptorSetLayout layout;
+	if (vkCreateDescriptorSetLayout(device, &layoutCreateInfo, nullptr, &layout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create texture descriptor set layout");
+	}
+	setLayout = UniqueDescriptorSetLayout(device, layout);
+
+	// -- DESCRIPTOR POOL --
+	VkDescriptorPoolSize poolSize = {};
+	poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSize.descriptorCount = maxTextures * frameCount;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = maxTextures * frameCount;
+	poolCreateInfo.poolSizeCount = 1;
+	poolCreateInfo.pPoolSizes = &poolSize;
+
+	VkDescriptorPool pool;
+	if (vkCreateDescriptorPool(device, &poolCreateInfo, nullptr, &pool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create texture descriptor pool");
+	}
+	descriptorPool = UniqueDescriptorPool(device, pool);
+}
+
+void TextureManager::writeDescriptorSet(Texture &texture, size_t frame){
+
+	VkDescriptorImageInfo imageInfo = {};
+	imageInfo.sampler = samplers[texture.residentLevel].get();
+	imageInfo.imageView = texture.view.get();
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = texture.descriptorSets[frame];
+	write.dstBinding = 0;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+	texture.frameVersions[frame] = texture.version;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+#include "UploadManager.h"
+#include "VulkanHandles.h"
+#include "Profiler.h"
+#include "DeviceDispatch.h"
+
+// Sampled 2D textures, uploaded through the upload manager.
+// A texture given a single uncompressed level gets its full mip chain generated on the GPU with a chain of
+// vkCmdBlitImage calls in the same submission as the upload. A texture given its own mip chain (the only option for
+// block compressed formats, which can't be blitted) is streamed coarsest level first: the smallest level is uploaded
+// straight away, and each update uploads finer levels within a byte budget. Levels that haven't arrived yet are
+// never sampled, each frame's descriptor points at a sampler whose minLod is the finest level that has.
+// Textures live until the manager is destroyed, each has one descriptor set per frame in flight
+class TextureManager
+{
+public:
+	TextureManager();
+
+	void create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, DeviceAllocator * newAllocator, UploadManager * newUploadManager,
+		int framesInFlight, uint32_t newMaxTextures = 256, VkDeviceSize newStreamBytesPerFrame = 8 * 1024 * 1024);
+	void destroy();
+
+	// levels are tightly packed, finest first. returns the texture's handle, can be called from any thread
+	uint32_t createTexture(uint32_t width, uint32_t height, VkFormat format, std::vector<std::vector<uint8_t>> levels);
+
+	// whether the device can sample the format (block compressed formats depend on the device's features),
+	// and the first of the candidates it can, VK_FORMAT_UNDEFINED if none
+	bool isFormatSupported(VkFormat format);
+	VkFormat chooseFormat(const std::vector<VkFormat> &candidates);
+
+	// size of one tightly packed level, throws for formats textures can't be made from
+	static VkDeviceSize getLevelSize(VkFormat format, uint32_t width, uint32_t height, uint32_t level);
+	static uint32_t getMipLevelCount(uint32_t width, uint32_t height);
+
+	// once a frame before recording, and before the upload manager's flush: stream in the next levels and
+	// point this frame's descriptor sets at what has arrived
+	void update(int frame);
+
+	// set 1 of the graphics pipeline layout, a combined image sampler at binding 0 read by the fragment shader
+	VkDescriptorSetLayout getDescriptorSetLayout();
+	VkDescriptorSet getDescriptorSet(int frame, uint32_t texture);
+
+	~TextureManager();
+
+private:
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	DeviceAllocator * allocator = nullptr;
+	UploadManager * uploadManager = nullptr;
+
+	uint32_t frameCount = 0;
+	uint32_t maxTextures = 0;
+	VkDeviceSize streamBytesPerFrame = 0;
+
+	struct Texture {
+		UniqueDeviceMemory memory;
+		UniqueImage image;
+		UniqueImageView view;					// every level, levels not streamed in yet are excluded by the sampler
+		VkFormat format;
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipLevels;
+		uint32_t residentLevel;					// finest level uploaded
+		std::vector<std::vector<uint8_t>> pendingLevels;	// host copies of the levels still to stream, freed once uploaded
+		uint64_t version = 0;					// bumped whenever residentLevel changes
+		std::vector<uint64_t> frameVersions;	// version each frame's descriptor set was written for
+		std::vector<VkDescriptorSet> descriptorSets;
+	};
+	std::mutex textureMutex;
+	std::vector<std::unique_ptr<Texture>> textures;
+
+	// - Descriptors
+	UniqueDescriptorSetLayout setLayout;
+	UniqueDescriptorPool descriptorPool;
+	std::vector<UniqueSampler> samplers;		// one per minimum level of detail
+
+	void createSamplers();
+	void createDescriptorPool();
+	void writeDescriptorSet(Texture &texture, size_t frame);
+};
@@ -0,0 +1,402 @@
+#include "UploadManager.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Utilities.h"
+
+// staged data starts on this alignment, enough for any element type or compressed texture block
+static const VkDeviceSize STAGING_ALIGNMENT = 16;
+
+UploadManager::UploadManager(){
+
+}
+
+void UploadManager::create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, VkQueue newQueue, uint32_t newQueueFamilyIndex,
+	FrameScheduler * newScheduler, DeviceAllocator * newAllocator, VkDeviceSize newStagingBlockSize, VkDeviceSize newMaxStagedBytes){
+
+	physicalDevice = newPhysicalDevice;
+	device = newDevice;
+	queue = newQueue;
+	queueFamilyIndex = newQueueFamilyIndex;
+	scheduler = newScheduler;
+	allocator = newAllocator;
+	stagingBlockSize = newStagingBlockSize;
+	maxStagedBytes = newMaxStagedBytes;
+}
+
+void UploadManager::destroy(){
+
+	// the device is idle, so every batch has finished. destroying a pool frees its command buffers
+	std::lock_guard<std::mutex> lock(contextMutex);
+	for (auto &context : contexts) {
+
+		for (auto &block : context->recording.blocks) {
+			releaseBlock(block);
+		}
+		for (auto &batch : context->inFlight) {
+			for (auto &block : batch.blocks) {
+				releaseBlock(block);
+			}
+		}
+		for (auto &block : context->freeBlocks) {
+			releaseBlock(block);
+		}
+
+		vkDestroyCommandPool(device, context->commandPool, nullptr);
+	}
+
+	contexts.clear();
+	threadContexts.clear();
+}
+
+void UploadManager::uploadBuffer(VkBuffer dstBuffer, const void * data, VkDeviceSize size, VkDeviceSize dstOffset){
+
+	PROFILE_FUNCTION();
+
+	if (size == 0) {
+		return;
+	}
+
+	ThreadContext &context = *getThreadContext();
+	bool flushNow = false;
+	{
+		std::lock_guard<std::mutex> lock(context.mutex);
+
+		reclaim(context);
+		if (context.recording.commandBuffer == VK_NULL_HANDLE) {
+			beginRecording(context);
+		}
+
+		// stage the data now, so the caller can free it straight away
+		VkBuffer stagingBuffer;
+		VkDeviceSize srcOffset = stage(context, data, size, &stagingBuffer);
+
+		VkBufferCopy bufferCopyRegion = {};
+		bufferCopyRegion.srcOffset = srcOffset;
+		bufferCopyRegion.dstOffset = dstOffset;
+		bufferCopyRegion.size = size;
+		deviceDispatch.vkCmdCopyBuffer(context.recording.commandBuffer, stagingBuffer, dstBuffer, 1, &bufferCopyRegion);
+
+		flushNow = context.recording.stagedBytes >= maxStagedBytes;
+	}
+
+	// outside the lock, flush takes every thread's lock in turn
+	if (flushNow) {
+		flush();
+	}
+}
+
+void UploadManager::uploadImage(VkImage dstImage, const void * data, VkDeviceSize size, uint32_t mipLevel, VkExtent2D extent, VkImageLayout finalLayout){
+
+	PROFILE_FUNCTION();
+
+	if (size == 0) {
+		return;
+	}
+
+	ThreadContext &context = *getThreadContext();
+	bool flushNow = false;
+	{
+		std::lock_guard<std::mutex> lock(context.mutex);
+
+		reclaim(context);
+		if (context.recording.commandBuffer == VK_NULL_HANDLE) {
+			beginRecording(context);
+		}
+
+		ImageCopy imageCopy = {};
+		imageCopy.image = dstImage;
+		imageCopy.finalLayout = finalLayout;
+		imageCopy.region.bufferOffset = stage(context, data, size, &imageCopy.stagingBuffer);
+		imageCopy.region.bufferRowLength = 0;					// 0 means tightly packed
+		imageCopy.region.bufferImageHeight = 0;
+		imageCopy.region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageCopy.region.imageSubresource.mipLevel = mipLevel;
+		imageCopy.region.imageSubresource.baseArrayLayer = 0;
+		imageCopy.region.imageSubresource.layerCount = 1;
+		imageCopy.region.imageOffset = { 0, 0, 0 };
+		imageCopy.region.imageExtent = { extent.width, extent.height, 1 };
+
+		// recorded at the flush, with the transitions of every other image copy of the batch
+		context.recording.imageCopies.push_back(imageCopy);
+
+		flushNow = context.recording.stagedBytes >= maxStagedBytes;
+	}
+
+	if (flushNow) {
+		flush();
+	}
+}
+
+void UploadManager::recordAfterCopies(std::function<void(VkCommandBuffer)> commands){
+
+	ThreadContext &context = *getThreadContext();
+	std::lock_guard<std::mutex> lock(context.mutex);
+
+	reclaim(context);
+	if (context.recording.commandBuffer == VK_NULL_HANDLE) {
+		beginRecording(context);
+	}
+
+	context.recording.afterCopies.push_back(std::move(commands));
+}
+
+uint64_t UploadManager::flush(){
+
+	PROFILE_FUNCTION();
+
+	std::lock_guard<std::mutex> flushLock(flushMutex);
+
+	// take the recorded batch of every thread, the threads can carry on recording in to new ones meanwhile
+	std::vector<std::pair<ThreadContext *, Batch>> batches;
+	{
+		std::lock_guard<std::mutex> lock(contextMutex);
+		for (auto &context : contexts) {
+
+			std::lock_guard<std::mutex> contextLock(context->mutex);
+			reclaim(*context);
+			if (context->recording.commandBuffer == VK_NULL_HANDLE) {
+				continue;
+			}
+
+			recordImageCopies(context->recording);
+			for (auto &commands : context->recording.afterCopies) {
+				commands(context->recording.commandBuffer);
+			}
+
+			// make the copies visible to everything submitted after them, so later submissions don't have to wait
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+			deviceDispatch.vkCmdPipelineBarrier(context->recording.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+				0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+			if (deviceDispatch.vkEndCommandBuffer(context->recording.commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("failed to stop recording an upload command buffer");
+			}
+
+			batches.emplace_back(context.get(), std::move(context->recording));
+			context->recording = Batch();
+		}
+	}
+
+	if (batches.empty()) {
+		return 0;
+	}
+
+	// -- SUBMIT --
+	std::vector<VkCommandBuffer> commandBuffers;
+	for (auto &batch : batches) {
+		commandBuffers.push_back(batch.second.commandBuffer);
+	}
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+	submitInfo.pCommandBuffers = commandBuffers.data();
+
+	uint64_t value = scheduler->submit(queue, submitInfo);
+
+	// each thread gets its batch back, to reuse once the timeline reaches the value
+	for (auto &batch : batches) {
+		batch.second.value = value;
+
+		std::lock_guard<std::mutex> lock(batch.first->mutex);
+		batch.first->inFlight.push_back(std::move(batch.second));
+	}
+
+	return value;
+}
+
+UploadManager::~UploadManager(){
+
+}
+
+UploadManager::ThreadContext * UploadManager::getThreadContext(){
+
+	std::lock_guard<std::mutex> lock(contextMutex);
+
+	auto found = threadContexts.find(std::this_thread::get_id());
+	if (found != threadContexts.end()) {
+		return found->second;
+	}
+
+	// first upload from this thread, it gets its own pool so recording never needs another thread's lock
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = queueFamilyIndex;
+
+	VkCommandPool commandPool;
+	if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create upload command pool");
+	}
+
+	contexts.push_back(std::make_unique<ThreadContext>());
+	ThreadContext * context = contexts.back().get();
+	context->commandPool = commandPool;
+	threadContexts[std::this_thread::get_id()] = context;
+
+	return context;
+}
+
+void UploadManager::reclaim(ThreadContext &context){
+
+	// batches finish in order, stop at the first one still running
+	while (!context.inFlight.empty() && scheduler->isComplete(context.inFlight.front().value)) {
+
+		Batch &batch = context.inFlight.front();
+		context.freeCommandBuffers.push_back(batch.commandBuffer);
+
+		// full size blocks are kept for the next batch, oversized ones were made for a single upload
+		for (auto &block : batch.blocks) {
+			if (block.size == stagingBlockSize) {
+				block.used = 0;
+				context.freeBlocks.push_back(std::move(block));
+			}
+			else
+			{
+				releaseBlock(block);
+			}
+		}
+
+		context.inFlight.pop_front();
+	}
+}
+
+UploadManager::StagingBlock &UploadManager::getStagingBlock(ThreadContext &context, VkDeviceSize size){
+
+	// keep filling the current block while the data fits
+	std::vector<StagingBlock> &blocks = context.recording.blocks;
+	if (!blocks.empty() && blocks.back().used + size <= blocks.back().size) {
+		return blocks.back();
+	}
+
+	if (size <= stagingBlockSize && !context.freeBlocks.empty()) {
+		blocks.push_back(std::move(context.freeBlocks.back()));
+		context.freeBlocks.pop_back();
+		return blocks.back();
+	}
+
+	// new block, persistently mapped while it exists
+	StagingBlock block;
+	block.size = std::max(size, stagingBlockSize);
+
+	VkBuffer buffer;
+	VkDeviceMemory memory;
+	createBuffer(physicalDevice, device, block.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &buffer, &memory, allocator);
+	block.memory = UniqueDeviceMemory(allocator, memory);
+	block.buffer = UniqueBuffer(device, buffer);
+
+	void * data;
+	vkMapMemory(device, memory, 0, block.size, 0, &data);
+	block.mapped = static_cast<uint8_t *>(data);
+
+	blocks.push_back(std::move(block));
+	return blocks.back();
+}
+
+VkDeviceSize UploadManager::stage(ThreadContext &context, const void * data, VkDeviceSize size, VkBuffer * stagingBuffer){
+
+	StagingBlock &block = getStagingBlock(context, size);
+	VkDeviceSize offset = block.used;
+	memcpy(block.mapped + offset, data, (size_t)size);
+	block.used = (offset + size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+	context.recording.stagedBytes += size;
+
+	*stagingBuffer = block.buffer.get();
+	return offset;
+}
+
+void UploadManager::recordImageCopies(Batch &batch){
+
+	if (batch.imageCopies.empty()) {
+		return;
+	}
+
+	// one barrier takes every level to TRANSFER_DST, one takes them all to their final layouts after the copies
+	std::vector<VkImageMemoryBarrier> barriers(batch.imageCopies.size());
+	for (size_t i = 0; i < batch.imageCopies.size(); i++) {
+
+		const ImageCopy &imageCopy = batch.imageCopies[i];
+
+		VkImageMemoryBarrier &barrier = barriers[i];
+		barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = imageCopy.image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = imageCopy.region.imageSubresource.mipLevel;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+	}
+
+	deviceDispatch.vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+	for (auto &imageCopy : batch.imageCopies) {
+		deviceDispatch.vkCmdCopyBufferToImage(batch.commandBuffer, imageCopy.stagingBuffer, imageCopy.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageCopy.region);
+	}
+
+	for (size_t i = 0; i < batch.imageCopies.size(); i++) {
+		barriers[i].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barriers[i].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+		barriers[i].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barriers[i].newLayout = batch.imageCopies[i].finalLayout;
+	}
+
+	deviceDispatch.vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+}
+
+void UploadManager::beginRecording(ThreadContext &context){
+
+	VkCommandBuffer commandBuffer;
+	if (!context.freeCommandBuffers.empty()) {
+		commandBuffer = context.freeCommandBuffers.back();
+		context.freeCommandBuffers.pop_back();
+	}
+	else
+	{
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = context.commandPool;
+		allocInfo.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate an upload command buffer");
+		}
+	}
+
+	// begin implicitly resets a reused command buffer
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (deviceDispatch.vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("failed to start recording an upload command buffer");
+	}
+
+	context.recording.commandBuffer = commandBuffer;
+}
+
+void UploadManager::releaseBlock(StagingBlock &block){
+
+	// unmapped before the memory goes back to the allocator to be recycled
+	if (block.mapped != nullptr) {
+		vkUnmapMemory(device, block.memory.get());
+		block.mapped = nullptr;
+	}
+	block.buffer.reset();
+	block.memory.reset();
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <mutex>
+
+#include "FrameScheduler.h"
+#include "VulkanHandles.h"
+#include "Profiler.h"
+#include "DeviceDispatch.h"
+
+// Uploads buffer and image data from any number of threads at once.
+// Every thread gets its own command pool and staging blocks, so recording copies never contends with
+// other threads. Nothing is submitted until flush, which sends every thread's copies to the queue in one
+// submission through the frame scheduler (the only place the queue is touched).
+// Image copies are held back until the flush, so every layout transition of a batch goes in one barrier before
+// its copies and one after them.
+// Staging blocks and command buffers are reused once the timeline passes the flush they were part of
+class UploadManager
+{
+public:
+	UploadManager();
+
+	void create(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, VkQueue newQueue, uint32_t newQueueFamilyIndex,
+		FrameScheduler * newScheduler, DeviceAllocator * newAllocator,
+		VkDeviceSize newStagingBlockSize = 4 * 1024 * 1024, VkDeviceSize newMaxStagedBytes = 64 * 1024 * 1024);
+	void destroy();
+
+	// copy data in to the buffer, which needs TRANSFER_DST usage. the data is staged before returning, the copy
+	// itself reaches the GPU with the next flush. a thread staging more than maxStagedBytes flushes by itself
+	void uploadBuffer(VkBuffer dstBuffer, const void * data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+
+	// copy tightly packed data in to one mip level of a color image, which needs TRANSFER_DST usage. the level is
+	// moved from undefined to finalLayout, and is visible to everything submitted after the flush
+	void uploadImage(VkImage dstImage, const void * data, VkDeviceSize size, uint32_t mipLevel, VkExtent2D extent, VkImageLayout finalLayout);
+
+	// record commands after this thread's copies and their transitions, in the same submission (e.g. mipmap generation)
+	void recordAfterCopies(std::function<void(VkCommandBuffer)> commands);
+
+	// submit the copies of every thread, returns the timeline value they signal (0 when there was nothing to submit).
+	// work submitted to the same queue afterwards sees the uploaded data without waiting on the value
+	uint64_t flush();
+
+	~UploadManager();
+
+private:
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	VkQueue queue = VK_NULL_HANDLE;
+	uint32_t queueFamilyIndex = 0;
+	FrameScheduler * scheduler = nullptr;
+	DeviceAllocator * allocator = nullptr;
+
+	VkDeviceSize stagingBlockSize = 0;
+	VkDeviceSize maxStagedBytes = 0;
+
+	// - Staging
+	struct StagingBlock {
+		UniqueDeviceMemory memory;
+		UniqueBuffer buffer;
+		uint8_t * mapped = nullptr;
+		VkDeviceSize size = 0;
+		VkDeviceSize used = 0;
+	};
+
+	// image copy waiting for the flush, the source is one of the batch's staging blocks
+	struct ImageCopy {
+		VkImage image;
+		VkBuffer stagingBuffer;
+		VkBufferImageCopy region;
+		VkImageLayout finalLayout;
+	};
+
+	// copies recorded by one thread and submitted together
+	struct Batch {
+		uint64_t value = 0;
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		std::vector<StagingBlock> blocks;
+		VkDeviceSize stagedBytes = 0;
+		std::vector<ImageCopy> imageCopies;
+		std::vector<std::function<void(VkCommandBuffer)>> afterCopies;
+	};
+
+	// - Per thread state, the mutex is only contended while a flush takes the recorded batch
+	struct ThreadContext {
+		std::mutex mutex;
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		Batch recording;								// command buffer stays null until the first copy after a flush
+		std::deque<Batch> inFlight;						// oldest first
+		std::vector<StagingBlock> freeBlocks;
+		std::vector<VkCommandBuffer> freeCommandBuffers;
+	};
+	std::mutex contextMutex;
+	std::vector<std::unique_ptr<ThreadContext>> contexts;
+	std::unordered_map<std::thread::id, ThreadContext *> threadContexts;
+
+	std::mutex flushMutex;
+
+	ThreadContext * getThreadContext();
+	void reclaim(ThreadContext &context);
+	StagingBlock &getStagingBlock(ThreadContext &context, VkDeviceSize size);
+	VkDeviceSize stage(ThreadContext &context, const void * data, VkDeviceSize size, VkBuffer * stagingBuffer);
+	void recordImageCopies(Batch &batch);
+	void beginRecording(ThreadContext &context);
+	void releaseBlock(StagingBlock &block);
+};
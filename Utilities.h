@@ -1,178 +1,315 @@
-#pragma once
-
-#include <fstream>
-
-#define GLFW_INCLUDE_VULKAN
-#include <GLFW/glfw3.h>
-#include <GLM/glm.hpp>
-
-const int MAX_FRAME_DRAWS = 2;
-
-const std::vector<const char *> deviceExtensions = {
-	VK_KHR_SWAPCHAIN_EXTENSION_NAME
-};
-
-// vertex data representation
-struct Vertex {
-	glm::vec3 pos; // vertex position (x, y, z)
-	glm::vec3 col; // vertex color (r, g, b)
-};
-
-// Indices (locations) of queue families (if they exist at all)
-struct QueueFamilyIndices {
-	int graphicsFamily = -1;			// location of graphics queue family
-	int presentationFamily = -1;		// location of presentation queue family
-
-	// check if queue families are valid
-	bool isValid() {
-		return graphicsFamily >= 0 && presentationFamily >= 0;
-	}
-};
-
-
-struct SwapChainDetails {
-	VkSurfaceCapabilitiesKHR surfaceCapabilities;		// Surface properties, example image size/extent
-	std::vector<VkSurfaceFormatKHR> formats;			// Surface image formats it can support, example RGBA and size of each color
-	std::vector<VkPresentModeKHR> presentationModes;		// how images should be presented to screen
-
-};
-
-struct SwapChainImage {
-	VkImage image;
-	VkImageView imageView;
-};
-
-static std::vector<char> readFile(const std::string &filename) {
-	// open stream from given file
-	// std::ios::binary tells streamt o read file as binary
-	// std::ios::ate tells stream to start reading from end of file
-	std::ifstream file(filename, std::ios::binary | std::ios::ate);
-
-	// check if file stream successfully opened
-	if (!file.is_open()) {
-		throw std::runtime_error("failed to open a file");
-	}
-
-	// get current read position and use to resize file buffer
-	size_t fileSize = (size_t)file.tellg();
-	std::vector<char> fileBuffer(fileSize);
-
-	// move read position (seek to) start of the file
-	file.seekg(0);
-
-	// read the file data into the buffer 
-	file.read(fileBuffer.data(),fileSize);
-
-	// close stream
-	file.close();
-
-	return fileBuffer;
-}
-
-static uint32_t findMemoryTypeIndex(VkPhysicalDevice physicalDevice ,uint32_t allowedTypes, VkMemoryPropertyFlags properties)
-{
-	// get properties of physical device memory
-	VkPhysicalDeviceMemoryProperties memoryProperties;
-	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
-
-	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
-	{
-		if ((allowedTypes & (1 << i))														// index of memory type must match corresponding bit in allowedTypes
-			&& (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)	// desired property bit flags are part of memory type's property flags
-		{
-			// this memory type is valid, so return its index
-			return i;
-		}
-	}
-}
-
-
-static void createBuffer(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize bufferSize, VkBufferUsageFlags bufferUsage, VkMemoryPropertyFlags bufferPorperties, VkBuffer * buffer, VkDeviceMemory * bufferMemory ) {
-
-	// CREATE VERTEX BUFFER
-// information to create a buffer (doesn't include assigning memory)
-	VkBufferCreateInfo bufferInfo = {};
-	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	bufferInfo.size = bufferSize;								// size of buffer (size of 1 vertex * number of vertices)
-	bufferInfo.usage = bufferUsage;								// multiple types of buffer possible, we want Vertex Buffer
-	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;			// similar to Swap Chain images, can share vertex buffers
-
-	VkResult result = vkCreateBuffer(device, &bufferInfo, nullptr, buffer);
-	if (result != VK_SUCCESS)
-	{
-		throw std::runtime_error("Failed to create a Vertex Buffer!");
-	}
-
-	// GET BUFFER MEMORY REQUIREMENTS
-	VkMemoryRequirements memRequirements;
-	vkGetBufferMemoryRequirements(device, *buffer, &memRequirements);
-
-	// ALLOCATE MEMORY TO BUFFER
-	VkMemoryAllocateInfo memoryAllocInfo = {};
-	memoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memoryAllocInfo.allocationSize = memRequirements.size;
-	memoryAllocInfo.memoryTypeIndex = findMemoryTypeIndex(physicalDevice ,memRequirements.memoryTypeBits,		// index of memory type on Physical Device that has required bit flags
-		bufferPorperties);																				// VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT	: CPU can interact with memory
-																										// VK_MEMORY_PROPERTY_HOST_COHERENT_BIT	: Allows placement of data straight into buffer after mapping (otherwise would have to specify manually)
-	// allocate memory to VkDeviceMemory
-	result = vkAllocateMemory(device, &memoryAllocInfo, nullptr, bufferMemory);
-	if (result != VK_SUCCESS)
-	{
-		throw std::runtime_error("Failed to allocate Vertex Buffer Memory!");
-	}
-
-	// allocate memory to given vertex buffer
-	vkBindBufferMemory(device, *buffer , *bufferMemory, 0);
-
-}
-
-static void copyBuffer(VkDevice device, VkQueue transferQueue, VkCommandPool transferCommandPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize bufferSize) {
-
-	// command buffer to hold transfer commands
-	VkCommandBuffer transferCommandBuffer;
-
-	// command buffer details
-	VkCommandBufferAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocInfo.commandPool = transferCommandPool;
-	allocInfo.commandBufferCount = 1;
-
-	// allocate command buffer from pool
-
-	vkAllocateCommandBuffers(device, &allocInfo, &transferCommandBuffer);
-	
-	
-	// info to begin the command buffer record
-	VkCommandBufferBeginInfo beginInfo = {};
-	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-	// begin transfer commands
-	vkBeginCommandBuffer(transferCommandBuffer, &beginInfo);
-
-	// region of data to copy from and to
-	VkBufferCopy bufferCopyRegion = {};
-	bufferCopyRegion.srcOffset = 0;
-	bufferCopyRegion.dstOffset = 0;
-	bufferCopyRegion.size = bufferSize;
-
-	// command to copy src buffer to dst buffer
-	vkCmdCopyBuffer(transferCommandBuffer, srcBuffer, dstBuffer, 1, &bufferCopyRegion);
-
-	// end command
-	vkEndCommandBuffer(transferCommandBuffer);
-
-	// Queue submission information
-	VkSubmitInfo submitInfo = {};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &transferCommandBuffer;
-
-	// submit transfer command to transfer queue and wait until it finishes
-	vkQueueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE);
-	vkQueueWaitIdle(transferQueue);
-
-	// free temporary command buffer back to pool
-	vkFreeCommandBuffers(device, transferCommandPool, 1, &transferCommandBuffer);
+#pragma once
+
+#include <fstream>
+#include <algorithm>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <GLM/glm.hpp>
+
+#include "FrameScheduler.h"
+#include "DeviceAllocator.h"
+#include "VulkanHandles.h"
+
+const int MAX_FRAME_DRAWS = 2;
+
+const std::vector<const char *> deviceExtensions = {
+	VK_KHR_SWAPCHAIN_EXTENSION_NAME
+};
+
+// used when available, devices with more of them score higher
+const std::vector<const char *> optionalDeviceExtensions = {
+	VK_EXT_MESH_SHADER_EXTENSION_NAME,
+	VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+	VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME,
+	VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME
+};
+
+// vertex data representation
+struct Vertex {
+	glm::vec3 pos; // vertex position (x, y, z)
+	glm::vec3 col; // vertex color (r, g, b)
+	glm::vec2 tex; // texture coordinates (u, v)
+};
+
+// particle as the compute shaders store it (std430) and the particle pipeline reads it per instance
+struct Particle {
+	glm::vec3 position;		// clip space, like the scene's vertices
+	float life;				// seconds left, gone at 0
+	glm::vec3 velocity;
+	uint32_t color;			// RGBA8
+};
+
+// debug line and triangle vertex, read with the scene root's model matrix like the scene's vertices
+struct DebugVertex {
+	glm::vec3 position;
+	uint32_t color;			// RGBA8
+};
+
+// Indices (locations) of queue families (if they exist at all)
+struct QueueFamilyIndices {
+	int graphicsFamily = -1;			// location of graphics queue family
+	int presentationFamily = -1;		// location of presentation queue family
+	int computeFamily = -1;				// compute without graphics for async compute, the graphics family if there's none
+
+	// check if queue families are valid
+	bool isValid() {
+		return graphicsFamily >= 0 && presentationFamily >= 0;
+	}
+};
+
+
+struct SwapChainDetails {
+	VkSurfaceCapabilitiesKHR surfaceCapabilities;		// Surface properties, example image size/extent
+	std::vector<VkSurfaceFormatKHR> formats;			// Surface image formats it can support, example RGBA and size of each color
+	std::vector<VkPresentModeKHR> presentationModes;		// how images should be presented to screen
+
+};
+
+struct SwapChainImage {
+	VkImage image;
+	VkImageView imageView;
+};
+
+// RGBA8 in memory order, as read by a VK_FORMAT_R8G8B8A8_UNORM attribute
+static uint32_t packColor(const glm::vec4 &color)
+{
+	uint32_t packed = 0;
+	for (int i = 0; i < 4; i++) {
+		float channel = std::min(std::max(color[i], 0.0f), 1.0f);
+		packed |= static_cast<uint32_t>(channel * 255.0f + 0.5f) << (8 * i);
+	}
+	return packed;
+}
+
+// probe for a memory type, false if the device has none with the properties
+static bool findMemoryTypeIndex(VkPhysicalDevice physicalDevice, uint32_t allowedTypes, VkMemoryPropertyFlags properties, uint32_t * memoryTypeIndex)
+{
+	// get properties of physical device memory
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		if ((allowedTypes & (1 << i))														// index of memory type must match corresponding bit in allowedTypes
+			&& (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)	// desired property bit flags are part of memory type's property flags
+		{
+			// this memory type is valid, so return its index
+			*memoryTypeIndex = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static uint32_t findMemoryTypeIndex(VkPhysicalDevice physicalDevice ,uint32_t allowedTypes, VkMemoryPropertyFlags properties)
+{
+	uint32_t memoryTypeIndex;
+	if (!findMemoryTypeIndex(physicalDevice, allowedTypes, properties, &memoryTypeIndex)) {
+		throw std::runtime_error("failed to find a suitable memory type");
+	}
+	return memoryTypeIndex;
+}
+
+
+static void createBuffer(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize bufferSize, VkBufferUsageFlags bufferUsage, VkMemoryPropertyFlags bufferPorperties, VkBuffer * buffer, VkDeviceMemory * bufferMemory, DeviceAllocator * allocator = nullptr,
+	const std::vector<uint32_t> &queueFamilies = {}) {
+
+	// CREATE VERTEX BUFFER
+// information to create a buffer (doesn't include assigning memory)
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = bufferSize;								// size of buffer (size of 1 vertex * number of vertices)
+	bufferInfo.usage = bufferUsage;								// multiple types of buffer possible, we want Vertex Buffer
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;			// similar to Swap Chain images, can share vertex buffers
+
+	// used on more than one queue family without ownership transfers
+	if (queueFamilies.size() > 1) {
+		bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+		bufferInfo.pQueueFamilyIndices = queueFamilies.data();
+	}
+
+	VkResult result = vkCreateBuffer(device, &bufferInfo, nullptr, buffer);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Vertex Buffer!");
+	}
+
+	// destroyed again if there's no memory for it, the caller only owns it once it is bound
+	UniqueBuffer ownedBuffer(device, *buffer);
+
+	// GET BUFFER MEMORY REQUIREMENTS
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(device, *buffer, &memRequirements);
+
+	// ALLOCATE MEMORY TO BUFFER
+	if (allocator != nullptr) {
+		// allocator may hand back a recycled block instead of allocating new memory
+		*bufferMemory = allocator->allocate(memRequirements, bufferPorperties);
+		vkBindBufferMemory(device, *buffer, *bufferMemory, 0);
+		ownedBuffer.release();
+		return;
+	}
+
+	VkMemoryAllocateInfo memoryAllocInfo = {};
+	memoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memoryAllocInfo.allocationSize = memRequirements.size;
+	memoryAllocInfo.memoryTypeIndex = findMemoryTypeIndex(physicalDevice ,memRequirements.memoryTypeBits,		// index of memory type on Physical Device that has required bit flags
+		bufferPorperties);																				// VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT	: CPU can interact with memory
+																										// VK_MEMORY_PROPERTY_HOST_COHERENT_BIT	: Allows placement of data straight into buffer after mapping (otherwise would have to specify manually)
+	// allocate memory to VkDeviceMemory
+	result = vkAllocateMemory(device, &memoryAllocInfo, nullptr, bufferMemory);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate Vertex Buffer Memory!");
+	}
+
+	// allocate memory to given vertex buffer
+	vkBindBufferMemory(device, *buffer , *bufferMemory, 0);
+	ownedBuffer.release();
+
+}
+
+static void copyBuffer(VkDevice device, VkQueue transferQueue, VkCommandPool transferCommandPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize bufferSize, FrameScheduler * scheduler = nullptr) {
+
+	// command buffer to hold transfer commands
+	VkCommandBuffer transferCommandBuffer;
+
+	// command buffer details
+	VkCommandBufferAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandPool = transferCommandPool;
+	allocInfo.commandBufferCount = 1;
+
+	// allocate command buffer from pool
+
+	vkAllocateCommandBuffers(device, &allocInfo, &transferCommandBuffer);
+	
+	
+	// info to begin the command buffer record
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	// begin transfer commands
+	vkBeginCommandBuffer(transferCommandBuffer, &beginInfo);
+
+	// region of data to copy from and to
+	VkBufferCopy bufferCopyRegion = {};
+	bufferCopyRegion.srcOffset = 0;
+	bufferCopyRegion.dstOffset = 0;
+	bufferCopyRegion.size = bufferSize;
+
+	// command to copy src buffer to dst buffer
+	vkCmdCopyBuffer(transferCommandBuffer, srcBuffer, dstBuffer, 1, &bufferCopyRegion);
+
+	// end command
+	vkEndCommandBuffer(transferCommandBuffer);
+
+	// Queue submission information
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &transferCommandBuffer;
+
+	// submit transfer command to transfer queue and wait until it finishes
+	if (scheduler != nullptr) {
+		// only wait for this upload's timeline value, frames already in flight on the queue keep running
+		scheduler->wait(scheduler->submit(transferQueue, submitInfo));
+	}
+	else
+	{
+		vkQueueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE);
+		vkQueueWaitIdle(transferQueue);
+	}
+
+	// free temporary command buffer back to pool
+	vkFreeCommandBuffers(device, transferCommandPool, 1, &transferCommandBuffer);
+}
+static void createImage(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage * image, VkDeviceMemory * imageMemory, DeviceAllocator * allocator = nullptr) {
+
+	// CREATE IMAGE
+	VkImageCreateInfo imageCreateInfo = {};
+	imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;						// type of image (1D, 2D or 3D)
+	imageCreateInfo.extent.width = width;								// width of image extent
+	imageCreateInfo.extent.height = height;								// height of image extent
+	imageCreateInfo.extent.depth = 1;									// depth of image (just 1, no 3D aspect)
+	imageCreateInfo.mipLevels = mipLevels;								// number of mipmap levels
+	imageCreateInfo.arrayLayers = 1;									// number of levels in image array
+	imageCreateInfo.format = format;									// format type of image
+	imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;					// how image data should be "tiled" (arranged for optimal reading)
+	imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;			// layout of image data on creation
+	imageCreateInfo.usage = usage;										// bit flags defining what image will be used for
+	imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;					// number of samples for multi-sampling
+	imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;			// whether image can be shared between queues
+
+	VkResult result = vkCreateImage(device, &imageCreateInfo, nullptr, image);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create an Image!");
+	}
+
+	// destroyed again if there's no memory for it, as with buffers
+	UniqueImage ownedImage(device, *image);
+
+	// GET IMAGE MEMORY REQUIREMENTS
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(device, *image, &memRequirements);
+
+	// ALLOCATE MEMORY TO IMAGE
+	if (allocator != nullptr) {
+		*imageMemory = allocator->allocate(memRequirements, properties);
+		vkBindImageMemory(device, *image, *imageMemory, 0);
+		ownedImage.release();
+		return;
+	}
+
+	VkMemoryAllocateInfo memoryAllocInfo = {};
+	memoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memoryAllocInfo.allocationSize = memRequirements.size;
+	memoryAllocInfo.memoryTypeIndex = findMemoryTypeIndex(physicalDevice, memRequirements.memoryTypeBits, properties);
+
+	result = vkAllocateMemory(device, &memoryAllocInfo, nullptr, imageMemory);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate memory for image!");
+	}
+
+	// connect memory to image
+	vkBindImageMemory(device, *image, *imageMemory, 0);
+	ownedImage.release();
+}
+
+static VkImageView createImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectflags, uint32_t baseMipLevel = 0, uint32_t levelCount = 1) {
+
+	VkImageViewCreateInfo viewCreateInfo = {};
+	viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewCreateInfo.image = image;									// image to create view for
+	viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;				// type of image 
+	viewCreateInfo.format = format;									// format of image data
+	viewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;	// allows remapping of rgba components to other rgba values
+	viewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+	viewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+	viewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+
+	// subresources allow the view to view only a part of an image
+	viewCreateInfo.subresourceRange.aspectMask = aspectflags;		// which aspect of image to view (example COLOR_BIT for viewing color)
+	viewCreateInfo.subresourceRange.baseMipLevel = baseMipLevel;	// start mipmap level to view from
+	viewCreateInfo.subresourceRange.levelCount = levelCount;		// number of mipmap levels to view
+	viewCreateInfo.subresourceRange.baseArrayLayer = 0;				// start array level to view from
+	viewCreateInfo.subresourceRange.layerCount = 1;					// number of array levels to view
+
+	// create image view and return it
+	VkImageView imageView;
+	VkResult result = vkCreateImageView(device, &viewCreateInfo, nullptr, &imageView);
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create an image view!");
+	}
+
+	return imageView;
 }
\ No newline at end of file
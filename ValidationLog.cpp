@@ -0,0 +1,304 @@
+#include "ValidationLog.h"
+
+#if VULKAN_VALIDATION_ENABLED
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+namespace {
+
+	// repeat counts are printed this often, and messages queued past this many are dropped (the writer is stuck)
+	const std::chrono::seconds REPEAT_REPORT_INTERVAL(5);
+	const size_t MAX_QUEUED_MESSAGES = 4096;
+
+	// distinct messages remembered for deduplication, the least recently seen is forgotten (and its count printed)
+	const size_t MAX_SEEN_MESSAGES = 4096;
+
+	// the same problem on different objects differs only in handles and addresses, which are all 0x hex
+	std::string stripHandles(const char * message) {
+
+		std::string stripped;
+		for (const char * c = message; *c != '\0'; c++) {
+			if (c[0] == '0' && (c[1] == 'x' || c[1] == 'X') && isxdigit(static_cast<unsigned char>(c[2]))) {
+				stripped += "0x";
+				c += 2;
+				while (isxdigit(static_cast<unsigned char>(c[1]))) {
+					c++;
+				}
+				continue;
+			}
+			stripped += *c;
+		}
+		return stripped;
+	}
+}
+
+ValidationLog::ValidationLog()
+{
+}
+
+void ValidationLog::create(VkDebugUtilsMessageSeverityFlagBitsEXT newMinSeverity, const std::vector<std::string> &newIgnoredIds, uint32_t newMaxPerSecond){
+
+	minSeverity = newMinSeverity;
+	ignoredIds = newIgnoredIds;
+	maxPerSecond = newMaxPerSecond;
+
+	rateWindowStart = std::chrono::steady_clock::now();
+	rateWindowCount = 0;
+	droppedCount = 0;
+
+	stopping = false;
+	writer = std::thread(&ValidationLog::writerLoop, this);
+}
+
+void ValidationLog::destroy(){
+
+	if (!writer.joinable()) {
+		return;
+	}
+
+	// the writer prints everything already queued before stopping
+	{
+		std::lock_guard<std::mutex> lock(messageMutex);
+		stopping = true;
+	}
+	writerCondition.notify_one();
+	writer.join();
+
+	// and the repeats since it last reported
+	for (const auto &summary : takeRepeatSummaries(true)) {
+		fputs(summary.c_str(), stderr);
+	}
+	fflush(stderr);
+
+	seenMessages.clear();
+	seenOrder.clear();
+}
+
+VkDebugUtilsMessageSeverityFlagsEXT ValidationLog::getSeverityMask(){
+
+	// severity bits go up in order, so everything from the minimum up is the bits at or above it
+	VkDebugUtilsMessageSeverityFlagsEXT mask = 0;
+	VkDebugUtilsMessageSeverityFlagBitsEXT severities[] = { VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT, VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT,
+		VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT, VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT };
+	for (auto severity : severities) {
+		if (severity >= minSeverity) {
+			mask |= severity;
+		}
+	}
+	return mask;
+}
+
+VKAPI_ATTR VkBool32 VKAPI_CALL ValidationLog::callback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType,
+	const VkDebugUtilsMessengerCallbackDataEXT * callbackData, void * userData){
+
+	(void)messageType;
+	static_cast<ValidationLog *>(userData)->submit(messageSeverity, callbackData);
+
+	// the call that triggered the message isn't aborted
+	return VK_FALSE;
+}
+
+VkDebugUtilsMessageSeverityFlagBitsEXT ValidationLog::parseSeverity(const char * text, VkDebugUtilsMessageSeverityFlagBitsEXT fallback){
+
+	if (text == nullptr) {
+		return fallback;
+	}
+	if (strcmp(text, "verbose") == 0) {
+		return VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
+	}
+	if (strcmp(text, "info") == 0) {
+		return VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT;
+	}
+	if (strcmp(text, "warning") == 0) {
+		return VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+	}
+	if (strcmp(text, "error") == 0) {
+		return VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+	}
+	return fallback;
+}
+
+std::vector<std::string> ValidationLog::parseList(const char * text){
+
+	std::vector<std::string> entries;
+	if (text == nullptr) {
+		return entries;
+	}
+
+	std::string entry;
+	for (const char * c = text; ; c++) {
+		if (*c == ',' || *c == '\0') {
+			if (!entry.empty()) {
+				entries.push_back(entry);
+			}
+			entry.clear();
+			if (*c == '\0') {
+				break;
+			}
+		}
+		else if (*c != ' ')
+		{
+			entry += *c;
+		}
+	}
+	return entries;
+}
+
+ValidationLog::~ValidationLog()
+{
+}
+
+void ValidationLog::submit(VkDebugUtilsMessageSeverityFlagBitsEXT severity, const VkDebugUtilsMessengerCallbackDataEXT * callbackData){
+
+	if (severity < minSeverity || isIgnored(callbackData)) {
+		return;
+	}
+
+	const char * idName = callbackData->pMessageIdName != nullptr ? callbackData->pMessageIdName : "";
+	const char * message = callbackData->pMessage != nullptr ? callbackData->pMessage : "";
+
+	std::string text = std::string(getSeverityName(severity)) + " " + idName;
+	std::string key = std::to_string(callbackData->messageIdNumber) + " " + stripHandles(message);
+
+	{
+		std::lock_guard<std::mutex> lock(messageMutex);
+
+		// -- DEDUPLICATE --
+		auto seen = seenMessages.find(key);
+		if (seen != seenMessages.end()) {
+			seen->second.count++;
+			seenOrder.splice(seenOrder.begin(), seenOrder, seen->second.age);
+			return;
+		}
+
+		// -- RATE LIMIT --
+		auto now = std::chrono::steady_clock::now();
+		if (now - rateWindowStart >= std::chrono::seconds(1)) {
+			rateWindowStart = now;
+			rateWindowCount = 0;
+		}
+		bool isError = severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+		if ((!isError && rateWindowCount >= maxPerSecond) || writerQueue.size() >= MAX_QUEUED_MESSAGES) {
+			droppedCount++;
+			return;
+		}
+		rateWindowCount++;
+
+		// forget the least recently seen message, what it repeated since the last report is printed first
+		if (seenMessages.size() >= MAX_SEEN_MESSAGES) {
+			auto oldest = seenMessages.find(seenOrder.back());
+			if (oldest->second.count > oldest->second.reported) {
+				writerQueue.push_back(getRepeatSummary(oldest->second, false));
+			}
+			seenMessages.erase(oldest);
+			seenOrder.pop_back();
+		}
+
+		seenOrder.push_front(key);
+		Repeat repeat;
+		repeat.summary = text;
+		repeat.age = seenOrder.begin();
+		seenMessages.emplace(key, repeat);
+
+		writerQueue.push_back("validation " + text + ": " + message + "\n");
+	}
+	writerCondition.notify_one();
+}
+
+bool ValidationLog::isIgnored(const VkDebugUtilsMessengerCallbackDataEXT * callbackData){
+
+	for (const auto &id : ignoredIds) {
+		if (callbackData->pMessageIdName != nullptr && id == callbackData->pMessageIdName) {
+			return true;
+		}
+
+		// numbers are compared as the signed 32 bit IDs the layer reports, so hex IDs above 0x7fffffff work too
+		char * end = nullptr;
+		long long number = strtoll(id.c_str(), &end, 0);
+		if (end != id.c_str() && *end == '\0' && static_cast<int32_t>(static_cast<uint32_t>(number)) == callbackData->messageIdNumber) {
+			return true;
+		}
+	}
+	return false;
+}
+
+std::vector<std::string> ValidationLog::takeRepeatSummaries(bool final){
+
+	std::vector<std::string> summaries;
+
+	for (auto &seen : seenMessages) {
+		Repeat &repeat = seen.second;
+		if (repeat.count > repeat.reported) {
+			summaries.push_back(getRepeatSummary(repeat, final));
+		}
+	}
+	if (droppedCount > 0) {
+		summaries.push_back("validation: " + std::to_string(droppedCount) + " messages dropped over the rate limit\n");
+		droppedCount = 0;
+	}
+	return summaries;
+}
+
+std::string ValidationLog::getRepeatSummary(Repeat &repeat, bool final){
+
+	repeat.reported = repeat.count;
+	return "validation " + repeat.summary + ": repeated " + std::to_string(repeat.count) + " times" + (final ? " in total\n" : " so far\n");
+}
+
+void ValidationLog::writerLoop(){
+
+	auto lastReport = std::chrono::steady_clock::now();
+
+	while (true) {
+
+		std::deque<std::string> messages;
+		std::vector<std::string> summaries;
+		bool stop;
+		{
+			std::unique_lock<std::mutex> lock(messageMutex);
+			writerCondition.wait_for(lock, REPEAT_REPORT_INTERVAL, [this]() { return stopping || !writerQueue.empty(); });
+
+			messages.swap(writerQueue);
+			stop = stopping;
+
+			if (std::chrono::steady_clock::now() - lastReport >= REPEAT_REPORT_INTERVAL) {
+				summaries = takeRepeatSummaries(false);
+				lastReport = std::chrono::steady_clock::now();
+			}
+		}
+
+		// printed outside the lock with one flush a batch, the callback never waits on stderr
+		for (const auto &message : messages) {
+			fputs(message.c_str(), stderr);
+		}
+		for (const auto &summary : summaries) {
+			fputs(summary.c_str(), stderr);
+		}
+		if (!messages.empty() || !summaries.empty()) {
+			fflush(stderr);
+		}
+
+		if (stop) {
+			return;
+		}
+	}
+}
+
+const char * ValidationLog::getSeverityName(VkDebugUtilsMessageSeverityFlagBitsEXT severity){
+
+	if (severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
+		return "error";
+	}
+	if (severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
+		return "warning";
+	}
+	if (severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT) {
+		return "info";
+	}
+	return "verbose";
+}
+
+#endif // VULKAN_VALIDATION_ENABLED
@@ -0,0 +1,88 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "VulkanValidation.h"
+
+#if VULKAN_VALIDATION_ENABLED
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// Sink for debug messenger messages. The callback only filters and queues, a writer thread does the printing,
+// so a layer reporting the same problem every draw doesn't stall the thread that made the call:
+// - messages below the minimum severity aren't even sent by the layer (see getSeverityMask)
+// - messages whose ID name or number is ignored are dropped
+// - a message with the ID and text of one already printed, apart from handles and addresses, is only counted.
+//   the counts are printed every few seconds, and only the most recently seen few thousand messages are remembered
+// - past maxPerSecond new messages in a second the rest are dropped and counted, errors are never dropped
+// The whole class only exists in builds with VULKAN_VALIDATION_ENABLED
+class ValidationLog
+{
+public:
+	ValidationLog();
+
+	// ignoredIds holds message ID names (e.g. "UNASSIGNED-BestPractices-vkCreateDevice") or numbers (decimal or 0x hex)
+	void create(VkDebugUtilsMessageSeverityFlagBitsEXT newMinSeverity, const std::vector<std::string> &newIgnoredIds, uint32_t newMaxPerSecond = 20);
+	// prints what is still queued and the final repeat counts
+	void destroy();
+
+	// severities for the messenger's create info, everything from the minimum up
+	VkDebugUtilsMessageSeverityFlagsEXT getSeverityMask();
+
+	// messenger callback, pUserData must be the log
+	static VKAPI_ATTR VkBool32 VKAPI_CALL callback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType,
+		const VkDebugUtilsMessengerCallbackDataEXT * callbackData, void * userData);
+
+	// - Settings, e.g. from environment variables
+	// "verbose", "info", "warning" or "error", anything else is fallback
+	static VkDebugUtilsMessageSeverityFlagBitsEXT parseSeverity(const char * text, VkDebugUtilsMessageSeverityFlagBitsEXT fallback);
+	// comma separated, empty entries skipped
+	static std::vector<std::string> parseList(const char * text);
+
+	~ValidationLog();
+
+private:
+	VkDebugUtilsMessageSeverityFlagBitsEXT minSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+	std::vector<std::string> ignoredIds;
+	uint32_t maxPerSecond = 0;
+
+	// - Filtering, under messageMutex
+	std::mutex messageMutex;
+	struct Repeat {
+		std::string summary;			// severity and ID of the message
+		uint64_t count = 0;				// times seen after the first
+		uint64_t reported = 0;			// count last printed
+		std::list<std::string>::iterator age;	// in seenOrder
+	};
+	std::unordered_map<std::string, Repeat> seenMessages;	// by ID number and text without handles
+	std::list<std::string> seenOrder;						// their keys, most recently seen first
+	std::chrono::steady_clock::time_point rateWindowStart;
+	uint32_t rateWindowCount = 0;
+	uint64_t droppedCount = 0;							// over the rate limit, since last printed
+
+	// - Writer thread
+	std::thread writer;
+	std::condition_variable writerCondition;
+	std::deque<std::string> writerQueue;
+	bool stopping = false;
+
+	void submit(VkDebugUtilsMessageSeverityFlagBitsEXT severity, const VkDebugUtilsMessengerCallbackDataEXT * callbackData);
+	bool isIgnored(const VkDebugUtilsMessengerCallbackDataEXT * callbackData);
+	std::vector<std::string> takeRepeatSummaries(bool final);
+	std::string getRepeatSummary(Repeat &repeat, bool final);
+	void writerLoop();
+
+	static const char * getSeverityName(VkDebugUtilsMessageSeverityFlagBitsEXT severity);
+};
+
+#endif // VULKAN_VALIDATION_ENABLED
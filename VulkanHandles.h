@@ -0,0 +1,113 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <utility>
+
+#include "DeviceAllocator.h"
+
+// Move-only owner of a single Vulkan handle. Destroys the handle when it goes out of scope,
+// so objects holding these can be moved around (e.g. by vector growth) without copying
+// or double-destroying the raw handles
+template <typename Handle, typename Owner, void (*Destroy)(Owner, Handle)>
+class UniqueHandle
+{
+public:
+	UniqueHandle() {}
+	UniqueHandle(Owner newOwner, Handle newHandle) : owner(newOwner), handle(newHandle) {}
+
+	UniqueHandle(const UniqueHandle &) = delete;
+	UniqueHandle &operator=(const UniqueHandle &) = delete;
+
+	UniqueHandle(UniqueHandle &&other) noexcept : owner(other.owner), handle(other.release()) {}
+
+	UniqueHandle &operator=(UniqueHandle &&other) noexcept {
+		if (this != &other) {
+			reset();
+			owner = other.owner;
+			handle = other.release();
+		}
+		return *this;
+	}
+
+	Handle get() const { return handle; }
+	explicit operator bool() const { return handle != VK_NULL_HANDLE; }
+
+	// give up ownership without destroying (e.g. to hand the handle to the deletion queue)
+	Handle release() {
+		Handle released = handle;
+		handle = VK_NULL_HANDLE;
+		return released;
+	}
+
+	// destroy the owned handle now
+	void reset() {
+		if (handle != VK_NULL_HANDLE) {
+			Destroy(owner, handle);
+			handle = VK_NULL_HANDLE;
+		}
+	}
+
+	~UniqueHandle() {
+		reset();
+	}
+
+private:
+	Owner owner = Owner();
+	Handle handle = VK_NULL_HANDLE;
+};
+
+// -- DESTROY FUNCTIONS --
+inline void destroyBufferHandle(VkDevice device, VkBuffer buffer) {
+	vkDestroyBuffer(device, buffer, nullptr);
+}
+
+inline void freeMemoryHandle(DeviceAllocator * allocator, VkDeviceMemory memory) {
+	// memory goes back to the allocator it came from so it can be recycled
+	allocator->free(memory);
+}
+
+inline void destroyPipelineHandle(VkDevice device, VkPipeline pipeline) {
+	vkDestroyPipeline(device, pipeline, nullptr);
+}
+
+inline void destroyPipelineLayoutHandle(VkDevice device, VkPipelineLayout pipelineLayout) {
+	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+}
+
+inline void destroyImageHandle(VkDevice device, VkImage image) {
+	vkDestroyImage(device, image, nullptr);
+}
+
+inline void destroyImageViewHandle(VkDevice device, VkImageView imageView) {
+	vkDestroyImageView(device, imageView, nullptr);
+}
+
+inline void destroySamplerHandle(VkDevice device, VkSampler sampler) {
+	vkDestroySampler(device, sampler, nullptr);
+}
+
+inline void destroyDescriptorSetLayoutHandle(VkDevice device, VkDescriptorSetLayout descriptorSetLayout) {
+	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+}
+
+inline void destroyDescriptorPoolHandle(VkDevice device, VkDescriptorPool descriptorPool) {
+	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+}
+
+inline void destroyQueryPoolHandle(VkDevice device, VkQueryPool queryPool) {
+	vkDestroyQueryPool(device, queryPool, nullptr);
+}
+
+// -- HANDLE TYPES --
+using UniqueBuffer = UniqueHandle<VkBuffer, VkDevice, destroyBufferHandle>;
+using UniqueDeviceMemory = UniqueHandle<VkDeviceMemory, DeviceAllocator *, freeMemoryHandle>;
+using UniquePipeline = UniqueHandle<VkPipeline, VkDevice, destroyPipelineHandle>;
+using UniquePipelineLayout = UniqueHandle<VkPipelineLayout, VkDevice, destroyPipelineLayoutHandle>;
+using UniqueImage = UniqueHandle<VkImage, VkDevice, destroyImageHandle>;
+using UniqueImageView = UniqueHandle<VkImageView, VkDevice, destroyImageViewHandle>;
+using UniqueSampler = UniqueHandle<VkSampler, VkDevice, destroySamplerHandle>;
+using UniqueDescriptorSetLayout = UniqueHandle<VkDescriptorSetLayout, VkDevice, destroyDescriptorSetLayoutHandle>;
+using UniqueDescriptorPool = UniqueHandle<VkDescriptorPool, VkDevice, destroyDescriptorPoolHandle>;
+using UniqueQueryPool = UniqueHandle<VkQueryPool, VkDevice, destroyQueryPoolHandle>;
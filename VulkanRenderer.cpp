@@ -1,1164 +1,2150 @@
-#include "VulkanRenderer.h"
-
-#ifdef NDEBUG
-const bool enableValidationLayers = false;
-
-#else
-const bool enableValidationLayers = true;
-#endif // NDEBUG
-
-
-VulkanRenderer::VulkanRenderer()
-{
-}
-
-int VulkanRenderer::init(GLFWwindow * newWindow)
-{
-	window = newWindow;
-
-	try
-	{
-		createInstance();
-		createDebugMessenger();
-		createSurface();
-		getPhysicalDevice();
-		createLogicalDevice();
-		createSwapChain();
-		createRenderPass();
-		createGraphicsPipeline();
-		createFrameBuffers();
-		createCommandPool();
-
-		// create a mesh
-		// vertex data
-		std::vector<Vertex> meshVertices = {
-			{{-0.1, -0.4, 0.0}, {1.0f, 0.0f, 0.0f}},
-			{{-0.1, 0.4, 0.0}, {0.0f, 1.0f, 0.0f}},
-			{{-0.9, 0.4, 0.0}, {0.0f, 0.0f, 1.0f}},
-			{{-0.9, -0.4, 0.0}, {1.0f, 1.0f, 0.0f}},
-		};
-
-		std::vector<Vertex> meshVertices2 = {
-			{{0.9, -0.3, 0.0}, {1.0f, 0.0f, 0.0f}},
-			{{0.9, 0.1, 0.0}, {0.0f, 1.0f, 0.0f}},
-			{{0.1, 0.3, 0.0}, {0.0f, 0.0f, 1.0f}},
-			{{0.1, -0.1, 0.0}, {1.0f, 1.0f, 0.0f}},
-		};
-		// index data
-		std::vector<uint32_t> meshIndices = {
-			0,1,2,
-			2,3,0
-		};
-
-
-		Mesh firstMesh = Mesh(mainDevice.physicalDevice, mainDevice.logicalDevice, graphicsQueue, graphicsCommandPool, &meshVertices, &meshIndices);
-		Mesh secondMesh = Mesh(mainDevice.physicalDevice, mainDevice.logicalDevice, graphicsQueue, graphicsCommandPool, &meshVertices2, &meshIndices);
-
-		meshList.push_back(firstMesh);
-		meshList.push_back(secondMesh);
-
-		createCommandBuffers();
-		recordCommands();
-		createSynchronization();
-	}
-	catch (const std::runtime_error &e)
-	{
-		printf("ERROR: %s\n", e.what());
-		return EXIT_FAILURE;
-	}
-
-
-	return 0;
-}
-
-void VulkanRenderer::draw(){
-
-	// -- GET NEXT IMAGE --
-	// wait for given fence to signal (open) from last drawing call 
-	vkWaitForFences(mainDevice.logicalDevice, 1, &drawFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
-	// manually reset (close) fences
-	vkResetFences(mainDevice.logicalDevice, 1, &drawFences[currentFrame]);
-
-	// get index of next image to draw to and signal semaphore when read to draw to
-	uint32_t imageIndex;
-	vkAcquireNextImageKHR(mainDevice.logicalDevice, swapchain, std::numeric_limits<uint64_t>::max(), imageAvailable[currentFrame], VK_NULL_HANDLE, &imageIndex);
-
-	// -- SUBMIT COMMAND BUFFER TO RENDER --
-	// queue submission infomration
-	VkSubmitInfo submitInfo = {};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.waitSemaphoreCount = 1;								// number of semaphores to wait on
-	submitInfo.pWaitSemaphores = &imageAvailable[currentFrame];		// list of semaphores to wait on
-	VkPipelineStageFlags waitStages[] = {
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
-	};
-	submitInfo.pWaitDstStageMask = waitStages;						// stages to check semaphores at
-	submitInfo.commandBufferCount = 1;								// number of command buffers to submit
-	submitInfo.pCommandBuffers = &commandBuffers[imageIndex];		// command buffer to submit
-	submitInfo.signalSemaphoreCount = 1;							// number of semaphores to signal
-	submitInfo.pSignalSemaphores = &renderFinished[currentFrame];	// semaphores to signal when command buffer finishes
-	
-	// submit command buffer to queue
-	VkResult result = vkQueueSubmit(graphicsQueue, 1, &submitInfo, drawFences[currentFrame]);
-
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error("failed to submit command buffer to Queue");
-	}
-
-	// -- PRESENT RENDERED IMAGE TO SCREEN --
-	VkPresentInfoKHR presentInfo = {};
-	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-	presentInfo.waitSemaphoreCount = 1;								// number of semaphores to wait on
-	presentInfo.pWaitSemaphores = &renderFinished[currentFrame];	// semaphore to wait on
-	presentInfo.swapchainCount = 1;									// number of swapchains to present to
-	presentInfo.pSwapchains = &swapchain;							// swapcahins to present images to
-	presentInfo.pImageIndices = &imageIndex;						// index of images in swapchains to present
-
-	// present image
-	result = vkQueuePresentKHR(presentationQueue, &presentInfo);
-
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error("failed to present rendered image");
-	}
-	
-	// get next frame (use % MAX_FRAME_DRAWS to keep value below MAX_FRAME_DRAWS)
-	currentFrame = (currentFrame + 1) % MAX_FRAME_DRAWS;
-}
-
-void VulkanRenderer::cleanup()
-{
-	// wait until no actions being run on the device before destroying it
-	vkDeviceWaitIdle(mainDevice.logicalDevice);
-
-	for (size_t i = 0; i < meshList.size(); i++){
-		meshList[i].destroyBuffers();
-	}
-
-	for (size_t i = 0; i < MAX_FRAME_DRAWS; i++)
-	{
-		vkDestroySemaphore(mainDevice.logicalDevice, renderFinished[i], nullptr);
-		vkDestroySemaphore(mainDevice.logicalDevice, imageAvailable[i], nullptr);
-		vkDestroyFence(mainDevice.logicalDevice,drawFences[i],nullptr);
-	}
-	
-	vkDestroyCommandPool(mainDevice.logicalDevice, graphicsCommandPool, nullptr);
-	for (auto framebuffer : swapChainFrameBuffers) {
-		vkDestroyFramebuffer(mainDevice.logicalDevice, framebuffer, nullptr);
-	}
-
-	vkDestroyPipeline(mainDevice.logicalDevice, graphicsPipeline, nullptr);
-	vkDestroyPipelineLayout(mainDevice.logicalDevice, pipelineLayout, nullptr);
-	vkDestroyRenderPass(mainDevice.logicalDevice, renderPass, nullptr);
-	
-	for (auto image : swapChainImages) {
-		vkDestroyImageView(mainDevice.logicalDevice, image.imageView, nullptr);
-	}
-
-	vkDestroySwapchainKHR(mainDevice.logicalDevice, swapchain, nullptr);
-	vkDestroySurfaceKHR(instance, surface, nullptr);
-	vkDestroyDevice(mainDevice.logicalDevice, nullptr);
-	
-	if (enableValidationLayers) {
-		DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
-	}
-
-	vkDestroyInstance(instance, nullptr);
-}
-
-
-VulkanRenderer::~VulkanRenderer()
-{
-}
-
-void VulkanRenderer::createInstance()
-{
-
-	if (enableValidationLayers && !checkValidationLayerSupport()) {
-		throw std::runtime_error("validation layers requested but not available!");
-	}
-
-	// information about the application
-	// most data here does not affect the program and it is for dev convenience
-	VkApplicationInfo appInfo = {};
-	appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-	appInfo.pApplicationName = "Vulkan App x64";			// custom name of the application
-	appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);	// custom version of the application
-	appInfo.pEngineName = "No Engine";						// custom engine name
-	appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);		// custom engine version
-	appInfo.apiVersion = VK_API_VERSION_1_2;				// the vulkan version
-
-
-	// creation information for a VkInstance 
-	VkInstanceCreateInfo createInfo = {};
-	createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-	createInfo.pApplicationInfo = &appInfo;
-
-
-	// create list to hold instance extensions
-	std::vector<const char*> instanceExtensions = std::vector<const char*>();
-
-	// set up extensions instance will use
-	uint32_t glfwExtensionCount = 0;						// GLFW may require multiple extensions
-	const char** glfwExtensions;							// extesions passed as array of cstrings, so need pointer (array) to pointer (cstring)
-
-	// get GLFW extensions
-	glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-	// add GLFW extensions to list of extensions
-	for (size_t i = 0; i < glfwExtensionCount; i++) {
-
-		instanceExtensions.push_back(glfwExtensions[i]);
-	}
-
-	if (enableValidationLayers) {
-		instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-	}
-	// check instance extensions supported
-	if (!checkInstanceExtensionSupport(&instanceExtensions)) {
-		
-		throw std::runtime_error("VkInstance does not uspport required extensions!");
-	}
-
-	
-	createInfo.enabledExtensionCount = static_cast<uint32_t>(instanceExtensions.size());
-	createInfo.ppEnabledExtensionNames = instanceExtensions.data();
-	
-	//VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo{};
-
-	if (enableValidationLayers) {
-		createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
-		createInfo.ppEnabledLayerNames = validationLayers.data();
-
-		//populateDebugMEssengerCreateInfo(debugCreateInfo);
-		//createInfo.pNext = (VkDebugUtilsMessengerCreateFlagsEXT*)&debugCreateInfo;
-	}
-	else
-	{
-		createInfo.enabledLayerCount = 0;
-
-		createInfo.ppEnabledLayerNames = nullptr;
-	}
-
-	// create instance
-	VkResult result = vkCreateInstance(&createInfo, nullptr, &instance);
-
-	if (result != VK_SUCCESS) {
-		
-		throw std::runtime_error("failed to create a vulkan instance");
-	}
-
-}
-
-
-void VulkanRenderer::createDebugMessenger() {
-	if (!enableValidationLayers) return;
-
-	VkDebugUtilsMessengerCreateInfoEXT createInfo = {};
-	createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
-	createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
-	createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
-	createInfo.pfnUserCallback = debugCallback;
-	//populateDebugMEssengerCreateInfo(createInfo);
-
-	VkResult result = CreateDebugUtilsMessengerEXT(instance, &createInfo, nullptr, &debugMessenger);
-
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error("failed to set up debug messenger!");
-	}
-}
-
-void VulkanRenderer::createLogicalDevice()
-{
-	// get the queue family indices for the choosen physical device
-	QueueFamilyIndices indices = getQueueFamilies(mainDevice.physicalDevice);
-
-	// vector for queue creation information and set for family indices
-	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-	std::set<int> queueFamilyIndices = { indices.graphicsFamily, indices.presentationFamily };
-
-	// Queues the logica device needs to create and info to do so 
-	for (int queueFamilyIndex : queueFamilyIndices) {
-
-		VkDeviceQueueCreateInfo queueCreateInfo = {};
-		queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-		queueCreateInfo.queueFamilyIndex = queueFamilyIndex;				// the index of the family to create a queue from
-		queueCreateInfo.queueCount = 1;										// number of queues to create
-		float priority = 1.0f;
-		queueCreateInfo.pQueuePriorities = &priority;						// vulkan needs to know how to handle multiple queues, so decide prioriy (1 highest)
-	
-		queueCreateInfos.push_back(queueCreateInfo);
-	}
-
-	// information to create logical device (somestimes called "device")
-	VkDeviceCreateInfo deviceCreateInfo = {};
-	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-	deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());		// number of queue create infos
-	deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();								// list of queue create infos so device can create required queues
-	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());	// number of enabled logical device extensions
-	deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();							// list of enabled logical device extensions
-	
-	// physical device features the logical device will be using
-	VkPhysicalDeviceFeatures deviceFeatures = {};
-
-	deviceCreateInfo.pEnabledFeatures = &deviceFeatures;				// physical device features logical device will use
-
-	// create the logical device for the given physical device
-	VkResult result = vkCreateDevice(mainDevice.physicalDevice, &deviceCreateInfo, nullptr, &mainDevice.logicalDevice);
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error("Failed to create logical device");
-	 }
-
-	// Queues are created at the same time as the device
-	// so we want to hand the quees
-	// given logical device of given queue family of given queue index (0 since olny one queue) place reference in given queue
-	vkGetDeviceQueue(mainDevice.logicalDevice, indices.graphicsFamily, 0, &graphicsQueue);
-	vkGetDeviceQueue(mainDevice.logicalDevice, indices.presentationFamily, 0, &presentationQueue);
-}
-
-void VulkanRenderer::createSurface() {
-	// create Surface (creates a surface create info struct, runs the create surface function, returns VK result)
-	VkResult result = glfwCreateWindowSurface(instance, window, nullptr, &surface);
-	
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error("Failed to create a surface");
-	}
-
-}
-
-void VulkanRenderer::createSwapChain(){
-	// get swapchain details so we can pick best settings
-	SwapChainDetails swapChainDetails = getSwapChainDetails(mainDevice.physicalDevice);
-
-	// find optimal surface values for our swap chain
-	VkSurfaceFormatKHR surfaceFormat = chooseBestSurfaceFormat(swapChainDetails.formats);
-	VkPresentModeKHR presentMode = chooseBestPresentationMode(swapChainDetails.presentationModes);
-	VkExtent2D extent = chooseSwapExtent(swapChainDetails.surfaceCapabilities);
-
-	// how many images are in the swap chain? get 1 more than the minimum to allow triple buffering
-	uint32_t imageCount = swapChainDetails.surfaceCapabilities.minImageCount + 1;
-
-	// if adding one goes over maximum, make max our imageCount
-	// if 0 then limitless
-	if (swapChainDetails.surfaceCapabilities.maxImageCount > 0 && swapChainDetails.surfaceCapabilities.maxImageCount < imageCount) {
-		imageCount = swapChainDetails.surfaceCapabilities.maxImageCount;
-	}
-
-	// creation information for swapchain
-	VkSwapchainCreateInfoKHR swapChainCreateInfo = {};
-	swapChainCreateInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-	swapChainCreateInfo.surface = surface;														// swap chain surface
-	swapChainCreateInfo.imageFormat = surfaceFormat.format;										// swap chain format
-	swapChainCreateInfo.imageColorSpace = surfaceFormat.colorSpace;								// swap chain color space
-	swapChainCreateInfo.presentMode = presentMode;												// swap chain presentation mode
-	swapChainCreateInfo.imageExtent = extent;													// swap chain image extent
-	swapChainCreateInfo.minImageCount = imageCount;												// minimum images in swapchain
-	swapChainCreateInfo.imageArrayLayers = 1;													// number of layers for each image in chain
-	swapChainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;						// what attachment images will be used as
-	swapChainCreateInfo.preTransform = swapChainDetails.surfaceCapabilities.currentTransform;	// transform to perform on swap chain
-	swapChainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;						// how to handle blending images with external graphics
-	swapChainCreateInfo.clipped = VK_TRUE;														// whether to clip parts of image
-
-	// get queue family indices
-	QueueFamilyIndices indices = getQueueFamilies(mainDevice.physicalDevice);
-
-	// if graphics and presentation families are different, then swapchain must let images be shared between families
-
-	
-
-	if (indices.graphicsFamily != indices.presentationFamily) {
-
-		// queues to share between
-		uint32_t queueFamilyIndices[] = {
-			(uint32_t)indices.graphicsFamily,
-			(uint32_t)indices.presentationFamily
-		};
-
-		swapChainCreateInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;		// image share handling
-		swapChainCreateInfo.queueFamilyIndexCount = 2;							// number of ques to share images between
-		swapChainCreateInfo.pQueueFamilyIndices = queueFamilyIndices;			// array of queues to share between
-	}
-	else
-	{
-		swapChainCreateInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-		swapChainCreateInfo.queueFamilyIndexCount = 0;
-		swapChainCreateInfo.pQueueFamilyIndices = nullptr;
-	}
-
-	// if old swap chain been destroyed and this one replaces it, then link old one to quicly hand over responsibilities
-	swapChainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
-
-	// create swapchain
-
-	VkResult result = vkCreateSwapchainKHR(mainDevice.logicalDevice, &swapChainCreateInfo, nullptr, &swapchain);
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error("Failed to create a Swapchain!");
-	}
-
-	// store for later reference
-	swapChainImageFormat = surfaceFormat.format;
-	swapChainExtent = extent;
-
-	// get swapchain images (first count, then values)
-	uint32_t swapChainImageCount;
-	vkGetSwapchainImagesKHR(mainDevice.logicalDevice, swapchain, &swapChainImageCount, nullptr);
-
-	std::vector<VkImage> images(swapChainImageCount);
-	vkGetSwapchainImagesKHR(mainDevice.logicalDevice, swapchain, &swapChainImageCount, images.data());
-
-	for (VkImage image : images) {
-
-		// store image handle
-		SwapChainImage swapChainImage = {};
-		swapChainImage.image = image;
-		swapChainImage.imageView = createImageView(image, swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
-
-		// add to swapchain image list
-		swapChainImages.push_back(swapChainImage);
-	}
-}
-
-void VulkanRenderer::createRenderPass(){
-
-	// color attachment of render pass
-	VkAttachmentDescription colorAttachment = {};
-	colorAttachment.format = swapChainImageFormat;						// format to use for attachment
-	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;					// number of samples to write for multisampling 
-	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;				// describes what to do with attachment before rendering
-	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;				// describes what to do with attachment after rendering
-	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;	// describes what to do with stencil before rendering
-	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;	// describes what to do with stencil after rendering
-
-	// framebuffer data will be stored as an image, but images can be given different data layouts
-	// to give optimal use for certain operation
-	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;			// image data layout before render pass starts
-	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;		// image data layout after render pass (to change to)
-
-	// attachment reference uses an attachment index that refers to index in the attachment list passed to renderpasscreateinfo
-	VkAttachmentReference colorAttachmentReference = {};
-	colorAttachmentReference.attachment = 0;							// index of the attachment in the render pass
-	colorAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-	// information about a partiucular subpass the render pass is using
-	VkSubpassDescription subPass = {};
-	subPass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;		// pipeline type subpass is to be bound to
-	subPass.colorAttachmentCount = 1;
-	subPass.pColorAttachments = &colorAttachmentReference;
-
-	// need to determine when layout transitions occur using subpass dependencies
-	std::array<VkSubpassDependency, 2> subpassDependencies;
-
-	// conversion from VK_IMAGE_LAYOUT_UNDEFINED to VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-	// transition must happen after...
-	subpassDependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;						// subpass index (VK_SUBPASS_EXTERNAL = special value, meaning outside of render pass)
-	subpassDependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;		// pipeline stage
-	subpassDependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;				// stage access mask
-
-	// transition must happen before
-	subpassDependencies[0].dstSubpass = 0;
-	subpassDependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	subpassDependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	subpassDependencies[0].dependencyFlags = 0;
-
-	// conversion from VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL to VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
-	// transition must happen after...
-	subpassDependencies[1].srcSubpass = 0;							
-	subpassDependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;		
-	subpassDependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-	// but must happen before
-	subpassDependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-	subpassDependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	subpassDependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	subpassDependencies[1].dependencyFlags = 0;
-
-	// create info for render pass
-	VkRenderPassCreateInfo renderPassCreateInfo = {};
-	renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	renderPassCreateInfo.attachmentCount = 1;
-	renderPassCreateInfo.pAttachments = &colorAttachment;
-	renderPassCreateInfo.subpassCount = 1;
-	renderPassCreateInfo.pSubpasses = &subPass;
-	renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(subpassDependencies.size());
-	renderPassCreateInfo.pDependencies = subpassDependencies.data();
-
-	VkResult result = vkCreateRenderPass(mainDevice.logicalDevice, &renderPassCreateInfo, nullptr, &renderPass);
-
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error("failed to create a render pass!");
-	}
-
-}
-
-void VulkanRenderer::createGraphicsPipeline() {
-
-	// read SPIR-V code of shaders
-	auto vertexShaderCode = readFile("Shaders/vert.spv");
-	auto fragmentShaderCode = readFile("Shaders/frag.spv");
-
-	// create shader modules
-	VkShaderModule vertexShaderModule = createShaderModule(vertexShaderCode);
-	VkShaderModule fragmentShaderModule = createShaderModule(fragmentShaderCode);
-
-	// --SHADER STAGE CREATION INFORMATION --
-	// Vertex stage creation information
-	VkPipelineShaderStageCreateInfo vertexShaderCreateInfo = {};
-	vertexShaderCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	vertexShaderCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;				// shader stage name
-	vertexShaderCreateInfo.module = vertexShaderModule;						// shader module to be used by stage
-	vertexShaderCreateInfo.pName = "main";									// entry point in to shader
-
-	// Fragment stage creation information
-	VkPipelineShaderStageCreateInfo fragmentShaderCreateInfo = {};
-	fragmentShaderCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	fragmentShaderCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	fragmentShaderCreateInfo.module = fragmentShaderModule;
-	fragmentShaderCreateInfo.pName = "main";
-
-	// put shader stage creation info in to array
-	// graphics pipeline creation info requires an array of shader stage creates
-	VkPipelineShaderStageCreateInfo shaderStages[] = { vertexShaderCreateInfo, fragmentShaderCreateInfo };
-
-	// how the data for a single vertex (including info like position, color, normals etc) isas a whole
-	VkVertexInputBindingDescription bindingDescription = {};
-	bindingDescription.binding = 0;									// can bind multiple source of data. this defines which one
-	bindingDescription.stride = sizeof(Vertex);						// size of a single vertex object
-	bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;		// how to move between data after each vertex
-																	// VK_VERTEX_INPUT_RATE_VERTEX		move onto next vertex
-																	// VK_VERTEX_INPUT_RATE_INSTANCE	move to a vertex for the next instance
-
-	// how the data for an attribute is defined within a vertex
-	std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions;
-
-	// position attribute
-	attributeDescriptions[0].binding = 0;							// which binding the data is at (should be the same as above
-	attributeDescriptions[0].location = 0;							// location in shader where data will be read from
-	attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;	// format the data will be ( helps define size of data)
-	attributeDescriptions[0].offset = offsetof(Vertex, pos);			// where this attribute is defined in the data for single vertex
-
-	// color attribute
-	attributeDescriptions[1].binding = 0;							
-	attributeDescriptions[1].location = 1;							
-	attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;	
-	attributeDescriptions[1].offset = offsetof(Vertex, col);		
-
-	// -- VERTEX INPUT --
-	VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = {};
-	vertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputCreateInfo.vertexBindingDescriptionCount = 1;
-	vertexInputCreateInfo.pVertexBindingDescriptions = &bindingDescription;									// list of vertex binding descriptions (data spacing, stride info)
-	vertexInputCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-	vertexInputCreateInfo.pVertexAttributeDescriptions = attributeDescriptions.data();						// list of vertex attribute descriptions (data format and where to bind to or from)
-
-	// -- INPUT ASSEMBLY --
-	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;		// primitive type to assemble
-	inputAssembly.primitiveRestartEnable = VK_FALSE;					// allow overriding of strip topology to start new primitives
-
-	// -- VIEWPORT & SCISSOR --
-	// create a viewport info struct
-	VkViewport viewport = {};
-	viewport.x = 0.0f;									// x start coordinate
-	viewport.y = 0.0f;									// y start coordinate
-	viewport.width = (float)swapChainExtent.width;		// width of viewport
-	viewport.height = (float)swapChainExtent.height;	// height of viewport
-	viewport.minDepth = 0.0f;							// min framebuffer depth
-	viewport.maxDepth = 1.0f;							// max framebuffer depth
-
-	// create a scissor info struct
-	VkRect2D scissor = {};
-	scissor.offset = { 0,0 };							// offset to use region from
-	scissor.extent = swapChainExtent;					// extent to describe region to use, starting at offset
-
-	VkPipelineViewportStateCreateInfo viewportStateCreateInfo = {};
-	viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-	viewportStateCreateInfo.viewportCount = 1;
-	viewportStateCreateInfo.pViewports = &viewport;
-	viewportStateCreateInfo.scissorCount = 1;
-	viewportStateCreateInfo.pScissors = &scissor;
-
-	// -- DYNAMIC STATES --
-	// dynamic states to enable
-	//std::vector<VkDynamicState> dynamicStateEnables;
-	//dynamicStateEnables.push_back(VK_DYNAMIC_STATE_VIEWPORT);		// dynamic viewport - can resize in command buffer
-	//dynamicStateEnables.push_back(VK_DYNAMIC_STATE_SCISSOR);		// dynamic scissor - can resixe in command buffer
-
-	// dynamic state crteation info
-	//VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = {};
-	//dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-	//dynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
-	//dynamicStateCreateInfo.pDynamicStates = dynamicStateEnables.data();
-
-	// -- RASTERIZER -- 
-	VkPipelineRasterizationStateCreateInfo rasterizerCreateInfo = {};
-	rasterizerCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-	rasterizerCreateInfo.depthClampEnable = VK_FALSE;				// change if fragments beyond near or far plane are clipped (default) or clamped to plane (needs gpu feature if other setting)
-	rasterizerCreateInfo.rasterizerDiscardEnable = VK_FALSE;		// wether to discard data and sckip rasterizer, never creates fragments, only for pipeline without framebuffer
-	rasterizerCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;		// how to handle filling points between vertices (needs gpu feature if other setting)
-	rasterizerCreateInfo.lineWidth = 1.0f;								// how thic lines should be when drawn (needs gpu feature if other setting)
-	rasterizerCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;			// which face of a tri to cull
-	rasterizerCreateInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;		// winding to determine which side is front
-	rasterizerCreateInfo.depthBiasEnable = VK_FALSE;				// whether to add depth bias to fragments (good for stopping "shadow_acne" in shadow mapping
-
-
-	// -- MULTISAMPLING --
-	VkPipelineMultisampleStateCreateInfo multisamplingCreateInfo = {};
-	multisamplingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-	multisamplingCreateInfo.sampleShadingEnable = VK_FALSE;					// enable multisample shading or not
-	multisamplingCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;	// number of samples to use per fragment
-
-
-	// -- BLENDING --
-	// blending decides how to blend a new color being written to a fragment with the old value
-
-	// blend attachment state (how blending is handled)
-	VkPipelineColorBlendAttachmentState colorState = {};
-	colorState.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;	// color to apply blending to
-	colorState.blendEnable = VK_TRUE;																										// enable blending
-
-	// blending use equation (srcColorBlendFactor * new color) colorBlendOp (destColorBlendFactor * old color)
-	colorState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-	colorState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-	colorState.colorBlendOp = VK_BLEND_OP_ADD;
-
-	// summarized: (VK_BLEND_FACTOR_SRC_ALPHA * new color) * (VKL_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA * old color)
-	//			   (new color alpha * new color) * ((1- new color alpha) * new color)
-
-	colorState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-	colorState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-	colorState.alphaBlendOp = VK_BLEND_OP_ADD;
-
-	// summmarized: (1 * new alpha) + (0 * old alpha) = new alpha
-
-	VkPipelineColorBlendStateCreateInfo colorBlendingCreateInfo = {};
-	colorBlendingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-	colorBlendingCreateInfo.logicOpEnable = VK_FALSE;				// alternative to calculations is to use logical operations
-	colorBlendingCreateInfo.attachmentCount = 1;
-	colorBlendingCreateInfo.pAttachments = &colorState;
-
-	// -- PIPELINE LAYOUT --
-	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
-	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutCreateInfo.setLayoutCount = 0;
-	pipelineLayoutCreateInfo.pSetLayouts = nullptr;
-	pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-	pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
-
-	// create pipeline layout
-	VkResult result = vkCreatePipelineLayout(mainDevice.logicalDevice, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout);
-
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error("failed to create pipeline layout");
-	}
-
-	// -- DEPTH STENCIL TESTING --
-	// TODO set up depth stencil testing
-
-
-	// -- GRAPHICS PIPELINE CREATION --
-	VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
-	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	pipelineCreateInfo.stageCount = 2;									// number of shader stages
-	pipelineCreateInfo.pStages = shaderStages;							// list of shader stages
-	pipelineCreateInfo.pVertexInputState = &vertexInputCreateInfo;		// all the fixed function pipeline states
-	pipelineCreateInfo.pInputAssemblyState = &inputAssembly;
-	pipelineCreateInfo.pViewportState = &viewportStateCreateInfo;
-	pipelineCreateInfo.pDynamicState = nullptr;
-	pipelineCreateInfo.pRasterizationState = &rasterizerCreateInfo;
-	pipelineCreateInfo.pMultisampleState = &multisamplingCreateInfo;
-	pipelineCreateInfo.pColorBlendState = &colorBlendingCreateInfo;
-	pipelineCreateInfo.pDepthStencilState = nullptr;
-	pipelineCreateInfo.layout = pipelineLayout;							// pipeline layout pipeline should use
-	pipelineCreateInfo.renderPass = renderPass;							// render pass description the pipeline is compatible with
-	pipelineCreateInfo.subpass = 0;										// subpass of render pass to use with pipeline
-
-	// pipeline derivatives, can create multiple pipelines that derive from one another for optimization
-	pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;				// existing pipeline to derive from
-	pipelineCreateInfo.basePipelineIndex = -1;							// or index of pipeline being created to derive from
-
-	// create graphics pipeline
-	result = vkCreateGraphicsPipelines(mainDevice.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &graphicsPipeline);
-
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error("failed to create graphics pipeline");
-	}
-
-	// destroy shader modules, no longer needed after pipeline created
-	vkDestroyShaderModule(mainDevice.logicalDevice, fragmentShaderModule, nullptr);
-	vkDestroyShaderModule(mainDevice.logicalDevice, vertexShaderModule, nullptr);
-}
-
-void VulkanRenderer::createFrameBuffers(){
-
-	// resize frame buffer count to swapchain image count
-	swapChainFrameBuffers.resize(swapChainImages.size());
-
-	// create a framebuffer for each swapchain image
-	for (size_t i = 0; i < swapChainFrameBuffers.size(); i++){
-		
-		std::array<VkImageView, 1> attachments = {
-			swapChainImages[i].imageView
-		};
-
-		VkFramebufferCreateInfo framebufferCreateInfo = {};
-		framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		framebufferCreateInfo.renderPass = renderPass;											// render pass layout the frame buffer will be using
-		framebufferCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());		
-		framebufferCreateInfo.pAttachments = attachments.data();								// list of attachments (1:1 awith render pass)
-		framebufferCreateInfo.width = swapChainExtent.width;									// frame buffer widht
-		framebufferCreateInfo.height = swapChainExtent.height;									// frame buffer height
-		framebufferCreateInfo.layers = 1;														// frame buffer layers
-
-		VkResult result = vkCreateFramebuffer(mainDevice.logicalDevice, &framebufferCreateInfo, nullptr, &swapChainFrameBuffers[i]);
-
-		if (result != VK_SUCCESS) {
-			throw std::runtime_error("falied to create framebuffer");
-		}
-	}
-}
-
-void VulkanRenderer::createCommandPool(){
-
-	// get indices of queue families from device
-	QueueFamilyIndices queueFamilyIndices = getQueueFamilies(mainDevice.physicalDevice);
-
-	VkCommandPoolCreateInfo poolInfo = {};
-	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-	poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;	// queue family type that buffers from this command pool will use
-
-	// createa a graphics queue family command pool
-	VkResult result = vkCreateCommandPool(mainDevice.logicalDevice, &poolInfo, nullptr, &graphicsCommandPool);
-	
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error("failed to create command buffer pool");
-	}
-}
-
-void VulkanRenderer::createCommandBuffers(){
-
-	// resize command buffer count to have one for each framebuffer
-	commandBuffers.resize(swapChainFrameBuffers.size());
-
-	VkCommandBufferAllocateInfo cbAllocInfo = {};
-	cbAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	cbAllocInfo.commandPool = graphicsCommandPool;
-	cbAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;	// VK_COMMAND_BUFFER_LEVEL_PRIMARY buffer will submit directly to the pool, can't be called from other command buffers
-															// VK_COMMAND_BUFFER_LEVEL_SECONDARY can't be called directrly, but can be colled from other buffers via vkCommandExecuteBuffers
-	cbAllocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
-
-	// allocate command buffers and place handles in array of buffers
-	VkResult result = vkAllocateCommandBuffers(mainDevice.logicalDevice, &cbAllocInfo, commandBuffers.data());
-
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error("failed to allocate command buffers");
-	}
-
-}
-
-void VulkanRenderer::createSynchronization() {
-
-	imageAvailable.resize(MAX_FRAME_DRAWS);
-	renderFinished.resize(MAX_FRAME_DRAWS);
-	drawFences.resize(MAX_FRAME_DRAWS);
-	// Semaphore creation information
-	VkSemaphoreCreateInfo semaphoreCreateInfo = {};
-	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-
-	// fence creation information
-	VkFenceCreateInfo fenceCreateInfo = {};
-	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-	for (size_t i = 0; i < MAX_FRAME_DRAWS; i++) {
-
-		if (vkCreateSemaphore(mainDevice.logicalDevice, &semaphoreCreateInfo, nullptr, &imageAvailable[i]) != VK_SUCCESS || 
-			vkCreateSemaphore(mainDevice.logicalDevice, &semaphoreCreateInfo, nullptr, &renderFinished[i]) != VK_SUCCESS || 
-			vkCreateFence(mainDevice.logicalDevice, &fenceCreateInfo, nullptr, &drawFences[i]) != VK_SUCCESS) {
-
-			throw std::runtime_error("failed to create a semaphore and/or fence");
-		}
-	}
-}
-
-void VulkanRenderer::recordCommands() {
-
-	// information about how to begin each command buffer
-	VkCommandBufferBeginInfo bufferBeginInfo = {};
-	bufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-
-	// information about how to begin a  render pass (only needed for graphical application)
-	VkRenderPassBeginInfo renderPassBeginInfo = {};
-	renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	renderPassBeginInfo.renderPass = renderPass;								// render pass to begin
-	renderPassBeginInfo.renderArea.offset = { 0,0 };							// start point of render pass in pixels
-	renderPassBeginInfo.renderArea.extent = swapChainExtent;					// size of region to run render pass on (starting at offset)
-	VkClearValue clearValues[] = {
-		{0.6f, 0.65f, 0.4f, 1.0f}
-	};
-	renderPassBeginInfo.pClearValues = clearValues;								// list of clear values (TODO depth attachment clear value)
-	renderPassBeginInfo.clearValueCount = 1;	
-
-	for (size_t i = 0; i < commandBuffers.size(); i++) {
-
-		renderPassBeginInfo.framebuffer = swapChainFrameBuffers[i];
-
-		// start recording commands to command buffer
-		VkResult result = vkBeginCommandBuffer(commandBuffers[i], &bufferBeginInfo);
-
-		if (result != VK_SUCCESS) {
-			throw std::runtime_error("failed to start recording a command buffer");
-		}
-
-		// begin render pass
-		vkCmdBeginRenderPass(commandBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-		// bind pipeline to be used in render pass
-		vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-
-		for (size_t j = 0; j < meshList.size(); j++){
-
-			VkBuffer vertexBuffers[] = { meshList[j].getVertexBuffer() };					// buffers to bind
-			VkDeviceSize offsets[] = { 0 };												// offsets into buffers being bound
-			vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);	// command to bind vertex buffer before drawing with them
-
-			// bind mesh index buffer with 0 offset and using the uint32_t type
-			vkCmdBindIndexBuffer(commandBuffers[i], meshList[j].getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
-
-			// execute pipeline
-			vkCmdDrawIndexed(commandBuffers[i], meshList[j].getIndexCount(), 1, 0, 0, 0);
-		}
-		// end render pass
-		vkCmdEndRenderPass(commandBuffers[i]);
-
-		// stop recording to command buffer
-		result = vkEndCommandBuffer(commandBuffers[i]);
-
-		if (result != VK_SUCCESS) {
-			throw std::runtime_error("failed to stop recording a command buffer");
-		}
-	}
-}
-
-void VulkanRenderer::getPhysicalDevice()
-{
-	// enumerate physical devices the ckinstance can access
-	uint32_t deviceCount = 0;
-	vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
-
-	// if no devices available, then none support vulkan
-	if (deviceCount == 0) {
-		throw std::runtime_error("Can't find GPUs that support Vulkan instance");
-	}
-
-	// get list of physical devices
-	std::vector<VkPhysicalDevice> deviceList(deviceCount);
-	vkEnumeratePhysicalDevices(instance, &deviceCount, deviceList.data());
-
-	for (const auto &device : deviceList) {
-
-		if (checkDeviceSuitable(device)) {
-			mainDevice.physicalDevice = device;
-			break;
-		}
-	}
-}
-
-bool VulkanRenderer::checkInstanceExtensionSupport(std::vector<const char*>* checkExtensions)
-{
-	// need to get number of extensions to create array of correct size to hold extensions
-	uint32_t extensionCount = 0;
-	vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
-
-	// create a list of vkExtension properties using count
-	std::vector<VkExtensionProperties> extensions(extensionCount);
-	vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
-
-	// check if given extensions are in list of available extensions
-	for (const auto &checkExtension : *checkExtensions) {
-		
-		bool hasExtension = false;
-		for (const auto &extension : extensions) {
-
-			if (strcmp(checkExtension, extension.extensionName)==0) {
-				
-				hasExtension = true;
-				break;
-			}
-		}
-		if (!hasExtension) {
-			return false;
-		}
-	}
-
-	return true;
-}
-
-bool VulkanRenderer::checkDeviceExtensionSupport(VkPhysicalDevice device)
-{
-	// Get device extension count
-	uint32_t extensionCount = 0;
-	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
-
-	// If no extensions found, return failure
-	if (extensionCount == 0)
-	{
-		return false;
-	}
-
-	// Populate list of extensions
-	std::vector<VkExtensionProperties> extensions(extensionCount);
-	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
-
-	// Check for extension
-	for (const auto &deviceExtension : deviceExtensions)
-	{
-		bool hasExtension = false;
-		for (const auto &extension : extensions)
-		{
-			if (strcmp(deviceExtension, extension.extensionName) == 0)
-			{
-				hasExtension = true;
-				break;
-			}
-		}
-
-		if (!hasExtension)
-		{
-			return false;
-		}
-	}
-
-	return true;
-}
-
-
-bool VulkanRenderer::checkValidationLayerSupport() {
-	uint32_t layerCount;
-	vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
-
-	std::vector<VkLayerProperties> availableLayers(layerCount);
-	vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
-
-	for (const char* layerName : validationLayers) {
-		bool layerFound = false;
-
-		for (const auto& layerProperties : availableLayers) {
-			if (strcmp(layerName, layerProperties.layerName) == 0) {
-				layerFound = true;
-				break;
-			}
-		}
-
-		if (!layerFound) {
-			return false;
-		}
-	}
-
-	return true;
-}
-
-bool VulkanRenderer::checkDeviceSuitable(VkPhysicalDevice device)
-{
-	/*
-	// information about the device itself
-	VkPhysicalDeviceProperties deviceProperties;
-	vkGetPhysicalDeviceProperties(device, &deviceProperties);
-
-	// information about what the device can do
-	VkPhysicalDeviceFeatures deviceFeatures;
-	vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
-	*/
-
-	QueueFamilyIndices indices = getQueueFamilies(device);
-
-	bool extensionsSupported = checkDeviceExtensionSupport(device);
-
-	bool swapChainValid = false;
-
-	if (extensionsSupported) {
-		SwapChainDetails swapChainDetails = getSwapChainDetails(device);
-		swapChainValid = !swapChainDetails.presentationModes.empty() && !swapChainDetails.formats.empty();
-	}
-	return indices.isValid() && extensionsSupported && swapChainValid;
-}
-
-
-QueueFamilyIndices VulkanRenderer::getQueueFamilies(VkPhysicalDevice device)
-{
-	QueueFamilyIndices indices;
-
-	// get all queue family property info for the given devices
-	uint32_t queueFamilyCount = 0;
-	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
-
-	std::vector<VkQueueFamilyProperties> queueFamilyList(queueFamilyCount);
-	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilyList.data());
-
-	// go through each queue family and check if it has at least one of the reuqired types of queue
-	int i = 0;
-	for (const auto &queueFamily : queueFamilyList) {
-		// first check if queue family has at least 1 queue in that family
-		// queue can have multiple types defined through bitfield, need to bitwise check if it has required type
-		if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-
-			indices.graphicsFamily = i;		// if queue family is valid, get index
-		}
-
-
-		// check if queue family supports presentation
-		VkBool32 presentationSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentationSupport);
-
-		// check if queue is presentation type (can be both graphics and presentation type)
-		if (queueFamily.queueCount > 0 && presentationSupport) {
-			indices.presentationFamily = i;
-		}
-
-		// check if queue family indices are in a valid state, stop searching if so
-		if (indices.isValid()) {
-			break;
-		}
-
-		i++;
-	}
-	return indices;
-}
-
-SwapChainDetails VulkanRenderer::getSwapChainDetails(VkPhysicalDevice device){
-
-	SwapChainDetails swapChainDetails;
-	// -- CAPABILITIES--
-	// get the surface capabilities for the given surface on the given physical device
-	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &swapChainDetails.surfaceCapabilities);
-
-	// -- FORMATS--
-	uint32_t formatCount = 0;
-	vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, nullptr);
-
-	// if formats returned, get list of formats
-	if (formatCount != 0) {
-		swapChainDetails.formats.resize(formatCount);
-		vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, swapChainDetails.formats.data());
-	}
-
-	// --PRESENTATION MODES--
-	uint32_t presentationCount = 0;
-	vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentationCount, nullptr);
-
-	// if presentation modes returned, get list of presentation modes
-	if (presentationCount != 0) {
-		swapChainDetails.presentationModes.resize(presentationCount);
-		vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentationCount, swapChainDetails.presentationModes.data());
-	}
-
-	return swapChainDetails;
-}
-
-// best format is subjective, but this will be
-// format		:	VK_FORMAT_R8G8B8A8_UNORM (VK_FORMAT_B8G8R8A8_UNORM as backup)
-// colorspace	:	VK_COLOR_SPACE_SRGB_NONLINEAR_KHR
-VkSurfaceFormatKHR VulkanRenderer::chooseBestSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& formats) {
-
-	// if only 1 format is available and is undefined it means all are available and no restrictions
-	if (formats.size() == 1 && formats[0].format == VK_FORMAT_UNDEFINED) {
-		return { VK_FORMAT_R8G8B8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
-	}
-
-	// if restricted, find optimal
-	for (const auto &format : formats) {
-		if ((format.format == VK_FORMAT_R8G8B8A8_UNORM || format.format == VK_FORMAT_B8G8R8A8_UNORM) && format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
-			return format;
-		}
-	}
-
-	// if optimal not found, use first
-	return formats[0];
-}
-
-VkPresentModeKHR VulkanRenderer::chooseBestPresentationMode(const std::vector<VkPresentModeKHR> presentationModes){
-
-	// look for mailbox presentation mode
-	for (const auto &presentationMode : presentationModes) {
-		if (presentationMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-			return presentationMode;
-		}
-	}
-
-	// if can't find look for FIFO as vulkan spec says it must be present
-	return VK_PRESENT_MODE_FIFO_KHR;
-}
-
-VkExtent2D VulkanRenderer::chooseSwapExtent(const VkSurfaceCapabilitiesKHR & surfaceCapabilities){
-
-	// if current extent is at numeric limits, the extent can vary, otherwise it's the size of the window
-	if (surfaceCapabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
-		return surfaceCapabilities.currentExtent;
-	}
-	else
-	{
-		// if value can vary, need to set manually
-
-		// get window size
-		int width, height;
-		glfwGetFramebufferSize(window, &width, &height);
-
-		// create new extent using window size
-		VkExtent2D newExtent = {};
-		newExtent.width = static_cast<uint32_t>(width);
-		newExtent.height = static_cast<uint32_t>(height);
-
-		// surface also defines max and min, so make sure within boundaries by clamping value
-		newExtent.width = std::max(surfaceCapabilities.minImageExtent.width, std::min(surfaceCapabilities.maxImageExtent.width, newExtent.width));
-		newExtent.height = std::max(surfaceCapabilities.minImageExtent.height, std::min(surfaceCapabilities.maxImageExtent.height, newExtent.height));
-
-		return newExtent;
-	}
-}
-
-VkImageView VulkanRenderer::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectflags) {
-
-	VkImageViewCreateInfo viewCreateInfo = {};
-	viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-	viewCreateInfo.image = image;									// image to create view for
-	viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;				// type of image 
-	viewCreateInfo.format = format;									// format of image data
-	viewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;	// allows remapping of rgba components to other rgba values
-	viewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-	viewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-	viewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-
-	// subresources allow the view to view only a part of an image
-	viewCreateInfo.subresourceRange.aspectMask = aspectflags;		// which aspect of image to view (example COLOR_BIT for viewing color)
-	viewCreateInfo.subresourceRange.baseMipLevel = 0;				// start mipmap level to view from
-	viewCreateInfo.subresourceRange.levelCount = 1;					// number of mipmap levels to view
-	viewCreateInfo.subresourceRange.baseArrayLayer = 0;				// start array level to view from
-	viewCreateInfo.subresourceRange.layerCount = 1;					// number of array levels to view
-
-	// create image view and return it
-	VkImageView imageView;
-	VkResult result = vkCreateImageView(mainDevice.logicalDevice, &viewCreateInfo, nullptr, &imageView);
-
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error("Failed to create an image view!");
-	}
-
-	return imageView;
-}
-
-VkShaderModule VulkanRenderer::createShaderModule(const std::vector<char>& code){
-	
-	// shader module creation information
-	VkShaderModuleCreateInfo shaderModuleCreateInfo = {};
-	shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	shaderModuleCreateInfo.codeSize = code.size();										// size of code
-	shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());		// pointer to code (uint32_t type)
-
-	VkShaderModule shaderModule;
-	VkResult result = vkCreateShaderModule(mainDevice.logicalDevice, &shaderModuleCreateInfo, nullptr, &shaderModule);
-
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error("failed to create the shader module");
-	}
-
-	return shaderModule;
-}
+#include "VulkanRenderer.h"
+
+VulkanRenderer::VulkanRenderer()
+{
+}
+
+int VulkanRenderer::init(GLFWwindow * newWindow, JobSystem * newJobSystem, VkExtent2D newHeadlessExtent)
+{
+	window = newWindow;
+	jobSystem = newJobSystem;
+	headless = window == nullptr;
+	headlessExtent = newHeadlessExtent;
+
+	try
+	{
+		createInstance();
+		createDebugMessenger();
+		if (!headless) {
+			createSurface();
+		}
+		getPhysicalDevice();
+		createLogicalDevice();
+
+		deviceAllocator.create(mainDevice.physicalDevice, mainDevice.logicalDevice, memoryBudgetEnabled);
+		deletionQueue.create(mainDevice.logicalDevice, &frameScheduler, &deviceAllocator);
+
+		// render graph passes are timed on the GPU while the profiler is enabled
+		gpuProfiler.create(instance, mainDevice.physicalDevice, mainDevice.logicalDevice,
+			static_cast<uint32_t>(getQueueFamilies(mainDevice.physicalDevice).graphicsFamily), MAX_FRAME_DRAWS, calibratedTimestampsEnabled);
+		gpuStatistics.create(mainDevice.logicalDevice, MAX_FRAME_DRAWS, pipelineStatisticsEnabled);
+
+		// offscreen targets are allocated like any other image, so after the allocator
+		if (headless) {
+			createOffscreenTargets();
+		}
+		else
+		{
+			createSwapChain();
+		}
+		renderGraph.create(mainDevice.physicalDevice, mainDevice.logicalDevice, &deviceAllocator);
+		createRenderGraph();
+
+		// archives listed in ASSET_ARCHIVES (comma separated) are looked in before the disk, later ones first
+		fileSystem.create();
+		const char * assetArchives = std::getenv("ASSET_ARCHIVES");
+		for (const char * archive = assetArchives; archive != nullptr && *archive != '\0'; ) {
+			const char * end = strchr(archive, ',');
+			std::string archivePath = end != nullptr ? std::string(archive, end) : std::string(archive);
+			if (!archivePath.empty()) {
+				fileSystem.mountArchive(archivePath);
+			}
+			archive = end != nullptr ? end + 1 : archive + archivePath.size();
+		}
+
+		// shader modules are shared by the culling compute pipelines and the graphics pipelines,
+		// the ones used at startup are read in one batch instead of one at a time as pipelines ask for them
+		shaderManager.create(mainDevice.logicalDevice, &fileSystem);
+		std::vector<std::string> startupShaders = { "Shaders/shader.vert", "Shaders/shader.frag", "Shaders/hiz.comp", "Shaders/cull.comp", "Shaders/meshlet_cull.comp",
+			"Shaders/particle_emit.comp", "Shaders/particle_prepare.comp", "Shaders/particle_simulate.comp", "Shaders/particle.vert", "Shaders/particle.frag",
+			"Shaders/debug.vert", "Shaders/debug.frag" };
+		if (meshShaderEnabled) {
+			startupShaders.push_back("Shaders/meshlet.task");
+			startupShaders.push_back("Shaders/meshlet.mesh");
+		}
+		shaderManager.preload(startupShaders);
+
+		// transforms are written straight in to per frame instance buffers, which the meshlet culler binds
+		sceneGraph.create(mainDevice.physicalDevice, mainDevice.logicalDevice, &deviceAllocator, MAX_FRAME_DRAWS);
+		sceneRoot = sceneGraph.addNode(-1);
+
+		// the graphics pipeline layout includes the meshlet culler's set when mesh shaders draw
+		occlusionCuller.create(mainDevice.physicalDevice, mainDevice.logicalDevice, &shaderManager, &deviceAllocator,
+			renderGraph.getImageView(depthResource), swapChainExtent, MAX_FRAME_DRAWS);
+		meshletCuller.create(mainDevice.physicalDevice, mainDevice.logicalDevice, &shaderManager, &deviceAllocator, &occlusionCuller,
+			&sceneGraph, MAX_FRAME_DRAWS, drawIndirectCountEnabled, multiDrawIndirectEnabled, meshShaderEnabled);
+
+		// texture sets are the second set of the graphics pipeline layout, textures themselves come after the upload manager
+		textureManager.create(mainDevice.physicalDevice, mainDevice.logicalDevice, &deviceAllocator, &uploadManager, MAX_FRAME_DRAWS);
+
+		// per frame CPU geometry, written straight in to mapped memory
+		dynamicMesh.create(mainDevice.physicalDevice, mainDevice.logicalDevice, &deviceAllocator, MAX_FRAME_DRAWS, 65536, 196608);
+
+		// simulated on async compute and drawn on the GPU, emits nothing until an emitter is set. the buffers are
+		// shared by both families when they differ
+		QueueFamilyIndices queueFamilies = getQueueFamilies(mainDevice.physicalDevice);
+		uint32_t graphicsFamily = static_cast<uint32_t>(queueFamilies.graphicsFamily);
+		uint32_t computeFamily = asyncComputeEnabled ? static_cast<uint32_t>(queueFamilies.computeFamily) : graphicsFamily;
+		std::vector<uint32_t> particleQueueFamilies;
+		if (computeFamily != graphicsFamily) {
+			particleQueueFamilies = { graphicsFamily, computeFamily };
+		}
+		particleSystem.create(mainDevice.physicalDevice, mainDevice.logicalDevice, &shaderManager, &deviceAllocator, 262144, particleQueueFamilies);
+		lastParticleUpdate = std::chrono::steady_clock::now();
+
+		// render passes and their framebuffers are only needed without dynamic rendering, which begins rendering
+		// straight on the attachments' views
+		if (!dynamicRenderingEnabled) {
+			createRenderPass();
+		}
+		createGraphicsPipeline();
+		if (!dynamicRenderingEnabled) {
+			createFrameBuffers();
+		}
+		createCommandPool();
+		createSynchronization();
+		asyncCompute.create(mainDevice.physicalDevice, mainDevice.logicalDevice, computeQueue, computeFamily, graphicsFamily, &frameScheduler,
+			MAX_FRAME_DRAWS);
+
+		// lines, shapes and text accumulated between frames, room for a million lines and then some
+		debugDraw.create(mainDevice.logicalDevice, &deviceAllocator, &pipelineManager, swapChainExtent,
+			MAX_FRAME_DRAWS, 1 << 22);
+
+		// create a mesh
+		// vertex data
+		std::vector<Vertex> meshVertices = {
+			{{-0.1, -0.4, 0.0}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
+			{{-0.1, 0.4, 0.0}, {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f}},
+			{{-0.9, 0.4, 0.0}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
+			{{-0.9, -0.4, 0.0}, {1.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
+		};
+
+		std::vector<Vertex> meshVertices2 = {
+			{{0.9, -0.3, 0.0}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
+			{{0.9, 0.1, 0.0}, {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f}},
+			{{0.1, 0.3, 0.0}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
+			{{0.1, -0.1, 0.0}, {1.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
+		};
+		// index data
+		std::vector<uint32_t> meshIndices = {
+			0,1,2,
+			2,3,0
+		};
+
+
+		// uploads are recorded by whichever thread builds a mesh, on its own command pool and staging
+		uploadManager.create(mainDevice.physicalDevice, mainDevice.logicalDevice, graphicsQueue,
+			static_cast<uint32_t>(getQueueFamilies(mainDevice.physicalDevice).graphicsFamily), &frameScheduler, &deviceAllocator);
+
+		// meshes are built as jobs, each in its final slot since they own their buffers and are never copied
+		std::vector<std::vector<Vertex> *> meshVertexLists = { &meshVertices, &meshVertices2 };
+		size_t firstMesh = meshList.size();
+		meshList.resize(firstMesh + meshVertexLists.size());
+
+		JobCounter meshJobs;
+		jobSystem->parallelFor(static_cast<uint32_t>(meshVertexLists.size()), 1, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) {
+				meshList[firstMesh + i] = Mesh(mainDevice.physicalDevice, mainDevice.logicalDevice, &uploadManager, &deviceAllocator,
+					meshVertexLists[i], &meshIndices);
+			}
+		}, &meshJobs);
+		jobSystem->wait(&meshJobs);
+
+		// a checkerboard whose mip chain is made on the GPU for the first mesh, plain white (vertex colors only) for the other
+		const uint32_t checkerSize = 256;
+		std::vector<uint8_t> checkerPixels(checkerSize * checkerSize * 4);
+		for (uint32_t y = 0; y < checkerSize; y++) {
+			for (uint32_t x = 0; x < checkerSize; x++) {
+				uint8_t value = ((x / 32 + y / 32) % 2 == 0) ? 255 : 64;
+				for (uint32_t channel = 0; channel < 4; channel++) {
+					checkerPixels[(y * checkerSize + x) * 4 + channel] = channel == 3 ? 255 : value;
+				}
+			}
+		}
+		uint32_t checkerTexture = textureManager.createTexture(checkerSize, checkerSize, VK_FORMAT_R8G8B8A8_UNORM, { checkerPixels });
+		uint32_t whiteTexture = textureManager.createTexture(1, 1, VK_FORMAT_R8G8B8A8_UNORM, { std::vector<uint8_t>(4, 255) });
+		dynamicTexture = whiteTexture;
+
+		for (size_t i = 0; i < meshVertexLists.size(); i++) {
+			meshNodes.push_back(sceneGraph.addNode(sceneRoot));
+			meshTextures.push_back(i == 0 ? checkerTexture : whiteTexture);
+			meshLastVisible.push_back(frameNumber);
+		}
+		meshListVersion++;
+
+		createCommandBuffers();
+
+		pipelineManager.reportCompileTimes();
+	}
+	catch (const std::runtime_error &e)
+	{
+		printf("ERROR: %s\n", e.what());
+		return EXIT_FAILURE;
+	}
+
+
+	return 0;
+}
+
+void VulkanRenderer::draw(){
+
+	PROFILE_FUNCTION();
+
+	// -- GET NEXT IMAGE --
+	// wait until the GPU reaches the timeline value of the last submission that used this frame's semaphores
+	{
+		PROFILE_SCOPE("waitForFrame");
+		frameScheduler.waitForFrame(currentFrame);
+	}
+
+#if PROFILER_ENABLED
+	// the frame's pass timestamps are available now
+	gpuProfiler.collect(currentFrame);
+#endif
+
+	// and its pass statistics, and how its async compute lined up with the graphics work
+	gpuStatistics.collect(currentFrame);
+	asyncCompute.collect(currentFrame);
+	if (statisticsLogInterval > 0.0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - lastStatisticsLog).count() >= statisticsLogInterval) {
+		gpuStatistics.log(static_cast<uint64_t>(swapChainExtent.width) * swapChainExtent.height);
+		printf("dynamic geometry: %llu bytes streamed a frame in to %s memory, %u writes dropped\n", static_cast<unsigned long long>(dynamicStreamedBytes),
+			dynamicMesh.isDeviceLocal() ? "device local" : "host", dynamicMesh.getDroppedCount(currentFrame));
+		printf("debug draw: %u vertices, %u dropped\n", debugDraw.getVertexCount(currentFrame), debugDraw.getDroppedCount(currentFrame));
+		asyncCompute.log();
+		lastStatisticsLog = std::chrono::steady_clock::now();
+	}
+
+	// this frame's culling results are complete now
+	occludedObjectCount = occlusionCuller.getOccludedCount(currentFrame);
+
+	// frames read back by finished submissions go to the writer thread
+	if (readbackEnabled) {
+		frameReadback.collect();
+	}
+
+	// destroy resources retired by frames the GPU has finished, and run any other deferred work
+	deletionQueue.collect();
+	frameScheduler.collect();
+
+	// pick up edited shaders, rebuilt pipelines are swapped in before recording
+	pipelineManager.update();
+
+	// stream in the next texture levels (uploaded by the flush below) and point this frame's sets at them
+	textureManager.update(currentFrame);
+
+	// reload meshes that became visible and evict the least recently visible ones over budget, before the frame
+	// jobs read the mesh list
+	updateMeshResidency();
+
+	// the GPU is done with this frame's region of the dynamic mesh, so it can be rewritten
+	dynamicMesh.begin(currentFrame);
+	if (dynamicGeometryCallback) {
+		PROFILE_SCOPE("dynamicGeometry");
+		dynamicGeometryCallback(dynamicMesh);
+	}
+	dynamicStreamedBytes = dynamicMesh.getStreamedBytes(currentFrame);
+
+	// particles move by the time since the last frame, capped so a stall doesn't throw them across the screen
+	auto now = std::chrono::steady_clock::now();
+	particleSystem.update(std::min(std::chrono::duration<float>(now - lastParticleUpdate).count(), 0.1f));
+	lastParticleUpdate = now;
+
+	// and are updated on async compute straight away, so the update runs alongside the last frame's graphics work.
+	// it reads what that frame draws and writes what the frame before drew, so it only waits for the older one
+	uint64_t computeValue;
+	{
+		PROFILE_SCOPE("asyncCompute");
+		VkCommandBuffer computeCommandBuffer = asyncCompute.begin(currentFrame);
+		particleSystem.recordUpdate(computeCommandBuffer);
+		computeValue = asyncCompute.submit(currentFrame, particleSystem.getWriteWaitValue());
+	}
+
+	// and of the debug draw buffer, everything drawn since the last frame goes in to it
+	{
+		PROFILE_SCOPE("debugDrawFlush");
+		debugDraw.flush(currentFrame);
+	}
+
+	// transforms and cull inputs are built on the job system while this thread waits for the next image
+	startFrameJobs();
+
+	// get index of next image to draw to and signal semaphore when read to draw to. headless frames draw to their
+	// own offscreen target, which the wait for the frame has already freed
+	uint32_t imageIndex = currentFrame;
+	if (!headless) {
+		PROFILE_SCOPE("acquireNextImage");
+		deviceDispatch.vkAcquireNextImageKHR(mainDevice.logicalDevice, swapchain, std::numeric_limits<uint64_t>::max(), imageAvailable[currentFrame], VK_NULL_HANDLE, &imageIndex);
+	}
+
+	// re-record this frame's command buffer so it always draws the current mesh list
+	recordCommands(imageIndex);
+
+	// every upload recorded since the last frame goes in one submission ahead of the frame, which then reads it
+	// without waiting (the upload ends in a barrier, and both go to the same queue)
+	uploadManager.flush();
+
+	// -- SUBMIT COMMAND BUFFER TO RENDER --
+	// queue submission infomration
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.waitSemaphoreCount = headless ? 0 : 1;				// number of semaphores to wait on (nothing is acquired headless)
+	submitInfo.pWaitSemaphores = &imageAvailable[currentFrame];		// list of semaphores to wait on
+	VkPipelineStageFlags waitStages[] = {
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+	};
+	submitInfo.pWaitDstStageMask = waitStages;						// stages to check semaphores at
+	submitInfo.commandBufferCount = 1;								// number of command buffers to submit
+	submitInfo.pCommandBuffers = &commandBuffers[currentFrame];		// command buffer to submit
+	submitInfo.signalSemaphoreCount = headless ? 0 : 1;				// number of semaphores to signal (or presented)
+	submitInfo.pSignalSemaphores = &renderFinished[currentFrame];	// semaphores to signal when command buffer finishes
+	
+	// submit command buffer to queue, it also signals the next timeline value
+#if PROFILER_ENABLED
+	gpuProfiler.setSubmitTime(currentFrame, Profiler::now());
+#endif
+	// only the draws wait for the frame's async compute, culling can start before it finishes
+	std::vector<TimelineWait> computeWaits = { asyncCompute.getWait(computeValue, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT) };
+	uint64_t frameValue = frameScheduler.submit(graphicsQueue, submitInfo, 0, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, computeWaits);
+	frameScheduler.setFrameValue(currentFrame, frameValue);
+	particleSystem.setDrawValue(frameValue);
+	if (readbackEnabled) {
+		frameReadback.setSubmitValue(frameValue);
+	}
+
+	// -- PRESENT RENDERED IMAGE TO SCREEN --
+	// headless frames are only seen through readback
+	if (!headless) {
+		VkPresentInfoKHR presentInfo = {};
+		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		presentInfo.waitSemaphoreCount = 1;								// number of semaphores to wait on
+		presentInfo.pWaitSemaphores = &renderFinished[currentFrame];	// semaphore to wait on
+		presentInfo.swapchainCount = 1;									// number of swapchains to present to
+		presentInfo.pSwapchains = &swapchain;							// swapcahins to present images to
+		presentInfo.pImageIndices = &imageIndex;						// index of images in swapchains to present
+
+		// present image
+		VkResult result;
+		{
+			PROFILE_SCOPE("present");
+			result = frameScheduler.present(presentationQueue, presentInfo);
+		}
+
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error("failed to present rendered image");
+		}
+	}
+
+	// get next frame (use % MAX_FRAME_DRAWS to keep value below MAX_FRAME_DRAWS)
+	currentFrame = (currentFrame + 1) % MAX_FRAME_DRAWS;
+	frameNumber++;
+}
+
+void VulkanRenderer::cleanup()
+{
+	// wait until no actions being run on the device before destroying it
+	vkDeviceWaitIdle(mainDevice.logicalDevice);
+
+	// destroying the meshes releases their buffers
+	meshList.clear();
+
+	// everything else allocated through the device allocator goes before it is destroyed
+	if (readbackEnabled) {
+		frameReadback.destroy();
+	}
+	textureManager.destroy();
+	uploadManager.destroy();
+	meshletCuller.destroy();
+	occlusionCuller.destroy();
+	sceneGraph.destroy();
+	dynamicMesh.destroy();
+	particleSystem.destroy();
+	debugDraw.destroy();
+	renderGraph.destroy();
+	gpuProfiler.destroy();
+	gpuStatistics.destroy();
+
+	// and the offscreen targets standing in for the swapchain
+	if (headless) {
+		for (auto image : swapChainImages) {
+			vkDestroyImageView(mainDevice.logicalDevice, image.imageView, nullptr);
+		}
+		swapChainImages.clear();
+		offscreenImages.clear();
+		offscreenMemory.clear();
+	}
+
+	// device is idle, so everything retired can go, then release recycled memory
+	deletionQueue.flush();
+	deviceAllocator.destroy();
+
+	for (size_t i = 0; i < MAX_FRAME_DRAWS; i++)
+	{
+		vkDestroySemaphore(mainDevice.logicalDevice, renderFinished[i], nullptr);
+		vkDestroySemaphore(mainDevice.logicalDevice, imageAvailable[i], nullptr);
+	}
+	asyncCompute.destroy();
+	frameScheduler.destroy();
+	
+	vkDestroyCommandPool(mainDevice.logicalDevice, graphicsCommandPool, nullptr);
+	for (auto framebuffer : swapChainFrameBuffers) {
+		vkDestroyFramebuffer(mainDevice.logicalDevice, framebuffer, nullptr);
+	}
+
+	pipelineManager.destroy();
+	shaderManager.destroy();
+	fileSystem.destroy();
+	pipelineLayout.reset();
+	vkDestroyRenderPass(mainDevice.logicalDevice, lateRenderPass, nullptr);
+	vkDestroyRenderPass(mainDevice.logicalDevice, renderPass, nullptr);
+	
+	for (auto image : swapChainImages) {
+		vkDestroyImageView(mainDevice.logicalDevice, image.imageView, nullptr);
+	}
+
+	if (!headless) {
+		vkDestroySwapchainKHR(mainDevice.logicalDevice, swapchain, nullptr);
+		vkDestroySurfaceKHR(instance, surface, nullptr);
+	}
+	vkDestroyDevice(mainDevice.logicalDevice, nullptr);
+	
+#if VULKAN_VALIDATION_ENABLED
+	if (validationEnabled) {
+		DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
+	}
+#endif
+
+	vkDestroyInstance(instance, nullptr);
+
+#if VULKAN_VALIDATION_ENABLED
+	validationLog.destroy();
+#endif
+}
+
+
+void VulkanRenderer::removeMesh(size_t meshIndex){
+
+	// frames in flight may still be drawing the mesh, so hand its buffers to the deletion queue
+	// instead of waiting for the device, the next recorded frame simply won't draw it
+	meshList[meshIndex].retireBuffers(&deletionQueue);
+	meshList.erase(meshList.begin() + meshIndex);
+	meshListVersion++;
+
+	// the node stays in the scene graph, removing it would renumber every node after it
+	meshNodes.erase(meshNodes.begin() + meshIndex);
+	meshTextures.erase(meshTextures.begin() + meshIndex);
+	meshLastVisible.erase(meshLastVisible.begin() + meshIndex);
+}
+
+void VulkanRenderer::setMeshMemoryBudget(VkDeviceSize bytes){
+	meshMemoryBudget = bytes;
+}
+
+VkDeviceSize VulkanRenderer::getResidentMeshBytes(){
+
+	VkDeviceSize residentBytes = 0;
+	for (auto &mesh : meshList) {
+		residentBytes += mesh.getResidentBytes();
+	}
+	return residentBytes;
+}
+
+uint32_t VulkanRenderer::getOccludedObjectCount(){
+	return occludedObjectCount;
+}
+
+bool VulkanRenderer::checkAsyncCompute(){
+
+	vkDeviceWaitIdle(mainDevice.logicalDevice);
+	return asyncCompute.check();
+}
+
+void VulkanRenderer::setPassStatistics(bool enabled, double logIntervalSeconds){
+
+	gpuStatistics.setEnabled(enabled);
+	statisticsLogInterval = enabled ? logIntervalSeconds : 0.0;
+	lastStatisticsLog = std::chrono::steady_clock::now();
+}
+
+const std::vector<PassStatistics> &VulkanRenderer::getPassStatistics(){
+	return gpuStatistics.getPassStatistics();
+}
+
+void VulkanRenderer::benchmarkDispatch(uint32_t drawCount){
+
+	// the commands of a draw, either the loader's exports or the table's
+	struct DrawCommands {
+		PFN_vkBeginCommandBuffer beginCommandBuffer;
+		PFN_vkEndCommandBuffer endCommandBuffer;
+		PFN_vkCmdBindPipeline bindPipeline;
+		PFN_vkCmdBindDescriptorSets bindDescriptorSets;
+		PFN_vkCmdBindVertexBuffers bindVertexBuffers;
+		PFN_vkCmdBindIndexBuffer bindIndexBuffer;
+		PFN_vkCmdDrawIndexed drawIndexed;
+	};
+	DrawCommands loaderCommands = { vkBeginCommandBuffer, vkEndCommandBuffer, vkCmdBindPipeline, vkCmdBindDescriptorSets,
+		vkCmdBindVertexBuffers, vkCmdBindIndexBuffer, vkCmdDrawIndexed };
+	DrawCommands tableCommands = { deviceDispatch.vkBeginCommandBuffer, deviceDispatch.vkEndCommandBuffer, deviceDispatch.vkCmdBindPipeline,
+		deviceDispatch.vkCmdBindDescriptorSets, deviceDispatch.vkCmdBindVertexBuffers, deviceDispatch.vkCmdBindIndexBuffer, deviceDispatch.vkCmdDrawIndexed };
+
+	// a secondary command buffer continuing the early render pass, so the draws are valid to record
+	VkCommandBufferAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = graphicsCommandPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+	allocateInfo.commandBufferCount = 1;
+
+	VkCommandBuffer commandBuffer;
+	VkResult result = vkAllocateCommandBuffers(mainDevice.logicalDevice, &allocateInfo, &commandBuffer);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate a benchmark command buffer");
+	}
+
+	VkCommandBufferInheritanceInfo inheritanceInfo = {};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.renderPass = renderPass;
+	inheritanceInfo.subpass = 0;
+
+	// with dynamic rendering there is no render pass, the attachment formats are inherited instead
+	VkCommandBufferInheritanceRenderingInfoKHR inheritanceRenderingInfo = {};
+	inheritanceRenderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+	inheritanceRenderingInfo.colorAttachmentCount = 1;
+	inheritanceRenderingInfo.pColorAttachmentFormats = &swapChainImageFormat;
+	inheritanceRenderingInfo.depthAttachmentFormat = depthBufferFormat;
+	inheritanceRenderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	if (dynamicRenderingEnabled) {
+		inheritanceInfo.pNext = &inheritanceRenderingInfo;
+	}
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	// every draw rebinds the mesh's buffers, like recordMeshDraws
+	VkBuffer vertexBuffers[] = { meshList[0].getVertexBuffer(), sceneGraph.getInstanceBuffer(currentFrame) };
+	VkDeviceSize offsets[] = { 0, meshNodes[0] * sizeof(glm::mat4) };
+	VkDescriptorSet textureSet = textureManager.getDescriptorSet(currentFrame, meshTextures[0]);
+	VkPipeline pipeline = pipelineManager.getPipeline(graphicsPipelineHandle);
+
+	auto record = [&](const DrawCommands &commands) {
+		auto startTime = std::chrono::steady_clock::now();
+
+		commands.beginCommandBuffer(commandBuffer, &beginInfo);
+		commands.bindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		commands.bindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout.get(), 1, 1, &textureSet, 0, nullptr);
+		for (uint32_t i = 0; i < drawCount; i++) {
+			commands.bindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+			commands.bindIndexBuffer(commandBuffer, meshList[0].getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+			commands.drawIndexed(commandBuffer, meshList[0].getIndexCount(), 1, 0, 0, 0);
+		}
+		commands.endCommandBuffer(commandBuffer);
+
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	};
+
+	// alternate the two and keep the best of each, so warm up and frequency changes don't favour either
+	double loaderMilliseconds = std::numeric_limits<double>::max();
+	double tableMilliseconds = std::numeric_limits<double>::max();
+	for (int run = 0; run < 5; run++) {
+		loaderMilliseconds = std::min(loaderMilliseconds, record(loaderCommands));
+		tableMilliseconds = std::min(tableMilliseconds, record(tableCommands));
+	}
+
+	vkFreeCommandBuffers(mainDevice.logicalDevice, graphicsCommandPool, 1, &commandBuffer);
+
+	double commandCount = drawCount * 3.0;
+	printf("dispatch benchmark, %u draws (%.0f commands): loader %.3f ms (%.1f ns a command), table %.3f ms (%.1f ns a command)\n",
+		drawCount, commandCount, loaderMilliseconds, loaderMilliseconds * 1.0e6 / commandCount,
+		tableMilliseconds, tableMilliseconds * 1.0e6 / commandCount);
+}
+
+void VulkanRenderer::setFrameReadback(ReadbackCallback callback){
+
+	if (!swapChainReadable) {
+		throw std::runtime_error("swapchain images can't be copied from on this surface, render headless to read frames back");
+	}
+
+	// a ring of one more than the frames in flight, so collecting a frame never waits on the GPU
+	frameReadback.create(mainDevice.physicalDevice, mainDevice.logicalDevice, &deviceAllocator, &frameScheduler,
+		swapChainExtent, swapChainImageFormat, callback, MAX_FRAME_DRAWS + 2);
+	readbackEnabled = true;
+}
+
+void VulkanRenderer::setDynamicGeometry(DynamicGeometryCallback callback){
+
+	dynamicGeometryCallback = callback;
+}
+
+VkDeviceSize VulkanRenderer::getDynamicStreamedBytes(){
+
+	return dynamicStreamedBytes;
+}
+
+DebugDraw &VulkanRenderer::getDebugDraw(){
+
+	return debugDraw;
+}
+
+void VulkanRenderer::setParticleEmitter(const ParticleEmitter &emitter){
+
+	particleSystem.setEmitter(emitter);
+}
+
+bool VulkanRenderer::benchmarkParticles(uint32_t maxParticles){
+
+	const uint32_t stepCount = 10;
+
+	VkCommandBufferAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = graphicsCommandPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = 1;
+
+	VkCommandBuffer commandBuffer;
+	VkResult result = vkAllocateCommandBuffers(mainDevice.logicalDevice, &allocateInfo, &commandBuffer);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate a benchmark command buffer");
+	}
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	// the live count after filling each system is read back here, so a kernel that didn't run shows up as a mismatch
+	VkBuffer countBuffer;
+	VkDeviceMemory countMemory;
+	createBuffer(mainDevice.physicalDevice, mainDevice.logicalDevice, sizeof(uint32_t), VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &countBuffer, &countMemory, &deviceAllocator);
+	UniqueDeviceMemory ownedCountMemory(&deviceAllocator, countMemory);
+	UniqueBuffer ownedCountBuffer(mainDevice.logicalDevice, countBuffer);
+
+	void * countData;
+	vkMapMemory(mainDevice.logicalDevice, countMemory, 0, sizeof(uint32_t), 0, &countData);
+
+	// record steps updates of the system, submit them alone and wait for them
+	auto run = [&](ParticleSystem &system, uint32_t steps, bool copyCount) {
+		deviceDispatch.vkBeginCommandBuffer(commandBuffer, &beginInfo);
+		for (uint32_t step = 0; step < steps; step++) {
+			system.update(1.0f / 60.0f);
+			system.recordUpdate(commandBuffer);
+		}
+		if (copyCount) {
+			system.recordCountCopy(commandBuffer, countBuffer, 0);
+		}
+		deviceDispatch.vkEndCommandBuffer(commandBuffer);
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+
+		auto startTime = std::chrono::steady_clock::now();
+		frameScheduler.wait(frameScheduler.submit(graphicsQueue, submitInfo));
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	};
+
+	bool failed = false;
+
+	// particles that outlive the benchmark, so every step simulates and compacts all of them
+	ParticleEmitter emitter;
+	emitter.lifetime = 1.0e6f;
+	emitter.gravity = glm::vec3(0.0f);
+	emitter.velocity = glm::vec3(0.0f);
+	emitter.spread = 0.0f;
+
+	for (uint64_t count = 10000; count <= maxParticles; count *= 10) {
+		ParticleSystem system;
+		try
+		{
+			system.create(mainDevice.physicalDevice, mainDevice.logicalDevice, &shaderManager, &deviceAllocator, static_cast<uint32_t>(count));
+		}
+		catch (const std::runtime_error &e)
+		{
+			printf("ERROR: particle benchmark stopped at %llu particles: %s\n", static_cast<unsigned long long>(count), e.what());
+			system.destroy();
+			break;
+		}
+		system.setEmitter(emitter);
+
+		// fill the system in one update, then time the steps on their own
+		*static_cast<uint32_t *>(countData) = 0;
+		system.emitBurst(static_cast<uint32_t>(count));
+		run(system, 1, true);
+		uint32_t liveCount = *static_cast<uint32_t *>(countData);
+		if (liveCount != count) {
+			printf("ERROR: particle benchmark emitted %llu particles but %u are alive\n", static_cast<unsigned long long>(count), liveCount);
+			failed = true;
+		}
+		double milliseconds = run(system, stepCount, false) / stepCount;
+
+		printf("particle benchmark, %llu particles: %.3f ms a step (%.2f ns a particle)\n", static_cast<unsigned long long>(count),
+			milliseconds, milliseconds * 1.0e6 / count);
+
+		// the GPU is idle, so the buffers can go straight away
+		system.destroy();
+	}
+
+	vkUnmapMemory(mainDevice.logicalDevice, countMemory);
+	vkFreeCommandBuffers(mainDevice.logicalDevice, graphicsCommandPool, 1, &commandBuffer);
+
+	return !failed;
+}
+
+
+VulkanRenderer::~VulkanRenderer()
+{
+}
+
+void VulkanRenderer::createInstance()
+{
+#if VULKAN_VALIDATION_ENABLED
+	// on in builds with validation unless turned off
+	const char * validationSetting = std::getenv("VULKAN_VALIDATION");
+	validationEnabled = validationSetting == nullptr || strcmp(validationSetting, "0") != 0;
+
+	if (validationEnabled && !checkValidationLayerSupport()) {
+		throw std::runtime_error("validation layers requested but not available!");
+	}
+#endif
+
+	// information about the application
+	// most data here does not affect the program and it is for dev convenience
+	VkApplicationInfo appInfo = {};
+	appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	appInfo.pApplicationName = "Vulkan App x64";			// custom name of the application
+	appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);	// custom version of the application
+	appInfo.pEngineName = "No Engine";						// custom engine name
+	appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);		// custom engine version
+	appInfo.apiVersion = VK_API_VERSION_1_2;				// the vulkan version
+
+
+	// creation information for a VkInstance 
+	VkInstanceCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	createInfo.pApplicationInfo = &appInfo;
+
+
+	// create list to hold instance extensions
+	std::vector<const char*> instanceExtensions = std::vector<const char*>();
+
+	// set up extensions instance will use
+	uint32_t glfwExtensionCount = 0;						// GLFW may require multiple extensions
+	const char** glfwExtensions = nullptr;					// extesions passed as array of cstrings, so need pointer (array) to pointer (cstring)
+
+	// get GLFW extensions, they are all for the surface so headless needs none (and GLFW may not even be initialized)
+	if (!headless) {
+		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+	}
+
+	// add GLFW extensions to list of extensions
+	for (size_t i = 0; i < glfwExtensionCount; i++) {
+
+		instanceExtensions.push_back(glfwExtensions[i]);
+	}
+
+	if (validationEnabled) {
+		instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+	}
+	// check instance extensions supported
+	if (!checkInstanceExtensionSupport(&instanceExtensions)) {
+		
+		throw std::runtime_error("VkInstance does not uspport required extensions!");
+	}
+
+	
+	createInfo.enabledExtensionCount = static_cast<uint32_t>(instanceExtensions.size());
+	createInfo.ppEnabledExtensionNames = instanceExtensions.data();
+	
+	createInfo.enabledLayerCount = 0;
+	createInfo.ppEnabledLayerNames = nullptr;
+
+#if VULKAN_VALIDATION_ENABLED
+	if (validationEnabled) {
+		createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
+		createInfo.ppEnabledLayerNames = validationLayers.data();
+	}
+#endif
+
+	// create instance
+	VkResult result = vkCreateInstance(&createInfo, nullptr, &instance);
+
+	if (result != VK_SUCCESS) {
+		
+		throw std::runtime_error("failed to create a vulkan instance");
+	}
+
+}
+
+
+void VulkanRenderer::createDebugMessenger() {
+#if VULKAN_VALIDATION_ENABLED
+	if (!validationEnabled) return;
+
+	// warnings and errors by default, VULKAN_VALIDATION_SEVERITY=verbose|info|warning|error changes the minimum and
+	// VULKAN_VALIDATION_IGNORE takes a comma separated list of message ID names or numbers to drop
+	validationLog.create(ValidationLog::parseSeverity(std::getenv("VULKAN_VALIDATION_SEVERITY"), VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT),
+		ValidationLog::parseList(std::getenv("VULKAN_VALIDATION_IGNORE")));
+
+	VkDebugUtilsMessengerCreateInfoEXT createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+	createInfo.messageSeverity = validationLog.getSeverityMask();		// the layer doesn't even format messages below the minimum
+	createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+	createInfo.pfnUserCallback = ValidationLog::callback;
+	createInfo.pUserData = &validationLog;
+
+	VkResult result = CreateDebugUtilsMessengerEXT(instance, &createInfo, nullptr, &debugMessenger);
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to set up debug messenger!");
+	}
+#endif
+}
+
+void VulkanRenderer::createLogicalDevice()
+{
+	// get the queue family indices for the choosen physical device
+	QueueFamilyIndices indices = getQueueFamilies(mainDevice.physicalDevice);
+
+	// vector for queue creation information and set for family indices
+	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+	std::set<int> queueFamilyIndices = { indices.graphicsFamily, indices.presentationFamily };
+
+	// async compute needs a family of its own to run alongside graphics, VULKAN_ASYNC_COMPUTE=0 keeps it on the graphics queue
+	const char * asyncComputeSetting = std::getenv("VULKAN_ASYNC_COMPUTE");
+	asyncComputeEnabled = indices.computeFamily != indices.graphicsFamily
+		&& (asyncComputeSetting == nullptr || std::string(asyncComputeSetting) != "0");
+	if (asyncComputeEnabled) {
+		queueFamilyIndices.insert(indices.computeFamily);
+	}
+
+	// Queues the logica device needs to create and info to do so 
+	for (int queueFamilyIndex : queueFamilyIndices) {
+
+		VkDeviceQueueCreateInfo queueCreateInfo = {};
+		queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queueCreateInfo.queueFamilyIndex = queueFamilyIndex;				// the index of the family to create a queue from
+		queueCreateInfo.queueCount = 1;										// number of queues to create
+		float priority = 1.0f;
+		queueCreateInfo.pQueuePriorities = &priority;						// vulkan needs to know how to handle multiple queues, so decide prioriy (1 highest)
+	
+		queueCreateInfos.push_back(queueCreateInfo);
+	}
+
+	// information to create logical device (somestimes called "device")
+	VkDeviceCreateInfo deviceCreateInfo = {};
+	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());		// number of queue create infos
+	deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();								// list of queue create infos so device can create required queues
+
+	// -- OPTIONAL FEATURES --
+	// meshlet drawing uses whichever of these the device has, and falls back without them
+	bool meshShaderExtension = checkDeviceExtensionAvailable(mainDevice.physicalDevice, VK_EXT_MESH_SHADER_EXTENSION_NAME);
+
+	VkPhysicalDeviceMeshShaderFeaturesEXT supportedMeshShaderFeatures = {};
+	supportedMeshShaderFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+
+	// render passes and framebuffers are the fallback without dynamic rendering (core in 1.3, an extension before),
+	// VULKAN_DYNAMIC_RENDERING=0 forces them
+	const char * dynamicRenderingSetting = std::getenv("VULKAN_DYNAMIC_RENDERING");
+	bool dynamicRenderingExtension = checkDeviceExtensionAvailable(mainDevice.physicalDevice, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)
+		&& (dynamicRenderingSetting == nullptr || std::string(dynamicRenderingSetting) != "0");
+
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR supportedDynamicRenderingFeatures = {};
+	supportedDynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+	supportedDynamicRenderingFeatures.pNext = meshShaderExtension ? &supportedMeshShaderFeatures : nullptr;
+
+	VkPhysicalDeviceVulkan12Features supportedVulkan12Features = {};
+	supportedVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	supportedVulkan12Features.pNext = dynamicRenderingExtension ? &supportedDynamicRenderingFeatures : supportedDynamicRenderingFeatures.pNext;
+
+	VkPhysicalDeviceFeatures2 supportedFeatures = {};
+	supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	supportedFeatures.pNext = &supportedVulkan12Features;
+	vkGetPhysicalDeviceFeatures2(mainDevice.physicalDevice, &supportedFeatures);
+
+	multiDrawIndirectEnabled = supportedFeatures.features.multiDrawIndirect == VK_TRUE;
+	drawIndirectCountEnabled = supportedVulkan12Features.drawIndirectCount == VK_TRUE;
+	meshShaderEnabled = meshShaderExtension && supportedMeshShaderFeatures.taskShader == VK_TRUE && supportedMeshShaderFeatures.meshShader == VK_TRUE;
+	pipelineStatisticsEnabled = supportedFeatures.features.pipelineStatisticsQuery == VK_TRUE;
+	dynamicRenderingEnabled = dynamicRenderingExtension && supportedDynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+
+	// budgets from the driver, the allocator falls back to counting its own allocations without it
+	memoryBudgetEnabled = checkDeviceExtensionAvailable(mainDevice.physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+	// GPU timestamps on the CPU clock for the profiler, which approximates it without
+	calibratedTimestampsEnabled = checkDeviceExtensionAvailable(mainDevice.physicalDevice, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+
+	// the required extensions are for presenting, which headless rendering doesn't
+	std::vector<const char *> enabledExtensions;
+	if (!headless) {
+		enabledExtensions = deviceExtensions;
+	}
+	if (meshShaderEnabled) {
+		enabledExtensions.push_back(VK_EXT_MESH_SHADER_EXTENSION_NAME);
+	}
+	if (memoryBudgetEnabled) {
+		enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
+	if (calibratedTimestampsEnabled) {
+		enabledExtensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+	}
+	if (dynamicRenderingEnabled) {
+		enabledExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+	}
+
+	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());	// number of enabled logical device extensions
+	deviceCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();						// list of enabled logical device extensions
+	
+	// physical device features the logical device will be using
+	VkPhysicalDeviceFeatures deviceFeatures = {};
+	deviceFeatures.multiDrawIndirect = multiDrawIndirectEnabled ? VK_TRUE : VK_FALSE;		// all of a mesh's meshlet draws in one call
+	deviceFeatures.pipelineStatisticsQuery = pipelineStatisticsEnabled ? VK_TRUE : VK_FALSE;		// per pass GPU counters
+	deviceFeatures.textureCompressionBC = supportedFeatures.features.textureCompressionBC;		// block compressed textures, whichever
+	deviceFeatures.textureCompressionETC2 = supportedFeatures.features.textureCompressionETC2;	// families the device has
+	deviceFeatures.textureCompressionASTC_LDR = supportedFeatures.features.textureCompressionASTC_LDR;
+
+	deviceCreateInfo.pEnabledFeatures = &deviceFeatures;				// physical device features logical device will use
+
+	// vulkan 1.2 features, timeline semaphores are used for all cpu/gpu synchronization
+	VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+	vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	vulkan12Features.timelineSemaphore = VK_TRUE;
+	vulkan12Features.drawIndirectCount = drawIndirectCountEnabled ? VK_TRUE : VK_FALSE;	// only visible meshlets are drawn, counted on the GPU
+
+	VkPhysicalDeviceMeshShaderFeaturesEXT meshShaderFeatures = {};
+	meshShaderFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+	meshShaderFeatures.taskShader = VK_TRUE;
+	meshShaderFeatures.meshShader = VK_TRUE;
+	if (meshShaderEnabled) {
+		vulkan12Features.pNext = &meshShaderFeatures;
+	}
+
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures = {};
+	dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+	dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+	if (dynamicRenderingEnabled) {
+		dynamicRenderingFeatures.pNext = vulkan12Features.pNext;
+		vulkan12Features.pNext = &dynamicRenderingFeatures;
+	}
+
+	deviceCreateInfo.pNext = &vulkan12Features;
+
+	// create the logical device for the given physical device
+	VkResult result = vkCreateDevice(mainDevice.physicalDevice, &deviceCreateInfo, nullptr, &mainDevice.logicalDevice);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create logical device");
+	 }
+
+	// Queues are created at the same time as the device
+	// so we want to hand the quees
+	// given logical device of given queue family of given queue index (0 since olny one queue) place reference in given queue
+	vkGetDeviceQueue(mainDevice.logicalDevice, indices.graphicsFamily, 0, &graphicsQueue);
+	vkGetDeviceQueue(mainDevice.logicalDevice, indices.presentationFamily, 0, &presentationQueue);
+	vkGetDeviceQueue(mainDevice.logicalDevice, asyncComputeEnabled ? indices.computeFamily : indices.graphicsFamily, 0, &computeQueue);
+
+	// per frame commands skip the loader from here on, this includes the enabled extensions' commands
+	deviceDispatch.load(mainDevice.logicalDevice);
+}
+
+void VulkanRenderer::createSurface() {
+	// create Surface (creates a surface create info struct, runs the create surface function, returns VK result)
+	VkResult result = glfwCreateWindowSurface(instance, window, nullptr, &surface);
+	
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create a surface");
+	}
+
+}
+
+void VulkanRenderer::createSwapChain(){
+	// get swapchain details so we can pick best settings
+	SwapChainDetails swapChainDetails = getSwapChainDetails(mainDevice.physicalDevice);
+
+	// find optimal surface values for our swap chain
+	VkSurfaceFormatKHR surfaceFormat = chooseBestSurfaceFormat(swapChainDetails.formats);
+	VkPresentModeKHR presentMode = chooseBestPresentationMode(swapChainDetails.presentationModes);
+	VkExtent2D extent = chooseSwapExtent(swapChainDetails.surfaceCapabilities);
+
+	// how many images are in the swap chain? get 1 more than the minimum to allow triple buffering
+	uint32_t imageCount = swapChainDetails.surfaceCapabilities.minImageCount + 1;
+
+	// if adding one goes over maximum, make max our imageCount
+	// if 0 then limitless
+	if (swapChainDetails.surfaceCapabilities.maxImageCount > 0 && swapChainDetails.surfaceCapabilities.maxImageCount < imageCount) {
+		imageCount = swapChainDetails.surfaceCapabilities.maxImageCount;
+	}
+
+	// creation information for swapchain
+	VkSwapchainCreateInfoKHR swapChainCreateInfo = {};
+	swapChainCreateInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+	swapChainCreateInfo.surface = surface;														// swap chain surface
+	swapChainCreateInfo.imageFormat = surfaceFormat.format;										// swap chain format
+	swapChainCreateInfo.imageColorSpace = surfaceFormat.colorSpace;								// swap chain color space
+	swapChainCreateInfo.presentMode = presentMode;												// swap chain presentation mode
+	swapChainCreateInfo.imageExtent = extent;													// swap chain image extent
+	swapChainCreateInfo.minImageCount = imageCount;												// minimum images in swapchain
+	swapChainCreateInfo.imageArrayLayers = 1;													// number of layers for each image in chain
+	swapChainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;						// what attachment images will be used as
+
+	// also a copy source when the surface allows it, so frames can be read back
+	swapChainReadable = (swapChainDetails.surfaceCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+	if (swapChainReadable) {
+		swapChainCreateInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	}
+	swapChainCreateInfo.preTransform = swapChainDetails.surfaceCapabilities.currentTransform;	// transform to perform on swap chain
+	swapChainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;						// how to handle blending images with external graphics
+	swapChainCreateInfo.clipped = VK_TRUE;														// whether to clip parts of image
+
+	// get queue family indices
+	QueueFamilyIndices indices = getQueueFamilies(mainDevice.physicalDevice);
+
+	// if graphics and presentation families are different, then swapchain must let images be shared between families
+
+	
+
+	if (indices.graphicsFamily != indices.presentationFamily) {
+
+		// queues to share between
+		uint32_t queueFamilyIndices[] = {
+			(uint32_t)indices.graphicsFamily,
+			(uint32_t)indices.presentationFamily
+		};
+
+		swapChainCreateInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;		// image share handling
+		swapChainCreateInfo.queueFamilyIndexCount = 2;							// number of ques to share images between
+		swapChainCreateInfo.pQueueFamilyIndices = queueFamilyIndices;			// array of queues to share between
+	}
+	else
+	{
+		swapChainCreateInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		swapChainCreateInfo.queueFamilyIndexCount = 0;
+		swapChainCreateInfo.pQueueFamilyIndices = nullptr;
+	}
+
+	// if old swap chain been destroyed and this one replaces it, then link old one to quicly hand over responsibilities
+	swapChainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
+
+	// create swapchain
+
+	VkResult result = vkCreateSwapchainKHR(mainDevice.logicalDevice, &swapChainCreateInfo, nullptr, &swapchain);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create a Swapchain!");
+	}
+
+	// store for later reference
+	swapChainImageFormat = surfaceFormat.format;
+	swapChainExtent = extent;
+
+	// get swapchain images (first count, then values)
+	uint32_t swapChainImageCount;
+	vkGetSwapchainImagesKHR(mainDevice.logicalDevice, swapchain, &swapChainImageCount, nullptr);
+
+	std::vector<VkImage> images(swapChainImageCount);
+	vkGetSwapchainImagesKHR(mainDevice.logicalDevice, swapchain, &swapChainImageCount, images.data());
+
+	for (VkImage image : images) {
+
+		// store image handle
+		SwapChainImage swapChainImage = {};
+		swapChainImage.image = image;
+		swapChainImage.imageView = createImageView(mainDevice.logicalDevice, image, swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+
+		// add to swapchain image list
+		swapChainImages.push_back(swapChainImage);
+	}
+}
+
+void VulkanRenderer::createOffscreenTargets(){
+
+	// stand ins for the swapchain's images, one for each frame in flight so a frame's wait frees its target like an
+	// acquire would. the format is a color attachment and copy source on every device
+	swapChainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+	swapChainExtent = headlessExtent;
+	swapChainReadable = true;
+	colorTargetLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	for (int i = 0; i < MAX_FRAME_DRAWS; i++) {
+
+		VkImage image;
+		VkDeviceMemory memory;
+		createImage(mainDevice.physicalDevice, mainDevice.logicalDevice, swapChainExtent.width, swapChainExtent.height, 1, swapChainImageFormat,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &image, &memory, &deviceAllocator);
+		offscreenImages.push_back(UniqueImage(mainDevice.logicalDevice, image));
+		offscreenMemory.push_back(UniqueDeviceMemory(&deviceAllocator, memory));
+
+		SwapChainImage swapChainImage = {};
+		swapChainImage.image = image;
+		swapChainImage.imageView = createImageView(mainDevice.logicalDevice, image, swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+		swapChainImages.push_back(swapChainImage);
+	}
+}
+
+void VulkanRenderer::createRenderPass(){
+
+	// frames are drawn in two render passes around occlusion culling:
+	// the early pass clears and draws what was visible last frame, the late pass loads its results and
+	// draws what the culler found newly visible. both use the same attachments so they share framebuffers
+
+	// color attachment of render pass
+	VkAttachmentDescription colorAttachment = {};
+	colorAttachment.format = swapChainImageFormat;						// format to use for attachment
+	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;					// number of samples to write for multisampling 
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;				// describes what to do with attachment before rendering
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;				// describes what to do with attachment after rendering
+	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;	// describes what to do with stencil before rendering
+	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;	// describes what to do with stencil after rendering
+
+	// framebuffer data will be stored as an image, but images can be given different data layouts
+	// to give optimal use for certain operation
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;		// image data layout before render pass starts
+	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;		// image data layout after render pass (to change to), the render graph moves it on
+
+	// depth attachment of render pass, sampled between the passes to build the depth pyramid
+	VkAttachmentDescription depthAttachment = {};
+	depthAttachment.format = depthBufferFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
+
+	// attachment reference uses an attachment index that refers to index in the attachment list passed to renderpasscreateinfo
+	VkAttachmentReference colorAttachmentReference = {};
+	colorAttachmentReference.attachment = 0;							// index of the attachment in the render pass
+	colorAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference depthAttachmentReference = {};
+	depthAttachmentReference.attachment = 1;
+	depthAttachmentReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	// information about a partiucular subpass the render pass is using
+	VkSubpassDescription subPass = {};
+	subPass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;		// pipeline type subpass is to be bound to
+	subPass.colorAttachmentCount = 1;
+	subPass.pColorAttachments = &colorAttachmentReference;
+	subPass.pDepthStencilAttachment = &depthAttachmentReference;
+
+	// no subpass dependencies, attachments are already in their layouts when the pass begins and the render graph
+	// records the barriers around it
+
+	// create info for render pass
+	VkRenderPassCreateInfo renderPassCreateInfo = {};
+	renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	renderPassCreateInfo.pAttachments = attachments.data();
+	renderPassCreateInfo.subpassCount = 1;
+	renderPassCreateInfo.pSubpasses = &subPass;
+	renderPassCreateInfo.dependencyCount = 0;
+	renderPassCreateInfo.pDependencies = nullptr;
+
+	VkResult result = vkCreateRenderPass(mainDevice.logicalDevice, &renderPassCreateInfo, nullptr, &renderPass);
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create a render pass!");
+	}
+
+	// -- LATE RENDER PASS --
+	// keeps everything the early pass drew
+	attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+	result = vkCreateRenderPass(mainDevice.logicalDevice, &renderPassCreateInfo, nullptr, &lateRenderPass);
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create a render pass!");
+	}
+}
+
+void VulkanRenderer::createGraphicsPipeline() {
+
+	// -- PIPELINE LAYOUT --
+	// set 0: the meshlet culler's buffers, read by mesh shaders (vertex pipelines leave it unused)
+	// set 1: the mesh's texture, read by the fragment shader
+	std::array<VkDescriptorSetLayout, 2> setLayouts = { meshletCuller.getDescriptorSetLayout(), textureManager.getDescriptorSetLayout() };
+
+	VkPushConstantRange meshletPushConstantRange = {};
+	meshletPushConstantRange.stageFlags = VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT;
+	meshletPushConstantRange.offset = 0;
+	meshletPushConstantRange.size = sizeof(MeshletConstants);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+	pipelineLayoutCreateInfo.pSetLayouts = setLayouts.data();
+	pipelineLayoutCreateInfo.pushConstantRangeCount = meshShaderEnabled ? 1 : 0;
+	pipelineLayoutCreateInfo.pPushConstantRanges = meshShaderEnabled ? &meshletPushConstantRange : nullptr;
+
+	// create pipeline layout
+	VkPipelineLayout layout;
+	VkResult result = vkCreatePipelineLayout(mainDevice.logicalDevice, &pipelineLayoutCreateInfo, nullptr, &layout);
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout");
+	}
+	pipelineLayout = UniquePipelineLayout(mainDevice.logicalDevice, layout);
+
+	// -- GRAPHICS PIPELINE CREATION --
+	// variants are compiled by the pipeline manager on worker threads, with shader modules
+	// shared through the shader manager. replaced pipelines go through the deletion queue
+	RenderTarget renderTarget;
+	renderTarget.renderPass = dynamicRenderingEnabled ? VK_NULL_HANDLE : renderPass;
+	renderTarget.colorFormat = swapChainImageFormat;
+	renderTarget.depthFormat = depthBufferFormat;
+	pipelineManager.create(mainDevice.logicalDevice, renderTarget, pipelineLayout.get(), swapChainExtent, &shaderManager, &deletionQueue);
+
+	// default pipeline is compiled straight away and stands in for any variant still compiling
+	graphicsPipelineHandle = pipelineManager.requestNow(PipelineState());
+	pipelineManager.setPlaceholder(graphicsPipelineHandle);
+
+	// the placeholder can't stand in for a mesh shader pipeline, so it is compiled straight away too
+	if (meshShaderEnabled) {
+		PipelineState meshletState;
+		meshletState.vertexShader.clear();
+		meshletState.taskShader = "Shaders/meshlet.task";
+		meshletState.meshShader = "Shaders/meshlet.mesh";
+		meshletPipelineHandle = pipelineManager.requestNow(meshletState);
+	}
+
+	// particles are blended over the scene without writing depth, and are quads facing either way
+	PipelineState particleState;
+	particleState.vertexShader = "Shaders/particle.vert";
+	particleState.fragmentShader = "Shaders/particle.frag";
+	particleState.vertexLayout = VERTEX_LAYOUT_PARTICLE;
+	particleState.cullMode = VK_CULL_MODE_NONE;
+	particleState.depthWriteEnable = false;
+	particlePipelineHandle = pipelineManager.request(particleState);
+}
+
+void VulkanRenderer::createRenderGraph(){
+
+	// depth format that can be both rendered to and sampled (for the depth pyramid)
+	depthBufferFormat = chooseSupportedFormat(
+		{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+
+	// -- RESOURCES --
+	// the swapchain image is acquired for color output, and left there in the present layout (an offscreen target in
+	// the attachment layout) so the readback copy (recorded after the graph) can follow on from it
+	swapChainColorResource = renderGraph.importImage("swapchain color", VK_IMAGE_ASPECT_COLOR_BIT,
+		{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED },
+		{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, colorTargetLayout });
+	depthResource = renderGraph.createTransientImage("depth", depthBufferFormat, swapChainExtent,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+	// the occlusion culler's per frame draw lists, the meshlet culler's buffers are synchronized by the culler
+	earlyDrawsResource = renderGraph.importBuffer("early draws");
+	lateDrawsResource = renderGraph.importBuffer("late draws");
+
+	// the particles the late pass draws and their indirect draw, written on async compute which the frame waits on
+	particleStateResource = renderGraph.importBuffer("particles");
+	particleControlResource = renderGraph.importBuffer("particle control");
+
+	VkPipelineStageFlags drawReadStages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+	VkAccessFlags drawReadAccess = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	if (meshShaderEnabled) {
+		drawReadStages |= VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT;
+		drawReadAccess |= VK_ACCESS_SHADER_READ_BIT;
+	}
+
+	VkPipelineStageFlags depthStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	VkAccessFlags depthAccess = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	VkAccessFlags colorAccess = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+	// -- EARLY PASS --
+	// draw what was visible last frame
+	uint32_t earlyCull = renderGraph.addPass("early cull", [this](VkCommandBuffer commandBuffer) {
+		occlusionCuller.recordEarlyCull(commandBuffer, currentFrame);
+		meshletCuller.recordCull(commandBuffer, currentFrame, false);
+	});
+	renderGraph.writeBuffer(earlyCull, earlyDrawsResource, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+	uint32_t earlyDraw = renderGraph.addPass("early draw", [this](VkCommandBuffer commandBuffer) {
+		recordRenderPass(commandBuffer, false);
+	});
+	renderGraph.readBuffer(earlyDraw, earlyDrawsResource, drawReadStages, drawReadAccess);
+	renderGraph.writeImage(earlyDraw, swapChainColorResource, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, colorAccess,
+		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+	renderGraph.writeImage(earlyDraw, depthResource, depthStages, depthAccess, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+
+	// -- LATE PASS --
+	// build the depth pyramid from the early pass and draw whatever it shows just became visible
+	uint32_t lateCull = renderGraph.addPass("late cull", [this](VkCommandBuffer commandBuffer) {
+		occlusionCuller.recordDepthPyramid(commandBuffer);
+		occlusionCuller.recordLateCull(commandBuffer, currentFrame);
+		meshletCuller.recordCull(commandBuffer, currentFrame, true);
+	});
+	renderGraph.readImage(lateCull, depthResource, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	renderGraph.writeBuffer(lateCull, lateDrawsResource, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+	uint32_t lateDraw = renderGraph.addPass("late draw", [this](VkCommandBuffer commandBuffer) {
+		recordRenderPass(commandBuffer, true);
+	});
+	renderGraph.readBuffer(lateDraw, lateDrawsResource, drawReadStages, drawReadAccess);
+	renderGraph.readBuffer(lateDraw, particleStateResource, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+	renderGraph.readBuffer(lateDraw, particleControlResource, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+	renderGraph.writeImage(lateDraw, swapChainColorResource, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, colorAccess,
+		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+	renderGraph.writeImage(lateDraw, depthResource, depthStages, depthAccess, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+
+	renderGraph.compile();
+
+	// the compiled graph can be looked at with graphviz
+	const char * dumpFile = std::getenv("RENDER_GRAPH_DUMP");
+	if (dumpFile != nullptr) {
+		renderGraph.dump(dumpFile);
+	}
+}
+
+void VulkanRenderer::createFrameBuffers(){
+
+	// resize frame buffer count to swapchain image count
+	swapChainFrameBuffers.resize(swapChainImages.size());
+
+	// create a framebuffer for each swapchain image
+	for (size_t i = 0; i < swapChainFrameBuffers.size(); i++){
+		
+		std::array<VkImageView, 2> attachments = {
+			swapChainImages[i].imageView,
+			renderGraph.getImageView(depthResource)
+		};
+
+		VkFramebufferCreateInfo framebufferCreateInfo = {};
+		framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferCreateInfo.renderPass = renderPass;											// render pass layout the frame buffer will be using
+		framebufferCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());		
+		framebufferCreateInfo.pAttachments = attachments.data();								// list of attachments (1:1 awith render pass)
+		framebufferCreateInfo.width = swapChainExtent.width;									// frame buffer widht
+		framebufferCreateInfo.height = swapChainExtent.height;									// frame buffer height
+		framebufferCreateInfo.layers = 1;														// frame buffer layers
+
+		VkResult result = vkCreateFramebuffer(mainDevice.logicalDevice, &framebufferCreateInfo, nullptr, &swapChainFrameBuffers[i]);
+
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error("falied to create framebuffer");
+		}
+	}
+}
+
+void VulkanRenderer::createCommandPool(){
+
+	// get indices of queue families from device
+	QueueFamilyIndices queueFamilyIndices = getQueueFamilies(mainDevice.physicalDevice);
+
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;	// command buffers are re-recorded every frame
+	poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;	// queue family type that buffers from this command pool will use
+
+	// createa a graphics queue family command pool
+	VkResult result = vkCreateCommandPool(mainDevice.logicalDevice, &poolInfo, nullptr, &graphicsCommandPool);
+	
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create command buffer pool");
+	}
+}
+
+void VulkanRenderer::createCommandBuffers(){
+
+	// one command buffer per frame in flight, each is re-recorded once its frame has finished
+	commandBuffers.resize(MAX_FRAME_DRAWS);
+
+	VkCommandBufferAllocateInfo cbAllocInfo = {};
+	cbAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	cbAllocInfo.commandPool = graphicsCommandPool;
+	cbAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;	// VK_COMMAND_BUFFER_LEVEL_PRIMARY buffer will submit directly to the pool, can't be called from other command buffers
+															// VK_COMMAND_BUFFER_LEVEL_SECONDARY can't be called directrly, but can be colled from other buffers via vkCommandExecuteBuffers
+	cbAllocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+	// allocate command buffers and place handles in array of buffers
+	VkResult result = vkAllocateCommandBuffers(mainDevice.logicalDevice, &cbAllocInfo, commandBuffers.data());
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate command buffers");
+	}
+
+}
+
+void VulkanRenderer::createSynchronization() {
+
+	imageAvailable.resize(MAX_FRAME_DRAWS);
+	renderFinished.resize(MAX_FRAME_DRAWS);
+	// Semaphore creation information
+	// acquire and present only accept binary semaphores, everything else waits on the timeline
+	VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	for (size_t i = 0; i < MAX_FRAME_DRAWS; i++) {
+
+		if (vkCreateSemaphore(mainDevice.logicalDevice, &semaphoreCreateInfo, nullptr, &imageAvailable[i]) != VK_SUCCESS || 
+			vkCreateSemaphore(mainDevice.logicalDevice, &semaphoreCreateInfo, nullptr, &renderFinished[i]) != VK_SUCCESS) {
+
+			throw std::runtime_error("failed to create a semaphore");
+		}
+	}
+
+	// timeline value 0 is signalled from the start, so nothing waits before the first submission
+	frameScheduler.create(mainDevice.logicalDevice, MAX_FRAME_DRAWS);
+}
+
+void VulkanRenderer::recordCommands(uint32_t currentImage) {
+
+	PROFILE_FUNCTION();
+
+	// information about how to begin each command buffer
+	VkCommandBufferBeginInfo bufferBeginInfo = {};
+	bufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	bufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;		// buffer is re-recorded before every submission
+
+	// command buffer of the current frame, its previous submission has already finished
+	VkCommandBuffer commandBuffer = commandBuffers[currentFrame];
+
+	// start recording commands to command buffer (implicitly resets it)
+	VkResult result = deviceDispatch.vkBeginCommandBuffer(commandBuffer, &bufferBeginInfo);
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to start recording a command buffer");
+	}
+
+#if PROFILER_ENABLED
+	gpuProfiler.beginFrame(commandBuffer, currentFrame);
+	GpuProfiler * passProfiler = &gpuProfiler;
+#else
+	GpuProfiler * passProfiler = nullptr;
+#endif
+	gpuStatistics.beginFrame(commandBuffer, currentFrame);
+	asyncCompute.beginGraphics(commandBuffer, currentFrame);
+
+	// -- OCCLUSION CULLING --
+	// inputs were built by the frame jobs from the transforms, a job that threw is rethrown here. both counters are
+	// waited on first so no job still reads the scene graph, and a failed transform update is the one reported
+	{
+		PROFILE_SCOPE("waitForFrameJobs");
+		std::exception_ptr transformError, cullInputError;
+		try
+		{
+			jobSystem->wait(&transformJobs);
+		}
+		catch (...)
+		{
+			transformError = std::current_exception();
+		}
+		try
+		{
+			jobSystem->wait(&cullInputJobs);
+		}
+		catch (...)
+		{
+			cullInputError = std::current_exception();
+		}
+		if (transformError) {
+			std::rethrow_exception(transformError);
+		}
+		if (cullInputError) {
+			std::rethrow_exception(cullInputError);
+		}
+	}
+	occlusionCuller.setObjects(currentFrame, cullObjects);
+	meshletCuller.setMeshes(currentFrame, meshletCullMeshes, meshListVersion);
+
+	// -- PASSES --
+	// culling and both render passes, with the barriers between them
+	recordingImage = currentImage;
+	renderGraph.setImportedImage(swapChainColorResource, swapChainImages[currentImage].image);
+	renderGraph.setImportedBuffer(earlyDrawsResource, occlusionCuller.getEarlyDrawBuffer(currentFrame));
+	renderGraph.setImportedBuffer(lateDrawsResource, occlusionCuller.getLateDrawBuffer(currentFrame));
+	renderGraph.setImportedBuffer(particleStateResource, particleSystem.getParticleBuffer());
+	renderGraph.setImportedBuffer(particleControlResource, particleSystem.getControlBuffer());
+	renderGraph.execute(commandBuffer, currentFrame, passProfiler, &gpuStatistics);
+
+	// -- READBACK --
+	// the finished image, before it is presented
+	if (readbackEnabled) {
+		frameReadback.recordCopy(commandBuffer, swapChainImages[currentImage].image, colorTargetLayout, frameNumber);
+	}
+	asyncCompute.endGraphics(commandBuffer, currentFrame);
+
+	// stop recording to command buffer
+	result = deviceDispatch.vkEndCommandBuffer(commandBuffer);
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to stop recording a command buffer");
+	}
+}
+
+void VulkanRenderer::recordRenderPass(VkCommandBuffer commandBuffer, bool latePhase){
+
+	// -- DYNAMIC RENDERING --
+	// the attachments are described as the pass begins, the early pass clears them and the late pass loads them.
+	// the render graph has already moved both in to their attachment layouts
+	if (dynamicRenderingEnabled) {
+		VkRenderingAttachmentInfoKHR colorAttachment = {};
+		colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+		colorAttachment.imageView = swapChainImages[recordingImage].imageView;
+		colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		colorAttachment.loadOp = latePhase ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.clearValue.color = { 0.6f, 0.65f, 0.4f, 1.0f };
+
+		// the depth pyramid is built from the early pass's depth, nothing reads the late pass's
+		VkRenderingAttachmentInfoKHR depthAttachment = {};
+		depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+		depthAttachment.imageView = renderGraph.getImageView(depthResource);
+		depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthAttachment.loadOp = latePhase ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = latePhase ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+		depthAttachment.clearValue.depthStencil.depth = 1.0f;
+
+		VkRenderingInfoKHR renderingInfo = {};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+		renderingInfo.renderArea.offset = { 0,0 };
+		renderingInfo.renderArea.extent = swapChainExtent;
+		renderingInfo.layerCount = 1;
+		renderingInfo.colorAttachmentCount = 1;
+		renderingInfo.pColorAttachments = &colorAttachment;
+		renderingInfo.pDepthAttachment = &depthAttachment;
+
+		deviceDispatch.vkCmdBeginRenderingKHR(commandBuffer, &renderingInfo);
+		recordMeshDraws(commandBuffer, latePhase);
+		deviceDispatch.vkCmdEndRenderingKHR(commandBuffer);
+		return;
+	}
+
+	// -- RENDER PASS --
+	// information about how to begin a  render pass (only needed for graphical application)
+	VkRenderPassBeginInfo renderPassBeginInfo = {};
+	renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassBeginInfo.renderPass = latePhase ? lateRenderPass : renderPass;	// render pass to begin
+	renderPassBeginInfo.renderArea.offset = { 0,0 };							// start point of render pass in pixels
+	renderPassBeginInfo.renderArea.extent = swapChainExtent;					// size of region to run render pass on (starting at offset)
+	std::array<VkClearValue, 2> clearValues = {};
+	clearValues[0].color = { 0.6f, 0.65f, 0.4f, 1.0f };
+	clearValues[1].depthStencil.depth = 1.0f;
+	renderPassBeginInfo.pClearValues = latePhase ? nullptr : clearValues.data();	// list of clear values, the late pass loads
+	renderPassBeginInfo.clearValueCount = latePhase ? 0 : static_cast<uint32_t>(clearValues.size());
+
+	renderPassBeginInfo.framebuffer = swapChainFrameBuffers[recordingImage];
+
+	deviceDispatch.vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	recordMeshDraws(commandBuffer, latePhase);
+	deviceDispatch.vkCmdEndRenderPass(commandBuffer);
+}
+
+void VulkanRenderer::updateMeshResidency(){
+
+	PROFILE_FUNCTION();
+
+	deviceAllocator.updateBudget();
+
+	// visibility comes from the occlusion culler, evicted meshes are still culled (as empty draws) so it is known
+	// when they come back in to view. meshes past the culler's capacity are always drawn
+	bool meshesChanged = false;
+	for (size_t j = 0; j < meshList.size(); j++) {
+
+		bool visible = j >= occlusionCuller.getMaxObjects() || occlusionCuller.isObjectVisible(static_cast<uint32_t>(j));
+		if (!visible) {
+			continue;
+		}
+
+		meshLastVisible[j] = frameNumber;
+		if (!meshList[j].isResident()) {
+			meshList[j].reload(&uploadManager);
+			meshesChanged = true;
+		}
+	}
+
+	// -- EVICTION --
+	// only mesh memory is compared against the meshes' share of the budget, so whatever else is in the heap (other
+	// resources, other processes) can't make every mesh out of view thrash
+	VkDeviceSize residentBytes = getResidentMeshBytes();
+	MemoryHeapBudget heapBudget = deviceAllocator.getDeviceLocalBudget();
+
+	// evicted buffers go through the deletion queue, the heap's usage still counts them until frames in flight are done
+	uint64_t completedValue = frameScheduler.getCompletedValue();
+	evictingMeshes.erase(std::remove_if(evictingMeshes.begin(), evictingMeshes.end(), [completedValue](const EvictingMesh &mesh) {
+		return mesh.value <= completedValue;
+	}), evictingMeshes.end());
+
+	VkDeviceSize evictingBytes = 0;
+	for (const EvictingMesh &mesh : evictingMeshes) {
+		evictingBytes += mesh.bytes;
+	}
+
+	// everything else in the heap. recycled blocks are counted as free, meshes may be given them again
+	VkDeviceSize meshRelatedBytes = residentBytes + evictingBytes + deviceAllocator.getRecycledBytes();
+	VkDeviceSize otherBytes = heapBudget.usage > meshRelatedBytes ? heapBudget.usage - meshRelatedBytes : 0;
+
+	// the meshes' share is what the rest of the heap leaves of its budget, and no more than the mesh budget.
+	// when the rest is over budget on its own no eviction can help, so only the mesh budget applies
+	VkDeviceSize meshLimit = meshMemoryBudget;
+	if (heapBudget.budget > otherBytes) {
+		VkDeviceSize heapShare = heapBudget.budget - otherBytes;
+		meshLimit = meshLimit == 0 ? heapShare : std::min(meshLimit, heapShare);
+	}
+
+	// once over the limit, evict down to a low water mark below it so the next few frames don't evict again.
+	// least recently visible first, never anything visible this frame
+	if (meshLimit != 0 && residentBytes > meshLimit) {
+
+		VkDeviceSize lowWater = meshLimit - meshLimit / 8;
+		while (residentBytes > lowWater) {
+
+			size_t leastRecent = meshList.size();
+			for (size_t j = 0; j < meshList.size(); j++) {
+				if (meshList[j].isResident() && meshLastVisible[j] < frameNumber &&
+					(leastRecent == meshList.size() || meshLastVisible[j] < meshLastVisible[leastRecent])) {
+					leastRecent = j;
+				}
+			}
+
+			if (leastRecent == meshList.size()) {
+				break;
+			}
+
+			VkDeviceSize meshBytes = meshList[leastRecent].getResidentBytes();
+			meshList[leastRecent].evict(&deletionQueue);
+			evictingMeshes.push_back({ frameScheduler.getLastSubmittedValue(), meshBytes });
+			residentBytes -= meshBytes;
+			meshesChanged = true;
+		}
+	}
+
+	if (meshesChanged) {
+		meshListVersion++;
+	}
+}
+
+void VulkanRenderer::startFrameJobs(){
+
+	PROFILE_FUNCTION();
+
+	// this frame's instance buffer is no longer read, so it can be brought up to date before recording draws from it.
+	// the scene graph and mesh list must not change until recordCommands has waited on these
+	int frame = currentFrame;
+	jobSystem->run([this, frame]() { sceneGraph.update(frame); }, &transformJobs);
+
+	size_t culledMeshCount = std::min<size_t>(meshList.size(), occlusionCuller.getMaxObjects());
+	cullObjects.resize(culledMeshCount);
+	meshletCullMeshes.resize(culledMeshCount);
+
+	// the batches are queued by a job that waits for the transforms, it is counted on the same counter so
+	// cullInputJobs can't reach zero before they are all queued
+	jobSystem->runAfter(&transformJobs, [this, culledMeshCount]() {
+		jobSystem->parallelFor(static_cast<uint32_t>(culledMeshCount), 256, [this](uint32_t begin, uint32_t end) {
+			buildCullInputs(begin, end);
+		}, &cullInputJobs);
+	}, &cullInputJobs);
+}
+
+void VulkanRenderer::buildCullInputs(uint32_t begin, uint32_t end){
+
+	PROFILE_FUNCTION();
+
+	for (uint32_t j = begin; j < end; j++) {
+
+		// every mesh is one object, there is no camera yet so world space bounds are already in clip space
+		glm::vec3 boundsMin, boundsMax;
+		transformBounds(sceneGraph.getWorldMatrix(meshNodes[j]), meshList[j].getBoundsMin(), meshList[j].getBoundsMax(), &boundsMin, &boundsMax);
+		cullObjects[j].boundsMin = glm::vec4(boundsMin, 1.0f);
+		cullObjects[j].boundsMax = glm::vec4(boundsMax, 1.0f);
+
+		// evicted meshes are still tested, as empty draws, so their visibility is known
+		bool resident = meshList[j].isResident();
+		cullObjects[j].indexCount = resident ? static_cast<uint32_t>(meshList[j].getIndexCount()) : 0;
+
+		// meshlets of the meshes that survive are culled again individually
+		meshletCullMeshes[j].meshletBuffer = meshList[j].getMeshletBuffer();
+		meshletCullMeshes[j].meshletVertexBuffer = meshList[j].getMeshletVertexBuffer();
+		meshletCullMeshes[j].meshletTriangleBuffer = meshList[j].getMeshletTriangleBuffer();
+		meshletCullMeshes[j].vertexBuffer = meshList[j].getVertexBuffer();
+		meshletCullMeshes[j].meshletCount = resident ? static_cast<uint32_t>(meshList[j].getMeshletCount()) : 0;
+		meshletCullMeshes[j].modelMatrix = sceneGraph.getWorldMatrix(meshNodes[j]);
+		meshletCullMeshes[j].instanceIndex = meshNodes[j];
+	}
+}
+
+void VulkanRenderer::recordMeshDraws(VkCommandBuffer commandBuffer, bool latePhase){
+
+	VkBuffer drawBuffer = latePhase ? occlusionCuller.getLateDrawBuffer(currentFrame) : occlusionCuller.getEarlyDrawBuffer(currentFrame);
+
+	// -- MESH SHADER DRAWS --
+	// the task shader culls the meshlets, and the mesh shader fetches the vertices itself
+	if (meshShaderEnabled) {
+
+		deviceDispatch.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineManager.getPipeline(meshletPipelineHandle));
+		gpuStatistics.countBinds(currentFrame, 1, 0, 0);
+
+		for (size_t j = 0; j < meshList.size(); j++) {
+			if (meshletCuller.isMeshCulled(currentFrame, j) && meshList[j].isResident()) {
+				VkDescriptorSet textureSet = textureManager.getDescriptorSet(currentFrame, meshTextures[j]);
+				deviceDispatch.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout.get(), 1, 1, &textureSet, 0, nullptr);
+				uint32_t drawCalls = meshletCuller.recordDraw(commandBuffer, currentFrame, j, latePhase, pipelineLayout.get());
+
+				// the texture set and the culler's set
+				gpuStatistics.countBinds(currentFrame, 0, 2, 0);
+				gpuStatistics.countDraws(currentFrame, drawCalls, meshList[j].getIndexCount() / 3);
+			}
+		}
+	}
+
+	// -- VERTEX SHADER DRAWS --
+	// bind pipeline to be used in render pass
+	deviceDispatch.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineManager.getPipeline(graphicsPipelineHandle));
+	gpuStatistics.countBinds(currentFrame, 1, 0, 0);
+
+	for (size_t j = 0; j < meshList.size(); j++){
+
+		// meshes past the culler's capacity are always drawn, once
+		bool culled = j < occlusionCuller.getMaxObjects();
+		bool meshletCulled = meshletCuller.isMeshCulled(currentFrame, j);
+		if ((!culled && latePhase) || (meshletCulled && meshShaderEnabled) || !meshList[j].isResident()) {
+			continue;
+		}
+
+		// the instance buffer is bound at the mesh's node, so instance 0 reads its model matrix
+		VkBuffer vertexBuffers[] = { meshList[j].getVertexBuffer(), sceneGraph.getInstanceBuffer(currentFrame) };		// buffers to bind
+		VkDeviceSize offsets[] = { 0, meshNodes[j] * sizeof(glm::mat4) };											// offsets into buffers being bound
+		deviceDispatch.vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);		// command to bind vertex buffer before drawing with them
+
+		// bind mesh index buffer with 0 offset and using the uint32_t type
+		deviceDispatch.vkCmdBindIndexBuffer(commandBuffer, meshList[j].getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+
+		VkDescriptorSet textureSet = textureManager.getDescriptorSet(currentFrame, meshTextures[j]);
+		deviceDispatch.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout.get(), 1, 1, &textureSet, 0, nullptr);
+
+		// execute pipeline, meshlet culled meshes draw the index range of each visible meshlet,
+		// other culled meshes read their instance count (0 or 1) from the culler's draw
+		uint32_t drawCalls = 1;
+		if (meshletCulled) {
+			drawCalls = meshletCuller.recordDraw(commandBuffer, currentFrame, j, latePhase, pipelineLayout.get());
+		}
+		else if (culled)
+		{
+			deviceDispatch.vkCmdDrawIndexedIndirect(commandBuffer, drawBuffer, j * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+		}
+		else
+		{
+			deviceDispatch.vkCmdDrawIndexed(commandBuffer, meshList[j].getIndexCount(), 1, 0, 0, 0);
+		}
+
+		// two vertex buffers and the index buffer. culled draws submit at most the whole mesh
+		gpuStatistics.countBinds(currentFrame, 0, 1, 3);
+		gpuStatistics.countDraws(currentFrame, drawCalls, meshList[j].getIndexCount() / 3);
+	}
+
+	// -- DYNAMIC GEOMETRY --
+	// never culled, so drawn once in the early pass. read straight from this frame's region of the mapped buffer
+	uint32_t dynamicIndexCount = dynamicMesh.getIndexCount(currentFrame);
+	if (!latePhase && dynamicIndexCount > 0) {
+
+		VkBuffer vertexBuffers[] = { dynamicMesh.getBuffer(), sceneGraph.getInstanceBuffer(currentFrame) };
+		VkDeviceSize offsets[] = { dynamicMesh.getVertexOffset(currentFrame), sceneRoot * sizeof(glm::mat4) };
+		deviceDispatch.vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+		deviceDispatch.vkCmdBindIndexBuffer(commandBuffer, dynamicMesh.getBuffer(), dynamicMesh.getIndexOffset(currentFrame), VK_INDEX_TYPE_UINT32);
+
+		VkDescriptorSet textureSet = textureManager.getDescriptorSet(currentFrame, dynamicTexture);
+		deviceDispatch.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout.get(), 1, 1, &textureSet, 0, nullptr);
+
+		deviceDispatch.vkCmdDrawIndexed(commandBuffer, dynamicIndexCount, 1, 0, 0, 0);
+
+		gpuStatistics.countBinds(currentFrame, 0, 1, 3);
+		gpuStatistics.countDraws(currentFrame, 1, dynamicIndexCount / 3);
+	}
+
+	// -- DEBUG DRAW --
+	// depth tested against everything opaque, so in the late pass after its meshes
+	if (latePhase) {
+		uint32_t debugDraws = debugDraw.recordDraws(commandBuffer, currentFrame, false, sceneGraph.getInstanceBuffer(currentFrame), sceneRoot * sizeof(glm::mat4));
+		gpuStatistics.countBinds(currentFrame, debugDraws, 0, debugDraws * 2);
+		gpuStatistics.countDraws(currentFrame, debugDraws, 0);
+	}
+
+	// -- PARTICLES --
+	// blended over everything opaque, so last in the late pass before the overlays. the instance count was written by
+	// the simulation. the placeholder pipeline has a different vertex input, so nothing is drawn until the particle pipeline is ready
+	if (latePhase && pipelineManager.isReady(particlePipelineHandle)) {
+
+		deviceDispatch.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineManager.getPipeline(particlePipelineHandle));
+		particleSystem.recordDraw(commandBuffer);
+
+		// the particle count is only known on the GPU, so no triangles are counted
+		gpuStatistics.countBinds(currentFrame, 1, 0, 1);
+		gpuStatistics.countDraws(currentFrame, 1, 0);
+	}
+
+	// -- DEBUG OVERLAY --
+	// on top of everything, last
+	if (latePhase) {
+		uint32_t debugDraws = debugDraw.recordDraws(commandBuffer, currentFrame, true, sceneGraph.getInstanceBuffer(currentFrame), sceneRoot * sizeof(glm::mat4));
+		gpuStatistics.countBinds(currentFrame, debugDraws, 0, debugDraws * 2);
+		gpuStatistics.countDraws(currentFrame, debugDraws, 0);
+	}
+}
+
+void VulkanRenderer::getPhysicalDevice()
+{
+	// enumerate physical devices the ckinstance can access
+	uint32_t deviceCount = 0;
+	vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+
+	// if no devices available, then none support vulkan
+	if (deviceCount == 0) {
+		throw std::runtime_error("Can't find GPUs that support Vulkan instance");
+	}
+
+	// get list of physical devices
+	std::vector<VkPhysicalDevice> deviceList(deviceCount);
+	vkEnumeratePhysicalDevices(instance, &deviceCount, deviceList.data());
+
+	// score every device instead of taking the first suitable one, which is often an integrated GPU or lavapipe
+	std::vector<DeviceCandidate> candidates;
+	for (const auto &device : deviceList) {
+
+		DeviceCandidate candidate = DeviceSelector::describe(device, optionalDeviceExtensions);
+		candidate.suitable = checkDeviceSuitable(device);
+		if (candidate.suitable) {
+			QueueFamilyIndices indices = getQueueFamilies(device);
+			candidate.presentOnGraphicsFamily = indices.graphicsFamily == indices.presentationFamily;
+		}
+		candidates.push_back(candidate);
+	}
+
+	// VULKAN_DEVICE picks a device by part of its name or its UUID
+	const char * deviceOverride = std::getenv("VULKAN_DEVICE");
+	int selected = DeviceSelector::select(candidates, deviceOverride != nullptr ? deviceOverride : "");
+	DeviceSelector::report(candidates, selected);
+
+	if (selected < 0) {
+		throw std::runtime_error("Can't find a GPU that meets the renderer's requirements");
+	}
+	mainDevice.physicalDevice = candidates[selected].device;
+}
+
+bool VulkanRenderer::checkInstanceExtensionSupport(std::vector<const char*>* checkExtensions)
+{
+	// need to get number of extensions to create array of correct size to hold extensions
+	uint32_t extensionCount = 0;
+	vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+
+	// create a list of vkExtension properties using count
+	std::vector<VkExtensionProperties> extensions(extensionCount);
+	vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+	// check if given extensions are in list of available extensions
+	for (const auto &checkExtension : *checkExtensions) {
+		
+		bool hasExtension = false;
+		for (const auto &extension : extensions) {
+
+			if (strcmp(checkExtension, extension.extensionName)==0) {
+				
+				hasExtension = true;
+				break;
+			}
+		}
+		if (!hasExtension) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool VulkanRenderer::checkDeviceExtensionSupport(VkPhysicalDevice device)
+{
+	// Get device extension count
+	uint32_t extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+	// If no extensions found, return failure
+	if (extensionCount == 0)
+	{
+		return false;
+	}
+
+	// Populate list of extensions
+	std::vector<VkExtensionProperties> extensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+
+	// Check for extension
+	for (const auto &deviceExtension : deviceExtensions)
+	{
+		bool hasExtension = false;
+		for (const auto &extension : extensions)
+		{
+			if (strcmp(deviceExtension, extension.extensionName) == 0)
+			{
+				hasExtension = true;
+				break;
+			}
+		}
+
+		if (!hasExtension)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+bool VulkanRenderer::checkDeviceExtensionAvailable(VkPhysicalDevice device, const char * extensionName)
+{
+	uint32_t extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+	std::vector<VkExtensionProperties> extensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+
+	for (const auto &extension : extensions)
+	{
+		if (strcmp(extensionName, extension.extensionName) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool VulkanRenderer::checkValidationLayerSupport() {
+#if VULKAN_VALIDATION_ENABLED
+	uint32_t layerCount;
+	vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+
+	std::vector<VkLayerProperties> availableLayers(layerCount);
+	vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
+
+	for (const char* layerName : validationLayers) {
+		bool layerFound = false;
+
+		for (const auto& layerProperties : availableLayers) {
+			if (strcmp(layerName, layerProperties.layerName) == 0) {
+				layerFound = true;
+				break;
+			}
+		}
+
+		if (!layerFound) {
+			return false;
+		}
+	}
+
+#endif
+	return true;
+}
+
+bool VulkanRenderer::checkDeviceSuitable(VkPhysicalDevice device)
+{
+	// only requirements, how good a suitable device is is up to DeviceSelector
+	QueueFamilyIndices indices = getQueueFamilies(device);
+
+	bool extensionsSupported = headless || checkDeviceExtensionSupport(device);
+
+	// timeline semaphores are core in vulkan 1.2 but still an optional feature to query
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties(device, &deviceProperties);
+
+	if (deviceProperties.apiVersion < VK_API_VERSION_1_2) {
+		return false;
+	}
+
+	VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+	vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	VkPhysicalDeviceFeatures2 deviceFeatures2 = {};
+	deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	deviceFeatures2.pNext = &vulkan12Features;
+	vkGetPhysicalDeviceFeatures2(device, &deviceFeatures2);
+
+	if (!vulkan12Features.timelineSemaphore) {
+		return false;
+	}
+
+	bool swapChainValid = headless;
+
+	if (extensionsSupported && !headless) {
+		SwapChainDetails swapChainDetails = getSwapChainDetails(device);
+		swapChainValid = !swapChainDetails.presentationModes.empty() && !swapChainDetails.formats.empty();
+	}
+	return indices.isValid() && extensionsSupported && swapChainValid;
+}
+
+
+QueueFamilyIndices VulkanRenderer::getQueueFamilies(VkPhysicalDevice device)
+{
+	QueueFamilyIndices indices;
+
+	// get all queue family property info for the given devices
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+
+	std::vector<VkQueueFamilyProperties> queueFamilyList(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilyList.data());
+
+	// go through each queue family and check if it has at least one of the reuqired types of queue
+	int i = 0;
+	for (const auto &queueFamily : queueFamilyList) {
+		// first check if queue family has at least 1 queue in that family
+		// queue can have multiple types defined through bitfield, need to bitwise check if it has required type
+		// the culling dispatches are recorded in to the graphics command buffers, so the family has to run compute
+		// too. the spec guarantees one family with both on any device that has graphics
+		if (queueFamily.queueCount > 0 && (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
+
+			indices.graphicsFamily = i;		// if queue family is valid, get index
+		}
+
+
+		// check if queue family supports presentation, anything goes without a surface as nothing is presented
+		VkBool32 presentationSupport = false;
+		if (surface != VK_NULL_HANDLE) {
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentationSupport);
+		}
+		else
+		{
+			presentationSupport = indices.graphicsFamily == i;
+		}
+
+		// check if queue is presentation type (can be both graphics and presentation type)
+		if (queueFamily.queueCount > 0 && presentationSupport) {
+			indices.presentationFamily = i;
+		}
+
+		// check if queue family indices are in a valid state, stop searching if so
+		if (indices.isValid()) {
+			break;
+		}
+
+		i++;
+	}
+
+	// async compute prefers a family without graphics, whose queues can run alongside the graphics queue.
+	// without one it falls back to the graphics family
+	for (int family = 0; family < static_cast<int>(queueFamilyList.size()); family++) {
+		const VkQueueFamilyProperties &queueFamily = queueFamilyList[family];
+		if (queueFamily.queueCount > 0 && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+			indices.computeFamily = family;
+			break;
+		}
+	}
+	if (indices.computeFamily < 0) {
+		indices.computeFamily = indices.graphicsFamily;
+	}
+
+	return indices;
+}
+
+SwapChainDetails VulkanRenderer::getSwapChainDetails(VkPhysicalDevice device){
+
+	SwapChainDetails swapChainDetails;
+	// -- CAPABILITIES--
+	// get the surface capabilities for the given surface on the given physical device
+	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &swapChainDetails.surfaceCapabilities);
+
+	// -- FORMATS--
+	uint32_t formatCount = 0;
+	vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, nullptr);
+
+	// if formats returned, get list of formats
+	if (formatCount != 0) {
+		swapChainDetails.formats.resize(formatCount);
+		vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, swapChainDetails.formats.data());
+	}
+
+	// --PRESENTATION MODES--
+	uint32_t presentationCount = 0;
+	vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentationCount, nullptr);
+
+	// if presentation modes returned, get list of presentation modes
+	if (presentationCount != 0) {
+		swapChainDetails.presentationModes.resize(presentationCount);
+		vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentationCount, swapChainDetails.presentationModes.data());
+	}
+
+	return swapChainDetails;
+}
+
+// best format is subjective, but this will be
+// format		:	VK_FORMAT_R8G8B8A8_UNORM (VK_FORMAT_B8G8R8A8_UNORM as backup)
+// colorspace	:	VK_COLOR_SPACE_SRGB_NONLINEAR_KHR
+VkSurfaceFormatKHR VulkanRenderer::chooseBestSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& formats) {
+
+	// if only 1 format is available and is undefined it means all are available and no restrictions
+	if (formats.size() == 1 && formats[0].format == VK_FORMAT_UNDEFINED) {
+		return { VK_FORMAT_R8G8B8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+	}
+
+	// if restricted, find optimal
+	for (const auto &format : formats) {
+		if ((format.format == VK_FORMAT_R8G8B8A8_UNORM || format.format == VK_FORMAT_B8G8R8A8_UNORM) && format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+			return format;
+		}
+	}
+
+	// if optimal not found, use first
+	return formats[0];
+}
+
+VkPresentModeKHR VulkanRenderer::chooseBestPresentationMode(const std::vector<VkPresentModeKHR> presentationModes){
+
+	// look for mailbox presentation mode
+	for (const auto &presentationMode : presentationModes) {
+		if (presentationMode == VK_PRESENT_MODE_MAILBOX_KHR) {
+			return presentationMode;
+		}
+	}
+
+	// if can't find look for FIFO as vulkan spec says it must be present
+	return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+VkFormat VulkanRenderer::chooseSupportedFormat(const std::vector<VkFormat> &formats, VkImageTiling tiling, VkFormatFeatureFlags featureFlags){
+
+	// first format in the list (most preferred) that supports everything needed
+	for (VkFormat format : formats) {
+
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(mainDevice.physicalDevice, format, &properties);
+
+		VkFormatFeatureFlags supported = tiling == VK_IMAGE_TILING_LINEAR ? properties.linearTilingFeatures : properties.optimalTilingFeatures;
+		if ((supported & featureFlags) == featureFlags) {
+			return format;
+		}
+	}
+
+	throw std::runtime_error("failed to find a matching format");
+}
+
+VkExtent2D VulkanRenderer::chooseSwapExtent(const VkSurfaceCapabilitiesKHR & surfaceCapabilities){
+
+	// if current extent is at numeric limits, the extent can vary, otherwise it's the size of the window
+	if (surfaceCapabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
+		return surfaceCapabilities.currentExtent;
+	}
+	else
+	{
+		// if value can vary, need to set manually
+
+		// get window size
+		int width, height;
+		glfwGetFramebufferSize(window, &width, &height);
+
+		// create new extent using window size
+		VkExtent2D newExtent = {};
+		newExtent.width = static_cast<uint32_t>(width);
+		newExtent.height = static_cast<uint32_t>(height);
+
+		// surface also defines max and min, so make sure within boundaries by clamping value
+		newExtent.width = std::max(surfaceCapabilities.minImageExtent.width, std::min(surfaceCapabilities.maxImageExtent.width, newExtent.width));
+		newExtent.height = std::max(surfaceCapabilities.minImageExtent.height, std::min(surfaceCapabilities.maxImageExtent.height, newExtent.height));
+
+		return newExtent;
+	}
+}
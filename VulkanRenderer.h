@@ -1,112 +1,278 @@
-#pragma once
-
-#define GLFW_INCLUDE_VULKAN
-#include <GLFW/glfw3.h>
-
-#include <stdexcept>
-#include <vector>
-#include <set>
-#include <algorithm>
-#include <array>
-
-#include "Mesh.h"
-#include "VulkanValidation.h"
-#include "Utilities.h"
-
-
-
-class VulkanRenderer
-{
-public:
-	VulkanRenderer();
-
-	int init(GLFWwindow * newWindow);
-	void draw();
-	void cleanup();
-
-
-	~VulkanRenderer();
-
-private: 
-	GLFWwindow * window;
-
-	int currentFrame = 0;
-
-	// scene objects
-	std::vector<Mesh> meshList;
-
-	// vulkan components
-	// - Main
-	VkInstance instance;
-	VkDebugUtilsMessengerEXT debugMessenger;
-	struct {
-		VkPhysicalDevice physicalDevice;
-		VkDevice logicalDevice;
-	} mainDevice;
-	VkQueue graphicsQueue;
-	VkQueue presentationQueue;
-	VkSurfaceKHR surface;
-	VkSwapchainKHR swapchain;
-
-	std::vector<SwapChainImage> swapChainImages;
-	std::vector<VkFramebuffer> swapChainFrameBuffers;
-	std::vector<VkCommandBuffer> commandBuffers;
-
-	// - Pipeline
-	VkPipeline graphicsPipeline;
-	VkPipelineLayout pipelineLayout;
-	VkRenderPass renderPass;
-
-	// - Pools
-	VkCommandPool graphicsCommandPool;
-
-	// - Utility
-	VkFormat swapChainImageFormat;
-	VkExtent2D swapChainExtent;
-
-	// - Synchronization
-	std::vector<VkSemaphore> imageAvailable;
-	std::vector<VkSemaphore> renderFinished;
-	std::vector<VkFence> drawFences;
-
-	// vulkan functions
-	// create functions
-	void createInstance();
-	void createDebugMessenger();
-	void createLogicalDevice();
-	void createSurface();
-	void createSwapChain();
-	void createRenderPass();
-	void createGraphicsPipeline();
-	void createFrameBuffers();
-	void createCommandPool();
-	void createCommandBuffers();
-	void createSynchronization();
-
-	// - Record functions
-	void recordCommands();
-
-	// Get functions
-	void getPhysicalDevice();
-
-	// support functions
-	// -- checker functions
-	bool checkInstanceExtensionSupport(std::vector<const char*> * checkExtensions);
-	bool checkDeviceExtensionSupport(VkPhysicalDevice device);
-	bool checkValidationLayerSupport();
-	bool checkDeviceSuitable(VkPhysicalDevice device);
-
-	// -- getter functions
-	QueueFamilyIndices getQueueFamilies(VkPhysicalDevice device);
-	SwapChainDetails getSwapChainDetails(VkPhysicalDevice device);
-
-	// -- Choose functions
-	VkSurfaceFormatKHR chooseBestSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &formats);
-	VkPresentModeKHR chooseBestPresentationMode(const std::vector<VkPresentModeKHR> presentationModes);
-	VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &surfaceCapabilities);
-
-	// -- Create functions
-	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectflags);
-	VkShaderModule createShaderModule(const std::vector<char> &code);
-};
-
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <chrono>
+
+#include "Mesh.h"
+#include "DynamicMesh.h"
+#include "ParticleSystem.h"
+#include "DebugDraw.h"
+#include "PipelineManager.h"
+#include "OcclusionCuller.h"
+#include "MeshletCuller.h"
+#include "SceneGraph.h"
+#include "JobSystem.h"
+#include "UploadManager.h"
+#include "TextureManager.h"
+#include "FrameReadback.h"
+#include "RenderGraph.h"
+#include "GpuProfiler.h"
+#include "GpuStatistics.h"
+#include "AsyncCompute.h"
+#include "DeviceSelector.h"
+#include "Profiler.h"
+#include "VulkanValidation.h"
+#include "ValidationLog.h"
+#include "Utilities.h"
+#include "DeviceDispatch.h"
+
+
+
+class VulkanRenderer
+{
+public:
+	VulkanRenderer();
+
+	// without a window (nullptr) frames are rendered headless in to offscreen color targets of headlessExtent. nothing
+	// needs a surface, swapchain or display then, so it runs on software drivers, and frames are seen through readback
+	int init(GLFWwindow * newWindow, JobSystem * newJobSystem, VkExtent2D newHeadlessExtent = { 800, 600 });
+	void draw();
+	void cleanup();
+
+	// scene changes
+	void removeMesh(size_t meshIndex);
+
+	// device memory resident meshes may hold, least recently visible meshes are evicted beyond it and reloaded once
+	// they become visible again. 0 leaves them limited only by what the rest of the device local heap leaves of its budget
+	void setMeshMemoryBudget(VkDeviceSize bytes);
+	VkDeviceSize getResidentMeshBytes();
+
+	// objects the occlusion culler rejected in the last finished frame
+	uint32_t getOccludedObjectCount();
+
+	// after the last draw: wait for the device, then check every async compute submission ran. false if one didn't
+	bool checkAsyncCompute();
+
+	// copy every presented (or headless) frame back to the host, the callback runs on a writer thread a few frames later
+	void setFrameReadback(ReadbackCallback callback);
+
+	// geometry rebuilt every frame. the callback runs on this thread during draw, once the frame's region of the
+	// dynamic mesh is free, and what it writes is drawn as triangles with the scene root's transform
+	void setDynamicGeometry(DynamicGeometryCallback callback);
+	VkDeviceSize getDynamicStreamedBytes();			// written for the last frame
+
+	// immediate mode lines, shapes and text, drawn with the next frame. use from this thread between draws
+	DebugDraw &getDebugDraw();
+
+	// particles simulated and drawn on the GPU, none are emitted until this is called
+	void setParticleEmitter(const ParticleEmitter &emitter);
+
+	// count draws, binds and pipeline statistics per render graph pass, logged every logIntervalSeconds (0 never logs).
+	// statistics are those of a frame that finished a few frames ago
+	void setPassStatistics(bool enabled, double logIntervalSeconds = 0.0);
+	const std::vector<PassStatistics> &getPassStatistics();
+
+	// time recording drawCount draws through the loader's exported commands and through the dispatch table, and
+	// print both. nothing is submitted. without validation layers (a release build) the difference is the trampoline
+	void benchmarkDispatch(uint32_t drawCount);
+
+	// time simulating 10k, 100k ... up to maxParticles particles a step with systems of their own, and print the
+	// time a step and a particle takes. stops early if a system's buffers can't be allocated. returns false if
+	// a system didn't have every emitted particle alive after the first step
+	bool benchmarkParticles(uint32_t maxParticles);
+
+
+	~VulkanRenderer();
+
+private: 
+	GLFWwindow * window;
+	JobSystem * jobSystem = nullptr;
+
+	int currentFrame = 0;
+	uint64_t frameNumber = 0;						// frames drawn since init
+
+	// scene objects
+	std::vector<Mesh> meshList;
+	uint64_t meshListVersion = 0;					// bumped whenever meshes are added, removed, evicted or reloaded
+	SceneGraph sceneGraph;
+	uint32_t sceneRoot = 0;
+	std::vector<uint32_t> meshNodes;				// scene graph node of each mesh, parallel to meshList
+	std::vector<uint32_t> meshTextures;				// texture manager handle of each mesh, parallel to meshList
+	std::vector<uint64_t> meshLastVisible;			// frame each mesh was last seen visible, parallel to meshList
+	VkDeviceSize meshMemoryBudget = 0;
+	struct EvictingMesh {
+		uint64_t value;								// timeline value the deletion queue frees it after
+		VkDeviceSize bytes;
+	};
+	std::vector<EvictingMesh> evictingMeshes;		// evicted mesh memory the heap's usage still counts
+	DynamicMesh dynamicMesh;
+	DynamicGeometryCallback dynamicGeometryCallback;
+	uint32_t dynamicTexture = 0;					// plain white, so vertex colours are drawn as they are
+	VkDeviceSize dynamicStreamedBytes = 0;
+	ParticleSystem particleSystem;
+	std::chrono::steady_clock::time_point lastParticleUpdate;
+	DebugDraw debugDraw;
+
+	// vulkan components
+	// - Main
+	VkInstance instance;
+	VkDebugUtilsMessengerEXT debugMessenger;
+	bool validationEnabled = false;					// only ever set in builds with VULKAN_VALIDATION_ENABLED
+#if VULKAN_VALIDATION_ENABLED
+	ValidationLog validationLog;
+#endif
+	struct {
+		VkPhysicalDevice physicalDevice;
+		VkDevice logicalDevice;
+	} mainDevice;
+	VkQueue graphicsQueue;
+	VkQueue presentationQueue;
+	VkQueue computeQueue;							// the graphics queue without async compute
+	VkSurfaceKHR surface = VK_NULL_HANDLE;
+	VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+
+	// the swapchain's images, or the offscreen color targets that stand in for them when headless
+	std::vector<SwapChainImage> swapChainImages;
+	std::vector<VkFramebuffer> swapChainFrameBuffers;		// empty with dynamic rendering
+	std::vector<VkCommandBuffer> commandBuffers;
+
+	// - Pipeline
+	FileSystem fileSystem;							// shaders and assets, mapped from disk or mounted archives
+	ShaderManager shaderManager;
+	PipelineManager pipelineManager;
+	uint64_t graphicsPipelineHandle = 0;
+	uint64_t meshletPipelineHandle = 0;				// task / mesh shader pipeline, when mesh shaders are enabled
+	uint64_t particlePipelineHandle = 0;
+	UniquePipelineLayout pipelineLayout;
+	// without dynamic rendering only
+	VkRenderPass renderPass = VK_NULL_HANDLE;		// early pass, clears and draws what was visible last frame
+	VkRenderPass lateRenderPass = VK_NULL_HANDLE;	// late pass, loads the early pass's results and draws what became visible
+
+	// - Pools
+	VkCommandPool graphicsCommandPool;
+
+	// - Utility
+	VkFormat swapChainImageFormat;
+	VkExtent2D swapChainExtent;
+	bool swapChainReadable = false;					// images can be copied from, needed for readback
+	VkImageLayout colorTargetLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;	// images are left in after each frame
+
+	// - Headless
+	bool headless = false;							// no window, surface or swapchain
+	VkExtent2D headlessExtent = {};
+	std::vector<UniqueImage> offscreenImages;		// one per frame in flight, the frame's wait frees its image
+	std::vector<UniqueDeviceMemory> offscreenMemory;
+
+	// - Readback
+	FrameReadback frameReadback;
+	bool readbackEnabled = false;
+
+	// - Render graph
+	// culling and drawing passes, their barriers, and the depth buffer (a transient image of the graph)
+	RenderGraph renderGraph;
+	VkFormat depthBufferFormat;
+	uint32_t swapChainColorResource = 0;
+	uint32_t depthResource = 0;
+	uint32_t earlyDrawsResource = 0;
+	uint32_t lateDrawsResource = 0;
+	uint32_t particleStateResource = 0;
+	uint32_t particleControlResource = 0;
+	uint32_t recordingImage = 0;					// swapchain image the graph's passes are recording for
+
+	// - Profiling
+	GpuProfiler gpuProfiler;
+	GpuStatistics gpuStatistics;
+	double statisticsLogInterval = 0.0;
+	std::chrono::steady_clock::time_point lastStatisticsLog;
+
+	// - Culling
+	OcclusionCuller occlusionCuller;
+	MeshletCuller meshletCuller;
+	uint32_t occludedObjectCount = 0;
+
+	// - Frame jobs
+	JobCounter transformJobs;						// scene graph update
+	JobCounter cullInputJobs;						// cull objects and meshlet meshes, after the transforms
+	std::vector<CullObject> cullObjects;
+	std::vector<MeshletCullMesh> meshletCullMeshes;
+
+	// - Optional features, enabled when the device has them
+	bool multiDrawIndirectEnabled = false;
+	bool drawIndirectCountEnabled = false;
+	bool meshShaderEnabled = false;
+	bool memoryBudgetEnabled = false;
+	bool calibratedTimestampsEnabled = false;
+	bool pipelineStatisticsEnabled = false;
+	bool dynamicRenderingEnabled = false;			// render passes and framebuffers are created without it
+	bool asyncComputeEnabled = false;				// a family with compute but no graphics, for the particle update
+
+	// - Synchronization
+	std::vector<VkSemaphore> imageAvailable;
+	std::vector<VkSemaphore> renderFinished;
+	FrameScheduler frameScheduler;					// timeline semaphore all graphics queue submissions signal
+	AsyncCompute asyncCompute;						// compute submitted ahead of each frame, on its own queue when there is one
+
+	// - Memory
+	DeviceAllocator deviceAllocator;
+	DeletionQueue deletionQueue;					// resources waiting for the GPU to finish with them
+	UploadManager uploadManager;					// buffer and image uploads from any thread, submitted once a frame
+	TextureManager textureManager;
+
+	// vulkan functions
+	// create functions
+	void createInstance();
+	void createDebugMessenger();
+	void createLogicalDevice();
+	void createSurface();
+	void createSwapChain();
+	void createOffscreenTargets();
+	void createRenderGraph();
+	void createRenderPass();
+	void createGraphicsPipeline();
+	void createFrameBuffers();
+	void createCommandPool();
+	void createCommandBuffers();
+	void createSynchronization();
+
+	// - Residency
+	void updateMeshResidency();
+
+	// - Frame jobs
+	void startFrameJobs();
+	void buildCullInputs(uint32_t begin, uint32_t end);
+
+	// - Record functions
+	void recordCommands(uint32_t currentImage);
+	void recordRenderPass(VkCommandBuffer commandBuffer, bool latePhase);
+	void recordMeshDraws(VkCommandBuffer commandBuffer, bool latePhase);
+
+	// Get functions
+	void getPhysicalDevice();
+
+	// support functions
+	// -- checker functions
+	bool checkInstanceExtensionSupport(std::vector<const char*> * checkExtensions);
+	bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+	bool checkDeviceExtensionAvailable(VkPhysicalDevice device, const char * extensionName);
+	bool checkValidationLayerSupport();
+	bool checkDeviceSuitable(VkPhysicalDevice device);
+
+	// -- getter functions
+	QueueFamilyIndices getQueueFamilies(VkPhysicalDevice device);
+	SwapChainDetails getSwapChainDetails(VkPhysicalDevice device);
+
+	// -- Choose functions
+	VkSurfaceFormatKHR chooseBestSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &formats);
+	VkPresentModeKHR chooseBestPresentationMode(const std::vector<VkPresentModeKHR> presentationModes);
+	VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &surfaceCapabilities);
+	VkFormat chooseSupportedFormat(const std::vector<VkFormat> &formats, VkImageTiling tiling, VkFormatFeatureFlags featureFlags);
+};
+
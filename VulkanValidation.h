@@ -1,32 +1,58 @@
-#pragma once
-
-#include <vector>
-#include <iostream>
-
-const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
-
-
-static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* pUserData) {
-
-	std::cerr << "validation layer: " << pCallbackData->pMessage << std::endl;
-
-	return VK_FALSE;
-
-}
-
-static VkResult CreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDebugUtilsMessengerEXT* pDebugMessenger) {
-	auto func = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
-	if (func != nullptr) {
-		return func(instance, pCreateInfo, pAllocator, pDebugMessenger);
-	}
-	else {
-		return VK_ERROR_EXTENSION_NOT_PRESENT;
-	}
-}
-
-static void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT debugMessenger, const VkAllocationCallbacks* pAllocator) {
-	auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT");
-	if (func != nullptr) {
-		func(instance, debugMessenger, pAllocator);
-	}
-}
+#pragma once
+
+#include <vector>
+
+// validation layers and the debug messenger only exist in builds with this set, it follows NDEBUG unless given
+// (e.g. -DVULKAN_VALIDATION_ENABLED=1 for a release build with validation). builds with it can still turn
+// validation off at runtime with VULKAN_VALIDATION=0
+#ifndef VULKAN_VALIDATION_ENABLED
+#ifdef NDEBUG
+#define VULKAN_VALIDATION_ENABLED 0
+#else
+#define VULKAN_VALIDATION_ENABLED 1
+#endif
+#endif
+
+#if VULKAN_VALIDATION_ENABLED
+
+const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
+
+// instance extension commands are looked up once per instance rather than on every call
+static PFN_vkCreateDebugUtilsMessengerEXT getCreateDebugUtilsMessenger(VkInstance instance) {
+	static VkInstance loadedInstance = VK_NULL_HANDLE;
+	static PFN_vkCreateDebugUtilsMessengerEXT func = nullptr;
+	if (instance != loadedInstance) {
+		func = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
+		loadedInstance = instance;
+	}
+	return func;
+}
+
+static PFN_vkDestroyDebugUtilsMessengerEXT getDestroyDebugUtilsMessenger(VkInstance instance) {
+	static VkInstance loadedInstance = VK_NULL_HANDLE;
+	static PFN_vkDestroyDebugUtilsMessengerEXT func = nullptr;
+	if (instance != loadedInstance) {
+		func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT");
+		loadedInstance = instance;
+	}
+	return func;
+}
+
+static VkResult CreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDebugUtilsMessengerEXT* pDebugMessenger) {
+	auto func = getCreateDebugUtilsMessenger(instance);
+	if (func != nullptr) {
+		return func(instance, pCreateInfo, pAllocator, pDebugMessenger);
+	}
+	else {
+		return VK_ERROR_EXTENSION_NOT_PRESENT;
+	}
+}
+
+static void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT debugMessenger, const VkAllocationCallbacks* pAllocator) {
+	auto func = getDestroyDebugUtilsMessenger(instance);
+	if (func != nullptr) {
+		func(instance, debugMessenger, pAllocator);
+	}
+}
+
+#endif // VULKAN_VALIDATION_ENABLED
@@ -1,54 +1,262 @@
-#define GLFW_INCLUDE_VULKAN
-#include <GLFW/glfw3.h>
-
-#include <iostream>
-#include <stdexcept>
-#include <vector>
-
-#include "VulkanRenderer.h"
-
-
-GLFWwindow * window;
-VulkanRenderer vulkanRenderer;
-VkInstance instance;
-VkDebugUtilsMessengerEXT debugMessenger;
-
-
-void initWindow(std::string wName = "Test Window", const int width = 800, const int height = 600) {
-
-	// initialize GLFW
-	glfwInit();
-
-	// set GLFW to not work with OpenGL
-	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-	glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-
-	window = glfwCreateWindow(width, height, wName.c_str(), nullptr, nullptr);
-}
-
-int main() {
-
-	// create window
-	initWindow("Test Window", 800, 600);
-
-	// create vulkan renderer instance
-	if (vulkanRenderer.init(window) == EXIT_FAILURE) {
-		
-		return EXIT_FAILURE;
-	}
-
-	// loop until closed
-	while (!glfwWindowShouldClose(window))
-	{
-		glfwPollEvents();
-		vulkanRenderer.draw();
-	}
-
-	vulkanRenderer.cleanup();
-
-	// destroy window and terminate glfw
-	glfwDestroyWindow(window);
-	glfwTerminate();
-
-	return 0;
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <atomic>
+
+#include "VulkanRenderer.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+
+GLFWwindow * window;
+VulkanRenderer vulkanRenderer;
+JobSystem jobSystem;
+VkInstance instance;
+VkDebugUtilsMessengerEXT debugMessenger;
+
+
+void initWindow(std::string wName = "Test Window", const int width = 800, const int height = 600) {
+
+	// initialize GLFW
+	glfwInit();
+
+	// set GLFW to not work with OpenGL
+	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+	glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+
+	window = glfwCreateWindow(width, height, wName.c_str(), nullptr, nullptr);
+}
+
+// the debug marker, a solid magenta square in the top left corner (the same in RGBA and BGRA, UNORM and SRGB)
+static const float DEBUG_MARKER_SIZE = 4.0f;
+
+static bool hasDebugMarker(const ReadbackImage &image) {
+
+	if (image.width < DEBUG_MARKER_SIZE || image.height < DEBUG_MARKER_SIZE) {
+		return false;
+	}
+	const uint8_t * pixel = image.data + image.rowPitch + 4;
+	return pixel[0] > 240 && pixel[1] < 16 && pixel[2] > 240;
+}
+
+int main() {
+
+	// render this many frames without a window or swapchain and exit, with FRAME_READBACK_DIR for regression images
+	// on machines without a display, e.g. HEADLESS_FRAMES=100
+	const char * headlessFrames = std::getenv("HEADLESS_FRAMES");
+	bool headless = headlessFrames != nullptr;
+	uint64_t frameLimit = headless ? std::strtoull(headlessFrames, nullptr, 10) : 0;
+
+	// create window
+	if (headless) {
+		window = nullptr;
+	}
+	else
+	{
+		initWindow("Test Window", 800, 600);
+	}
+
+	// this thread becomes the job system's main thread, the only one allowed to touch the window
+	jobSystem.create();
+
+	// create vulkan renderer instance
+	if (vulkanRenderer.init(window, &jobSystem) == EXIT_FAILURE) {
+		
+		jobSystem.destroy();
+		return EXIT_FAILURE;
+	}
+
+	// cleared by any check below that finds something didn't run, for a failing exit code
+	bool checksPassed = true;
+
+	// this many random debug lines every frame with a frame time overlay, e.g. DEBUG_LINES=1000000
+	const char * debugLines = std::getenv("DEBUG_LINES");
+
+	// headless, debug draw also puts a solid marker in the top left corner and the frames read back are checked
+	// for it, so a run without a display shows whether debug draw reached the screen
+	bool checkDebugMarker = headless && debugLines != nullptr;
+	std::atomic<bool> debugMarkerSeen{ false };
+
+	// write every frame to this directory as a PPM when set, e.g. for regression images
+	const char * readbackDirectory = std::getenv("FRAME_READBACK_DIR");
+	if (readbackDirectory != nullptr || checkDebugMarker) {
+		std::string directory = readbackDirectory != nullptr ? readbackDirectory : "";
+		try
+		{
+			vulkanRenderer.setFrameReadback([directory, checkDebugMarker, &debugMarkerSeen](const ReadbackImage &image) {
+				if (checkDebugMarker && hasDebugMarker(image)) {
+					debugMarkerSeen = true;
+				}
+				if (!directory.empty()) {
+					FrameReadback::writePPM(image, directory + "/frame_" + std::to_string(image.frameNumber) + ".ppm");
+				}
+			});
+		}
+		catch (const std::runtime_error &e)
+		{
+			printf("ERROR: %s\n", e.what());
+		}
+	}
+
+	// time profile scopes disabled and enabled, e.g. PROFILER_BENCHMARK=1000000
+	const char * profilerBenchmark = std::getenv("PROFILER_BENCHMARK");
+	if (profilerBenchmark != nullptr) {
+		Profiler::benchmark(static_cast<uint32_t>(std::strtoul(profilerBenchmark, nullptr, 10)));
+	}
+
+	// time scheduling jobs on the job system, e.g. JOB_BENCHMARK=100000
+	const char * jobBenchmark = std::getenv("JOB_BENCHMARK");
+	if (jobBenchmark != nullptr) {
+		jobSystem.benchmark(static_cast<uint32_t>(std::strtoul(jobBenchmark, nullptr, 10)));
+	}
+
+	// compare recording through the loader and through the dispatch table, e.g. DISPATCH_BENCHMARK=100000
+	const char * dispatchBenchmark = std::getenv("DISPATCH_BENCHMARK");
+	if (dispatchBenchmark != nullptr) {
+		try
+		{
+			vulkanRenderer.benchmarkDispatch(static_cast<uint32_t>(std::strtoul(dispatchBenchmark, nullptr, 10)));
+		}
+		catch (const std::runtime_error &e)
+		{
+			printf("ERROR: %s\n", e.what());
+		}
+	}
+
+	// time the particle simulation from 10k particles up to this many, e.g. PARTICLE_BENCHMARK=10000000.
+	// also checks the kernels ran: the exit code is a failure if particles went missing
+	const char * particleBenchmark = std::getenv("PARTICLE_BENCHMARK");
+	if (particleBenchmark != nullptr) {
+		try
+		{
+			checksPassed &= vulkanRenderer.benchmarkParticles(static_cast<uint32_t>(std::strtoul(particleBenchmark, nullptr, 10)));
+		}
+		catch (const std::runtime_error &e)
+		{
+			printf("ERROR: %s\n", e.what());
+			checksPassed = false;
+		}
+	}
+
+	// a fountain of this many particles a second, e.g. PARTICLES=20000
+	const char * particles = std::getenv("PARTICLES");
+	if (particles != nullptr) {
+		ParticleEmitter emitter;
+		emitter.rate = static_cast<float>(std::strtod(particles, nullptr));
+		vulkanRenderer.setParticleEmitter(emitter);
+	}
+
+	// log per pass draw counts and GPU statistics every this many seconds when set
+	const char * passStatistics = std::getenv("PASS_STATISTICS");
+	if (passStatistics != nullptr) {
+		vulkanRenderer.setPassStatistics(true, std::atof(passStatistics));
+	}
+
+	// profile in to this Chrome trace file when set, F12 writes the last few seconds, the whole buffer is written on exit
+	const char * profileTrace = std::getenv("PROFILE_TRACE");
+	Profiler::setEnabled(profileTrace != nullptr);
+	bool traceKeyDown = false;
+
+	std::vector<glm::vec3> debugLinePoints;
+	if (debugLines != nullptr) {
+		debugLinePoints.resize(std::strtoul(debugLines, nullptr, 10) * 2);
+		for (glm::vec3 &point : debugLinePoints) {
+			point = glm::vec3(std::rand() / (RAND_MAX * 0.5f) - 1.0f, std::rand() / (RAND_MAX * 0.5f) - 1.0f, 0.0f);
+		}
+	}
+	auto lastFrameTime = std::chrono::steady_clock::now();
+
+	// loop until closed
+	uint32_t shownOccludedCount = 0;
+	uint64_t drawnFrames = 0;
+	while (headless ? drawnFrames < frameLimit : !glfwWindowShouldClose(window))
+	{
+		// window events and anything jobs handed back to the main thread
+		if (!headless) {
+			glfwPollEvents();
+		}
+		jobSystem.runMainThreadJobs();
+
+		if (debugLines != nullptr) {
+			auto frameTime = std::chrono::steady_clock::now();
+			double frameMilliseconds = std::chrono::duration<double, std::milli>(frameTime - lastFrameTime).count();
+			lastFrameTime = frameTime;
+
+			DebugDraw &debugDraw = vulkanRenderer.getDebugDraw();
+			debugDraw.lines(debugLinePoints.data(), static_cast<uint32_t>(debugLinePoints.size()), glm::vec4(0.1f, 0.3f, 0.8f, 0.5f));
+			debugDraw.rect(glm::vec2(4.0f, 4.0f), glm::vec2(220.0f, 34.0f), glm::vec4(0.0f, 0.0f, 0.0f, 0.6f));
+			debugDraw.text(glm::vec2(8.0f, 8.0f), std::to_string(debugLinePoints.size() / 2) + " LINES\n" + std::to_string(frameMilliseconds) + " MS",
+				glm::vec4(1.0f), 2.0f);
+			if (checkDebugMarker) {
+				debugDraw.rect(glm::vec2(0.0f, 0.0f), glm::vec2(DEBUG_MARKER_SIZE, DEBUG_MARKER_SIZE), glm::vec4(1.0f, 0.0f, 1.0f, 1.0f));
+			}
+		}
+
+		vulkanRenderer.draw();
+		drawnFrames++;
+		if (headless) {
+			continue;
+		}
+
+		// show how many objects occlusion culling skipped, only when it changes
+		uint32_t occludedCount = vulkanRenderer.getOccludedObjectCount();
+		if (occludedCount != shownOccludedCount) {
+			std::string title = "Test Window (" + std::to_string(occludedCount) + " occluded)";
+			glfwSetWindowTitle(window, title.c_str());
+			shownOccludedCount = occludedCount;
+		}
+
+		bool traceKeyPressed = glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS;
+		if (profileTrace != nullptr && traceKeyPressed && !traceKeyDown) {
+			try
+			{
+				Profiler::exportTrace(profileTrace, 5.0);
+			}
+			catch (const std::runtime_error &e)
+			{
+				printf("ERROR: %s\n", e.what());
+			}
+		}
+		traceKeyDown = traceKeyPressed;
+	}
+
+	// headless runs are checks as much as anything, make sure the compute submitted alongside the frames all ran
+	if (headless && drawnFrames > 0) {
+		checksPassed &= vulkanRenderer.checkAsyncCompute();
+	}
+
+	if (profileTrace != nullptr) {
+		try
+		{
+			Profiler::exportTrace(profileTrace);
+		}
+		catch (const std::runtime_error &e)
+		{
+			printf("ERROR: %s\n", e.what());
+		}
+	}
+
+	vulkanRenderer.cleanup();
+	jobSystem.destroy();
+
+	// cleanup finished every readback, so all frames have been checked
+	if (checkDebugMarker && !debugMarkerSeen) {
+		printf("ERROR: debug draw marker missing from every frame read back\n");
+		checksPassed = false;
+	}
+
+	// destroy window and terminate glfw
+	if (!headless) {
+		glfwDestroyWindow(window);
+		glfwTerminate();
+	}
+
+	return checksPassed ? EXIT_SUCCESS : EXIT_FAILURE;
 }
\ No newline at end of file